@@ -0,0 +1,39 @@
+// Compares two result files written by ffi_overhead_benchmark.dart:
+//
+//   dart run benchmark/compare.dart base.json new.json
+
+import 'dart:convert';
+import 'dart:io';
+
+Map<String, Map<String, dynamic>> _load(String path) {
+  final json = jsonDecode(File(path).readAsStringSync()) as Map<String, dynamic>;
+  return {
+    for (final result in json['results'] as List<dynamic>)
+      (result as Map<String, dynamic>)['name'] as String: result,
+  };
+}
+
+void main(List<String> args) {
+  if (args.length != 2) {
+    stderr.writeln('usage: dart run benchmark/compare.dart base.json new.json');
+    exit(2);
+  }
+  final base = _load(args[0]);
+  final current = _load(args[1]);
+
+  stdout.writeln(
+    '${'case'.padRight(36)} ${'base ns'.padLeft(10)} ${'new ns'.padLeft(10)} '
+    '${'change'.padLeft(8)}',
+  );
+  for (final name in {...base.keys, ...current.keys}) {
+    final before = base[name]?['mean_ns'] as int?;
+    final after = current[name]?['mean_ns'] as int?;
+    final change = before != null && after != null && before > 0
+        ? '${((after - before) * 100 / before).toStringAsFixed(1)}%'
+        : '-';
+    stdout.writeln(
+      '${name.padRight(36)} ${'${before ?? '-'}'.padLeft(10)} '
+      '${'${after ?? '-'}'.padLeft(10)} ${change.padLeft(8)}',
+    );
+  }
+}
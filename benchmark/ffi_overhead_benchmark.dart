@@ -0,0 +1,235 @@
+// Measures the Dart side of every call — string and struct marshaling,
+// frame copies, isolate hops — against the no-op backend in
+// benchmark/native, so the native work is close to zero.
+//
+//   cmake -S benchmark/native -B build/noop && cmake --build build/noop
+//   VIDEO_PROBE_LIBRARY=$PWD/build/noop/libvideo_probe_noop.so \
+//   VIDEO_PROBE_BENCH_OUT=new.json \
+//     flutter test benchmark/ffi_overhead_benchmark.dart
+//   dart run benchmark/compare.dart base.json new.json
+//
+// VIDEO_PROBE_BENCH_SECONDS sets the sampling time per case (default 1).
+@Timeout(Duration(minutes: 10))
+library;
+
+import 'dart:convert';
+import 'dart:ffi';
+import 'dart:io';
+
+import 'package:ffi/ffi.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:video_probe/video_probe_bindings_generated.dart';
+import 'package:video_probe/video_probe_ffi.dart';
+
+/// A typical absolute path, so UTF-8 marshaling costs what it does in apps.
+final _path = '/storage/emulated/0/DCIM/Camera/${'VID_20240101_120000' * 3}.mp4';
+
+const _frameSizes = {
+  '100B': 100,
+  '64KB': 64 * 1024,
+  '1MB': 1024 * 1024,
+  '8MB': 8 * 1024 * 1024,
+};
+
+class _Result {
+  _Result(this.name, List<double> sorted)
+    : samples = sorted.length,
+      mean = sorted.reduce((a, b) => a + b) / sorted.length,
+      p50 = _percentile(sorted, 0.50),
+      p99 = _percentile(sorted, 0.99);
+
+  final String name;
+  final int samples;
+
+  /// Nanoseconds per call.
+  final double mean;
+  final double p50;
+  final double p99;
+
+  static double _percentile(List<double> sorted, double fraction) =>
+      sorted[((sorted.length - 1) * fraction).round()];
+
+  Map<String, Object> toJson() => {
+    'name': name,
+    'mean_ns': mean.round(),
+    'p50_ns': p50.round(),
+    'p99_ns': p99.round(),
+    'samples': samples,
+  };
+}
+
+final _results = <_Result>[];
+
+Duration get _sampleTime => Duration(
+  milliseconds:
+      (double.parse(Platform.environment['VIDEO_PROBE_BENCH_SECONDS'] ?? '1') *
+              1000)
+          .round(),
+);
+
+/// Times [runBatch] on batches large enough (100 us or more) for the
+/// stopwatch to resolve, after a warm-up that also sizes the batch. Each
+/// sample is the per-call time of one batch.
+Future<void> _measureBatches(
+  String name,
+  Future<void> Function(int calls) runBatch,
+) async {
+  var batch = 1;
+  final watch = Stopwatch();
+  while (true) {
+    watch
+      ..reset()
+      ..start();
+    await runBatch(batch);
+    watch.stop();
+    if (watch.elapsedMicroseconds >= 100 || batch >= 1 << 20) break;
+    batch *= 2;
+  }
+
+  final samples = <double>[];
+  final total = Stopwatch()..start();
+  while (total.elapsed < _sampleTime || samples.length < 10) {
+    watch
+      ..reset()
+      ..start();
+    await runBatch(batch);
+    watch.stop();
+    samples.add(watch.elapsedTicks * 1e9 / watch.frequency / batch);
+  }
+  samples.sort();
+  final result = _Result(name, samples);
+  _results.add(result);
+  // ignore: avoid_print
+  print(
+    '${name.padRight(36)} mean ${result.mean.toStringAsFixed(0).padLeft(10)} ns'
+    '  p50 ${result.p50.toStringAsFixed(0).padLeft(10)} ns'
+    '  p99 ${result.p99.toStringAsFixed(0).padLeft(10)} ns',
+  );
+}
+
+/// Times an asynchronous API call, awaiting each one.
+Future<void> _measure(String name, Future<void> Function() op) =>
+    _measureBatches(name, (calls) async {
+      for (var i = 0; i < calls; i++) {
+        await op();
+      }
+    });
+
+/// Times a synchronous call without an await per call.
+Future<void> _measureSync(String name, void Function() op) =>
+    _measureBatches(name, (calls) {
+      for (var i = 0; i < calls; i++) {
+        op();
+      }
+      return Future<void>.value();
+    });
+
+void main() {
+  final libraryPath = Platform.environment['VIDEO_PROBE_LIBRARY'];
+  if (libraryPath == null || libraryPath.isEmpty) {
+    test('ffi overhead', () {}, skip: 'Set VIDEO_PROBE_LIBRARY to the no-op backend');
+    return;
+  }
+  final library = DynamicLibrary.open(libraryPath);
+  final bindings = VideoProbeBindings(library);
+  final setFrameSize = library
+      .lookupFunction<Void Function(Int), void Function(int)>(
+        'noop_set_frame_size',
+      );
+  final probe = VideoProbeFfi();
+
+  tearDownAll(() {
+    final out = Platform.environment['VIDEO_PROBE_BENCH_OUT'];
+    if (out == null || out.isEmpty) return;
+    File(out).writeAsStringSync(
+      const JsonEncoder.withIndent('  ').convert({
+        'version': 1,
+        'dart': Platform.version,
+        'results': [for (final result in _results) result.toJson()],
+      }),
+    );
+  });
+
+  group('native call', () {
+    test('sum', () => _measureSync('call/sum', () => bindings.sum(1, 2)));
+
+    test('get_duration', () {
+      final pathPtr = _path.toNativeUtf8();
+      return _measureSync(
+        'call/get_duration',
+        () => bindings.get_duration(pathPtr.cast()),
+      ).whenComplete(() => calloc.free(pathPtr));
+    });
+  });
+
+  group('marshaling', () {
+    test('path to UTF-8', () {
+      return _measureSync('marshal/path', () {
+        final pathPtr = _path.toNativeUtf8();
+        calloc.free(pathPtr);
+      });
+    });
+
+    test('media info struct', () {
+      final pathPtr = _path.toNativeUtf8();
+      return _measureSync('marshal/media_info', () {
+        final infoPtr = calloc<vp_media_info>();
+        bindings.probe_media_info(pathPtr.cast(), infoPtr);
+        bindings.free_media_info(infoPtr);
+        calloc.free(infoPtr);
+      }).whenComplete(() => calloc.free(pathPtr));
+    });
+  });
+
+  group('VideoProbeFfi', () {
+    test('getDuration', () {
+      return _measure('api/getDuration', () => probe.getDuration(_path));
+    });
+
+    test('getMediaInfo', () {
+      return _measure('api/getMediaInfo', () => probe.getMediaInfo(_path));
+    });
+
+    test('getMediaInfo in isolate', () {
+      return _measure(
+        'api/getMediaInfo/isolate',
+        () => probe.getMediaInfo(_path, timeout: const Duration(minutes: 1)),
+      );
+    });
+  });
+
+  // The raw call allocates and fills the frame natively; the gap to the
+  // API call is the Dart copy and its allocation
+  group('frames', () {
+    for (final MapEntry(key: label, value: size) in _frameSizes.entries) {
+      test(label, () async {
+        setFrameSize(size);
+        final pathPtr = _path.toNativeUtf8();
+        final sizePtr = calloc<Int>();
+        try {
+          await _measureSync('frame/raw/$label', () {
+            bindings.free_frame(
+              bindings.extract_frame(pathPtr.cast(), 0, sizePtr),
+            );
+          });
+          await _measure(
+            'frame/api/$label',
+            () => probe.extractFrame(_path, 0),
+          );
+          await _measure(
+            'frame/api/isolate/$label',
+            () => probe.extractFrame(
+              _path,
+              0,
+              timeout: const Duration(minutes: 1),
+            ),
+          );
+        } finally {
+          calloc.free(pathPtr);
+          calloc.free(sizePtr);
+          setFrameSize(100);
+        }
+      });
+    }
+  });
+}
@@ -0,0 +1,13 @@
+// The reference stub as a no-op backend for the Dart FFI benchmarks. Every
+// call returns canned results immediately, so what the benchmarks measure is
+// the Dart side: marshaling, copies and call overhead.
+
+static int noop_frame_size = 100;
+#define VP_STUB_FRAME_SIZE noop_frame_size
+
+#include "../../src/video_probe.c"
+
+// Sets the size of the frames extract_frame() returns.
+EXPORT void noop_set_frame_size(int size) {
+    noop_frame_size = size > 0 ? size : 1;
+}
@@ -171,6 +171,201 @@ void main() {
       }
       // If frames are null, test passes (expected in headless env)
     });
+
+    testWidgets('GStreamer getMediaInfo agrees with single probes', (
+      tester,
+    ) async {
+      if (!isLinux) {
+        return;
+      }
+
+      final info = await videoProbe.getMediaInfo(videoPath);
+      final duration = await videoProbe.getDuration(videoPath);
+
+      expect(info, isNotNull);
+      expect(info!.hasVideo, isTrue);
+      expect(info.width, greaterThan(0));
+      expect(info.height, greaterThan(0));
+      expect(info.videoStreams, isNotEmpty);
+      expect(info.duration, closeTo(duration, 0.001));
+    });
+
+    testWidgets('GStreamer getMediaInfo returns null for missing file', (
+      tester,
+    ) async {
+      if (!isLinux) {
+        return;
+      }
+
+      final info = await videoProbe.getMediaInfo('/nonexistent/video.mp4');
+      expect(info, isNull);
+    });
+
+    testWidgets('GStreamer probeBatch reports per-file status', (tester) async {
+      if (!isLinux) {
+        return;
+      }
+
+      final results = await videoProbe.probeBatch([
+        videoPath,
+        '/nonexistent/video.mp4',
+        videoPath,
+      ]);
+
+      expect(results.length, 3);
+      expect(results[0].isOk, isTrue);
+      expect(results[0].info!.hasVideo, isTrue);
+      expect(results[1].status, ProbeStatus.notFound);
+      expect(results[2].info!.duration, results[0].info!.duration);
+    });
+
+    testWidgets('GStreamer discoverMediaInfo streams every file', (
+      tester,
+    ) async {
+      if (!isLinux) {
+        return;
+      }
+
+      final results = await videoProbe.discoverMediaInfo([
+        videoPath,
+        '/nonexistent/video.mp4',
+        videoPath,
+      ], maxInFlight: 2).toList();
+
+      expect(results.length, 3);
+      final found = results.where((r) => r.path == videoPath).toList();
+      expect(found.length, 2);
+      expect(found.every((r) => r.isOk && r.info!.hasVideo), isTrue);
+      expect(
+        results.singleWhere((r) => r.path != videoPath).status,
+        ProbeStatus.notFound,
+      );
+    });
+
+    testWidgets('analyzeGop reads the keyframe structure', (tester) async {
+      if (!isLinux) {
+        return;
+      }
+
+      final gop = await videoProbe.analyzeGop(videoPath);
+
+      expect(gop, isNotNull);
+      expect(gop!.frameCount, greaterThan(0));
+      expect(gop.keyframeCount, greaterThan(0));
+      expect(gop.costs.length, gop.frameCount);
+      expect(gop.seekCost(Duration.zero)!.frames, 1);
+      expect(gop.seekFramesMax, lessThanOrEqualTo(gop.gopFramesMax * 2));
+      expect(await videoProbe.analyzeGop('/nonexistent/video.mp4'), isNull);
+    });
+
+    testWidgets('embedded thumbnails fall back to decoded frames', (
+      tester,
+    ) async {
+      if (!isLinux) {
+        return;
+      }
+
+      final results = await videoProbe.probeBatch(
+        [videoPath],
+        thumbnails: true,
+        preferEmbeddedThumbnails: true,
+      );
+      final stored = await videoProbe.getEmbeddedThumbnail(videoPath);
+
+      expect(results.single.thumbnail, isNotNull);
+      if (stored != null) {
+        expect(results.single.thumbnail, stored);
+      } else {
+        expect(results.single.thumbnail!.sublist(0, 2), [0xFF, 0xD8]);
+      }
+      expect(
+        await videoProbe.getEmbeddedThumbnail('/nonexistent/video.mp4'),
+        isNull,
+      );
+    });
+
+    testWidgets('GStreamer extractFrames returns frames in request order', (
+      tester,
+    ) async {
+      if (!isLinux) {
+        return;
+      }
+
+      final frameCount = await videoProbe.getFrameCount(videoPath);
+      final results = await videoProbe.extractFrames(videoPath, [
+        frameCount ~/ 2,
+        0,
+        frameCount ~/ 2,
+        frameCount * 10,
+      ]);
+
+      expect(results.map((r) => r.frameNum), [
+        frameCount ~/ 2,
+        0,
+        frameCount ~/ 2,
+        frameCount * 10,
+      ]);
+      expect(results[3].status, ProbeStatus.invalidArgument);
+      // In headless Docker decoding may fail; frames that do decode are
+      // JPEGs, and repeated frames are the same image
+      if (results[0].isOk && results[2].isOk) {
+        expect(results[0].data![0], equals(0xFF));
+        expect(results[2].data, equals(results[0].data));
+      }
+    });
+
+    testWidgets('GStreamer frameStream emits every step-th frame', (
+      tester,
+    ) async {
+      if (!isLinux) {
+        return;
+      }
+
+      try {
+        final frames = await videoProbe
+            .frameStream(videoPath, step: 10, endFrame: 50)
+            .toList();
+        expect(frames.map((f) => f.frameNum), [0, 10, 20, 30, 40]);
+        for (final frame in frames) {
+          expect(frame.data[0], equals(0xFF));
+        }
+      } on ProbeException {
+        // In headless Docker decoding may fail
+      }
+    });
+
+    testWidgets('GStreamer sampleFrames emits packed RGBA at the interval', (
+      tester,
+    ) async {
+      if (!isLinux) {
+        return;
+      }
+
+      try {
+        final batches = await videoProbe
+            .sampleFrames(
+              videoPath,
+              interval: const Duration(milliseconds: 500),
+              format: FrameFormat.rgba,
+              batchSize: 4,
+            )
+            .toList();
+        final frames = batches.expand((b) => b).toList();
+        expect(frames, isNotEmpty);
+        expect(batches.every((b) => b.isNotEmpty && b.length <= 4), isTrue);
+        expect(frames.first.timestamp, Duration.zero);
+        for (var i = 1; i < frames.length; i++) {
+          final gap = frames[i].timestamp - frames[i - 1].timestamp;
+          expect(gap.inMilliseconds, greaterThanOrEqualTo(400));
+        }
+        for (final frame in frames) {
+          expect(frame.format, FrameFormat.rgba);
+          expect(frame.data.length, frame.width * frame.height * 4);
+        }
+      } on ProbeException {
+        // In headless Docker decoding may fail
+      }
+    });
   });
 
   group('Platform Detection Tests', () {
@@ -0,0 +1,617 @@
+import 'dart:async';
+import 'dart:typed_data';
+
+/// Kinds of streams reported in [MediaStreamInfo.type].
+enum MediaStreamType { video, audio, subtitle }
+
+/// Metadata of a single elementary stream inside a media file.
+///
+/// Video-only fields are zero for audio and subtitle streams and vice versa.
+class MediaStreamInfo {
+  const MediaStreamInfo({
+    required this.type,
+    required this.codec,
+    this.language,
+    this.bitrate = 0,
+    this.width = 0,
+    this.height = 0,
+    this.pixelAspectNum = 1,
+    this.pixelAspectDen = 1,
+    this.frameRateNum = 0,
+    this.frameRateDen = 1,
+    this.rotation = 0,
+    this.bitDepth = 0,
+    this.colorPrimaries = 2,
+    this.transfer = 2,
+    this.isHdr = false,
+    this.channels = 0,
+    this.sampleRate = 0,
+  });
+
+  final MediaStreamType type;
+
+  /// Short codec name, e.g. `h264`, `hevc` or `aac`.
+  final String codec;
+
+  /// ISO 639 language code, if the container declares one.
+  final String? language;
+
+  /// Bits per second, 0 if unknown.
+  final int bitrate;
+
+  final int width;
+  final int height;
+  final int pixelAspectNum;
+  final int pixelAspectDen;
+  final int frameRateNum;
+  final int frameRateDen;
+
+  /// Clockwise display rotation in degrees.
+  final int rotation;
+
+  final int bitDepth;
+
+  /// ISO/IEC 23001-8 colour primaries code (1 = BT.709, 9 = BT.2020).
+  final int colorPrimaries;
+
+  /// ISO/IEC 23001-8 transfer characteristics code (16 = PQ, 18 = HLG).
+  final int transfer;
+
+  final bool isHdr;
+  final int channels;
+  final int sampleRate;
+
+  /// Frames per second, or 0 if unknown.
+  double get frameRate => frameRateDen > 0 ? frameRateNum / frameRateDen : 0.0;
+}
+
+/// Everything known about a media file, gathered in a single probe.
+///
+/// The top-level video fields describe the primary video stream, while
+/// [streams] lists every stream in the file, including that one.
+class VideoInfo {
+  const VideoInfo({
+    this.container,
+    required this.duration,
+    this.bitrate = 0,
+    this.frameCount = 0,
+    this.hasVideo = false,
+    this.videoCodec,
+    this.width = 0,
+    this.height = 0,
+    this.pixelAspectNum = 1,
+    this.pixelAspectDen = 1,
+    this.frameRateNum = 0,
+    this.frameRateDen = 1,
+    this.rotation = 0,
+    this.bitDepth = 0,
+    this.colorPrimaries = 2,
+    this.transfer = 2,
+    this.isHdr = false,
+    this.streams = const [],
+  });
+
+  /// Container media type, e.g. `video/quicktime`.
+  final String? container;
+
+  /// Duration in seconds.
+  final double duration;
+
+  /// Overall bits per second, 0 if unknown.
+  final int bitrate;
+
+  final int frameCount;
+  final bool hasVideo;
+  final String? videoCodec;
+  final int width;
+  final int height;
+  final int pixelAspectNum;
+  final int pixelAspectDen;
+  final int frameRateNum;
+  final int frameRateDen;
+
+  /// Clockwise display rotation in degrees.
+  final int rotation;
+
+  final int bitDepth;
+
+  /// ISO/IEC 23001-8 colour primaries code (1 = BT.709, 9 = BT.2020).
+  final int colorPrimaries;
+
+  /// ISO/IEC 23001-8 transfer characteristics code (16 = PQ, 18 = HLG).
+  final int transfer;
+
+  final bool isHdr;
+  final List<MediaStreamInfo> streams;
+
+  /// Frames per second of the primary video stream, or 0 if unknown.
+  double get frameRate => frameRateDen > 0 ? frameRateNum / frameRateDen : 0.0;
+
+  List<MediaStreamInfo> get videoStreams =>
+      streams.where((s) => s.type == MediaStreamType.video).toList();
+
+  List<MediaStreamInfo> get audioStreams =>
+      streams.where((s) => s.type == MediaStreamType.audio).toList();
+
+  List<MediaStreamInfo> get subtitleStreams =>
+      streams.where((s) => s.type == MediaStreamType.subtitle).toList();
+}
+
+/// Outcome of a native probe, mirroring the `VP_*` status codes.
+enum ProbeStatus {
+  ok(0),
+  invalidArgument(-1),
+  notFound(-2),
+  unsupported(-3),
+  failed(-4),
+  noMemory(-5),
+
+  /// Part of a partially downloaded file must arrive first.
+  needData(-6),
+
+  /// The call's [CancelToken] was cancelled.
+  cancelled(-7),
+
+  /// The call ran past its timeout.
+  timedOut(-8),
+
+  /// Decoding would not fit the memory budget, even downscaled; see
+  /// [VideoProbe.setMemoryBudget].
+  overBudget(-9),
+
+  /// A caller-provided buffer was too small for the frame.
+  bufferTooSmall(-10);
+
+  const ProbeStatus(this.code);
+
+  final int code;
+
+  static ProbeStatus fromCode(int code) => ProbeStatus.values.firstWhere(
+    (status) => status.code == code,
+    orElse: () => ProbeStatus.failed,
+  );
+}
+
+/// Result for one file of a batch probe.
+class BatchProbeResult {
+  const BatchProbeResult({
+    required this.path,
+    required this.status,
+    this.info,
+    this.thumbnail,
+  });
+
+  final String path;
+  final ProbeStatus status;
+
+  /// Metadata, present when [status] is [ProbeStatus.ok].
+  final VideoInfo? info;
+
+  /// JPEG thumbnail, present when requested and extraction succeeded. An
+  /// image stored in the file may be PNG.
+  final Uint8List? thumbnail;
+
+  bool get isOk => status == ProbeStatus.ok;
+}
+
+/// Result for one frame of [VideoProbe.extractFrames].
+class FrameResult {
+  const FrameResult({required this.frameNum, required this.status, this.data});
+
+  final int frameNum;
+  final ProbeStatus status;
+
+  /// JPEG bytes, present when [status] is [ProbeStatus.ok].
+  final Uint8List? data;
+
+  bool get isOk => status == ProbeStatus.ok;
+}
+
+/// Pixel format of frames from [VideoProbe.frameStream] and
+/// [VideoProbe.sampleFrames].
+enum FrameFormat {
+  /// JPEG at quality 90.
+  jpeg(0),
+
+  /// 8-bit RGBA rows of `width * 4` bytes without padding, e.g. for
+  /// `decodeImageFromPixels` or a model's input tensor.
+  rgba(1);
+
+  const FrameFormat(this.code);
+
+  final int code;
+}
+
+/// A decoded frame emitted by [VideoProbe.frameStream] and
+/// [VideoProbe.sampleFrames].
+class VideoFrame {
+  const VideoFrame({
+    required this.frameNum,
+    required this.timestamp,
+    required this.data,
+    this.width = 0,
+    this.height = 0,
+    this.format = FrameFormat.jpeg,
+  });
+
+  final int frameNum;
+
+  /// Presentation time of the frame.
+  final Duration timestamp;
+
+  /// Encoded as [format].
+  final Uint8List data;
+
+  final int width;
+  final int height;
+  final FrameFormat format;
+}
+
+/// A byte range of a file.
+class ByteRange {
+  const ByteRange(this.offset, this.length);
+
+  final int offset;
+  final int length;
+
+  /// Offset one past the last byte.
+  int get end => offset + length;
+
+  @override
+  bool operator ==(Object other) =>
+      other is ByteRange && other.offset == offset && other.length == length;
+
+  @override
+  int get hashCode => Object.hash(offset, length);
+
+  @override
+  String toString() => 'ByteRange($offset, $length)';
+}
+
+/// Result of probing a file that is still being downloaded.
+class PartialProbeResult {
+  const PartialProbeResult({
+    required this.status,
+    this.info,
+    this.neededRanges = const [],
+  });
+
+  final ProbeStatus status;
+
+  /// Metadata, present when [status] is [ProbeStatus.ok].
+  final VideoInfo? info;
+
+  /// Ranges to download before probing again, when [status] is
+  /// [ProbeStatus.needData].
+  final List<ByteRange> neededRanges;
+
+  bool get needsData => status == ProbeStatus.needData;
+}
+
+/// What showing one frame costs after a seek, see [GopInfo.seekCost].
+class SeekCost {
+  const SeekCost({
+    required this.position,
+    required this.keyframePosition,
+    required this.frames,
+    this.bytes = 0,
+  });
+
+  /// When the frame is shown.
+  final Duration position;
+
+  /// The keyframe an accurate seek to the frame decodes from; snapping to
+  /// it costs a single decode.
+  final Duration keyframePosition;
+
+  /// Frames decoded from the keyframe up to and including this one.
+  final int frames;
+
+  /// Coded size of those frames, 0 if the index has no sizes.
+  final int bytes;
+}
+
+/// Keyframe structure of a video track, from [VideoProbe.analyzeGop].
+class GopInfo {
+  const GopInfo({
+    required this.frameCount,
+    required this.keyframeCount,
+    this.allIntra = false,
+    this.hasBFrames = false,
+    this.openGop = false,
+    this.gopFramesMin = 0,
+    this.gopFramesP50 = 0,
+    this.gopFramesP90 = 0,
+    this.gopFramesMax = 0,
+    this.gopDurationMean = Duration.zero,
+    this.gopDurationMax = Duration.zero,
+    this.seekFramesMean = 0,
+    this.seekFramesMax = 0,
+    this.costs = const [],
+  });
+
+  final int frameCount;
+  final int keyframeCount;
+
+  /// Every frame is a keyframe (MJPEG, ProRes, ...), so accurate seeks are
+  /// as cheap as snapping.
+  final bool allIntra;
+
+  /// Frames are decoded in a different order than shown.
+  final bool hasBFrames;
+
+  /// Some GOP starts with frames shown before its keyframe; seeking to
+  /// them decodes the previous GOP as well.
+  final bool openGop;
+
+  /// Frames per GOP, keyframe to keyframe.
+  final int gopFramesMin;
+  final int gopFramesP50;
+  final int gopFramesP90;
+  final int gopFramesMax;
+
+  final Duration gopDurationMean;
+  final Duration gopDurationMax;
+
+  /// Frames decoded to show one frame, over every frame.
+  final double seekFramesMean;
+  final int seekFramesMax;
+
+  /// One entry per frame in presentation order.
+  final List<SeekCost> costs;
+
+  /// Cost of showing the frame at [position], i.e. the last frame shown
+  /// at or before it (the first frame for earlier positions), or null
+  /// without frames.
+  SeekCost? seekCost(Duration position) {
+    if (costs.isEmpty) return null;
+    var low = 0;
+    var high = costs.length - 1;
+    while (low < high) {
+      final mid = low + (high - low + 1) ~/ 2;
+      if (costs[mid].position <= position) {
+        low = mid;
+      } else {
+        high = mid - 1;
+      }
+    }
+    return costs[low];
+  }
+}
+
+/// How the native container parsers read local files.
+enum IoBackend {
+  /// io_uring where the kernel allows it, else [pread].
+  auto(0),
+
+  /// Positioned reads with readahead hints.
+  pread(1),
+
+  /// Memory-mapped files.
+  mmap(2),
+
+  /// Batched io_uring reads (Linux 5.1+).
+  ioUring(3);
+
+  const IoBackend(this.code);
+
+  final int code;
+}
+
+/// Process-wide local file I/O counters of the native container parsers.
+///
+/// Subtract two snapshots to measure the calls made in between.
+class IoStats {
+  const IoStats({
+    this.files = 0,
+    this.reads = 0,
+    this.bytesRead = 0,
+    this.bytesFetched = 0,
+    this.readSyscalls = 0,
+    this.hintSyscalls = 0,
+  });
+
+  final int files;
+
+  /// Read requests and bytes handed to the parsers.
+  final int reads;
+  final int bytesRead;
+
+  /// Bytes transferred from storage, including the prefetched head and
+  /// tail of each file.
+  final int bytesFetched;
+
+  /// Blocking read syscalls. Page faults of memory-mapped files are not
+  /// counted.
+  final int readSyscalls;
+
+  /// Readahead hints given to the kernel.
+  final int hintSyscalls;
+
+  IoStats operator -(IoStats other) => IoStats(
+    files: files - other.files,
+    reads: reads - other.reads,
+    bytesRead: bytesRead - other.bytesRead,
+    bytesFetched: bytesFetched - other.bytesFetched,
+    readSyscalls: readSyscalls - other.readSyscalls,
+    hintSyscalls: hintSyscalls - other.hintSyscalls,
+  );
+}
+
+/// Cancels the calls it is passed to.
+///
+/// Cancelled native work shuts its pipelines down and releases its
+/// resources within milliseconds; the calls then throw
+/// [ProbeCancelledException]. A token can be shared by several calls and
+/// cannot be reset.
+class CancelToken {
+  final _cancelled = Completer<void>();
+
+  bool get isCancelled => _cancelled.isCompleted;
+
+  /// Completes when [cancel] is called.
+  Future<void> get whenCancelled => _cancelled.future;
+
+  void cancel() {
+    if (!_cancelled.isCompleted) _cancelled.complete();
+  }
+}
+
+/// Thrown by a call that was cancelled through its [CancelToken] or ran
+/// past its timeout.
+class ProbeCancelledException implements Exception {
+  const ProbeCancelledException({this.timedOut = false});
+
+  /// Whether the timeout passed, rather than the token being cancelled.
+  final bool timedOut;
+
+  ProbeStatus get status =>
+      timedOut ? ProbeStatus.timedOut : ProbeStatus.cancelled;
+
+  @override
+  String toString() =>
+      'ProbeCancelledException: ${timedOut ? 'timed out' : 'cancelled'}';
+}
+
+/// Thrown by [VideoProbe.frameStream] and [VideoProbe.sampleFrames] when
+/// decoding fails part way.
+class ProbeException implements Exception {
+  const ProbeException(this.status);
+
+  final ProbeStatus status;
+
+  @override
+  String toString() => 'ProbeException: ${status.name}';
+}
+
+/// Scheduling class of a request, most urgent first.
+enum RequestPriority {
+  /// On screen now.
+  visible(0),
+
+  /// About to come on screen, e.g. just past the edge of a scrolling grid.
+  prefetch(1),
+
+  /// Runs only while nothing more urgent is waiting.
+  background(2);
+
+  const RequestPriority(this.code);
+
+  final int code;
+}
+
+/// A request queued on the native scheduler.
+class ScheduledRequest<T> {
+  const ScheduledRequest(this.id, this.result);
+
+  /// Identifies the request when changing its priority or cancelling it.
+  final int id;
+
+  /// Completes once the request finishes, fails, or is cancelled,
+  /// superseded on its slot or timed out. Never completes with an error.
+  final Future<ScheduledResult<T>> result;
+}
+
+/// Outcome of a [ScheduledRequest].
+class ScheduledResult<T> {
+  const ScheduledResult({
+    required this.status,
+    this.value,
+    this.queued = Duration.zero,
+    this.peakMemory = 0,
+  });
+
+  /// [ProbeStatus.cancelled] when cancelled or superseded on its slot.
+  final ProbeStatus status;
+
+  /// The result, present when [status] is [ProbeStatus.ok].
+  final T? value;
+
+  /// Time spent waiting for a worker.
+  final Duration queued;
+
+  /// Native memory attributed to the request's decode, in bytes.
+  final int peakMemory;
+
+  bool get isOk => status == ProbeStatus.ok;
+}
+
+/// Stages of probing and extraction timed by [VideoProbe.metrics].
+enum ProbeStage {
+  /// Native container parsing or a GStreamer discovery pass.
+  discovery(0),
+
+  /// Creating and linking the extraction pipeline.
+  pipelineBuild(1),
+
+  /// First transition to paused, up to the first prerolled frame.
+  preroll(2),
+
+  /// Flushing seek, up to the first buffer reaching the decoder.
+  seek(3),
+
+  /// Decoding, up to the first decoded frame.
+  decode(4),
+
+  /// Colorspace conversion.
+  convert(5),
+
+  /// JPEG encoding.
+  encode(6);
+
+  const ProbeStage(this.code);
+
+  final int code;
+}
+
+/// Latency distribution of one [ProbeStage].
+class StageMetrics {
+  const StageMetrics({
+    this.count = 0,
+    this.total = Duration.zero,
+    this.p50 = Duration.zero,
+    this.p90 = Duration.zero,
+    this.p99 = Duration.zero,
+  });
+
+  /// Completed runs of the stage.
+  final int count;
+  final Duration total;
+
+  /// Percentiles, within 1/16 of the exact value.
+  final Duration p50;
+  final Duration p90;
+  final Duration p99;
+
+  Duration get mean => count > 0 ? total ~/ count : Duration.zero;
+}
+
+/// Stage latencies and I/O counters of every native call in the process.
+class ProbeMetrics {
+  const ProbeMetrics({
+    this.stages = const {},
+    this.bytesRead = 0,
+    this.allocations = 0,
+    this.liveFrames = 0,
+    this.liveResults = 0,
+  });
+
+  final Map<ProbeStage, StageMetrics> stages;
+
+  /// Bytes handed to parsers and demuxers by the plugin's own readers.
+  /// Local files GStreamer opens itself are not counted.
+  final int bytesRead;
+
+  /// Heap allocations for results and parser state.
+  final int allocations;
+
+  /// Native frame buffers not yet freed. Current level, not reset.
+  final int liveFrames;
+
+  /// Native media info and batch results not yet freed, including those of
+  /// calls in progress. Current level, not reset.
+  final int liveResults;
+
+  StageMetrics operator [](ProbeStage stage) =>
+      stages[stage] ?? const StageMetrics();
+}
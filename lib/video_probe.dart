@@ -1,12 +1,15 @@
 
 import 'package:flutter/foundation.dart';
 
+import 'video_info.dart';
 import 'video_probe_platform_interface.dart';
 import 'video_probe_method_channel.dart';
 
 // Conditional import: only load FFI on non-web platforms
 import 'video_probe_ffi_stub.dart' if (dart.library.ffi) 'video_probe_ffi.dart';
 
+export 'video_info.dart';
+
 class VideoProbe {
   static bool _manualRegistrationDone = false;
 
@@ -26,6 +29,18 @@ class VideoProbe {
     _manualRegistrationDone = true;
   }
 
+  /// Answers calls through the platform channel instead of FFI, for apps
+  /// that cannot load the native library into the Dart VM.
+  ///
+  /// Only the Linux plugin implements the channel, for [getDuration],
+  /// [getFrameCount], [extractFrame] and [extractFrames]; it decodes on
+  /// worker threads, so the platform thread is never blocked. Other methods
+  /// throw [UnimplementedError].
+  static void useMethodChannel() {
+    VideoProbePlatform.instance = MethodChannelVideoProbe();
+    _manualRegistrationDone = true;
+  }
+
   Future<String?> getPlatformVersion() {
     return VideoProbePlatform.instance.getPlatformVersion();
   }
@@ -40,8 +55,499 @@ class VideoProbe {
     return VideoProbePlatform.instance.getFrameCount(path);
   }
 
-  Future<Uint8List?> extractFrame(String path, int frameNum) {
+  /// Decodes frame [frameNum] of [path] as a JPEG.
+  ///
+  /// Returns null if the frame cannot be extracted. See [getMediaInfo] for
+  /// [cancelToken] and [timeout].
+  Future<Uint8List?> extractFrame(
+    String path,
+    int frameNum, {
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) {
+    _ensureInitialized();
+    return VideoProbePlatform.instance.extractFrame(
+      path,
+      frameNum,
+      cancelToken: cancelToken,
+      timeout: timeout,
+    );
+  }
+
+  /// Probes container, video, audio and subtitle metadata in one pass.
+  ///
+  /// Returns null if the file cannot be probed. Cancelling [cancelToken]
+  /// or reaching [timeout] stops the native work and throws a
+  /// [ProbeCancelledException]; without a timeout each stage keeps its
+  /// built-in limit.
+  Future<VideoInfo?> getMediaInfo(
+    String path, {
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) {
+    _ensureInitialized();
+    return VideoProbePlatform.instance.getMediaInfo(
+      path,
+      cancelToken: cancelToken,
+      timeout: timeout,
+    );
+  }
+
+  /// Like [getMediaInfo], for a video held in memory.
+  ///
+  /// Nothing is written to disk; the bytes are read in place by the native
+  /// parser or streamed to the decoder.
+  Future<VideoInfo?> getMediaInfoFromBytes(
+    Uint8List bytes, {
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) {
+    _ensureInitialized();
+    return VideoProbePlatform.instance.getMediaInfoFromBytes(
+      bytes,
+      cancelToken: cancelToken,
+      timeout: timeout,
+    );
+  }
+
+  /// Like [extractFrame], for a video held in memory.
+  Future<Uint8List?> extractFrameFromBytes(
+    Uint8List bytes,
+    int frameNum, {
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) {
+    _ensureInitialized();
+    return VideoProbePlatform.instance.extractFrameFromBytes(
+      bytes,
+      frameNum,
+      cancelToken: cancelToken,
+      timeout: timeout,
+    );
+  }
+
+  /// Like [getMediaInfoFromBytes], for a video arriving as a byte stream,
+  /// e.g. an upload or a decrypting reader.
+  ///
+  /// The stream is consumed completely. Passing its total [length], when
+  /// known, avoids regrowing the buffer it is collected into.
+  Future<VideoInfo?> getMediaInfoFromStream(
+    Stream<List<int>> stream, {
+    int? length,
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) {
+    _ensureInitialized();
+    return VideoProbePlatform.instance.getMediaInfoFromStream(
+      stream,
+      length: length,
+      cancelToken: cancelToken,
+      timeout: timeout,
+    );
+  }
+
+  /// Like [extractFrameFromBytes], for a video arriving as a byte stream.
+  Future<Uint8List?> extractFrameFromStream(
+    Stream<List<int>> stream,
+    int frameNum, {
+    int? length,
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) {
+    _ensureInitialized();
+    return VideoProbePlatform.instance.extractFrameFromStream(
+      stream,
+      frameNum,
+      length: length,
+      cancelToken: cancelToken,
+      timeout: timeout,
+    );
+  }
+
+  /// Probes a video that is still being downloaded to [path].
+  ///
+  /// [totalSize] is the final size of the file. [available] lists the
+  /// ranges written so far; when omitted, the file is assumed to be
+  /// downloaded sequentially up to its current length. Metadata is returned
+  /// as soon as the bytes holding it are present, e.g. from the head and
+  /// tail of a file with its index at the end. Until then the result lists
+  /// the ranges to fetch next. Only MP4/MOV files are supported.
+  Future<PartialProbeResult> probePartial(
+    String path, {
+    required int totalSize,
+    List<ByteRange>? available,
+  }) {
+    _ensureInitialized();
+    return VideoProbePlatform.instance.probePartial(
+      path,
+      totalSize: totalSize,
+      available: available,
+    );
+  }
+
+  /// The ranges [probePartial] still needs, so a downloader can fetch them
+  /// first. Empty once the metadata is available.
+  ///
+  /// Throws an [ArgumentError] if the file cannot be probed while partial,
+  /// e.g. because it is not MP4/MOV; download it sequentially instead.
+  Future<List<ByteRange>> getNeededRanges(
+    String path, {
+    required int totalSize,
+    List<ByteRange>? available,
+  }) {
+    _ensureInitialized();
+    return VideoProbePlatform.instance.getNeededRanges(
+      path,
+      totalSize: totalSize,
+      available: available,
+    );
+  }
+
+  /// Probes many files at once on native worker threads.
+  ///
+  /// Results are returned in the order of [paths], each with its own
+  /// status. With [thumbnails] set, a JPEG of frame [thumbnailFrame] is
+  /// extracted for every file with a video stream. With
+  /// [preferEmbeddedThumbnails] also set, files that store cover art or a
+  /// camera thumbnail return that image instead (see
+  /// [getEmbeddedThumbnail]), audio files included, and only the others
+  /// are decoded. [maxWorkers] of 0 uses one worker per CPU core.
+  ///
+  /// Cancelling [cancelToken] or reaching [timeout] stops the files still
+  /// in progress; they and the ones not started yet report
+  /// [ProbeStatus.cancelled] or [ProbeStatus.timedOut].
+  Future<List<BatchProbeResult>> probeBatch(
+    List<String> paths, {
+    bool thumbnails = false,
+    int thumbnailFrame = 0,
+    bool preferEmbeddedThumbnails = false,
+    int maxWorkers = 0,
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) {
+    _ensureInitialized();
+    return VideoProbePlatform.instance.probeBatch(
+      paths,
+      thumbnails: thumbnails,
+      thumbnailFrame: thumbnailFrame,
+      preferEmbeddedThumbnails: preferEmbeddedThumbnails,
+      maxWorkers: maxWorkers,
+      cancelToken: cancelToken,
+      timeout: timeout,
+    );
+  }
+
+  /// Reads the media info of many files or URIs through one long-lived
+  /// platform discovery service (GStreamer's GstDiscoverer on Linux),
+  /// keeping up to [maxInFlight] discoveries running at once (0 for 4).
+  ///
+  /// Results are emitted as each file finishes, not in the order of
+  /// [paths]. Unlike [probeBatch] the native container parser is skipped,
+  /// so this suits formats it does not read and network URIs. [timeout]
+  /// bounds each file (1 s to 1 h, 5 s by default).
+  ///
+  /// Cancelling [cancelToken] reports the files not done yet as
+  /// [ProbeStatus.cancelled]; cancelling the subscription drops them.
+  Stream<BatchProbeResult> discoverMediaInfo(
+    List<String> paths, {
+    int maxInFlight = 0,
+    Duration? timeout,
+    CancelToken? cancelToken,
+  }) {
+    _ensureInitialized();
+    return VideoProbePlatform.instance.discoverMediaInfo(
+      paths,
+      maxInFlight: maxInFlight,
+      timeout: timeout,
+      cancelToken: cancelToken,
+    );
+  }
+
+  /// Reads the keyframe structure of [path] from its container index,
+  /// without decoding: GOP lengths, B-frames, open GOPs, and what an
+  /// accurate seek to each frame costs, e.g. to decide between accurate
+  /// seeks and snapping to the nearest keyframe.
+  ///
+  /// An all-intra file shows any frame after one decode; a file with
+  /// 10 second GOPs may need hundreds. Returns null for containers without
+  /// a native index parser (only MP4/MOV for now).
+  Future<GopInfo?> analyzeGop(
+    String path, {
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) {
+    _ensureInitialized();
+    return VideoProbePlatform.instance.analyzeGop(
+      path,
+      cancelToken: cancelToken,
+      timeout: timeout,
+    );
+  }
+
+  /// Returns the cover art or camera thumbnail stored in [path], as JPEG or
+  /// PNG bytes, or null if the file stores none.
+  ///
+  /// The native container parsers read the image straight from the file
+  /// (`covr` in MP4/MOV/M4V metadata, Canon thumbnails, Matroska/WebM cover
+  /// attachments) without starting a decoder, so this is much cheaper than
+  /// [extractFrame] for library grids.
+  Future<Uint8List?> getEmbeddedThumbnail(
+    String path, {
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) {
+    _ensureInitialized();
+    return VideoProbePlatform.instance.getEmbeddedThumbnail(
+      path,
+      cancelToken: cancelToken,
+      timeout: timeout,
+    );
+  }
+
+  /// Selects how the native parsers read local files from now on.
+  ///
+  /// Returns false if [backend] is not available on this system, e.g.
+  /// io_uring on an old kernel or under a seccomp policy that blocks it.
+  Future<bool> setIoBackend(IoBackend backend) {
+    _ensureInitialized();
+    return VideoProbePlatform.instance.setIoBackend(backend);
+  }
+
+  /// Local file I/O counters of the native parsers since startup.
+  Future<IoStats> getIoStats() {
+    _ensureInitialized();
+    return VideoProbePlatform.instance.getIoStats();
+  }
+
+  /// Per-stage latency percentiles and I/O counters over every native call
+  /// since startup or the last reset, e.g. for production dashboards.
+  ///
+  /// With [reset], the next snapshot only covers calls made after this
+  /// one.
+  Future<ProbeMetrics> metrics({bool reset = false}) {
+    _ensureInitialized();
+    return VideoProbePlatform.instance.metrics(reset: reset);
+  }
+
+  /// Starts recording a timeline of native activity: every stage of
+  /// discovery and extraction, GStreamer state changes and bus waits, per
+  /// thread.
+  ///
+  /// Keeps the newest [capacity] spans (0 for the native default of
+  /// 65536). Returns false if [capacity] is out of range.
+  Future<bool> startTracing({int capacity = 0}) {
+    _ensureInitialized();
+    return VideoProbePlatform.instance.startTracing(capacity: capacity);
+  }
+
+  /// Stops recording and returns the timeline as Chrome trace event JSON,
+  /// to open in Perfetto (ui.perfetto.dev) or chrome://tracing.
+  Future<String> stopTracing() {
+    _ensureInitialized();
+    return VideoProbePlatform.instance.stopTracing();
+  }
+
+  /// Limits the native memory decoding may use, in bytes; 0 is unlimited.
+  ///
+  /// [global] caps all decodes running at once, [perRequest] each call.
+  /// Decodes that would not fit run single-threaded, then downscaled before
+  /// JPEG encoding; those that still do not fit fail early with
+  /// [ProbeStatus.overBudget] instead of growing the process. Returns false
+  /// for negative budgets.
+  Future<bool> setMemoryBudget({int global = 0, int perRequest = 0}) {
+    _ensureInitialized();
+    return VideoProbePlatform.instance.setMemoryBudget(
+      global: global,
+      perRequest: perRequest,
+    );
+  }
+
+  /// Caps the native memory kept to reuse freed frame buffers (32 MiB by
+  /// default), so steady extraction does not allocate per frame. 0 turns
+  /// the pool off and releases it. Returns false for a negative limit.
+  Future<bool> setFramePoolLimit(int bytes) {
+    _ensureInitialized();
+    return VideoProbePlatform.instance.setFramePoolLimit(bytes);
+  }
+
+  /// Starts initializing the native decoder framework on a background
+  /// thread, e.g. at app launch, so the first probe or thumbnail does not
+  /// wait for GStreamer's plugin registry and decoder loading. Calls made
+  /// before it finishes wait only as long as they would have anyway.
+  /// Returns false if the thread could not be started.
+  Future<bool> warmup() {
+    _ensureInitialized();
+    return VideoProbePlatform.instance.warmup();
+  }
+
+  /// Loads only the named GStreamer [plugins] (e.g. `isomp4`, `matroska`,
+  /// `libav`, `videoparsersbad`) besides those the library's own pipelines
+  /// need, so unused formats and hardware decoders are never loaded. An
+  /// empty list allows every plugin.
+  ///
+  /// Must be called before anything else initializes GStreamer, including
+  /// [warmup]; returns false afterwards.
+  Future<bool> setPluginAllowlist(List<String> plugins) {
+    _ensureInitialized();
+    return VideoProbePlatform.instance.setPluginAllowlist(plugins);
+  }
+
+  /// Extracts several frames of [path] as JPEGs in one call, e.g. for a
+  /// storyboard or scrubbing previews.
+  ///
+  /// Results are returned in the order of [frameNums], each with its own
+  /// status; a repeated frame number shares the same bytes. Frames are
+  /// decoded in runs that start from the same keyframe, one seek per run,
+  /// and runs are spread over [maxWorkers] parallel pipelines (0 for one
+  /// per CPU core). [decoderThreads] sets the threads of each decoder; 0
+  /// splits the cores between the pipelines.
+  ///
+  /// Throws [ProbeCancelledException] if [cancelToken] is cancelled or
+  /// [timeout] passes before the video could be opened; frames not decoded
+  /// by then report [ProbeStatus.cancelled] or [ProbeStatus.timedOut].
+  Future<List<FrameResult>> extractFrames(
+    String path,
+    List<int> frameNums, {
+    int maxWorkers = 0,
+    int decoderThreads = 0,
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) {
+    _ensureInitialized();
+    return VideoProbePlatform.instance.extractFrames(
+      path,
+      frameNums,
+      maxWorkers: maxWorkers,
+      decoderThreads: decoderThreads,
+      cancelToken: cancelToken,
+      timeout: timeout,
+    );
+  }
+
+  /// Decodes [path] in one linear pass, emitting every [step]-th frame from
+  /// [startFrame] up to (not including) [endFrame], or to the end of the
+  /// video, e.g. to feed a model.
+  ///
+  /// Frames come from one long-lived native pipeline that decodes at most
+  /// [queueSize] frames ahead (0 for 4). Pausing the subscription stops
+  /// asking for frames, so the decoder waits once the queue is full rather
+  /// than buffering the whole video. Skipped frames are decoded but never
+  /// converted or encoded.
+  ///
+  /// The stream ends with a [ProbeException] if decoding fails, or a
+  /// [ProbeCancelledException] once [cancelToken] is cancelled.
+  Stream<VideoFrame> frameStream(
+    String path, {
+    int startFrame = 0,
+    int step = 1,
+    int? endFrame,
+    int queueSize = 0,
+    CancelToken? cancelToken,
+  }) {
+    _ensureInitialized();
+    return VideoProbePlatform.instance.frameStream(
+      path,
+      startFrame: startFrame,
+      step: step,
+      endFrame: endFrame,
+      queueSize: queueSize,
+      cancelToken: cancelToken,
+    );
+  }
+
+  /// Decodes [path] in one linear pass like [frameStream], emitting the
+  /// frame showing every [interval] from [startFrame], e.g. one frame per
+  /// second for a scene index or a model.
+  ///
+  /// Frames between samples are dropped before conversion; for MP4, those
+  /// the container index shows no sample depends on are not decoded at
+  /// all, so sparse sampling of long GOPs costs far less than a full
+  /// decode. [format] picks JPEG or raw RGBA frames, which skip encoding.
+  ///
+  /// Frames arrive in lists of up to [batchSize]: each list holds the next
+  /// frame plus those already decoded, so a slow consumer gets fewer,
+  /// fuller lists instead of one event per frame. Backpressure, errors and
+  /// cancellation work as for [frameStream].
+  Stream<List<VideoFrame>> sampleFrames(
+    String path, {
+    Duration interval = const Duration(seconds: 1),
+    int startFrame = 0,
+    int? endFrame,
+    FrameFormat format = FrameFormat.jpeg,
+    int batchSize = 1,
+    int queueSize = 0,
+    CancelToken? cancelToken,
+  }) {
+    _ensureInitialized();
+    return VideoProbePlatform.instance.sampleFrames(
+      path,
+      interval: interval,
+      startFrame: startFrame,
+      endFrame: endFrame,
+      format: format,
+      batchSize: batchSize,
+      queueSize: queueSize,
+      cancelToken: cancelToken,
+    );
+  }
+
+  /// Queues extraction of frame [frameNum] of [path] on the native
+  /// scheduler, e.g. for a thumbnail grid.
+  ///
+  /// Workers always take the oldest request of the most urgent [priority]
+  /// first. [slot] names the view position the frame is for, such as a grid
+  /// index: a later request on the same slot supersedes this one, which is
+  /// then dropped, or cancelled if already running. The [timeout] counts
+  /// from now, so it includes the time spent queued. With
+  /// [preferEmbeddedThumbnail] set, a file that stores cover art or a
+  /// camera thumbnail returns that image, which may be PNG, instead of the
+  /// frame (see [getEmbeddedThumbnail]).
+  ScheduledRequest<Uint8List> scheduleFrame(
+    String path,
+    int frameNum, {
+    RequestPriority priority = RequestPriority.visible,
+    int? slot,
+    Duration? timeout,
+    bool preferEmbeddedThumbnail = false,
+  }) {
+    _ensureInitialized();
+    return VideoProbePlatform.instance.scheduleFrame(
+      path,
+      frameNum,
+      priority: priority,
+      slot: slot,
+      timeout: timeout,
+      preferEmbeddedThumbnail: preferEmbeddedThumbnail,
+    );
+  }
+
+  /// Like [scheduleFrame], probing [path] with [getMediaInfo].
+  ScheduledRequest<VideoInfo> scheduleMediaInfo(
+    String path, {
+    RequestPriority priority = RequestPriority.visible,
+    int? slot,
+    Duration? timeout,
+  }) {
+    _ensureInitialized();
+    return VideoProbePlatform.instance.scheduleMediaInfo(
+      path,
+      priority: priority,
+      slot: slot,
+      timeout: timeout,
+    );
+  }
+
+  /// Moves a queued request to another priority class, e.g. when its cell
+  /// scrolls into or out of view. Returns false once it has started.
+  Future<bool> setRequestPriority(int id, RequestPriority priority) {
+    _ensureInitialized();
+    return VideoProbePlatform.instance.setRequestPriority(id, priority);
+  }
+
+  /// Cancels a queued or running request. Returns false once it has
+  /// finished.
+  Future<bool> cancelRequest(int id) {
     _ensureInitialized();
-    return VideoProbePlatform.instance.extractFrame(path, frameNum);
+    return VideoProbePlatform.instance.cancelRequest(id);
   }
 }
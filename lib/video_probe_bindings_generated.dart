@@ -94,7 +94,8 @@ class VideoProbeBindings {
         )
       >();
 
-  /// Frees the buffer returned by extract_frame.
+  /// Frees the buffer returned by extract_frame. Freed buffers are pooled and
+  /// reused by later extractions, see set_frame_pool_limit().
   void free_frame(ffi.Pointer<ffi.Uint8> buffer) {
     return _free_frame(buffer);
   }
@@ -105,4 +106,1933 @@ class VideoProbeBindings {
       );
   late final _free_frame = _free_framePtr
       .asFunction<void Function(ffi.Pointer<ffi.Uint8>)>();
+
+  /// Probes container, video, audio and subtitle metadata in a single pass.
+  /// Fills *out on success; the caller must release it with free_media_info().
+  /// Returns VP_OK or a VP_ERROR_* code. *out is zeroed on error.
+  int probe_media_info(
+    ffi.Pointer<ffi.Char> path,
+    ffi.Pointer<vp_media_info> out,
+  ) {
+    return _probe_media_info(path, out);
+  }
+
+  late final _probe_media_infoPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Int Function(ffi.Pointer<ffi.Char>, ffi.Pointer<vp_media_info>)
+        >
+      >('probe_media_info');
+  late final _probe_media_info = _probe_media_infoPtr
+      .asFunction<
+        int Function(ffi.Pointer<ffi.Char>, ffi.Pointer<vp_media_info>)
+      >();
+
+  /// Releases the memory held by a vp_media_info filled by probe_media_info().
+  void free_media_info(ffi.Pointer<vp_media_info> info) {
+    return _free_media_info(info);
+  }
+
+  late final _free_media_infoPtr =
+      _lookup<ffi.NativeFunction<ffi.Void Function(ffi.Pointer<vp_media_info>)>>(
+        'free_media_info',
+      );
+  late final _free_media_info = _free_media_infoPtr
+      .asFunction<void Function(ffi.Pointer<vp_media_info>)>();
+
+  /// Like probe_media_info(), reading from `size` bytes at `data` instead of
+  /// a file. The buffer is only read during the call and is not copied.
+  int probe_media_info_buffer(
+    ffi.Pointer<ffi.Uint8> data,
+    int size,
+    ffi.Pointer<vp_media_info> out,
+  ) {
+    return _probe_media_info_buffer(data, size, out);
+  }
+
+  late final _probe_media_info_bufferPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Int Function(
+            ffi.Pointer<ffi.Uint8>,
+            ffi.Int64,
+            ffi.Pointer<vp_media_info>,
+          )
+        >
+      >('probe_media_info_buffer');
+  late final _probe_media_info_buffer = _probe_media_info_bufferPtr
+      .asFunction<
+        int Function(ffi.Pointer<ffi.Uint8>, int, ffi.Pointer<vp_media_info>)
+      >();
+
+  /// Like probe_media_info(), reading through caller-supplied callbacks.
+  int probe_media_info_io(
+    ffi.Pointer<vp_io_callbacks> io,
+    ffi.Pointer<vp_media_info> out,
+  ) {
+    return _probe_media_info_io(io, out);
+  }
+
+  late final _probe_media_info_ioPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Int Function(
+            ffi.Pointer<vp_io_callbacks>,
+            ffi.Pointer<vp_media_info>,
+          )
+        >
+      >('probe_media_info_io');
+  late final _probe_media_info_io = _probe_media_info_ioPtr
+      .asFunction<
+        int Function(ffi.Pointer<vp_io_callbacks>, ffi.Pointer<vp_media_info>)
+      >();
+
+  /// Like extract_frame(), decoding from `size` bytes at `data`.
+  /// Release the result with free_frame().
+  ffi.Pointer<ffi.Uint8> extract_frame_buffer(
+    ffi.Pointer<ffi.Uint8> data,
+    int size,
+    int frameNum,
+    ffi.Pointer<ffi.Int> outSize,
+  ) {
+    return _extract_frame_buffer(data, size, frameNum, outSize);
+  }
+
+  late final _extract_frame_bufferPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Pointer<ffi.Uint8> Function(
+            ffi.Pointer<ffi.Uint8>,
+            ffi.Int64,
+            ffi.Int,
+            ffi.Pointer<ffi.Int>,
+          )
+        >
+      >('extract_frame_buffer');
+  late final _extract_frame_buffer = _extract_frame_bufferPtr
+      .asFunction<
+        ffi.Pointer<ffi.Uint8> Function(
+          ffi.Pointer<ffi.Uint8>,
+          int,
+          int,
+          ffi.Pointer<ffi.Int>,
+        )
+      >();
+
+  /// Like extract_frame(), decoding through caller-supplied callbacks.
+  /// Release the result with free_frame().
+  ffi.Pointer<ffi.Uint8> extract_frame_io(
+    ffi.Pointer<vp_io_callbacks> io,
+    int frameNum,
+    ffi.Pointer<ffi.Int> outSize,
+  ) {
+    return _extract_frame_io(io, frameNum, outSize);
+  }
+
+  late final _extract_frame_ioPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Pointer<ffi.Uint8> Function(
+            ffi.Pointer<vp_io_callbacks>,
+            ffi.Int,
+            ffi.Pointer<ffi.Int>,
+          )
+        >
+      >('extract_frame_io');
+  late final _extract_frame_io = _extract_frame_ioPtr
+      .asFunction<
+        ffi.Pointer<ffi.Uint8> Function(
+          ffi.Pointer<vp_io_callbacks>,
+          int,
+          ffi.Pointer<ffi.Int>,
+        )
+      >();
+
+  /// Probes a file that is still being downloaded.
+  /// `path` holds the bytes received so far at their final offsets, either
+  /// written sequentially or into a sparse file of `total_size` bytes.
+  /// `available` lists the ranges already written; if NULL, the first
+  /// (current file length) bytes are taken as present.
+  /// Returns VP_OK as soon as the metadata can be read from the present
+  /// ranges. Otherwise returns VP_ERROR_NEED_DATA and writes the ranges still
+  /// missing to `needed` (up to `needed_capacity`), with the total number in
+  /// *needed_count. Only MP4/MOV is supported; other formats return
+  /// VP_ERROR_UNSUPPORTED once their header is present.
+  int probe_media_info_partial(
+    ffi.Pointer<ffi.Char> path,
+    int total_size,
+    ffi.Pointer<vp_byte_range> available,
+    int available_count,
+    ffi.Pointer<vp_media_info> out,
+    ffi.Pointer<vp_byte_range> needed,
+    int needed_capacity,
+    ffi.Pointer<ffi.Int> needed_count,
+  ) {
+    return _probe_media_info_partial(
+      path,
+      total_size,
+      available,
+      available_count,
+      out,
+      needed,
+      needed_capacity,
+      needed_count,
+    );
+  }
+
+  late final _probe_media_info_partialPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Int Function(
+            ffi.Pointer<ffi.Char>,
+            ffi.Int64,
+            ffi.Pointer<vp_byte_range>,
+            ffi.Int,
+            ffi.Pointer<vp_media_info>,
+            ffi.Pointer<vp_byte_range>,
+            ffi.Int,
+            ffi.Pointer<ffi.Int>,
+          )
+        >
+      >('probe_media_info_partial');
+  late final _probe_media_info_partial = _probe_media_info_partialPtr
+      .asFunction<
+        int Function(
+          ffi.Pointer<ffi.Char>,
+          int,
+          ffi.Pointer<vp_byte_range>,
+          int,
+          ffi.Pointer<vp_media_info>,
+          ffi.Pointer<vp_byte_range>,
+          int,
+          ffi.Pointer<ffi.Int>,
+        )
+      >();
+
+  /// Reports the ranges probe_media_info_partial() still needs, so downloads
+  /// can fetch them first. Returns VP_OK with *needed_count == 0 once
+  /// everything is present.
+  int probe_needed_ranges(
+    ffi.Pointer<ffi.Char> path,
+    int total_size,
+    ffi.Pointer<vp_byte_range> available,
+    int available_count,
+    ffi.Pointer<vp_byte_range> needed,
+    int needed_capacity,
+    ffi.Pointer<ffi.Int> needed_count,
+  ) {
+    return _probe_needed_ranges(
+      path,
+      total_size,
+      available,
+      available_count,
+      needed,
+      needed_capacity,
+      needed_count,
+    );
+  }
+
+  late final _probe_needed_rangesPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Int Function(
+            ffi.Pointer<ffi.Char>,
+            ffi.Int64,
+            ffi.Pointer<vp_byte_range>,
+            ffi.Int,
+            ffi.Pointer<vp_byte_range>,
+            ffi.Int,
+            ffi.Pointer<ffi.Int>,
+          )
+        >
+      >('probe_needed_ranges');
+  late final _probe_needed_ranges = _probe_needed_rangesPtr
+      .asFunction<
+        int Function(
+          ffi.Pointer<ffi.Char>,
+          int,
+          ffi.Pointer<vp_byte_range>,
+          int,
+          ffi.Pointer<vp_byte_range>,
+          int,
+          ffi.Pointer<ffi.Int>,
+        )
+      >();
+
+  /// Probes `count` files in parallel on native worker threads.
+  /// options may be NULL for defaults. Fills *out with one item per path, all
+  /// allocated from a single arena; release it with free_batch_result().
+  /// Returns VP_OK unless the arguments are invalid; per-file failures are
+  /// reported in each item's status.
+  int probe_batch(
+    ffi.Pointer<ffi.Pointer<ffi.Char>> paths,
+    int count,
+    ffi.Pointer<vp_batch_options> options,
+    ffi.Pointer<vp_batch_result> out,
+  ) {
+    return _probe_batch(paths, count, options, out);
+  }
+
+  late final _probe_batchPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Int Function(
+            ffi.Pointer<ffi.Pointer<ffi.Char>>,
+            ffi.Int,
+            ffi.Pointer<vp_batch_options>,
+            ffi.Pointer<vp_batch_result>,
+          )
+        >
+      >('probe_batch');
+  late final _probe_batch = _probe_batchPtr
+      .asFunction<
+        int Function(
+          ffi.Pointer<ffi.Pointer<ffi.Char>>,
+          int,
+          ffi.Pointer<vp_batch_options>,
+          ffi.Pointer<vp_batch_result>,
+        )
+      >();
+
+  /// Releases everything held by a vp_batch_result filled by probe_batch().
+  void free_batch_result(ffi.Pointer<vp_batch_result> result) {
+    return _free_batch_result(result);
+  }
+
+  late final _free_batch_resultPtr =
+      _lookup<
+        ffi.NativeFunction<ffi.Void Function(ffi.Pointer<vp_batch_result>)>
+      >('free_batch_result');
+  late final _free_batch_result = _free_batch_resultPtr
+      .asFunction<void Function(ffi.Pointer<vp_batch_result>)>();
+
+  /// Selects how the native container parsers read local files from now on.
+  /// Returns VP_OK, VP_ERROR_UNSUPPORTED if the backend is not available on
+  /// this system, or VP_ERROR_INVALID_ARGUMENT.
+  int set_io_backend(int backend) {
+    return _set_io_backend(backend);
+  }
+
+  late final _set_io_backendPtr =
+      _lookup<ffi.NativeFunction<ffi.Int Function(ffi.Int)>>('set_io_backend');
+  late final _set_io_backend = _set_io_backendPtr
+      .asFunction<int Function(int)>();
+
+  /// Fills *out with the process-wide I/O counters since startup. Diff two
+  /// snapshots to measure a single call.
+  void get_io_stats(ffi.Pointer<vp_io_stats> out) {
+    return _get_io_stats(out);
+  }
+
+  late final _get_io_statsPtr =
+      _lookup<ffi.NativeFunction<ffi.Void Function(ffi.Pointer<vp_io_stats>)>>(
+        'get_io_stats',
+      );
+  late final _get_io_stats = _get_io_statsPtr
+      .asFunction<void Function(ffi.Pointer<vp_io_stats>)>();
+
+  /// Creates a cancellation token. Release it with cancel_token_free() once
+  /// no call using it is running.
+  ffi.Pointer<vp_cancel_token> cancel_token_new() {
+    return _cancel_token_new();
+  }
+
+  late final _cancel_token_newPtr =
+      _lookup<ffi.NativeFunction<ffi.Pointer<vp_cancel_token> Function()>>(
+        'cancel_token_new',
+      );
+  late final _cancel_token_new = _cancel_token_newPtr
+      .asFunction<ffi.Pointer<vp_cancel_token> Function()>();
+
+  /// Cancels every running and future call given `token`. Thread-safe and
+  /// idempotent; calls notice within milliseconds.
+  void cancel_token_cancel(ffi.Pointer<vp_cancel_token> token) {
+    return _cancel_token_cancel(token);
+  }
+
+  late final _cancel_token_cancelPtr =
+      _lookup<
+        ffi.NativeFunction<ffi.Void Function(ffi.Pointer<vp_cancel_token>)>
+      >('cancel_token_cancel');
+  late final _cancel_token_cancel = _cancel_token_cancelPtr
+      .asFunction<void Function(ffi.Pointer<vp_cancel_token>)>();
+
+  int cancel_token_is_cancelled(ffi.Pointer<vp_cancel_token> token) {
+    return _cancel_token_is_cancelled(token);
+  }
+
+  late final _cancel_token_is_cancelledPtr =
+      _lookup<
+        ffi.NativeFunction<ffi.Int Function(ffi.Pointer<vp_cancel_token>)>
+      >('cancel_token_is_cancelled');
+  late final _cancel_token_is_cancelled = _cancel_token_is_cancelledPtr
+      .asFunction<int Function(ffi.Pointer<vp_cancel_token>)>();
+
+  void cancel_token_free(ffi.Pointer<vp_cancel_token> token) {
+    return _cancel_token_free(token);
+  }
+
+  late final _cancel_token_freePtr =
+      _lookup<
+        ffi.NativeFunction<ffi.Void Function(ffi.Pointer<vp_cancel_token>)>
+      >('cancel_token_free');
+  late final _cancel_token_free = _cancel_token_freePtr
+      .asFunction<void Function(ffi.Pointer<vp_cancel_token>)>();
+
+  /// probe_media_info() with a deadline and cancellation; options may be NULL.
+  int probe_media_info_ex(
+    ffi.Pointer<ffi.Char> path,
+    ffi.Pointer<vp_call_options> options,
+    ffi.Pointer<vp_media_info> out,
+  ) {
+    return _probe_media_info_ex(path, options, out);
+  }
+
+  late final _probe_media_info_exPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Int Function(
+            ffi.Pointer<ffi.Char>,
+            ffi.Pointer<vp_call_options>,
+            ffi.Pointer<vp_media_info>,
+          )
+        >
+      >('probe_media_info_ex');
+  late final _probe_media_info_ex = _probe_media_info_exPtr
+      .asFunction<
+        int Function(
+          ffi.Pointer<ffi.Char>,
+          ffi.Pointer<vp_call_options>,
+          ffi.Pointer<vp_media_info>,
+        )
+      >();
+
+  /// probe_media_info_buffer() with a deadline and cancellation.
+  int probe_media_info_buffer_ex(
+    ffi.Pointer<ffi.Uint8> data,
+    int size,
+    ffi.Pointer<vp_call_options> options,
+    ffi.Pointer<vp_media_info> out,
+  ) {
+    return _probe_media_info_buffer_ex(data, size, options, out);
+  }
+
+  late final _probe_media_info_buffer_exPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Int Function(
+            ffi.Pointer<ffi.Uint8>,
+            ffi.Int64,
+            ffi.Pointer<vp_call_options>,
+            ffi.Pointer<vp_media_info>,
+          )
+        >
+      >('probe_media_info_buffer_ex');
+  late final _probe_media_info_buffer_ex = _probe_media_info_buffer_exPtr
+      .asFunction<
+        int Function(
+          ffi.Pointer<ffi.Uint8>,
+          int,
+          ffi.Pointer<vp_call_options>,
+          ffi.Pointer<vp_media_info>,
+        )
+      >();
+
+  /// probe_media_info_io() with a deadline and cancellation.
+  int probe_media_info_io_ex(
+    ffi.Pointer<vp_io_callbacks> io,
+    ffi.Pointer<vp_call_options> options,
+    ffi.Pointer<vp_media_info> out,
+  ) {
+    return _probe_media_info_io_ex(io, options, out);
+  }
+
+  late final _probe_media_info_io_exPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Int Function(
+            ffi.Pointer<vp_io_callbacks>,
+            ffi.Pointer<vp_call_options>,
+            ffi.Pointer<vp_media_info>,
+          )
+        >
+      >('probe_media_info_io_ex');
+  late final _probe_media_info_io_ex = _probe_media_info_io_exPtr
+      .asFunction<
+        int Function(
+          ffi.Pointer<vp_io_callbacks>,
+          ffi.Pointer<vp_call_options>,
+          ffi.Pointer<vp_media_info>,
+        )
+      >();
+
+  /// extract_frame() with a deadline and cancellation. On VP_OK, *out holds a
+  /// JPEG of *outSize bytes to release with free_frame(); otherwise *out is
+  /// NULL and the status says why.
+  int extract_frame_ex(
+    ffi.Pointer<ffi.Char> path,
+    int frameNum,
+    ffi.Pointer<vp_call_options> options,
+    ffi.Pointer<ffi.Pointer<ffi.Uint8>> out,
+    ffi.Pointer<ffi.Int> outSize,
+  ) {
+    return _extract_frame_ex(path, frameNum, options, out, outSize);
+  }
+
+  late final _extract_frame_exPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Int Function(
+            ffi.Pointer<ffi.Char>,
+            ffi.Int,
+            ffi.Pointer<vp_call_options>,
+            ffi.Pointer<ffi.Pointer<ffi.Uint8>>,
+            ffi.Pointer<ffi.Int>,
+          )
+        >
+      >('extract_frame_ex');
+  late final _extract_frame_ex = _extract_frame_exPtr
+      .asFunction<
+        int Function(
+          ffi.Pointer<ffi.Char>,
+          int,
+          ffi.Pointer<vp_call_options>,
+          ffi.Pointer<ffi.Pointer<ffi.Uint8>>,
+          ffi.Pointer<ffi.Int>,
+        )
+      >();
+
+  /// extract_frame_buffer() with a deadline and cancellation.
+  int extract_frame_buffer_ex(
+    ffi.Pointer<ffi.Uint8> data,
+    int size,
+    int frameNum,
+    ffi.Pointer<vp_call_options> options,
+    ffi.Pointer<ffi.Pointer<ffi.Uint8>> out,
+    ffi.Pointer<ffi.Int> outSize,
+  ) {
+    return _extract_frame_buffer_ex(data, size, frameNum, options, out, outSize);
+  }
+
+  late final _extract_frame_buffer_exPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Int Function(
+            ffi.Pointer<ffi.Uint8>,
+            ffi.Int64,
+            ffi.Int,
+            ffi.Pointer<vp_call_options>,
+            ffi.Pointer<ffi.Pointer<ffi.Uint8>>,
+            ffi.Pointer<ffi.Int>,
+          )
+        >
+      >('extract_frame_buffer_ex');
+  late final _extract_frame_buffer_ex = _extract_frame_buffer_exPtr
+      .asFunction<
+        int Function(
+          ffi.Pointer<ffi.Uint8>,
+          int,
+          int,
+          ffi.Pointer<vp_call_options>,
+          ffi.Pointer<ffi.Pointer<ffi.Uint8>>,
+          ffi.Pointer<ffi.Int>,
+        )
+      >();
+
+  /// extract_frame_io() with a deadline and cancellation.
+  int extract_frame_io_ex(
+    ffi.Pointer<vp_io_callbacks> io,
+    int frameNum,
+    ffi.Pointer<vp_call_options> options,
+    ffi.Pointer<ffi.Pointer<ffi.Uint8>> out,
+    ffi.Pointer<ffi.Int> outSize,
+  ) {
+    return _extract_frame_io_ex(io, frameNum, options, out, outSize);
+  }
+
+  late final _extract_frame_io_exPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Int Function(
+            ffi.Pointer<vp_io_callbacks>,
+            ffi.Int,
+            ffi.Pointer<vp_call_options>,
+            ffi.Pointer<ffi.Pointer<ffi.Uint8>>,
+            ffi.Pointer<ffi.Int>,
+          )
+        >
+      >('extract_frame_io_ex');
+  late final _extract_frame_io_ex = _extract_frame_io_exPtr
+      .asFunction<
+        int Function(
+          ffi.Pointer<vp_io_callbacks>,
+          int,
+          ffi.Pointer<vp_call_options>,
+          ffi.Pointer<ffi.Pointer<ffi.Uint8>>,
+          ffi.Pointer<ffi.Int>,
+        )
+      >();
+
+  /// Creates a scheduler running requests on `max_workers` threads (0 for
+  /// one per CPU core) and reporting them to `callback`.
+  /// Returns NULL on failure.
+  ffi.Pointer<vp_scheduler> scheduler_new(
+    int max_workers,
+    vp_request_callback callback,
+    ffi.Pointer<ffi.Void> user_data,
+  ) {
+    return _scheduler_new(max_workers, callback, user_data);
+  }
+
+  late final _scheduler_newPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Pointer<vp_scheduler> Function(
+            ffi.Int,
+            vp_request_callback,
+            ffi.Pointer<ffi.Void>,
+          )
+        >
+      >('scheduler_new');
+  late final _scheduler_new = _scheduler_newPtr
+      .asFunction<
+        ffi.Pointer<vp_scheduler> Function(
+          int,
+          vp_request_callback,
+          ffi.Pointer<ffi.Void>,
+        )
+      >();
+
+  /// Queues `request` and returns its id (> 0), or a VP_ERROR_* code.
+  int scheduler_submit(
+    ffi.Pointer<vp_scheduler> scheduler,
+    ffi.Pointer<vp_request> request,
+  ) {
+    return _scheduler_submit(scheduler, request);
+  }
+
+  late final _scheduler_submitPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Int64 Function(ffi.Pointer<vp_scheduler>, ffi.Pointer<vp_request>)
+        >
+      >('scheduler_submit');
+  late final _scheduler_submit = _scheduler_submitPtr
+      .asFunction<
+        int Function(ffi.Pointer<vp_scheduler>, ffi.Pointer<vp_request>)
+      >();
+
+  /// Moves a queued request to another VP_PRIORITY_* class, behind the
+  /// requests already there. Returns VP_OK, or VP_ERROR_NOT_FOUND once the
+  /// request has started.
+  int scheduler_set_priority(
+    ffi.Pointer<vp_scheduler> scheduler,
+    int id,
+    int priority,
+  ) {
+    return _scheduler_set_priority(scheduler, id, priority);
+  }
+
+  late final _scheduler_set_priorityPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Int Function(ffi.Pointer<vp_scheduler>, ffi.Int64, ffi.Int)
+        >
+      >('scheduler_set_priority');
+  late final _scheduler_set_priority = _scheduler_set_priorityPtr
+      .asFunction<int Function(ffi.Pointer<vp_scheduler>, int, int)>();
+
+  /// Cancels a queued or running request; it completes with
+  /// VP_ERROR_CANCELLED. Returns VP_OK or VP_ERROR_NOT_FOUND once finished.
+  int scheduler_cancel(ffi.Pointer<vp_scheduler> scheduler, int id) {
+    return _scheduler_cancel(scheduler, id);
+  }
+
+  late final _scheduler_cancelPtr =
+      _lookup<
+        ffi.NativeFunction<ffi.Int Function(ffi.Pointer<vp_scheduler>, ffi.Int64)>
+      >('scheduler_cancel');
+  late final _scheduler_cancel = _scheduler_cancelPtr
+      .asFunction<int Function(ffi.Pointer<vp_scheduler>, int)>();
+
+  /// Cancels every request, waits for the workers to stop and frees the
+  /// scheduler. Requests that had not started are reported with
+  /// VP_ERROR_CANCELLED before this returns.
+  void scheduler_free(ffi.Pointer<vp_scheduler> scheduler) {
+    return _scheduler_free(scheduler);
+  }
+
+  late final _scheduler_freePtr =
+      _lookup<ffi.NativeFunction<ffi.Void Function(ffi.Pointer<vp_scheduler>)>>(
+        'scheduler_free',
+      );
+  late final _scheduler_free = _scheduler_freePtr
+      .asFunction<void Function(ffi.Pointer<vp_scheduler>)>();
+
+  /// Releases a result passed to a vp_request_callback.
+  void free_request_result(ffi.Pointer<vp_request_result> result) {
+    return _free_request_result(result);
+  }
+
+  late final _free_request_resultPtr =
+      _lookup<
+        ffi.NativeFunction<ffi.Void Function(ffi.Pointer<vp_request_result>)>
+      >('free_request_result');
+  late final _free_request_result = _free_request_resultPtr
+      .asFunction<void Function(ffi.Pointer<vp_request_result>)>();
+
+  /// Snapshot of the stage timings and counters since the last
+  /// reset_metrics(), over every thread. Recording is always on and costs a
+  /// few relaxed atomic adds per stage.
+  void get_metrics(ffi.Pointer<vp_metrics> out) {
+    return _get_metrics(out);
+  }
+
+  late final _get_metricsPtr =
+      _lookup<ffi.NativeFunction<ffi.Void Function(ffi.Pointer<vp_metrics>)>>(
+        'get_metrics',
+      );
+  late final _get_metrics = _get_metricsPtr
+      .asFunction<void Function(ffi.Pointer<vp_metrics>)>();
+
+  /// Starts a new measurement window for get_metrics().
+  void reset_metrics() {
+    return _reset_metrics();
+  }
+
+  late final _reset_metricsPtr =
+      _lookup<ffi.NativeFunction<ffi.Void Function()>>('reset_metrics');
+  late final _reset_metrics = _reset_metricsPtr.asFunction<void Function()>();
+
+  /// Starts recording spans of every stage, GStreamer state change and bus
+  /// wait, with thread ids, into a ring of `capacity` events (0 for 65536).
+  /// The oldest events are overwritten once it is full. Restarting discards
+  /// the previous recording.
+  /// Returns VP_OK, VP_ERROR_INVALID_ARGUMENT or VP_ERROR_NO_MEMORY.
+  int trace_start(int capacity) {
+    return _trace_start(capacity);
+  }
+
+  late final _trace_startPtr =
+      _lookup<ffi.NativeFunction<ffi.Int Function(ffi.Int)>>('trace_start');
+  late final _trace_start = _trace_startPtr.asFunction<int Function(int)>();
+
+  /// Stops recording; the events stay available to trace_dump().
+  void trace_stop() {
+    return _trace_stop();
+  }
+
+  late final _trace_stopPtr = _lookup<ffi.NativeFunction<ffi.Void Function()>>(
+    'trace_stop',
+  );
+  late final _trace_stop = _trace_stopPtr.asFunction<void Function()>();
+
+  /// Writes the recorded events as Chrome trace event JSON, loadable in
+  /// Perfetto or chrome://tracing, to a NUL-terminated string at *out of
+  /// *outSize bytes. Release it with free_trace(). Works while recording.
+  int trace_dump(
+    ffi.Pointer<ffi.Pointer<ffi.Char>> out,
+    ffi.Pointer<ffi.Int64> outSize,
+  ) {
+    return _trace_dump(out, outSize);
+  }
+
+  late final _trace_dumpPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Int Function(
+            ffi.Pointer<ffi.Pointer<ffi.Char>>,
+            ffi.Pointer<ffi.Int64>,
+          )
+        >
+      >('trace_dump');
+  late final _trace_dump = _trace_dumpPtr
+      .asFunction<
+        int Function(ffi.Pointer<ffi.Pointer<ffi.Char>>, ffi.Pointer<ffi.Int64>)
+      >();
+
+  void free_trace(ffi.Pointer<ffi.Char> json) {
+    return _free_trace(json);
+  }
+
+  late final _free_tracePtr =
+      _lookup<ffi.NativeFunction<ffi.Void Function(ffi.Pointer<ffi.Char>)>>(
+        'free_trace',
+      );
+  late final _free_trace = _free_tracePtr
+      .asFunction<void Function(ffi.Pointer<ffi.Char>)>();
+
+  /// Limits native memory for decoding. `global_bytes` caps the estimated
+  /// memory of all decodes running at once; `request_bytes` is the budget of
+  /// calls that do not set vp_call_options.memory_budget. 0 means unlimited.
+  /// Returns VP_OK or VP_ERROR_INVALID_ARGUMENT for negative values.
+  int set_memory_budget(int global_bytes, int request_bytes) {
+    return _set_memory_budget(global_bytes, request_bytes);
+  }
+
+  late final _set_memory_budgetPtr =
+      _lookup<ffi.NativeFunction<ffi.Int Function(ffi.Int64, ffi.Int64)>>(
+        'set_memory_budget',
+      );
+  late final _set_memory_budget = _set_memory_budgetPtr
+      .asFunction<int Function(int, int)>();
+
+  /// extract_frame_ex() into `capacity` bytes at `dst`, which the caller owns,
+  /// so extraction allocates no frame buffer. On VP_OK, *outSize is the JPEG
+  /// size. If it does not fit, returns VP_ERROR_BUFFER_TOO_SMALL with the
+  /// size needed in *outSize; a retry decodes the frame again, so callers
+  /// should keep the buffer and grow it rather than size it per frame.
+  int extract_frame_into(
+    ffi.Pointer<ffi.Char> path,
+    int frameNum,
+    ffi.Pointer<vp_call_options> options,
+    ffi.Pointer<ffi.Uint8> dst,
+    int capacity,
+    ffi.Pointer<ffi.Int> outSize,
+  ) {
+    return _extract_frame_into(path, frameNum, options, dst, capacity, outSize);
+  }
+
+  late final _extract_frame_intoPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Int Function(
+            ffi.Pointer<ffi.Char>,
+            ffi.Int,
+            ffi.Pointer<vp_call_options>,
+            ffi.Pointer<ffi.Uint8>,
+            ffi.Int,
+            ffi.Pointer<ffi.Int>,
+          )
+        >
+      >('extract_frame_into');
+  late final _extract_frame_into = _extract_frame_intoPtr
+      .asFunction<
+        int Function(
+          ffi.Pointer<ffi.Char>,
+          int,
+          ffi.Pointer<vp_call_options>,
+          ffi.Pointer<ffi.Uint8>,
+          int,
+          ffi.Pointer<ffi.Int>,
+        )
+      >();
+
+  /// Caps the bytes of freed frames kept for reuse (32 MiB by default),
+  /// releasing what is over the new limit. 0 disables pooling.
+  /// Returns VP_OK or VP_ERROR_INVALID_ARGUMENT for a negative limit.
+  int set_frame_pool_limit(int bytes) {
+    return _set_frame_pool_limit(bytes);
+  }
+
+  late final _set_frame_pool_limitPtr =
+      _lookup<ffi.NativeFunction<ffi.Int Function(ffi.Int64)>>(
+        'set_frame_pool_limit',
+      );
+  late final _set_frame_pool_limit = _set_frame_pool_limitPtr
+      .asFunction<int Function(int)>();
+
+  /// Extract several frames of one video as JPEGs, e.g. for a storyboard.
+  /// Frames are sorted and grouped into runs that decode from the same
+  /// keyframe; each run costs one seek, and runs are spread over parallel
+  /// pipelines. `options` may be NULL. Returns VP_OK once every frame has a
+  /// status in *out, or an error for the whole call (bad arguments, the
+  /// video cannot be opened). Release *out with free_frames_result().
+  int extract_frames(
+    ffi.Pointer<ffi.Char> path,
+    ffi.Pointer<ffi.Int> frame_nums,
+    int count,
+    ffi.Pointer<vp_frames_options> options,
+    ffi.Pointer<vp_frames_result> out,
+  ) {
+    return _extract_frames(path, frame_nums, count, options, out);
+  }
+
+  late final _extract_framesPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Int Function(
+            ffi.Pointer<ffi.Char>,
+            ffi.Pointer<ffi.Int>,
+            ffi.Int,
+            ffi.Pointer<vp_frames_options>,
+            ffi.Pointer<vp_frames_result>,
+          )
+        >
+      >('extract_frames');
+  late final _extract_frames = _extract_framesPtr
+      .asFunction<
+        int Function(
+          ffi.Pointer<ffi.Char>,
+          ffi.Pointer<ffi.Int>,
+          int,
+          ffi.Pointer<vp_frames_options>,
+          ffi.Pointer<vp_frames_result>,
+        )
+      >();
+
+  /// Releases everything held by a vp_frames_result filled by extract_frames().
+  void free_frames_result(ffi.Pointer<vp_frames_result> result) {
+    return _free_frames_result(result);
+  }
+
+  late final _free_frames_resultPtr =
+      _lookup<
+        ffi.NativeFunction<ffi.Void Function(ffi.Pointer<vp_frames_result>)>
+      >('free_frames_result');
+  late final _free_frames_result = _free_frames_resultPtr
+      .asFunction<void Function(ffi.Pointer<vp_frames_result>)>();
+
+  /// Opens `path` for reading frames in order from one long-lived pipeline,
+  /// e.g. to feed every Nth frame of a video to a model. `options` may be
+  /// NULL. On VP_OK, *out must be released with frame_iterator_close().
+  int frame_iterator_open(
+    ffi.Pointer<ffi.Char> path,
+    ffi.Pointer<vp_iterator_options> options,
+    ffi.Pointer<ffi.Pointer<vp_frame_iterator>> out,
+  ) {
+    return _frame_iterator_open(path, options, out);
+  }
+
+  late final _frame_iterator_openPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Int Function(
+            ffi.Pointer<ffi.Char>,
+            ffi.Pointer<vp_iterator_options>,
+            ffi.Pointer<ffi.Pointer<vp_frame_iterator>>,
+          )
+        >
+      >('frame_iterator_open');
+  late final _frame_iterator_open = _frame_iterator_openPtr
+      .asFunction<
+        int Function(
+          ffi.Pointer<ffi.Char>,
+          ffi.Pointer<vp_iterator_options>,
+          ffi.Pointer<ffi.Pointer<vp_frame_iterator>>,
+        )
+      >();
+
+  /// Waits for the next frame and moves it to *frame. Returns VP_OK,
+  /// VP_END_OF_STREAM once every frame has been returned, or an error after
+  /// which the iterator can only be closed.
+  int frame_iterator_next(
+    ffi.Pointer<vp_frame_iterator> iterator,
+    ffi.Pointer<vp_frame> frame,
+  ) {
+    return _frame_iterator_next(iterator, frame);
+  }
+
+  late final _frame_iterator_nextPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Int Function(ffi.Pointer<vp_frame_iterator>, ffi.Pointer<vp_frame>)
+        >
+      >('frame_iterator_next');
+  late final _frame_iterator_next = _frame_iterator_nextPtr
+      .asFunction<
+        int Function(ffi.Pointer<vp_frame_iterator>, ffi.Pointer<vp_frame>)
+      >();
+
+  /// Like frame_iterator_next(), returning up to `capacity` frames at once:
+  /// waits for the first, then adds those already decoded without waiting.
+  /// Returns VP_OK with *count >= 1, VP_END_OF_STREAM with *count == 0, or an
+  /// error. Frames returned before an error are kept; the error comes with
+  /// the next call.
+  int frame_iterator_next_batch(
+    ffi.Pointer<vp_frame_iterator> iterator,
+    ffi.Pointer<vp_frame> frames,
+    int capacity,
+    ffi.Pointer<ffi.Int> count,
+  ) {
+    return _frame_iterator_next_batch(iterator, frames, capacity, count);
+  }
+
+  late final _frame_iterator_next_batchPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Int Function(
+            ffi.Pointer<vp_frame_iterator>,
+            ffi.Pointer<vp_frame>,
+            ffi.Int,
+            ffi.Pointer<ffi.Int>,
+          )
+        >
+      >('frame_iterator_next_batch');
+  late final _frame_iterator_next_batch = _frame_iterator_next_batchPtr
+      .asFunction<
+        int Function(
+          ffi.Pointer<vp_frame_iterator>,
+          ffi.Pointer<vp_frame>,
+          int,
+          ffi.Pointer<ffi.Int>,
+        )
+      >();
+
+  /// Stops decoding and releases the iterator. Frames already returned stay
+  /// valid. Accepts NULL.
+  void frame_iterator_close(ffi.Pointer<vp_frame_iterator> iterator) {
+    return _frame_iterator_close(iterator);
+  }
+
+  late final _frame_iterator_closePtr =
+      _lookup<
+        ffi.NativeFunction<ffi.Void Function(ffi.Pointer<vp_frame_iterator>)>
+      >('frame_iterator_close');
+  late final _frame_iterator_close = _frame_iterator_closePtr
+      .asFunction<void Function(ffi.Pointer<vp_frame_iterator>)>();
+
+  /// Initializes the platform framework (GStreamer: gst_init and the plugin
+  /// registry) and loads the demuxers, decoders and encoder of the common
+  /// formats on a background thread, so the first probe or thumbnail after
+  /// launch does not pay for them. Returns at once; calls made meanwhile wait
+  /// only for what they need. Later calls do nothing. Returns VP_OK, or
+  /// VP_ERROR_FAILED if the thread could not be started.
+  int video_probe_warmup() {
+    return _video_probe_warmup();
+  }
+
+  late final _video_probe_warmupPtr =
+      _lookup<ffi.NativeFunction<ffi.Int Function()>>('video_probe_warmup');
+  late final _video_probe_warmup = _video_probe_warmupPtr
+      .asFunction<int Function()>();
+
+  /// Restricts the platform framework to `count` named plugins (GStreamer
+  /// plugin names, e.g. "isomp4", "matroska", "libav", "videoparsersbad"),
+  /// besides those the library's own pipelines use, so formats and hardware
+  /// decoders an app does not need are never loaded. 0 keeps every plugin.
+  /// Must be called before anything initializes GStreamer, including
+  /// video_probe_warmup(); returns VP_ERROR_FAILED afterwards, VP_OK or
+  /// VP_ERROR_INVALID_ARGUMENT.
+  int set_plugin_allowlist(
+    ffi.Pointer<ffi.Pointer<ffi.Char>> names,
+    int count,
+  ) {
+    return _set_plugin_allowlist(names, count);
+  }
+
+  late final _set_plugin_allowlistPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Int Function(ffi.Pointer<ffi.Pointer<ffi.Char>>, ffi.Int)
+        >
+      >('set_plugin_allowlist');
+  late final _set_plugin_allowlist = _set_plugin_allowlistPtr
+      .asFunction<int Function(ffi.Pointer<ffi.Pointer<ffi.Char>>, int)>();
+
+  /// Starts a discovery service: a thread running the platform's metadata
+  /// discovery (GStreamer: GstDiscoverer) on its own event loop, with up to
+  /// `max_in_flight` files in flight at once (0 for 4), each given up after
+  /// `timeout_ms` (0 for 5 s; GStreamer accepts 1 s to 1 h). Unlike
+  /// probe_media_info() it never uses the native container parser.
+  /// Returns NULL on failure.
+  ffi.Pointer<vp_discovery_service> discovery_service_new(
+    int max_in_flight,
+    int timeout_ms,
+    vp_discovery_callback callback,
+    ffi.Pointer<ffi.Void> user_data,
+  ) {
+    return _discovery_service_new(max_in_flight, timeout_ms, callback, user_data);
+  }
+
+  late final _discovery_service_newPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Pointer<vp_discovery_service> Function(
+            ffi.Int,
+            ffi.Int64,
+            vp_discovery_callback,
+            ffi.Pointer<ffi.Void>,
+          )
+        >
+      >('discovery_service_new');
+  late final _discovery_service_new = _discovery_service_newPtr
+      .asFunction<
+        ffi.Pointer<vp_discovery_service> Function(
+          int,
+          int,
+          vp_discovery_callback,
+          ffi.Pointer<ffi.Void>,
+        )
+      >();
+
+  /// Queues a path or URI and returns its id (> 0), or a VP_ERROR_* code.
+  int discovery_service_submit(
+    ffi.Pointer<vp_discovery_service> service,
+    ffi.Pointer<ffi.Char> path,
+  ) {
+    return _discovery_service_submit(service, path);
+  }
+
+  late final _discovery_service_submitPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Int64 Function(
+            ffi.Pointer<vp_discovery_service>,
+            ffi.Pointer<ffi.Char>,
+          )
+        >
+      >('discovery_service_submit');
+  late final _discovery_service_submit = _discovery_service_submitPtr
+      .asFunction<
+        int Function(ffi.Pointer<vp_discovery_service>, ffi.Pointer<ffi.Char>)
+      >();
+
+  /// Cancels a queued or running discovery; it completes with
+  /// VP_ERROR_CANCELLED. Returns VP_OK or VP_ERROR_NOT_FOUND once finished.
+  int discovery_service_cancel(
+    ffi.Pointer<vp_discovery_service> service,
+    int id,
+  ) {
+    return _discovery_service_cancel(service, id);
+  }
+
+  late final _discovery_service_cancelPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Int Function(ffi.Pointer<vp_discovery_service>, ffi.Int64)
+        >
+      >('discovery_service_cancel');
+  late final _discovery_service_cancel = _discovery_service_cancelPtr
+      .asFunction<int Function(ffi.Pointer<vp_discovery_service>, int)>();
+
+  /// Cancels every discovery, waits for the thread to stop and frees the
+  /// service. Discoveries that had not started are not reported.
+  void discovery_service_free(ffi.Pointer<vp_discovery_service> service) {
+    return _discovery_service_free(service);
+  }
+
+  late final _discovery_service_freePtr =
+      _lookup<
+        ffi.NativeFunction<ffi.Void Function(ffi.Pointer<vp_discovery_service>)>
+      >('discovery_service_free');
+  late final _discovery_service_free = _discovery_service_freePtr
+      .asFunction<void Function(ffi.Pointer<vp_discovery_service>)>();
+
+  /// Releases a result passed to a vp_discovery_callback.
+  void free_discovery_result(ffi.Pointer<vp_discovery_result> result) {
+    return _free_discovery_result(result);
+  }
+
+  late final _free_discovery_resultPtr =
+      _lookup<
+        ffi.NativeFunction<ffi.Void Function(ffi.Pointer<vp_discovery_result>)>
+      >('free_discovery_result');
+  late final _free_discovery_result = _free_discovery_resultPtr
+      .asFunction<void Function(ffi.Pointer<vp_discovery_result>)>();
+
+  /// Reads the keyframe structure of the first video track of `path` from the
+  /// container index without decoding anything: GOP lengths, B-frames, open
+  /// GOPs and, for every frame, what a seek to it costs. Lets callers choose
+  /// between accurate seeks and snapping to the nearest keyframe. `options`
+  /// may be NULL. Returns VP_OK, VP_ERROR_UNSUPPORTED for containers without
+  /// a native index parser (MP4/MOV only for now) or fragmented files, or an
+  /// error. Release *out with free_gop_info().
+  int analyze_gop(
+    ffi.Pointer<ffi.Char> path,
+    ffi.Pointer<vp_call_options> options,
+    ffi.Pointer<vp_gop_info> out,
+  ) {
+    return _analyze_gop(path, options, out);
+  }
+
+  late final _analyze_gopPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Int Function(
+            ffi.Pointer<ffi.Char>,
+            ffi.Pointer<vp_call_options>,
+            ffi.Pointer<vp_gop_info>,
+          )
+        >
+      >('analyze_gop');
+  late final _analyze_gop = _analyze_gopPtr
+      .asFunction<
+        int Function(
+          ffi.Pointer<ffi.Char>,
+          ffi.Pointer<vp_call_options>,
+          ffi.Pointer<vp_gop_info>,
+        )
+      >();
+
+  /// Cost of showing the frame at `seconds`, i.e. the last frame shown at or
+  /// before it (the first frame for earlier times). Returns VP_OK, or
+  /// VP_ERROR_NOT_FOUND if `info` has no frames.
+  int gop_seek_cost(
+    ffi.Pointer<vp_gop_info> info,
+    double seconds,
+    ffi.Pointer<vp_seek_cost> out,
+  ) {
+    return _gop_seek_cost(info, seconds, out);
+  }
+
+  late final _gop_seek_costPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Int Function(
+            ffi.Pointer<vp_gop_info>,
+            ffi.Double,
+            ffi.Pointer<vp_seek_cost>,
+          )
+        >
+      >('gop_seek_cost');
+  late final _gop_seek_cost = _gop_seek_costPtr
+      .asFunction<
+        int Function(
+          ffi.Pointer<vp_gop_info>,
+          double,
+          ffi.Pointer<vp_seek_cost>,
+        )
+      >();
+
+  /// Releases everything held by a vp_gop_info filled by analyze_gop().
+  void free_gop_info(ffi.Pointer<vp_gop_info> info) {
+    return _free_gop_info(info);
+  }
+
+  late final _free_gop_infoPtr =
+      _lookup<ffi.NativeFunction<ffi.Void Function(ffi.Pointer<vp_gop_info>)>>(
+        'free_gop_info',
+      );
+  late final _free_gop_info = _free_gop_infoPtr
+      .asFunction<void Function(ffi.Pointer<vp_gop_info>)>();
+
+  /// Reads the cover art or camera thumbnail stored in `path` (local file or
+  /// http(s) URL) with the native parsers, without decoding anything:
+  /// covr in an MP4/MOV/M4V ilst or Canon's CNTH thumbnail, or a Matroska/WebM
+  /// image attachment, covers first. *out receives the image bytes, to be
+  /// released with free_frame(), and *out_format (may be NULL) VP_IMAGE_JPEG
+  /// or VP_IMAGE_PNG.
+  /// Returns VP_OK, VP_ERROR_NOT_FOUND if the file stores no image,
+  /// VP_ERROR_UNSUPPORTED for other containers, or an error.
+  int get_embedded_thumbnail(
+    ffi.Pointer<ffi.Char> path,
+    ffi.Pointer<vp_call_options> options,
+    ffi.Pointer<ffi.Pointer<ffi.Uint8>> out,
+    ffi.Pointer<ffi.Int> out_size,
+    ffi.Pointer<ffi.Int> out_format,
+  ) {
+    return _get_embedded_thumbnail(path, options, out, out_size, out_format);
+  }
+
+  late final _get_embedded_thumbnailPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Int Function(
+            ffi.Pointer<ffi.Char>,
+            ffi.Pointer<vp_call_options>,
+            ffi.Pointer<ffi.Pointer<ffi.Uint8>>,
+            ffi.Pointer<ffi.Int>,
+            ffi.Pointer<ffi.Int>,
+          )
+        >
+      >('get_embedded_thumbnail');
+  late final _get_embedded_thumbnail = _get_embedded_thumbnailPtr
+      .asFunction<
+        int Function(
+          ffi.Pointer<ffi.Char>,
+          ffi.Pointer<vp_call_options>,
+          ffi.Pointer<ffi.Pointer<ffi.Uint8>>,
+          ffi.Pointer<ffi.Int>,
+          ffi.Pointer<ffi.Int>,
+        )
+      >();
+}
+
+/// Description of a single elementary stream.
+/// Video-only fields are zero for audio and subtitle streams and vice versa.
+final class vp_stream_info extends ffi.Struct {
+  @ffi.Int()
+  external int type;
+
+  /// Short codec name, e.g. "h264", "hevc", "aac". Never NULL.
+  external ffi.Pointer<ffi.Char> codec;
+
+  /// ISO 639 language code, or NULL if unknown.
+  external ffi.Pointer<ffi.Char> language;
+
+  /// Bits per second, 0 if unknown.
+  @ffi.Int64()
+  external int bitrate;
+
+  @ffi.Int()
+  external int width;
+
+  @ffi.Int()
+  external int height;
+
+  @ffi.Int()
+  external int par_num;
+
+  @ffi.Int()
+  external int par_den;
+
+  @ffi.Int()
+  external int fps_num;
+
+  @ffi.Int()
+  external int fps_den;
+
+  /// Clockwise display rotation in degrees (0, 90, 180 or 270).
+  @ffi.Int()
+  external int rotation;
+
+  @ffi.Int()
+  external int bit_depth;
+
+  /// ISO/IEC 23001-8 colour primaries and transfer characteristics codes,
+  /// 2 (unspecified) if unknown.
+  @ffi.Int()
+  external int color_primaries;
+
+  @ffi.Int()
+  external int transfer;
+
+  @ffi.Int()
+  external int is_hdr;
+
+  @ffi.Int()
+  external int channels;
+
+  @ffi.Int()
+  external int sample_rate;
+}
+
+/// Everything known about a media file, gathered in a single probe.
+/// The top-level video fields describe the primary video stream; streams
+/// lists every stream in the file, including that one.
+/// All pointers reference memory owned by the info; release it with
+/// free_media_info().
+final class vp_media_info extends ffi.Struct {
+  /// Container media type, e.g. "video/quicktime", or NULL if unknown.
+  external ffi.Pointer<ffi.Char> container;
+
+  @ffi.Double()
+  external double duration;
+
+  @ffi.Int64()
+  external int bitrate;
+
+  @ffi.Int64()
+  external int frame_count;
+
+  @ffi.Int()
+  external int has_video;
+
+  external ffi.Pointer<ffi.Char> video_codec;
+
+  @ffi.Int()
+  external int width;
+
+  @ffi.Int()
+  external int height;
+
+  @ffi.Int()
+  external int par_num;
+
+  @ffi.Int()
+  external int par_den;
+
+  @ffi.Int()
+  external int fps_num;
+
+  @ffi.Int()
+  external int fps_den;
+
+  @ffi.Int()
+  external int rotation;
+
+  @ffi.Int()
+  external int bit_depth;
+
+  @ffi.Int()
+  external int color_primaries;
+
+  @ffi.Int()
+  external int transfer;
+
+  @ffi.Int()
+  external int is_hdr;
+
+  @ffi.Int()
+  external int stream_count;
+
+  external ffi.Pointer<vp_stream_info> streams;
+
+  /// Backing storage for the strings and streams above. Do not touch.
+  external ffi.Pointer<ffi.Void> arena;
+}
+
+/// Cancellation token, see cancel_token_new(). Cancelling it aborts every
+/// call it was passed to: pipelines are shut down and waits are woken, and
+/// the calls return VP_ERROR_CANCELLED.
+final class vp_cancel_token extends ffi.Opaque {}
+
+/// Per-call limits for the *_ex functions. A NULL options pointer or a
+/// zeroed struct keeps the default behaviour.
+final class vp_call_options extends ffi.Struct {
+  /// Deadline for the whole call in milliseconds; the call returns
+  /// VP_ERROR_TIMEOUT once it passes. 0 keeps the built-in per-stage
+  /// timeouts (5 s discovery, 10 s preroll, 5 s seek).
+  @ffi.Int64()
+  external int timeout_ms;
+
+  /// May be NULL. Must outlive the call.
+  external ffi.Pointer<vp_cancel_token> cancel;
+
+  /// Native memory the call's decodes may use, in bytes. A decode that
+  /// would not fit runs single-threaded and downscaled before conversion,
+  /// or fails with VP_ERROR_OVER_BUDGET. 0 uses the default from
+  /// set_memory_budget().
+  @ffi.Int64()
+  external int memory_budget;
+
+  /// If not NULL, receives the most native memory attributed to a single
+  /// decode of the call, in bytes (0 if it decoded nothing).
+  external ffi.Pointer<ffi.Int64> peak_memory;
+
+  /// Threads of each video decoder the call runs (e.g. avdec_* max-threads),
+  /// 0 for the decoder's default. Memory budgets may lower it.
+  @ffi.Int()
+  external int decoder_threads;
+}
+
+final class vp_batch_options extends ffi.Struct {
+  @ffi.Int()
+  external int flags;
+
+  /// Number of worker threads, 0 for one per CPU core.
+  @ffi.Int()
+  external int max_workers;
+
+  /// Frame number used for thumbnails when VP_BATCH_THUMBNAILS is set.
+  @ffi.Int()
+  external int thumbnail_frame;
+
+  /// Deadline and cancellation for the whole batch. Files not finished in
+  /// time report VP_ERROR_TIMEOUT or VP_ERROR_CANCELLED.
+  external vp_call_options call;
+}
+
+/// Result for one input path.
+final class vp_batch_item extends ffi.Struct {
+  /// VP_OK or a VP_ERROR_* code; info is zeroed unless VP_OK.
+  @ffi.Int()
+  external int status;
+
+  /// Owned by the batch result; do not pass to free_media_info().
+  external vp_media_info info;
+
+  /// Image bytes, or NULL if not requested or extraction failed.
+  external ffi.Pointer<ffi.Uint8> thumbnail;
+
+  @ffi.Int()
+  external int thumbnail_size;
+
+  /// VP_IMAGE_JPEG, or VP_IMAGE_PNG for a stored PNG; 0 without a thumbnail.
+  @ffi.Int()
+  external int thumbnail_format;
+}
+
+final class vp_batch_result extends ffi.Struct {
+  @ffi.Int()
+  external int count;
+
+  /// items[i] describes paths[i].
+  external ffi.Pointer<vp_batch_item> items;
+
+  /// Backing storage for every item. Do not touch.
+  external ffi.Pointer<ffi.Void> arena;
+}
+
+final class vp_frames_options extends ffi.Struct {
+  /// Number of pipelines decoding in parallel, 0 for one per CPU core.
+  /// Each takes a run of frames that decode from the same keyframe.
+  @ffi.Int()
+  external int max_workers;
+
+  /// Deadline, cancellation and memory budget for the whole call. With
+  /// decoder_threads 0 the cores are split between the pipelines.
+  external vp_call_options call;
+}
+
+/// Result for one requested frame.
+final class vp_frame_item extends ffi.Struct {
+  /// VP_OK or a VP_ERROR_* code; data is NULL unless VP_OK.
+  @ffi.Int()
+  external int status;
+
+  /// JPEG bytes, owned by the frames result. Repeated frame numbers share
+  /// the same bytes.
+  external ffi.Pointer<ffi.Uint8> data;
+
+  @ffi.Int()
+  external int size;
+}
+
+final class vp_frames_result extends ffi.Struct {
+  @ffi.Int()
+  external int count;
+
+  /// items[i] is frame_nums[i].
+  external ffi.Pointer<vp_frame_item> items;
+
+  /// Backing storage for every item. Do not touch.
+  external ffi.Pointer<ffi.Void> arena;
+}
+
+/// A byte range of a file, e.g. a downloaded or still missing part.
+final class vp_byte_range extends ffi.Struct {
+  @ffi.Int64()
+  external int offset;
+
+  @ffi.Int64()
+  external int length;
+}
+
+/// Caller-supplied byte source for data that is not a local file, e.g. an
+/// encrypted blob or an archive member. Callbacks are invoked from the
+/// calling thread and from framework streaming threads, but never
+/// concurrently, and only until the function that was given the table
+/// returns.
+final class vp_io_callbacks extends ffi.Struct {
+  external ffi.Pointer<ffi.Void> opaque;
+
+  /// Reads up to `size` bytes at the current position.
+  /// Returns the number of bytes read, 0 at end of data, -1 on error.
+  external ffi.Pointer<
+    ffi.NativeFunction<
+      ffi.Int64 Function(
+        ffi.Pointer<ffi.Void> opaque,
+        ffi.Pointer<ffi.Uint8> buf,
+        ffi.Int64 size,
+      )
+    >
+  >
+  read;
+
+  /// Moves the current position to absolute `offset`.
+  /// Returns 0 on success, -1 on error.
+  external ffi.Pointer<
+    ffi.NativeFunction<
+      ffi.Int Function(ffi.Pointer<ffi.Void> opaque, ffi.Int64 offset)
+    >
+  >
+  seek;
+
+  /// Returns the total size in bytes, or -1 if unknown. May be NULL.
+  external ffi.Pointer<
+    ffi.NativeFunction<ffi.Int64 Function(ffi.Pointer<ffi.Void> opaque)>
+  >
+  size;
+}
+
+/// Local file I/O counters of the native container parsers.
+final class vp_io_stats extends ffi.Struct {
+  /// Files opened.
+  @ffi.Int64()
+  external int files;
+
+  /// Read requests and bytes handed to the parsers.
+  @ffi.Int64()
+  external int reads;
+
+  @ffi.Int64()
+  external int bytes_read;
+
+  /// Bytes transferred from storage, including the prefetched head and
+  /// tail of each file.
+  @ffi.Int64()
+  external int bytes_fetched;
+
+  /// Blocking read syscalls (pread, io_uring_enter). Page faults of
+  /// memory-mapped files are not counted.
+  @ffi.Int64()
+  external int read_syscalls;
+
+  /// Readahead hints (posix_fadvise, madvise).
+  @ffi.Int64()
+  external int hint_syscalls;
+}
+
+/// Scheduler of probe and extraction requests, see scheduler_new().
+final class vp_scheduler extends ffi.Opaque {}
+
+final class vp_request extends ffi.Struct {
+  /// VP_REQUEST_MEDIA_INFO or VP_REQUEST_FRAME.
+  @ffi.Int()
+  external int kind;
+
+  /// Copied by scheduler_submit().
+  external ffi.Pointer<ffi.Char> path;
+
+  /// Frame to extract for VP_REQUEST_FRAME.
+  @ffi.Int()
+  external int frame_num;
+
+  /// VP_PRIORITY_*.
+  @ffi.Int()
+  external int priority;
+
+  /// View slot (e.g. a grid cell) the request is for, 0 for none. A new
+  /// request on a slot supersedes the previous one: it is dropped if still
+  /// queued and cancelled if running, and completes with
+  /// VP_ERROR_CANCELLED.
+  @ffi.Int64()
+  external int slot;
+
+  /// Deadline in milliseconds from submission, 0 for none.
+  @ffi.Int64()
+  external int timeout_ms;
+
+  /// VP_REQUEST_* flags.
+  @ffi.Int()
+  external int flags;
+}
+
+final class vp_request_result extends ffi.Struct {
+  /// As returned by scheduler_submit().
+  @ffi.Int64()
+  external int id;
+
+  /// VP_OK or a VP_ERROR_* code.
+  @ffi.Int()
+  external int status;
+
+  /// VP_REQUEST_MEDIA_INFO results; zeroed unless VP_OK.
+  external vp_media_info info;
+
+  /// VP_REQUEST_FRAME results: image bytes, or NULL unless VP_OK.
+  external ffi.Pointer<ffi.Uint8> frame;
+
+  @ffi.Int()
+  external int frame_size;
+
+  /// Microseconds spent queued before a worker took the request.
+  @ffi.Int64()
+  external int queued_us;
+
+  /// Native memory attributed to the request's decode, in bytes.
+  @ffi.Int64()
+  external int peak_memory;
+
+  /// VP_IMAGE_JPEG, or VP_IMAGE_PNG for a stored PNG; 0 without a frame.
+  @ffi.Int()
+  external int frame_format;
+}
+
+/// Receives every finished request, from a worker thread or, for requests
+/// dropped before they started, from the thread that dropped them.
+/// Release the result with free_request_result().
+typedef vp_request_callback =
+    ffi.Pointer<ffi.NativeFunction<vp_request_callbackFunction>>;
+typedef vp_request_callbackFunction =
+    ffi.Void Function(
+      ffi.Pointer<vp_request_result> result,
+      ffi.Pointer<ffi.Void> user_data,
+    );
+typedef Dartvp_request_callbackFunction =
+    void Function(
+      ffi.Pointer<vp_request_result> result,
+      ffi.Pointer<ffi.Void> user_data,
+    );
+
+final class vp_stage_metrics extends ffi.Struct {
+  /// Completed runs of the stage.
+  @ffi.Int64()
+  external int count;
+
+  @ffi.Int64()
+  external int total_us;
+
+  /// Latency percentiles in microseconds, within 1/16 of the exact value.
+  @ffi.Int64()
+  external int p50_us;
+
+  @ffi.Int64()
+  external int p90_us;
+
+  @ffi.Int64()
+  external int p99_us;
+}
+
+final class vp_metrics extends ffi.Struct {
+  /// Indexed by VP_STAGE_*.
+  @ffi.Array.multi([7])
+  external ffi.Array<vp_stage_metrics> stages;
+
+  /// Bytes handed to parsers and demuxers by the plugin's readers (local
+  /// files probed natively, memory, callbacks and HTTP). Files GStreamer
+  /// opens itself are not counted.
+  @ffi.Int64()
+  external int bytes_read;
+
+  /// Heap allocations for results and parser state: arena blocks and
+  /// frame buffers not served from the frame pool.
+  @ffi.Int64()
+  external int allocations;
+
+  /// Frame buffers not yet released with free_frame(). Unlike the fields
+  /// above these are current levels, so reset_metrics() leaves them alone.
+  @ffi.Int64()
+  external int live_frames;
+
+  /// Media infos, batch results and request results not yet freed, plus
+  /// those of calls still running.
+  @ffi.Int64()
+  external int live_results;
+}
+
+/// Sequential frame reader, see frame_iterator_open().
+final class vp_frame_iterator extends ffi.Opaque {}
+
+final class vp_iterator_options extends ffi.Struct {
+  /// First frame to return.
+  @ffi.Int()
+  external int start_frame;
+
+  /// Return every step-th frame from start_frame, 0 or 1 for every frame.
+  @ffi.Int()
+  external int step;
+
+  /// Frame after the last one to return, 0 to read to the end.
+  @ffi.Int()
+  external int end_frame;
+
+  /// Seconds between frames, e.g. 1.0 for one frame per second, instead
+  /// of step; 0 to use step. Each sample returns the frame showing at
+  /// that time. Frames no sample needs are dropped before conversion
+  /// and, for MP4, not decoded where the index shows nothing depends on
+  /// them.
+  @ffi.Double()
+  external double interval;
+
+  /// Frames decoded ahead of frame_iterator_next(), 0 for the default of 4.
+  /// Decoding pauses while the queue is full.
+  @ffi.Int()
+  external int queue_size;
+
+  /// VP_FRAME_*.
+  @ffi.Int()
+  external int format;
+
+  /// Cancellation and memory budget for the life of the iterator;
+  /// timeout_ms bounds the open and each frame_iterator_next() call.
+  /// peak_memory must outlive the iterator.
+  external vp_call_options call;
+}
+
+/// One frame returned by frame_iterator_next().
+final class vp_frame extends ffi.Struct {
+  @ffi.Int()
+  external int frame_num;
+
+  /// Presentation time in seconds.
+  @ffi.Double()
+  external double timestamp;
+
+  /// JPEG or RGBA bytes, see vp_iterator_options.format; release with
+  /// free_frame().
+  external ffi.Pointer<ffi.Uint8> data;
+
+  @ffi.Int()
+  external int size;
+
+  @ffi.Int()
+  external int width;
+
+  @ffi.Int()
+  external int height;
+}
+
+/// Long-lived metadata discovery, see discovery_service_new().
+final class vp_discovery_service extends ffi.Opaque {}
+
+final class vp_discovery_result extends ffi.Struct {
+  /// As returned by discovery_service_submit().
+  @ffi.Int64()
+  external int id;
+
+  /// VP_OK or a VP_ERROR_* code.
+  @ffi.Int()
+  external int status;
+
+  /// Zeroed unless VP_OK.
+  external vp_media_info info;
+
+  /// Microseconds spent queued before the discovery started.
+  @ffi.Int64()
+  external int queued_us;
+}
+
+/// Receives every finished discovery from the service thread or, for
+/// queued ones cancelled by discovery_service_cancel(), from the cancelling
+/// thread. Release the result with free_discovery_result().
+typedef vp_discovery_callback =
+    ffi.Pointer<ffi.NativeFunction<vp_discovery_callbackFunction>>;
+typedef vp_discovery_callbackFunction =
+    ffi.Void Function(
+      ffi.Pointer<vp_discovery_result> result,
+      ffi.Pointer<ffi.Void> user_data,
+    );
+typedef Dartvp_discovery_callbackFunction =
+    void Function(
+      ffi.Pointer<vp_discovery_result> result,
+      ffi.Pointer<ffi.Void> user_data,
+    );
+
+/// Cost of showing one frame after a seek, see analyze_gop().
+final class vp_seek_cost extends ffi.Struct {
+  /// Presentation time of the frame in seconds.
+  @ffi.Double()
+  external double time;
+
+  /// Presentation time of the keyframe a seek to the frame decodes from.
+  @ffi.Double()
+  external double keyframe_time;
+
+  /// Frames decoded from that keyframe up to and including this one, in
+  /// decode order: 1 for a keyframe.
+  @ffi.Int()
+  external int frames;
+
+  /// Coded size of those frames in bytes, 0 if the index has no sizes.
+  @ffi.Int64()
+  external int bytes;
+}
+
+/// Keyframe structure of a video track, read from the container index.
+final class vp_gop_info extends ffi.Struct {
+  @ffi.Int()
+  external int frame_count;
+
+  @ffi.Int()
+  external int keyframe_count;
+
+  /// Every frame is a keyframe (MJPEG, ProRes, ...): any frame is one
+  /// decode away.
+  @ffi.Int()
+  external int all_intra;
+
+  /// Frames are decoded in a different order than shown (B-frames).
+  @ffi.Int()
+  external int has_b_frames;
+
+  /// Some GOP starts with frames shown before its keyframe, which refer
+  /// to the previous GOP; seeking to them decodes both.
+  @ffi.Int()
+  external int open_gop;
+
+  /// Frames per GOP, keyframe to keyframe.
+  @ffi.Int()
+  external int gop_frames_min;
+
+  @ffi.Int()
+  external int gop_frames_p50;
+
+  @ffi.Int()
+  external int gop_frames_p90;
+
+  @ffi.Int()
+  external int gop_frames_max;
+
+  /// Seconds per GOP.
+  @ffi.Double()
+  external double gop_seconds_mean;
+
+  @ffi.Double()
+  external double gop_seconds_max;
+
+  /// Frames decoded to show one frame, over every frame.
+  @ffi.Double()
+  external double seek_frames_mean;
+
+  @ffi.Int()
+  external int seek_frames_max;
+
+  /// One entry per frame in presentation order; see gop_seek_cost().
+  external ffi.Pointer<vp_seek_cost> costs;
+
+  /// Backing storage for costs. Do not touch.
+  external ffi.Pointer<ffi.Void> arena;
 }
+
+const int VP_OK = 0;
+
+const int VP_ERROR_INVALID_ARGUMENT = -1;
+
+const int VP_ERROR_NOT_FOUND = -2;
+
+const int VP_ERROR_UNSUPPORTED = -3;
+
+const int VP_ERROR_FAILED = -4;
+
+const int VP_ERROR_NO_MEMORY = -5;
+
+const int VP_ERROR_NEED_DATA = -6;
+
+const int VP_ERROR_CANCELLED = -7;
+
+const int VP_ERROR_TIMEOUT = -8;
+
+const int VP_ERROR_OVER_BUDGET = -9;
+
+const int VP_ERROR_BUFFER_TOO_SMALL = -10;
+
+const int VP_END_OF_STREAM = 1;
+
+const int VP_STREAM_VIDEO = 0;
+
+const int VP_STREAM_AUDIO = 1;
+
+const int VP_STREAM_SUBTITLE = 2;
+
+const int VP_BATCH_THUMBNAILS = 1;
+
+const int VP_BATCH_GSTREAMER_ONLY = 2;
+
+const int VP_BATCH_EMBEDDED_THUMBNAILS = 4;
+
+const int VP_IMAGE_JPEG = 1;
+
+const int VP_IMAGE_PNG = 2;
+
+const int VP_IO_AUTO = 0;
+
+const int VP_IO_PREAD = 1;
+
+const int VP_IO_MMAP = 2;
+
+const int VP_IO_URING = 3;
+
+const int VP_FRAME_JPEG = 0;
+
+const int VP_FRAME_RGBA = 1;
+
+const int VP_PRIORITY_VISIBLE = 0;
+
+const int VP_PRIORITY_PREFETCH = 1;
+
+const int VP_PRIORITY_BACKGROUND = 2;
+
+const int VP_REQUEST_MEDIA_INFO = 0;
+
+const int VP_REQUEST_FRAME = 1;
+
+const int VP_REQUEST_EMBEDDED_THUMBNAIL = 1;
+
+const int VP_STAGE_DISCOVERY = 0;
+
+const int VP_STAGE_PIPELINE_BUILD = 1;
+
+const int VP_STAGE_PREROLL = 2;
+
+const int VP_STAGE_SEEK = 3;
+
+const int VP_STAGE_DECODE = 4;
+
+const int VP_STAGE_CONVERT = 5;
+
+const int VP_STAGE_ENCODE = 6;
+
+const int VP_STAGE_COUNT = 7;
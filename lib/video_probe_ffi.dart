@@ -1,11 +1,39 @@
+import 'dart:async';
+import 'dart:convert';
 import 'dart:ffi';
 import 'dart:io';
+import 'dart:isolate';
+import 'dart:math';
 import 'dart:typed_data';
 
 import 'package:ffi/ffi.dart';
+import 'package:video_probe/video_info.dart';
 import 'package:video_probe/video_probe_bindings_generated.dart';
 import 'package:video_probe/video_probe_platform_interface.dart';
 
+/// Opens the native library for the current platform, or the one named by
+/// the `VIDEO_PROBE_LIBRARY` environment variable (used by the benchmarks
+/// to swap in a no-op backend).
+///
+/// Top-level so background isolates can open their own handle.
+DynamicLibrary _openVideoProbeLibrary() {
+  final override = Platform.environment['VIDEO_PROBE_LIBRARY'];
+  if (override != null && override.isNotEmpty) {
+    return DynamicLibrary.open(override);
+  }
+  if (Platform.isAndroid) {
+    return DynamicLibrary.open('libvideo_probe.so');
+  } else if (Platform.isLinux) {
+    return DynamicLibrary.open('libvideo_probe_plugin.so');
+  } else if (Platform.isWindows) {
+    return DynamicLibrary.open('video_probe_plugin.dll');
+  } else if (Platform.isMacOS || Platform.isIOS) {
+    // Symbols are linked into the app process via CocoaPods
+    return DynamicLibrary.process();
+  }
+  throw UnsupportedError('Unknown platform: ${Platform.operatingSystem}');
+}
+
 /// Top-level function to register FFI implementation
 /// This is called via conditional import from video_probe.dart
 void registerFfiImplementation() {
@@ -20,7 +48,7 @@ class VideoProbeFfi extends VideoProbePlatform {
   late final VideoProbeBindings _bindings;
 
   VideoProbeFfi() {
-    _dylib = _loadDynamicLibrary();
+    _dylib = _openVideoProbeLibrary();
     _bindings = VideoProbeBindings(_dylib);
   }
 
@@ -28,18 +56,14 @@ class VideoProbeFfi extends VideoProbePlatform {
     VideoProbePlatform.instance = VideoProbeFfi();
   }
 
-  DynamicLibrary _loadDynamicLibrary() {
-    if (Platform.isAndroid) {
-      return DynamicLibrary.open('libvideo_probe.so');
-    } else if (Platform.isLinux) {
-      return DynamicLibrary.open('libvideo_probe_plugin.so');
-    } else if (Platform.isWindows) {
-      return DynamicLibrary.open('video_probe_plugin.dll');
-    } else if (Platform.isMacOS || Platform.isIOS) {
-      // Symbols are linked into the app process via CocoaPods
-      return DynamicLibrary.process();
+  /// Not every backend exports the extended API yet; fail with a clear
+  /// error instead of a symbol lookup failure.
+  void _requireSymbol(String symbol) {
+    if (!_dylib.providesSymbol(symbol)) {
+      throw UnsupportedError(
+        '$symbol is not available on ${Platform.operatingSystem}.',
+      );
     }
-    throw UnsupportedError('Unknown platform: ${Platform.operatingSystem}');
   }
 
   @override
@@ -63,7 +87,21 @@ class VideoProbeFfi extends VideoProbePlatform {
   }
 
   @override
-  Future<Uint8List?> extractFrame(String path, int frameNum) async {
+  Future<Uint8List?> extractFrame(
+    String path,
+    int frameNum, {
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) async {
+    if (cancelToken != null || timeout != null) {
+      _requireSymbol('extract_frame_ex');
+      return _NativeCall(_bindings, cancelToken, timeout).run(
+        (options) => Isolate.run(
+          () => _extractFrameSync(path, frameNum, options),
+        ),
+      );
+    }
+
     final pathPtr = path.toNativeUtf8();
     final sizePtr = calloc<Int>();
 
@@ -97,4 +135,1502 @@ class VideoProbeFfi extends VideoProbePlatform {
       calloc.free(sizePtr);
     }
   }
+
+  @override
+  Future<VideoInfo?> getMediaInfo(
+    String path, {
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) async {
+    if (cancelToken != null || timeout != null) {
+      _requireSymbol('probe_media_info_ex');
+      return _NativeCall(_bindings, cancelToken, timeout).run(
+        (options) => Isolate.run(() => _probeMediaInfoSync(path, options)),
+      );
+    }
+
+    _requireSymbol('probe_media_info');
+    final pathPtr = path.toNativeUtf8();
+    final infoPtr = calloc<vp_media_info>();
+
+    try {
+      final status = _bindings.probe_media_info(pathPtr.cast(), infoPtr);
+      if (status != VP_OK) {
+        return null;
+      }
+
+      final result = videoInfoFromNative(infoPtr.ref);
+      _bindings.free_media_info(infoPtr);
+      return result;
+    } finally {
+      calloc.free(pathPtr);
+      calloc.free(infoPtr);
+    }
+  }
+
+  @override
+  Future<VideoInfo?> getMediaInfoFromBytes(
+    Uint8List bytes, {
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) async {
+    final data = malloc<Uint8>(bytes.isEmpty ? 1 : bytes.length);
+    data.asTypedList(bytes.length).setAll(0, bytes);
+    try {
+      return await _probeNativeBuffer(data, bytes.length, cancelToken, timeout);
+    } finally {
+      malloc.free(data);
+    }
+  }
+
+  @override
+  Future<Uint8List?> extractFrameFromBytes(
+    Uint8List bytes,
+    int frameNum, {
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) async {
+    final data = malloc<Uint8>(bytes.isEmpty ? 1 : bytes.length);
+    data.asTypedList(bytes.length).setAll(0, bytes);
+    try {
+      return await _extractNativeBuffer(
+        data,
+        bytes.length,
+        frameNum,
+        cancelToken,
+        timeout,
+      );
+    } finally {
+      malloc.free(data);
+    }
+  }
+
+  @override
+  Future<VideoInfo?> getMediaInfoFromStream(
+    Stream<List<int>> stream, {
+    int? length,
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) async {
+    final buffer = await _NativeBuffer.collect(stream, length);
+    try {
+      return await _probeNativeBuffer(
+        buffer.data,
+        buffer.length,
+        cancelToken,
+        timeout,
+      );
+    } finally {
+      buffer.free();
+    }
+  }
+
+  @override
+  Future<Uint8List?> extractFrameFromStream(
+    Stream<List<int>> stream,
+    int frameNum, {
+    int? length,
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) async {
+    final buffer = await _NativeBuffer.collect(stream, length);
+    try {
+      return await _extractNativeBuffer(
+        buffer.data,
+        buffer.length,
+        frameNum,
+        cancelToken,
+        timeout,
+      );
+    } finally {
+      buffer.free();
+    }
+  }
+
+  Future<VideoInfo?> _probeNativeBuffer(
+    Pointer<Uint8> data,
+    int length,
+    CancelToken? cancelToken,
+    Duration? timeout,
+  ) async {
+    if (cancelToken != null || timeout != null) {
+      _requireSymbol('probe_media_info_buffer_ex');
+      final address = data.address;
+      return _NativeCall(_bindings, cancelToken, timeout).run(
+        (options) => Isolate.run(
+          () => _probeBufferSync(address, length, options),
+        ),
+      );
+    }
+
+    _requireSymbol('probe_media_info_buffer');
+    final infoPtr = calloc<vp_media_info>();
+    try {
+      final status = _bindings.probe_media_info_buffer(data, length, infoPtr);
+      if (status != VP_OK) {
+        return null;
+      }
+
+      final result = videoInfoFromNative(infoPtr.ref);
+      _bindings.free_media_info(infoPtr);
+      return result;
+    } finally {
+      calloc.free(infoPtr);
+    }
+  }
+
+  Future<Uint8List?> _extractNativeBuffer(
+    Pointer<Uint8> data,
+    int length,
+    int frameNum,
+    CancelToken? cancelToken,
+    Duration? timeout,
+  ) async {
+    if (cancelToken != null || timeout != null) {
+      _requireSymbol('extract_frame_buffer_ex');
+      final address = data.address;
+      return _NativeCall(_bindings, cancelToken, timeout).run(
+        (options) => Isolate.run(
+          () => _extractBufferSync(address, length, frameNum, options),
+        ),
+      );
+    }
+
+    _requireSymbol('extract_frame_buffer');
+    final sizePtr = calloc<Int>();
+    try {
+      final bufferPtr = _bindings.extract_frame_buffer(
+        data,
+        length,
+        frameNum,
+        sizePtr,
+      );
+      if (bufferPtr == nullptr) {
+        return null;
+      }
+
+      final size = sizePtr.value;
+      final result = size > 0
+          ? Uint8List.fromList(bufferPtr.asTypedList(size))
+          : null;
+      _bindings.free_frame(bufferPtr);
+      return result;
+    } finally {
+      calloc.free(sizePtr);
+    }
+  }
+
+  @override
+  Future<PartialProbeResult> probePartial(
+    String path, {
+    required int totalSize,
+    List<ByteRange>? available,
+  }) async {
+    _requireSymbol('probe_media_info_partial');
+    final infoPtr = calloc<vp_media_info>();
+    try {
+      final (status, needed) = _withRanges(
+        path,
+        available,
+        (pathPtr, availablePtr, availableCount, neededPtr, capacity, countPtr) =>
+            _bindings.probe_media_info_partial(
+              pathPtr,
+              totalSize,
+              availablePtr,
+              availableCount,
+              infoPtr,
+              neededPtr,
+              capacity,
+              countPtr,
+            ),
+      );
+      if (status != VP_OK) {
+        return PartialProbeResult(
+          status: ProbeStatus.fromCode(status),
+          neededRanges: needed,
+        );
+      }
+
+      final info = videoInfoFromNative(infoPtr.ref);
+      _bindings.free_media_info(infoPtr);
+      return PartialProbeResult(status: ProbeStatus.ok, info: info);
+    } finally {
+      calloc.free(infoPtr);
+    }
+  }
+
+  @override
+  Future<List<ByteRange>> getNeededRanges(
+    String path, {
+    required int totalSize,
+    List<ByteRange>? available,
+  }) async {
+    _requireSymbol('probe_needed_ranges');
+    final (status, needed) = _withRanges(
+      path,
+      available,
+      (pathPtr, availablePtr, availableCount, neededPtr, capacity, countPtr) =>
+          _bindings.probe_needed_ranges(
+            pathPtr,
+            totalSize,
+            availablePtr,
+            availableCount,
+            neededPtr,
+            capacity,
+            countPtr,
+          ),
+    );
+    if (status != VP_OK) {
+      throw ArgumentError.value(
+        path,
+        'path',
+        'cannot be probed (${ProbeStatus.fromCode(status).name})',
+      );
+    }
+    return needed;
+  }
+
+  /// Marshals the arguments shared by the partial-file calls and collects
+  /// the needed ranges, growing the output array if the first one was too
+  /// small.
+  (int, List<ByteRange>) _withRanges(
+    String path,
+    List<ByteRange>? available,
+    int Function(
+      Pointer<Char> path,
+      Pointer<vp_byte_range> available,
+      int availableCount,
+      Pointer<vp_byte_range> needed,
+      int neededCapacity,
+      Pointer<Int> neededCount,
+    )
+    call,
+  ) {
+    final pathPtr = path.toNativeUtf8();
+    final availablePtr = available == null
+        ? nullptr
+        : calloc<vp_byte_range>(available.isEmpty ? 1 : available.length);
+    final countPtr = calloc<Int>();
+    var capacity = 8;
+    var neededPtr = calloc<vp_byte_range>(capacity);
+
+    try {
+      for (var i = 0; i < (available?.length ?? 0); i++) {
+        availablePtr[i]
+          ..offset = available![i].offset
+          ..length = available[i].length;
+      }
+
+      var status = 0;
+      for (;;) {
+        status = call(
+          pathPtr.cast(),
+          availablePtr,
+          available?.length ?? 0,
+          neededPtr,
+          capacity,
+          countPtr,
+        );
+        if (countPtr.value <= capacity) break;
+        capacity = countPtr.value;
+        calloc.free(neededPtr);
+        neededPtr = calloc<vp_byte_range>(capacity);
+      }
+
+      final needed = [
+        for (var i = 0; i < countPtr.value; i++)
+          ByteRange(neededPtr[i].offset, neededPtr[i].length),
+      ];
+      return (status, needed);
+    } finally {
+      calloc.free(pathPtr);
+      if (availablePtr != nullptr) calloc.free(availablePtr);
+      calloc.free(countPtr);
+      calloc.free(neededPtr);
+    }
+  }
+
+  @override
+  Future<List<BatchProbeResult>> probeBatch(
+    List<String> paths, {
+    bool thumbnails = false,
+    int thumbnailFrame = 0,
+    bool preferEmbeddedThumbnails = false,
+    int maxWorkers = 0,
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) {
+    _requireSymbol('probe_batch');
+    var flags = thumbnails ? VP_BATCH_THUMBNAILS : 0;
+    if (preferEmbeddedThumbnails) {
+      flags |= VP_BATCH_EMBEDDED_THUMBNAILS;
+    }
+    // The native call blocks until every file is done, so keep it off the
+    // calling isolate.
+    return _NativeCall(_bindings, cancelToken, timeout).run(
+      (options) => Isolate.run(
+        () => _probeBatchSync(paths, flags, thumbnailFrame, maxWorkers, options),
+      ),
+      throwOnCancel: false,
+    );
+  }
+
+  @override
+  Stream<BatchProbeResult> discoverMediaInfo(
+    List<String> paths, {
+    int maxInFlight = 0,
+    Duration? timeout,
+    CancelToken? cancelToken,
+  }) {
+    _requireSymbol('discovery_service_new');
+    if (maxInFlight < 0) {
+      throw ArgumentError.value(maxInFlight, 'maxInFlight');
+    }
+    return _DiscoveryStream(
+      _bindings,
+      paths,
+      maxInFlight,
+      timeout,
+      cancelToken,
+    ).stream;
+  }
+
+  @override
+  Future<GopInfo?> analyzeGop(
+    String path, {
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) {
+    _requireSymbol('analyze_gop');
+    // Remote indexes can take a while to fetch
+    return _NativeCall(_bindings, cancelToken, timeout).run(
+      (options) => Isolate.run(() => _analyzeGopSync(path, options)),
+    );
+  }
+
+  @override
+  Future<Uint8List?> getEmbeddedThumbnail(
+    String path, {
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) {
+    _requireSymbol('get_embedded_thumbnail');
+    return _NativeCall(_bindings, cancelToken, timeout).run(
+      (options) => Isolate.run(() => _embeddedThumbnailSync(path, options)),
+    );
+  }
+
+  @override
+  Future<bool> setIoBackend(IoBackend backend) async {
+    _requireSymbol('set_io_backend');
+    return _bindings.set_io_backend(backend.code) == VP_OK;
+  }
+
+  @override
+  Future<IoStats> getIoStats() async {
+    _requireSymbol('get_io_stats');
+    final statsPtr = calloc<vp_io_stats>();
+    try {
+      _bindings.get_io_stats(statsPtr);
+      final stats = statsPtr.ref;
+      return IoStats(
+        files: stats.files,
+        reads: stats.reads,
+        bytesRead: stats.bytes_read,
+        bytesFetched: stats.bytes_fetched,
+        readSyscalls: stats.read_syscalls,
+        hintSyscalls: stats.hint_syscalls,
+      );
+    } finally {
+      calloc.free(statsPtr);
+    }
+  }
+
+  @override
+  Future<ProbeMetrics> metrics({bool reset = false}) async {
+    _requireSymbol('get_metrics');
+    final metricsPtr = calloc<vp_metrics>();
+    try {
+      _bindings.get_metrics(metricsPtr);
+      if (reset) {
+        _bindings.reset_metrics();
+      }
+      final metrics = metricsPtr.ref;
+      return ProbeMetrics(
+        stages: {
+          for (final stage in ProbeStage.values)
+            stage: _stageMetrics(metrics.stages[stage.code]),
+        },
+        bytesRead: metrics.bytes_read,
+        allocations: metrics.allocations,
+        liveFrames: metrics.live_frames,
+        liveResults: metrics.live_results,
+      );
+    } finally {
+      calloc.free(metricsPtr);
+    }
+  }
+
+  @override
+  Future<bool> startTracing({int capacity = 0}) async {
+    _requireSymbol('trace_start');
+    return _bindings.trace_start(capacity) == VP_OK;
+  }
+
+  @override
+  Future<String> stopTracing() async {
+    _requireSymbol('trace_dump');
+    _bindings.trace_stop();
+    final outPtr = calloc<Pointer<Char>>();
+    final sizePtr = calloc<Int64>();
+    try {
+      final status = _bindings.trace_dump(outPtr, sizePtr);
+      if (status != VP_OK) {
+        throw StateError('trace_dump failed with status $status');
+      }
+      try {
+        return outPtr.value.cast<Utf8>().toDartString(length: sizePtr.value);
+      } finally {
+        _bindings.free_trace(outPtr.value);
+      }
+    } finally {
+      calloc.free(outPtr);
+      calloc.free(sizePtr);
+    }
+  }
+
+  @override
+  Future<bool> setMemoryBudget({int global = 0, int perRequest = 0}) async {
+    _requireSymbol('set_memory_budget');
+    return _bindings.set_memory_budget(global, perRequest) == VP_OK;
+  }
+
+  @override
+  Future<bool> setFramePoolLimit(int bytes) async {
+    _requireSymbol('set_frame_pool_limit');
+    return _bindings.set_frame_pool_limit(bytes) == VP_OK;
+  }
+
+  @override
+  Future<bool> warmup() async {
+    _requireSymbol('video_probe_warmup');
+    return _bindings.video_probe_warmup() == VP_OK;
+  }
+
+  @override
+  Future<bool> setPluginAllowlist(List<String> plugins) async {
+    _requireSymbol('set_plugin_allowlist');
+    final names = calloc<Pointer<Char>>(max(1, plugins.length));
+    for (var i = 0; i < plugins.length; i++) {
+      names[i] = plugins[i].toNativeUtf8().cast();
+    }
+    try {
+      return _bindings.set_plugin_allowlist(names, plugins.length) == VP_OK;
+    } finally {
+      for (var i = 0; i < plugins.length; i++) {
+        calloc.free(names[i]);
+      }
+      calloc.free(names);
+    }
+  }
+
+  @override
+  Future<List<FrameResult>> extractFrames(
+    String path,
+    List<int> frameNums, {
+    int maxWorkers = 0,
+    int decoderThreads = 0,
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) {
+    _requireSymbol('extract_frames');
+    return _NativeCall(_bindings, cancelToken, timeout).run(
+      (options) => Isolate.run(
+        () => _extractFramesSync(
+          path,
+          frameNums,
+          maxWorkers,
+          decoderThreads,
+          options,
+        ),
+      ),
+    );
+  }
+
+  @override
+  Stream<VideoFrame> frameStream(
+    String path, {
+    int startFrame = 0,
+    int step = 1,
+    int? endFrame,
+    int queueSize = 0,
+    CancelToken? cancelToken,
+  }) {
+    _requireSymbol('frame_iterator_next_batch');
+    return _FrameStream(_bindings, path, (
+      startFrame: startFrame,
+      step: step,
+      endFrame: endFrame ?? 0,
+      interval: 0,
+      queueSize: queueSize,
+      format: FrameFormat.jpeg,
+      batchSize: 1,
+    ), cancelToken).stream.expand((frames) => frames);
+  }
+
+  @override
+  Stream<List<VideoFrame>> sampleFrames(
+    String path, {
+    Duration interval = const Duration(seconds: 1),
+    int startFrame = 0,
+    int? endFrame,
+    FrameFormat format = FrameFormat.jpeg,
+    int batchSize = 1,
+    int queueSize = 0,
+    CancelToken? cancelToken,
+  }) {
+    _requireSymbol('frame_iterator_next_batch');
+    if (interval <= Duration.zero || batchSize < 1) {
+      throw ArgumentError('interval and batchSize must be positive');
+    }
+    return _FrameStream(_bindings, path, (
+      startFrame: startFrame,
+      step: 1,
+      endFrame: endFrame ?? 0,
+      interval: interval.inMicroseconds / 1e6,
+      queueSize: queueSize,
+      format: format,
+      batchSize: batchSize,
+    ), cancelToken).stream;
+  }
+
+  /// Shared by every scheduled request and kept for the life of the
+  /// process.
+  late final _NativeScheduler _scheduler = () {
+    _requireSymbol('scheduler_new');
+    return _NativeScheduler(_bindings);
+  }();
+
+  @override
+  ScheduledRequest<Uint8List> scheduleFrame(
+    String path,
+    int frameNum, {
+    RequestPriority priority = RequestPriority.visible,
+    int? slot,
+    Duration? timeout,
+    bool preferEmbeddedThumbnail = false,
+  }) {
+    return _scheduler.submit(
+      VP_REQUEST_FRAME,
+      path,
+      frameNum,
+      preferEmbeddedThumbnail ? VP_REQUEST_EMBEDDED_THUMBNAIL : 0,
+      priority,
+      slot,
+      timeout,
+      (result) => result.frame_size > 0
+          ? Uint8List.fromList(result.frame.asTypedList(result.frame_size))
+          : null,
+    );
+  }
+
+  @override
+  ScheduledRequest<VideoInfo> scheduleMediaInfo(
+    String path, {
+    RequestPriority priority = RequestPriority.visible,
+    int? slot,
+    Duration? timeout,
+  }) {
+    return _scheduler.submit(
+      VP_REQUEST_MEDIA_INFO,
+      path,
+      0,
+      0,
+      priority,
+      slot,
+      timeout,
+      (result) => videoInfoFromNative(result.info),
+    );
+  }
+
+  @override
+  Future<bool> setRequestPriority(int id, RequestPriority priority) async {
+    return _scheduler.setPriority(id, priority);
+  }
+
+  @override
+  Future<bool> cancelRequest(int id) async {
+    return _scheduler.cancel(id);
+  }
 }
+
+/// The native request scheduler. Results arrive on this isolate through a
+/// listener callback, whichever thread finished them.
+class _NativeScheduler {
+  _NativeScheduler(this._bindings) {
+    _callback = NativeCallable<vp_request_callbackFunction>.listener(_onResult);
+    _handle = _bindings.scheduler_new(0, _callback.nativeFunction, nullptr);
+    if (_handle == nullptr) {
+      _callback.close();
+      throw StateError('The native request scheduler could not be started.');
+    }
+  }
+
+  final VideoProbeBindings _bindings;
+  late final NativeCallable<vp_request_callbackFunction> _callback;
+  late final Pointer<vp_scheduler> _handle;
+
+  /// Completes the request with the given id from its native result.
+  final _pending = <int, void Function(vp_request_result)>{};
+
+  ScheduledRequest<T> submit<T>(
+    int kind,
+    String path,
+    int frameNum,
+    int flags,
+    RequestPriority priority,
+    int? slot,
+    Duration? timeout,
+    T? Function(vp_request_result result) convert,
+  ) {
+    final pathPtr = path.toNativeUtf8();
+    final request = calloc<vp_request>();
+    try {
+      request.ref
+        ..kind = kind
+        ..path = pathPtr.cast()
+        ..frame_num = frameNum
+        ..flags = flags
+        ..priority = priority.code
+        // Native slot 0 means none, so grid index 0 must not map to it
+        ..slot = slot == null || slot < 0 ? 0 : slot + 1
+        ..timeout_ms = timeout == null ? 0 : max(1, timeout.inMilliseconds);
+      final id = _bindings.scheduler_submit(_handle, request);
+      if (id < 0) {
+        return ScheduledRequest(
+          id,
+          Future.value(ScheduledResult(status: ProbeStatus.fromCode(id))),
+        );
+      }
+
+      // The listener posts results to this isolate's event loop, so this
+      // is registered before the request's own result can be handled
+      final completer = Completer<ScheduledResult<T>>();
+      _pending[id] = (result) {
+        final status = ProbeStatus.fromCode(result.status);
+        completer.complete(
+          ScheduledResult(
+            status: status,
+            value: status == ProbeStatus.ok ? convert(result) : null,
+            queued: Duration(microseconds: result.queued_us),
+            peakMemory: result.peak_memory,
+          ),
+        );
+      };
+      return ScheduledRequest(id, completer.future);
+    } finally {
+      calloc.free(pathPtr);
+      calloc.free(request);
+    }
+  }
+
+  bool setPriority(int id, RequestPriority priority) =>
+      _bindings.scheduler_set_priority(_handle, id, priority.code) == VP_OK;
+
+  bool cancel(int id) => _bindings.scheduler_cancel(_handle, id) == VP_OK;
+
+  void _onResult(Pointer<vp_request_result> result, Pointer<Void> userData) {
+    try {
+      _pending.remove(result.ref.id)?.call(result.ref);
+    } finally {
+      _bindings.free_request_result(result);
+    }
+  }
+}
+
+/// A native discovery service for one [VideoProbeFfi.discoverMediaInfo]
+/// call. Results arrive on this isolate through a listener callback from
+/// the service thread; the service is freed once every one has.
+class _DiscoveryStream {
+  _DiscoveryStream(
+    this._bindings,
+    this._paths,
+    this._maxInFlight,
+    this._timeout,
+    this._cancelToken,
+  ) {
+    _controller = StreamController(onListen: _start, onCancel: _stop);
+  }
+
+  final VideoProbeBindings _bindings;
+  final List<String> _paths;
+  final int _maxInFlight;
+  final Duration? _timeout;
+  final CancelToken? _cancelToken;
+  late final StreamController<BatchProbeResult> _controller;
+  late final NativeCallable<vp_discovery_callbackFunction> _callback;
+  Pointer<vp_discovery_service> _handle = nullptr;
+  final _done = Completer<void>();
+  var _stopped = false;
+
+  /// Path of each discovery not reported yet, by id.
+  final _pending = <int, String>{};
+
+  Stream<BatchProbeResult> get stream => _controller.stream;
+
+  void _start() {
+    _callback = NativeCallable<vp_discovery_callbackFunction>.listener(
+      _onResult,
+    );
+    final timeout = _timeout;
+    _handle = _bindings.discovery_service_new(
+      _maxInFlight,
+      timeout == null ? 0 : max(1, timeout.inMilliseconds),
+      _callback.nativeFunction,
+      nullptr,
+    );
+    if (_handle == nullptr) {
+      _callback.close();
+      _controller.addError(
+        StateError('The native discovery service could not be started.'),
+      );
+      _finish();
+      return;
+    }
+
+    for (final path in _paths) {
+      final pathPtr = path.toNativeUtf8();
+      try {
+        // The listener posts results to this isolate's event loop, so the
+        // id is registered before its result can be handled
+        final id = _bindings.discovery_service_submit(_handle, pathPtr.cast());
+        if (id < 0) {
+          _controller.add(
+            BatchProbeResult(path: path, status: ProbeStatus.fromCode(id)),
+          );
+        } else {
+          _pending[id] = path;
+        }
+      } finally {
+        calloc.free(pathPtr);
+      }
+    }
+    _cancelToken?.whenCancelled.then((_) => _cancelAll());
+    _closeIfDone();
+  }
+
+  void _onResult(Pointer<vp_discovery_result> result, Pointer<Void> userData) {
+    try {
+      final path = _pending.remove(result.ref.id);
+      if (path != null && !_stopped) {
+        final status = ProbeStatus.fromCode(result.ref.status);
+        _controller.add(
+          BatchProbeResult(
+            path: path,
+            status: status,
+            info: status == ProbeStatus.ok
+                ? videoInfoFromNative(result.ref.info)
+                : null,
+          ),
+        );
+      }
+    } finally {
+      _bindings.free_discovery_result(result);
+    }
+    _closeIfDone();
+  }
+
+  /// Cancelled discoveries still report, so the service is only freed
+  /// once their results are released.
+  void _cancelAll() {
+    if (_handle == nullptr) return;
+    for (final id in _pending.keys.toList()) {
+      _bindings.discovery_service_cancel(_handle, id);
+    }
+  }
+
+  Future<void> _stop() {
+    _stopped = true;
+    _cancelAll();
+    return _done.future;
+  }
+
+  void _closeIfDone() {
+    if (_pending.isNotEmpty || _handle == nullptr) return;
+    _bindings.discovery_service_free(_handle);
+    _handle = nullptr;
+    _callback.close();
+    _finish();
+  }
+
+  void _finish() {
+    if (!_stopped) _controller.close();
+    if (!_done.isCompleted) _done.complete();
+  }
+}
+
+/// The vp_call_options of one call, with a native token that follows a
+/// [CancelToken] while the call runs on a background isolate.
+class _NativeCall {
+  _NativeCall(this._bindings, CancelToken? cancelToken, Duration? timeout)
+    : _options = calloc<vp_call_options>() {
+    if (timeout != null) {
+      // 0 means no deadline natively; an elapsed timeout must still expire
+      _options.ref.timeout_ms = max(1, timeout.inMilliseconds);
+    }
+    if (cancelToken != null) {
+      final token = _bindings.cancel_token_new();
+      _options.ref.cancel = token;
+      if (cancelToken.isCancelled) {
+        _bindings.cancel_token_cancel(token);
+      } else {
+        cancelToken.whenCancelled.then((_) {
+          if (!_done) _bindings.cancel_token_cancel(token);
+        });
+      }
+    }
+  }
+
+  final VideoProbeBindings _bindings;
+  final Pointer<vp_call_options> _options;
+  var _done = false;
+
+  /// Runs [call] with the address of the options, which stay valid until
+  /// it completes. Cancelled and timed out calls throw
+  /// [ProbeCancelledException] unless [throwOnCancel] is false.
+  Future<T> run<T>(
+    Future<(int, T)> Function(int options) call, {
+    bool throwOnCancel = true,
+  }) async {
+    try {
+      final (status, value) = await call(_options.address);
+      if (throwOnCancel &&
+          (status == VP_ERROR_CANCELLED || status == VP_ERROR_TIMEOUT)) {
+        throw ProbeCancelledException(timedOut: status == VP_ERROR_TIMEOUT);
+      }
+      return value;
+    } finally {
+      _done = true;
+      if (_options.ref.cancel != nullptr) {
+        _bindings.cancel_token_free(_options.ref.cancel);
+      }
+      calloc.free(_options);
+    }
+  }
+}
+
+/// What a [_FrameStream] reads, as [vp_iterator_options] plus the batch
+/// size.
+typedef _FrameRange = ({
+  int startFrame,
+  int step,
+  int endFrame,
+  double interval,
+  int queueSize,
+  FrameFormat format,
+  int batchSize,
+});
+
+/// Frames of a native iterator, read in batches on a background isolate. A
+/// batch is only asked for while the stream is listened to and not paused,
+/// so a slow listener leaves the native queue full and the decoder waiting.
+class _FrameStream {
+  _FrameStream(this._bindings, this._path, this._range, this._cancelToken) {
+    _controller = StreamController(
+      onListen: _start,
+      onResume: _request,
+      onCancel: _stop,
+    );
+  }
+
+  final VideoProbeBindings _bindings;
+  final String _path;
+
+  final _FrameRange _range;
+  final CancelToken? _cancelToken;
+  late final StreamController<List<VideoFrame>> _controller;
+  final _responses = ReceivePort();
+  final _done = Completer<void>();
+
+  /// Takes `true` for the next batch and `false` to close the iterator.
+  SendPort? _commands;
+  var _requested = false;
+  var _stopped = false;
+
+  Stream<List<VideoFrame>> get stream => _controller.stream;
+
+  void _start() {
+    _NativeCall(_bindings, _cancelToken, null)
+        .run(_run)
+        .then<void>(
+          (_) {},
+          onError: (Object error, StackTrace stack) {
+            if (!_stopped) _controller.addError(error, stack);
+          },
+        )
+        .whenComplete(() {
+          _controller.close();
+          _done.complete();
+        });
+  }
+
+  Future<(int, Null)> _run(int options) async {
+    await Isolate.spawn(
+      _iterateFrames,
+      (_responses.sendPort, _path, _range, options),
+      onExit: _responses.sendPort,
+      onError: _responses.sendPort,
+    );
+
+    var status = VP_OK;
+    await for (final message in _responses) {
+      switch (message) {
+        case SendPort commands:
+          _commands = commands;
+          if (_stopped) {
+            commands.send(false);
+          } else {
+            _request();
+          }
+        case List<_NativeFrame> frames:
+          _requested = false;
+          _controller.add([
+            for (final (frameNum, timestamp, width, height, data) in frames)
+              VideoFrame(
+                frameNum: frameNum,
+                timestamp: Duration(microseconds: (timestamp * 1e6).round()),
+                data: data.materialize().asUint8List(),
+                width: width,
+                height: height,
+                format: _range.format,
+              ),
+          ]);
+          _request();
+        case int code:
+          status = code;
+        case List _:
+          // Uncaught error in the isolate
+          status = VP_ERROR_FAILED;
+        case null:
+          // The isolate exited
+          _responses.close();
+      }
+    }
+    if (status != VP_OK &&
+        status != VP_END_OF_STREAM &&
+        status != VP_ERROR_CANCELLED &&
+        status != VP_ERROR_TIMEOUT) {
+      throw ProbeException(ProbeStatus.fromCode(status));
+    }
+    return (status, null);
+  }
+
+  void _request() {
+    final commands = _commands;
+    if (commands != null &&
+        !_requested &&
+        !_stopped &&
+        !_controller.isPaused) {
+      _requested = true;
+      commands.send(true);
+    }
+  }
+
+  Future<void> _stop() {
+    _stopped = true;
+    _commands?.send(false);
+    return _done.future;
+  }
+}
+
+/// Native memory a byte stream is gathered into, so each chunk is copied
+/// exactly once on its way to the decoder.
+class _NativeBuffer {
+  _NativeBuffer._(this.data, this.length);
+
+  final Pointer<Uint8> data;
+  final int length;
+
+  static Future<_NativeBuffer> collect(
+    Stream<List<int>> stream,
+    int? expectedLength,
+  ) async {
+    var capacity = expectedLength != null && expectedLength > 0
+        ? expectedLength
+        : 1 << 20;
+    var data = malloc<Uint8>(capacity);
+    var length = 0;
+    try {
+      await for (final chunk in stream) {
+        if (length + chunk.length > capacity) {
+          var grown = capacity * 2;
+          while (grown < length + chunk.length) {
+            grown *= 2;
+          }
+          final next = malloc<Uint8>(grown);
+          next.asTypedList(length).setAll(0, data.asTypedList(length));
+          malloc.free(data);
+          data = next;
+          capacity = grown;
+        }
+        data.asTypedList(capacity).setAll(length, chunk);
+        length += chunk.length;
+      }
+    } catch (_) {
+      malloc.free(data);
+      rethrow;
+    }
+    return _NativeBuffer._(data, length);
+  }
+
+  void free() => malloc.free(data);
+}
+
+(int, VideoInfo?) _probeMediaInfoSync(String path, int options) {
+  final bindings = VideoProbeBindings(_openVideoProbeLibrary());
+  final pathPtr = path.toNativeUtf8();
+  final infoPtr = calloc<vp_media_info>();
+  try {
+    final status = bindings.probe_media_info_ex(
+      pathPtr.cast(),
+      Pointer.fromAddress(options),
+      infoPtr,
+    );
+    return (status, _takeMediaInfo(bindings, status, infoPtr));
+  } finally {
+    calloc.free(pathPtr);
+    calloc.free(infoPtr);
+  }
+}
+
+(int, VideoInfo?) _probeBufferSync(int data, int length, int options) {
+  final bindings = VideoProbeBindings(_openVideoProbeLibrary());
+  final infoPtr = calloc<vp_media_info>();
+  try {
+    final status = bindings.probe_media_info_buffer_ex(
+      Pointer.fromAddress(data),
+      length,
+      Pointer.fromAddress(options),
+      infoPtr,
+    );
+    return (status, _takeMediaInfo(bindings, status, infoPtr));
+  } finally {
+    calloc.free(infoPtr);
+  }
+}
+
+(int, GopInfo?) _analyzeGopSync(String path, int options) {
+  final bindings = VideoProbeBindings(_openVideoProbeLibrary());
+  final pathPtr = path.toNativeUtf8();
+  final infoPtr = calloc<vp_gop_info>();
+  try {
+    final status = bindings.analyze_gop(
+      pathPtr.cast(),
+      Pointer.fromAddress(options),
+      infoPtr,
+    );
+    if (status != VP_OK) {
+      return (status, null);
+    }
+    final info = infoPtr.ref;
+    final result = GopInfo(
+      frameCount: info.frame_count,
+      keyframeCount: info.keyframe_count,
+      allIntra: info.all_intra != 0,
+      hasBFrames: info.has_b_frames != 0,
+      openGop: info.open_gop != 0,
+      gopFramesMin: info.gop_frames_min,
+      gopFramesP50: info.gop_frames_p50,
+      gopFramesP90: info.gop_frames_p90,
+      gopFramesMax: info.gop_frames_max,
+      gopDurationMean: _seconds(info.gop_seconds_mean),
+      gopDurationMax: _seconds(info.gop_seconds_max),
+      seekFramesMean: info.seek_frames_mean,
+      seekFramesMax: info.seek_frames_max,
+      costs: [
+        for (var i = 0; i < info.frame_count; i++)
+          SeekCost(
+            position: _seconds(info.costs[i].time),
+            keyframePosition: _seconds(info.costs[i].keyframe_time),
+            frames: info.costs[i].frames,
+            bytes: info.costs[i].bytes,
+          ),
+      ],
+    );
+    bindings.free_gop_info(infoPtr);
+    return (status, result);
+  } finally {
+    calloc.free(pathPtr);
+    calloc.free(infoPtr);
+  }
+}
+
+Duration _seconds(double seconds) =>
+    Duration(microseconds: (seconds * 1e6).round());
+
+VideoInfo? _takeMediaInfo(
+  VideoProbeBindings bindings,
+  int status,
+  Pointer<vp_media_info> infoPtr,
+) {
+  if (status != VP_OK) {
+    return null;
+  }
+  final result = videoInfoFromNative(infoPtr.ref);
+  bindings.free_media_info(infoPtr);
+  return result;
+}
+
+(int, Uint8List?) _extractFrameSync(String path, int frameNum, int options) {
+  final bindings = VideoProbeBindings(_openVideoProbeLibrary());
+  final pathPtr = path.toNativeUtf8();
+  try {
+    return _takeFrame(
+      bindings,
+      (out, outSize) => bindings.extract_frame_ex(
+        pathPtr.cast(),
+        frameNum,
+        Pointer.fromAddress(options),
+        out,
+        outSize,
+      ),
+    );
+  } finally {
+    calloc.free(pathPtr);
+  }
+}
+
+(int, Uint8List?) _embeddedThumbnailSync(String path, int options) {
+  final bindings = VideoProbeBindings(_openVideoProbeLibrary());
+  final pathPtr = path.toNativeUtf8();
+  try {
+    return _takeFrame(
+      bindings,
+      (out, outSize) => bindings.get_embedded_thumbnail(
+        pathPtr.cast(),
+        Pointer.fromAddress(options),
+        out,
+        outSize,
+        nullptr,
+      ),
+    );
+  } finally {
+    calloc.free(pathPtr);
+  }
+}
+
+(int, Uint8List?) _extractBufferSync(
+  int data,
+  int length,
+  int frameNum,
+  int options,
+) {
+  final bindings = VideoProbeBindings(_openVideoProbeLibrary());
+  return _takeFrame(
+    bindings,
+    (out, outSize) => bindings.extract_frame_buffer_ex(
+      Pointer.fromAddress(data),
+      length,
+      frameNum,
+      Pointer.fromAddress(options),
+      out,
+      outSize,
+    ),
+  );
+}
+
+/// Runs one of the extract_frame_*_ex functions and copies its JPEG.
+(int, Uint8List?) _takeFrame(
+  VideoProbeBindings bindings,
+  int Function(Pointer<Pointer<Uint8>> out, Pointer<Int> outSize) extract,
+) {
+  final outPtr = calloc<Pointer<Uint8>>();
+  final sizePtr = calloc<Int>();
+  try {
+    final status = extract(outPtr, sizePtr);
+    if (status != VP_OK) {
+      return (status, null);
+    }
+    final size = sizePtr.value;
+    final result = size > 0
+        ? Uint8List.fromList(outPtr.value.asTypedList(size))
+        : null;
+    bindings.free_frame(outPtr.value);
+    return (status, result);
+  } finally {
+    calloc.free(outPtr);
+    calloc.free(sizePtr);
+  }
+}
+
+(int, List<BatchProbeResult>) _probeBatchSync(
+  List<String> paths,
+  int flags,
+  int thumbnailFrame,
+  int maxWorkers,
+  int callOptions,
+) {
+  final bindings = VideoProbeBindings(_openVideoProbeLibrary());
+
+  // Marshal every path into one allocation: the pointer table followed by
+  // the NUL-terminated UTF-8 strings it points to.
+  final encoded = paths.map(utf8.encode).toList();
+  final tableSize = paths.length * sizeOf<Pointer<Char>>();
+  final totalSize = encoded.fold(tableSize, (n, e) => n + e.length + 1);
+  final block = calloc<Uint8>(totalSize);
+  final table = block.cast<Pointer<Char>>();
+  final bytes = block.asTypedList(totalSize);
+  var offset = tableSize;
+  for (var i = 0; i < encoded.length; i++) {
+    bytes.setAll(offset, encoded[i]);
+    table[i] = (block + offset).cast();
+    offset += encoded[i].length + 1;
+  }
+
+  final options = calloc<vp_batch_options>();
+  options.ref
+    ..flags = flags
+    ..max_workers = maxWorkers
+    ..thumbnail_frame = thumbnailFrame;
+  final call = Pointer<vp_call_options>.fromAddress(callOptions).ref;
+  options.ref.call
+    ..timeout_ms = call.timeout_ms
+    ..cancel = call.cancel;
+  final result = calloc<vp_batch_result>();
+
+  try {
+    final status = bindings.probe_batch(table, paths.length, options, result);
+    if (status != VP_OK) {
+      return (
+        status,
+        [
+          for (final path in paths)
+            BatchProbeResult(path: path, status: ProbeStatus.fromCode(status)),
+        ],
+      );
+    }
+
+    final results = <BatchProbeResult>[];
+    for (var i = 0; i < result.ref.count; i++) {
+      final item = result.ref.items[i];
+      final itemStatus = ProbeStatus.fromCode(item.status);
+      final thumbnail = item.thumbnail != nullptr && item.thumbnail_size > 0
+          ? Uint8List.fromList(item.thumbnail.asTypedList(item.thumbnail_size))
+          : null;
+      results.add(
+        BatchProbeResult(
+          path: paths[i],
+          status: itemStatus,
+          info: itemStatus == ProbeStatus.ok
+              ? videoInfoFromNative(item.info)
+              : null,
+          thumbnail: thumbnail,
+        ),
+      );
+    }
+    bindings.free_batch_result(result);
+    return (status, results);
+  } finally {
+    calloc.free(block);
+    calloc.free(options);
+    calloc.free(result);
+  }
+}
+
+/// Frame number, timestamp in seconds, width, height and bytes of a frame
+/// sent from [_iterateFrames].
+typedef _NativeFrame = (int, double, int, int, TransferableTypedData);
+
+/// Entry point of the isolate behind [_FrameStream]: opens the iterator,
+/// then decodes one batch per `true` it receives until `false`, the end of
+/// the range or an error, and reports the final status.
+Future<void> _iterateFrames((SendPort, String, _FrameRange, int) args) async {
+  final (responses, path, range, callOptions) = args;
+  final bindings = VideoProbeBindings(_openVideoProbeLibrary());
+  final commands = ReceivePort();
+  final pathPtr = path.toNativeUtf8();
+  final options = calloc<vp_iterator_options>();
+  final iteratorPtr = calloc<Pointer<vp_frame_iterator>>();
+  final frames = calloc<vp_frame>(range.batchSize);
+  final count = calloc<Int>();
+  options.ref
+    ..start_frame = range.startFrame
+    ..step = range.step
+    ..end_frame = range.endFrame
+    ..interval = range.interval
+    ..queue_size = range.queueSize
+    ..format = range.format.code;
+  final call = Pointer<vp_call_options>.fromAddress(callOptions).ref;
+  options.ref.call
+    ..timeout_ms = call.timeout_ms
+    ..cancel = call.cancel;
+
+  try {
+    var status = bindings.frame_iterator_open(
+      pathPtr.cast(),
+      options,
+      iteratorPtr,
+    );
+    if (status == VP_OK) {
+      responses.send(commands.sendPort);
+      await for (final next in commands) {
+        if (next != true) break;
+        status = bindings.frame_iterator_next_batch(
+          iteratorPtr.value,
+          frames,
+          range.batchSize,
+          count,
+        );
+        if (status != VP_OK) break;
+        final batch = <_NativeFrame>[];
+        for (var i = 0; i < count.value; i++) {
+          final frame = frames[i];
+          batch.add((
+            frame.frame_num,
+            frame.timestamp,
+            frame.width,
+            frame.height,
+            TransferableTypedData.fromList([
+              frame.data.asTypedList(frame.size),
+            ]),
+          ));
+          bindings.free_frame(frame.data);
+        }
+        responses.send(batch);
+      }
+    }
+    responses.send(status);
+  } finally {
+    bindings.frame_iterator_close(iteratorPtr.value);
+    commands.close();
+    calloc.free(pathPtr);
+    calloc.free(options);
+    calloc.free(iteratorPtr);
+    calloc.free(frames);
+    calloc.free(count);
+  }
+}
+
+(int, List<FrameResult>) _extractFramesSync(
+  String path,
+  List<int> frameNums,
+  int maxWorkers,
+  int decoderThreads,
+  int callOptions,
+) {
+  final bindings = VideoProbeBindings(_openVideoProbeLibrary());
+  final pathPtr = path.toNativeUtf8();
+  final framesPtr = calloc<Int>(max(1, frameNums.length));
+  for (var i = 0; i < frameNums.length; i++) {
+    framesPtr[i] = frameNums[i];
+  }
+  final options = calloc<vp_frames_options>();
+  options.ref.max_workers = maxWorkers;
+  final call = Pointer<vp_call_options>.fromAddress(callOptions).ref;
+  options.ref.call
+    ..timeout_ms = call.timeout_ms
+    ..cancel = call.cancel
+    ..decoder_threads = decoderThreads;
+  final result = calloc<vp_frames_result>();
+
+  try {
+    final status = bindings.extract_frames(
+      pathPtr.cast(),
+      framesPtr,
+      frameNums.length,
+      options,
+      result,
+    );
+    if (status != VP_OK) {
+      return (status, const []);
+    }
+
+    // Repeated frame numbers point at the same bytes; copy them once
+    final copies = <int, Uint8List>{};
+    final results = <FrameResult>[];
+    for (var i = 0; i < result.ref.count; i++) {
+      final item = result.ref.items[i];
+      final data = item.data != nullptr && item.size > 0
+          ? copies.putIfAbsent(
+              item.data.address,
+              () => Uint8List.fromList(item.data.asTypedList(item.size)),
+            )
+          : null;
+      results.add(
+        FrameResult(
+          frameNum: frameNums[i],
+          status: ProbeStatus.fromCode(item.status),
+          data: data,
+        ),
+      );
+    }
+    bindings.free_frames_result(result);
+    return (status, results);
+  } finally {
+    calloc.free(pathPtr);
+    calloc.free(framesPtr);
+    calloc.free(options);
+    calloc.free(result);
+  }
+}
+
+String? _stringOrNull(Pointer<Char> ptr) =>
+    ptr == nullptr ? null : ptr.cast<Utf8>().toDartString();
+
+/// Copies a native [vp_media_info] into a Dart [VideoInfo].
+VideoInfo videoInfoFromNative(vp_media_info info) {
+  final streams = <MediaStreamInfo>[];
+  for (var i = 0; i < info.stream_count; i++) {
+    final stream = info.streams[i];
+    streams.add(
+      MediaStreamInfo(
+        type: MediaStreamType.values[stream.type],
+        codec: _stringOrNull(stream.codec) ?? 'unknown',
+        language: _stringOrNull(stream.language),
+        bitrate: stream.bitrate,
+        width: stream.width,
+        height: stream.height,
+        pixelAspectNum: stream.par_num,
+        pixelAspectDen: stream.par_den,
+        frameRateNum: stream.fps_num,
+        frameRateDen: stream.fps_den,
+        rotation: stream.rotation,
+        bitDepth: stream.bit_depth,
+        colorPrimaries: stream.color_primaries,
+        transfer: stream.transfer,
+        isHdr: stream.is_hdr != 0,
+        channels: stream.channels,
+        sampleRate: stream.sample_rate,
+      ),
+    );
+  }
+
+  return VideoInfo(
+    container: _stringOrNull(info.container),
+    duration: info.duration,
+    bitrate: info.bitrate,
+    frameCount: info.frame_count,
+    hasVideo: info.has_video != 0,
+    videoCodec: _stringOrNull(info.video_codec),
+    width: info.width,
+    height: info.height,
+    pixelAspectNum: info.par_num,
+    pixelAspectDen: info.par_den,
+    frameRateNum: info.fps_num,
+    frameRateDen: info.fps_den,
+    rotation: info.rotation,
+    bitDepth: info.bit_depth,
+    colorPrimaries: info.color_primaries,
+    transfer: info.transfer,
+    isHdr: info.is_hdr != 0,
+    streams: streams,
+  );
+}
+
+StageMetrics _stageMetrics(vp_stage_metrics stage) => StageMetrics(
+  count: stage.count,
+  total: Duration(microseconds: stage.total_us),
+  p50: Duration(microseconds: stage.p50_us),
+  p90: Duration(microseconds: stage.p90_us),
+  p99: Duration(microseconds: stage.p99_us),
+);
@@ -1,6 +1,9 @@
+import 'dart:math';
+
 import 'package:flutter/foundation.dart';
 import 'package:flutter/services.dart';
 
+import 'video_info.dart';
 import 'video_probe_platform_interface.dart';
 
 /// An implementation of [VideoProbePlatform] that uses method channels.
@@ -9,6 +12,50 @@ class MethodChannelVideoProbe extends VideoProbePlatform {
   @visibleForTesting
   final methodChannel = const MethodChannel('video_probe');
 
+  var _nextCallId = 0;
+
+  /// Invokes [method], which the Linux plugin answers on a worker thread.
+  ///
+  /// Returns null if it fails natively; cancellation and timeouts throw
+  /// [ProbeCancelledException] as with FFI. [cancelToken] reaches the
+  /// native call through a `cancel` call with the same id; without one
+  /// no id is sent, so the call takes no native cancel token.
+  Future<T?> _invokeProbe<T>(
+    String method,
+    Map<String, Object?> arguments, {
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) async {
+    if (cancelToken?.isCancelled ?? false) {
+      throw const ProbeCancelledException();
+    }
+    final callId = cancelToken != null ? ++_nextCallId : null;
+    var done = false;
+    cancelToken?.whenCancelled.then((_) {
+      if (!done) {
+        methodChannel.invokeMethod<void>('cancel', {'callId': callId});
+      }
+    });
+    try {
+      return await methodChannel.invokeMethod<T>(method, {
+        ...arguments,
+        if (callId != null) 'callId': callId,
+        // 0 means no deadline natively; an elapsed timeout must still expire
+        if (timeout != null) 'timeoutMs': max(1, timeout.inMilliseconds),
+      });
+    } on PlatformException catch (e) {
+      final details = e.details;
+      if (e.code != 'probeError' || details is! int) rethrow;
+      final status = ProbeStatus.fromCode(details);
+      if (status == ProbeStatus.cancelled || status == ProbeStatus.timedOut) {
+        throw ProbeCancelledException(timedOut: status == ProbeStatus.timedOut);
+      }
+      return null;
+    } finally {
+      done = true;
+    }
+  }
+
   @override
   Future<String?> getPlatformVersion() async {
     final version = await methodChannel.invokeMethod<String>(
@@ -19,23 +66,381 @@ class MethodChannelVideoProbe extends VideoProbePlatform {
 
   @override
   Future<double> getDuration(String path) async {
-    // If we were implementing MethodChannel fallback, it would go here.
+    return await _invokeProbe<double>('getDuration', {'path': path}) ?? -1.0;
+  }
+
+  @override
+  Future<int> getFrameCount(String path) async {
+    return await _invokeProbe<int>('getFrameCount', {'path': path}) ?? -1;
+  }
+
+  @override
+  Future<Uint8List?> extractFrame(
+    String path,
+    int frameNum, {
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) {
+    return _invokeProbe<Uint8List>(
+      'extractFrame',
+      {'path': path, 'frameNum': frameNum},
+      cancelToken: cancelToken,
+      timeout: timeout,
+    );
+  }
+
+  @override
+  Future<VideoInfo?> getMediaInfo(
+    String path, {
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) async {
+    final info = await _invokeProbe<Map<Object?, Object?>>(
+      'getMediaInfo',
+      {'path': path},
+      cancelToken: cancelToken,
+      timeout: timeout,
+    );
+    return info == null ? null : _videoInfoFromMap(info);
+  }
+
+  @override
+  Future<VideoInfo?> getMediaInfoFromBytes(
+    Uint8List bytes, {
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) async {
     throw UnimplementedError(
-      'getDuration() via MethodChannel is not implemented. Use FFI.',
+      'getMediaInfoFromBytes() via MethodChannel is not implemented. Use FFI.',
     );
   }
 
   @override
-  Future<int> getFrameCount(String path) async {
+  Future<Uint8List?> extractFrameFromBytes(
+    Uint8List bytes,
+    int frameNum, {
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) async {
+    throw UnimplementedError(
+      'extractFrameFromBytes() via MethodChannel is not implemented. Use FFI.',
+    );
+  }
+
+  @override
+  Future<PartialProbeResult> probePartial(
+    String path, {
+    required int totalSize,
+    List<ByteRange>? available,
+  }) async {
+    throw UnimplementedError(
+      'probePartial() via MethodChannel is not implemented. Use FFI.',
+    );
+  }
+
+  @override
+  Future<List<ByteRange>> getNeededRanges(
+    String path, {
+    required int totalSize,
+    List<ByteRange>? available,
+  }) async {
+    throw UnimplementedError(
+      'getNeededRanges() via MethodChannel is not implemented. Use FFI.',
+    );
+  }
+
+  @override
+  Future<List<BatchProbeResult>> probeBatch(
+    List<String> paths, {
+    bool thumbnails = false,
+    int thumbnailFrame = 0,
+    bool preferEmbeddedThumbnails = false,
+    int maxWorkers = 0,
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) async {
+    // A cancelled or expired batch reports it per path, as with FFI
+    final List<Object?>? items;
+    try {
+      items = await _invokeProbe<List<Object?>>(
+        'probeBatch',
+        {
+          'paths': paths,
+          'thumbnails': thumbnails,
+          'thumbnailFrame': thumbnailFrame,
+          'preferEmbeddedThumbnails': preferEmbeddedThumbnails,
+          'maxWorkers': maxWorkers,
+        },
+        cancelToken: cancelToken,
+        timeout: timeout,
+      );
+    } on ProbeCancelledException catch (e) {
+      final status = e.timedOut ? ProbeStatus.timedOut : ProbeStatus.cancelled;
+      return [
+        for (final path in paths) BatchProbeResult(path: path, status: status),
+      ];
+    }
+    if (items == null) {
+      return [
+        for (final path in paths)
+          BatchProbeResult(path: path, status: ProbeStatus.invalidArgument),
+      ];
+    }
+    return [
+      for (final (i, item) in items.cast<Map<Object?, Object?>>().indexed)
+        BatchProbeResult(
+          path: paths[i],
+          status: ProbeStatus.fromCode(item['status']! as int),
+          info: item['info'] == null
+              ? null
+              : _videoInfoFromMap(item['info']! as Map<Object?, Object?>),
+          thumbnail: item['thumbnail'] as Uint8List?,
+        ),
+    ];
+  }
+
+  @override
+  Stream<BatchProbeResult> discoverMediaInfo(
+    List<String> paths, {
+    int maxInFlight = 0,
+    Duration? timeout,
+    CancelToken? cancelToken,
+  }) {
+    throw UnimplementedError(
+      'discoverMediaInfo() via MethodChannel is not implemented. Use FFI.',
+    );
+  }
+
+  @override
+  Future<GopInfo?> analyzeGop(
+    String path, {
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) async {
+    throw UnimplementedError(
+      'analyzeGop() via MethodChannel is not implemented. Use FFI.',
+    );
+  }
+
+  @override
+  Future<Uint8List?> getEmbeddedThumbnail(
+    String path, {
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) async {
+    throw UnimplementedError(
+      'getEmbeddedThumbnail() via MethodChannel is not implemented. Use FFI.',
+    );
+  }
+
+  @override
+  Future<bool> setIoBackend(IoBackend backend) async {
+    throw UnimplementedError(
+      'setIoBackend() via MethodChannel is not implemented. Use FFI.',
+    );
+  }
+
+  @override
+  Future<IoStats> getIoStats() async {
+    throw UnimplementedError(
+      'getIoStats() via MethodChannel is not implemented. Use FFI.',
+    );
+  }
+
+  @override
+  Future<ProbeMetrics> metrics({bool reset = false}) async {
+    throw UnimplementedError(
+      'metrics() via MethodChannel is not implemented. Use FFI.',
+    );
+  }
+
+  @override
+  Future<bool> startTracing({int capacity = 0}) async {
+    throw UnimplementedError(
+      'startTracing() via MethodChannel is not implemented. Use FFI.',
+    );
+  }
+
+  @override
+  Future<String> stopTracing() async {
+    throw UnimplementedError(
+      'stopTracing() via MethodChannel is not implemented. Use FFI.',
+    );
+  }
+
+  @override
+  Future<bool> setMemoryBudget({int global = 0, int perRequest = 0}) async {
+    throw UnimplementedError(
+      'setMemoryBudget() via MethodChannel is not implemented. Use FFI.',
+    );
+  }
+
+  @override
+  Future<bool> setFramePoolLimit(int bytes) async {
+    throw UnimplementedError(
+      'setFramePoolLimit() via MethodChannel is not implemented. Use FFI.',
+    );
+  }
+
+  @override
+  Future<bool> warmup() async {
+    throw UnimplementedError(
+      'warmup() via MethodChannel is not implemented. Use FFI.',
+    );
+  }
+
+  @override
+  Future<bool> setPluginAllowlist(List<String> plugins) async {
     throw UnimplementedError(
-      'getFrameCount() via MethodChannel is not implemented. Use FFI.',
+      'setPluginAllowlist() via MethodChannel is not implemented. Use FFI.',
     );
   }
 
   @override
-  Future<Uint8List?> extractFrame(String path, int frameNum) async {
+  Future<List<FrameResult>> extractFrames(
+    String path,
+    List<int> frameNums, {
+    int maxWorkers = 0,
+    int decoderThreads = 0,
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) async {
+    final items = await _invokeProbe<List<Object?>>(
+      'extractFrames',
+      {
+        'path': path,
+        'frameNums': Int32List.fromList(frameNums),
+        'maxWorkers': maxWorkers,
+        'decoderThreads': decoderThreads,
+      },
+      cancelToken: cancelToken,
+      timeout: timeout,
+    );
+    if (items == null) return const [];
+    return [
+      for (final (i, item) in items.cast<Map<Object?, Object?>>().indexed)
+        FrameResult(
+          frameNum: frameNums[i],
+          status: ProbeStatus.fromCode(item['status']! as int),
+          data: item['data'] as Uint8List?,
+        ),
+    ];
+  }
+
+  @override
+  Stream<VideoFrame> frameStream(
+    String path, {
+    int startFrame = 0,
+    int step = 1,
+    int? endFrame,
+    int queueSize = 0,
+    CancelToken? cancelToken,
+  }) {
+    throw UnimplementedError(
+      'frameStream() via MethodChannel is not implemented. Use FFI.',
+    );
+  }
+
+  @override
+  Stream<List<VideoFrame>> sampleFrames(
+    String path, {
+    Duration interval = const Duration(seconds: 1),
+    int startFrame = 0,
+    int? endFrame,
+    FrameFormat format = FrameFormat.jpeg,
+    int batchSize = 1,
+    int queueSize = 0,
+    CancelToken? cancelToken,
+  }) {
+    throw UnimplementedError(
+      'sampleFrames() via MethodChannel is not implemented. Use FFI.',
+    );
+  }
+
+  @override
+  ScheduledRequest<Uint8List> scheduleFrame(
+    String path,
+    int frameNum, {
+    RequestPriority priority = RequestPriority.visible,
+    int? slot,
+    Duration? timeout,
+    bool preferEmbeddedThumbnail = false,
+  }) {
     throw UnimplementedError(
-      'extractFrame() via MethodChannel is not implemented. Use FFI.',
+      'scheduleFrame() via MethodChannel is not implemented. Use FFI.',
     );
   }
+
+  @override
+  ScheduledRequest<VideoInfo> scheduleMediaInfo(
+    String path, {
+    RequestPriority priority = RequestPriority.visible,
+    int? slot,
+    Duration? timeout,
+  }) {
+    throw UnimplementedError(
+      'scheduleMediaInfo() via MethodChannel is not implemented. Use FFI.',
+    );
+  }
+
+  @override
+  Future<bool> setRequestPriority(int id, RequestPriority priority) async {
+    throw UnimplementedError(
+      'setRequestPriority() via MethodChannel is not implemented. Use FFI.',
+    );
+  }
+
+  @override
+  Future<bool> cancelRequest(int id) async {
+    throw UnimplementedError(
+      'cancelRequest() via MethodChannel is not implemented. Use FFI.',
+    );
+  }
+}
+
+/// Reads a [VideoInfo] sent by the Linux plugin, keyed by its field names.
+VideoInfo _videoInfoFromMap(Map<Object?, Object?> map) {
+  final streams = (map['streams'] as List<Object?>? ?? const [])
+      .cast<Map<Object?, Object?>>();
+  return VideoInfo(
+    container: map['container'] as String?,
+    duration: map['duration']! as double,
+    bitrate: map['bitrate']! as int,
+    frameCount: map['frameCount']! as int,
+    hasVideo: map['hasVideo']! as bool,
+    videoCodec: map['videoCodec'] as String?,
+    width: map['width']! as int,
+    height: map['height']! as int,
+    pixelAspectNum: map['pixelAspectNum']! as int,
+    pixelAspectDen: map['pixelAspectDen']! as int,
+    frameRateNum: map['frameRateNum']! as int,
+    frameRateDen: map['frameRateDen']! as int,
+    rotation: map['rotation']! as int,
+    bitDepth: map['bitDepth']! as int,
+    colorPrimaries: map['colorPrimaries']! as int,
+    transfer: map['transfer']! as int,
+    isHdr: map['isHdr']! as bool,
+    streams: [
+      for (final stream in streams)
+        MediaStreamInfo(
+          type: MediaStreamType.values[stream['type']! as int],
+          codec: stream['codec']! as String,
+          language: stream['language'] as String?,
+          bitrate: stream['bitrate']! as int,
+          width: stream['width']! as int,
+          height: stream['height']! as int,
+          pixelAspectNum: stream['pixelAspectNum']! as int,
+          pixelAspectDen: stream['pixelAspectDen']! as int,
+          frameRateNum: stream['frameRateNum']! as int,
+          frameRateDen: stream['frameRateDen']! as int,
+          rotation: stream['rotation']! as int,
+          bitDepth: stream['bitDepth']! as int,
+          colorPrimaries: stream['colorPrimaries']! as int,
+          transfer: stream['transfer']! as int,
+          isHdr: stream['isHdr']! as bool,
+          channels: stream['channels']! as int,
+          sampleRate: stream['sampleRate']! as int,
+        ),
+    ],
+  );
 }
@@ -2,6 +2,7 @@ import 'dart:typed_data';
 
 import 'package:plugin_platform_interface/plugin_platform_interface.dart';
 
+import 'video_info.dart';
 import 'video_probe_method_channel.dart';
 
 abstract class VideoProbePlatform extends PlatformInterface {
@@ -37,7 +38,235 @@ abstract class VideoProbePlatform extends PlatformInterface {
     throw UnimplementedError('getFrameCount() has not been implemented.');
   }
 
-  Future<Uint8List?> extractFrame(String path, int frameNum) {
+  Future<Uint8List?> extractFrame(
+    String path,
+    int frameNum, {
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) {
     throw UnimplementedError('extractFrame() has not been implemented.');
   }
+
+  Future<VideoInfo?> getMediaInfo(
+    String path, {
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) {
+    throw UnimplementedError('getMediaInfo() has not been implemented.');
+  }
+
+  Future<VideoInfo?> getMediaInfoFromBytes(
+    Uint8List bytes, {
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) {
+    throw UnimplementedError(
+      'getMediaInfoFromBytes() has not been implemented.',
+    );
+  }
+
+  Future<Uint8List?> extractFrameFromBytes(
+    Uint8List bytes,
+    int frameNum, {
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) {
+    throw UnimplementedError(
+      'extractFrameFromBytes() has not been implemented.',
+    );
+  }
+
+  Future<PartialProbeResult> probePartial(
+    String path, {
+    required int totalSize,
+    List<ByteRange>? available,
+  }) {
+    throw UnimplementedError('probePartial() has not been implemented.');
+  }
+
+  Future<List<ByteRange>> getNeededRanges(
+    String path, {
+    required int totalSize,
+    List<ByteRange>? available,
+  }) {
+    throw UnimplementedError('getNeededRanges() has not been implemented.');
+  }
+
+  /// Collects [stream] and probes it with [getMediaInfoFromBytes].
+  ///
+  /// Implementations that can gather the chunks more cheaply override this.
+  Future<VideoInfo?> getMediaInfoFromStream(
+    Stream<List<int>> stream, {
+    int? length,
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) async {
+    return getMediaInfoFromBytes(
+      await _collect(stream),
+      cancelToken: cancelToken,
+      timeout: timeout,
+    );
+  }
+
+  /// Collects [stream] and decodes it with [extractFrameFromBytes].
+  Future<Uint8List?> extractFrameFromStream(
+    Stream<List<int>> stream,
+    int frameNum, {
+    int? length,
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) async {
+    return extractFrameFromBytes(
+      await _collect(stream),
+      frameNum,
+      cancelToken: cancelToken,
+      timeout: timeout,
+    );
+  }
+
+  static Future<Uint8List> _collect(Stream<List<int>> stream) async {
+    final builder = BytesBuilder(copy: false);
+    await for (final chunk in stream) {
+      builder.add(chunk);
+    }
+    return builder.takeBytes();
+  }
+
+  Future<List<BatchProbeResult>> probeBatch(
+    List<String> paths, {
+    bool thumbnails = false,
+    int thumbnailFrame = 0,
+    bool preferEmbeddedThumbnails = false,
+    int maxWorkers = 0,
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) {
+    throw UnimplementedError('probeBatch() has not been implemented.');
+  }
+
+  Stream<BatchProbeResult> discoverMediaInfo(
+    List<String> paths, {
+    int maxInFlight = 0,
+    Duration? timeout,
+    CancelToken? cancelToken,
+  }) {
+    throw UnimplementedError('discoverMediaInfo() has not been implemented.');
+  }
+
+  Future<GopInfo?> analyzeGop(
+    String path, {
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) {
+    throw UnimplementedError('analyzeGop() has not been implemented.');
+  }
+
+  Future<Uint8List?> getEmbeddedThumbnail(
+    String path, {
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) {
+    throw UnimplementedError('getEmbeddedThumbnail() has not been implemented.');
+  }
+
+  Future<bool> setIoBackend(IoBackend backend) {
+    throw UnimplementedError('setIoBackend() has not been implemented.');
+  }
+
+  Future<IoStats> getIoStats() {
+    throw UnimplementedError('getIoStats() has not been implemented.');
+  }
+
+  Future<ProbeMetrics> metrics({bool reset = false}) {
+    throw UnimplementedError('metrics() has not been implemented.');
+  }
+
+  Future<bool> startTracing({int capacity = 0}) {
+    throw UnimplementedError('startTracing() has not been implemented.');
+  }
+
+  Future<String> stopTracing() {
+    throw UnimplementedError('stopTracing() has not been implemented.');
+  }
+
+  Future<bool> setMemoryBudget({int global = 0, int perRequest = 0}) {
+    throw UnimplementedError('setMemoryBudget() has not been implemented.');
+  }
+
+  Future<bool> setFramePoolLimit(int bytes) {
+    throw UnimplementedError('setFramePoolLimit() has not been implemented.');
+  }
+
+  Future<bool> warmup() {
+    throw UnimplementedError('warmup() has not been implemented.');
+  }
+
+  Future<bool> setPluginAllowlist(List<String> plugins) {
+    throw UnimplementedError('setPluginAllowlist() has not been implemented.');
+  }
+
+  Future<List<FrameResult>> extractFrames(
+    String path,
+    List<int> frameNums, {
+    int maxWorkers = 0,
+    int decoderThreads = 0,
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) {
+    throw UnimplementedError('extractFrames() has not been implemented.');
+  }
+
+  Stream<VideoFrame> frameStream(
+    String path, {
+    int startFrame = 0,
+    int step = 1,
+    int? endFrame,
+    int queueSize = 0,
+    CancelToken? cancelToken,
+  }) {
+    throw UnimplementedError('frameStream() has not been implemented.');
+  }
+
+  Stream<List<VideoFrame>> sampleFrames(
+    String path, {
+    Duration interval = const Duration(seconds: 1),
+    int startFrame = 0,
+    int? endFrame,
+    FrameFormat format = FrameFormat.jpeg,
+    int batchSize = 1,
+    int queueSize = 0,
+    CancelToken? cancelToken,
+  }) {
+    throw UnimplementedError('sampleFrames() has not been implemented.');
+  }
+
+  ScheduledRequest<Uint8List> scheduleFrame(
+    String path,
+    int frameNum, {
+    RequestPriority priority = RequestPriority.visible,
+    int? slot,
+    Duration? timeout,
+    bool preferEmbeddedThumbnail = false,
+  }) {
+    throw UnimplementedError('scheduleFrame() has not been implemented.');
+  }
+
+  ScheduledRequest<VideoInfo> scheduleMediaInfo(
+    String path, {
+    RequestPriority priority = RequestPriority.visible,
+    int? slot,
+    Duration? timeout,
+  }) {
+    throw UnimplementedError('scheduleMediaInfo() has not been implemented.');
+  }
+
+  Future<bool> setRequestPriority(int id, RequestPriority priority) {
+    throw UnimplementedError(
+      'setRequestPriority() has not been implemented.',
+    );
+  }
+
+  Future<bool> cancelRequest(int id) {
+    throw UnimplementedError('cancelRequest() has not been implemented.');
+  }
 }
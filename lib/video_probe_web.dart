@@ -5,6 +5,7 @@ import 'dart:typed_data';
 import 'package:flutter_web_plugins/flutter_web_plugins.dart';
 import 'package:web/web.dart' as web;
 
+import 'video_info.dart';
 import 'video_probe_platform_interface.dart';
 
 /// JS interop extension type for video metadata
@@ -206,7 +207,17 @@ class VideoProbeWeb extends VideoProbePlatform {
   }
 
   @override
-  Future<Uint8List?> extractFrame(String path, int frameNum) async {
+  Future<Uint8List?> extractFrame(
+    String path,
+    int frameNum, {
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) async {
+    // The browser decodes on its own; only refuse work that is already
+    // cancelled
+    if (cancelToken?.isCancelled ?? false) {
+      throw const ProbeCancelledException();
+    }
     _ensureHelperInjected();
     try {
       // Get frame rate from cache or metadata
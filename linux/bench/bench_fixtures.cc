@@ -0,0 +1,314 @@
+#include "bench_fixtures.h"
+
+#include <gst/gst.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+namespace video_probe {
+namespace bench {
+
+namespace {
+
+struct Encoder {
+  const char* factory;
+  // printf format taking the keyframe interval and the B-frame count
+  const char* format;
+  // Whether the encoder honours the B-frame count
+  bool bframes;
+};
+
+// Encoders per codec, best first. Single-threaded with scene cut
+// detection off, so the output is identical across runs and keyframes
+// fall exactly every `gop` frames.
+const Encoder kH264Encoders[] = {
+    {"x264enc",
+     "x264enc key-int-max=%d bframes=%d b-adapt=false threads=1 speed-preset=ultrafast "
+     "option-string=\"scenecut=0\" ! h264parse",
+     true},
+    {"openh264enc", "openh264enc gop-size=%d multi-thread=1 ! h264parse", false},
+};
+const Encoder kH265Encoders[] = {
+    {"x265enc",
+     "x265enc key-int-max=%d speed-preset=ultrafast "
+     "option-string=\"bframes=%d:scenecut=0:frame-threads=1:pools=none\" ! h265parse",
+     true},
+};
+const Encoder kVp9Encoders[] = {
+    {"vp9enc", "vp9enc keyframe-max-dist=%d threads=1 deadline=1 cpu-used=8", false},
+};
+const Encoder kMpeg4Encoders[] = {
+    {"avenc_mpeg4", "avenc_mpeg4 gop-size=%d max-bframes=%d ! mpeg4videoparse", true},
+};
+const Encoder kMjpegEncoders[] = {
+    {"jpegenc", "jpegenc quality=85", false},
+};
+
+bool HasElement(const char* name) {
+  GstElementFactory* factory = gst_element_factory_find(name);
+  if (factory == nullptr) return false;
+  gst_object_unref(factory);
+  return true;
+}
+
+// First installed encoder able to encode `spec`, or NULL
+const Encoder* FindEncoder(const ClipSpec& spec) {
+  const Encoder* begin = nullptr;
+  const Encoder* end = nullptr;
+  switch (spec.codec) {
+    case Codec::kH264:
+      begin = std::begin(kH264Encoders), end = std::end(kH264Encoders);
+      break;
+    case Codec::kH265:
+      begin = std::begin(kH265Encoders), end = std::end(kH265Encoders);
+      break;
+    case Codec::kVp9:
+      begin = std::begin(kVp9Encoders), end = std::end(kVp9Encoders);
+      break;
+    case Codec::kMpeg4:
+      begin = std::begin(kMpeg4Encoders), end = std::end(kMpeg4Encoders);
+      break;
+    case Codec::kMjpeg:
+      begin = std::begin(kMjpegEncoders), end = std::end(kMjpegEncoders);
+      break;
+  }
+  for (const Encoder* encoder = begin; encoder != end; encoder++) {
+    if (spec.bframes > 0 && !encoder->bframes) continue;
+    if (HasElement(encoder->factory)) return encoder;
+  }
+  return nullptr;
+}
+
+const char* MuxerFactory(Container container) {
+  switch (container) {
+    case Container::kMatroska:
+      return "matroskamux";
+    case Container::kMpegTs:
+      return "mpegtsmux";
+    default:
+      return "mp4mux";
+  }
+}
+
+const char* MuxerFor(Container container) {
+  switch (container) {
+    case Container::kMp4:
+      return "mp4mux";
+    case Container::kMp4FastStart:
+      return "mp4mux faststart=true";
+    case Container::kFragmentedMp4:
+      return "mp4mux fragment-duration=1000";
+    case Container::kMatroska:
+      return "matroskamux";
+    case Container::kMpegTs:
+      return "mpegtsmux";
+  }
+  return "";
+}
+
+// Rewrites raw frame timestamps for VFR clips and tracks where the last
+// frame ends
+struct SourceState {
+  bool vfr;
+  GstClockTime tick;
+  GstClockTime next = 0;
+  guint64 index = 0;
+  GstClockTime end = 0;
+};
+
+GstPadProbeReturn OnSourceBuffer(GstPad*, GstPadProbeInfo* info, gpointer user_data) {
+  SourceState* state = static_cast<SourceState*>(user_data);
+  GstBuffer* buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+  if (state->vfr) {
+    buffer = gst_buffer_make_writable(buffer);
+    GST_BUFFER_PTS(buffer) = state->next;
+    GST_BUFFER_DTS(buffer) = GST_CLOCK_TIME_NONE;
+    GST_BUFFER_DURATION(buffer) = state->index % 3 == 2 ? state->tick * 2 : state->tick;
+    GST_PAD_PROBE_INFO_DATA(info) = buffer;
+  }
+  state->next = GST_BUFFER_PTS(buffer) + GST_BUFFER_DURATION(buffer);
+  state->end = state->next;
+  state->index++;
+  return GST_PAD_PROBE_OK;
+}
+
+struct EncodedState {
+  std::vector<GstClockTime> pts;
+  std::vector<GstClockTime> keyframes;
+};
+
+GstPadProbeReturn OnEncodedBuffer(GstPad*, GstPadProbeInfo* info, gpointer user_data) {
+  EncodedState* state = static_cast<EncodedState*>(user_data);
+  GstBuffer* buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+  if (GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_HEADER)) return GST_PAD_PROBE_OK;
+  state->pts.push_back(GST_BUFFER_PTS(buffer));
+  if (!GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT)) {
+    state->keyframes.push_back(GST_BUFFER_PTS(buffer));
+  }
+  return GST_PAD_PROBE_OK;
+}
+
+void AddProbe(GstElement* pipeline, const char* element, GstPadProbeCallback callback, gpointer user_data) {
+  GstElement* found = gst_bin_get_by_name(GST_BIN(pipeline), element);
+  GstPad* pad = gst_element_get_static_pad(found, "src");
+  gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, callback, user_data, nullptr);
+  gst_object_unref(pad);
+  gst_object_unref(found);
+}
+
+// Converts the measured buffers into presentation-order ground truth
+void FillTruth(const SourceState& source, EncodedState& encoded, ClipTruth* truth) {
+  std::sort(encoded.pts.begin(), encoded.pts.end());
+  std::sort(encoded.keyframes.begin(), encoded.keyframes.end());
+  GstClockTime first = encoded.pts.empty() ? 0 : encoded.pts.front();
+  truth->frames = static_cast<int>(encoded.pts.size());
+  truth->duration = static_cast<double>(source.end - first) / GST_SECOND;
+  truth->keyframes.clear();
+  truth->keyframe_times.clear();
+  for (GstClockTime keyframe : encoded.keyframes) {
+    auto at = std::lower_bound(encoded.pts.begin(), encoded.pts.end(), keyframe);
+    truth->keyframes.push_back(static_cast<int>(at - encoded.pts.begin()));
+    truth->keyframe_times.push_back(static_cast<double>(keyframe - first) / GST_SECOND);
+  }
+}
+
+}  // namespace
+
+const char* ContainerExtension(Container container) {
+  switch (container) {
+    case Container::kMatroska:
+      return "mkv";
+    case Container::kMpegTs:
+      return "ts";
+    default:
+      return "mp4";
+  }
+}
+
+const char* ContainerName(Container container) {
+  switch (container) {
+    case Container::kMp4:
+      return "mp4";
+    case Container::kMp4FastStart:
+      return "mp4-faststart";
+    case Container::kFragmentedMp4:
+      return "fmp4";
+    case Container::kMatroska:
+      return "mkv";
+    case Container::kMpegTs:
+      return "ts";
+  }
+  return "";
+}
+
+const char* CodecName(Codec codec) {
+  switch (codec) {
+    case Codec::kH264:
+      return "h264";
+    case Codec::kH265:
+      return "hevc";
+    case Codec::kVp9:
+      return "vp9";
+    case Codec::kMpeg4:
+      return "mpeg4";
+    case Codec::kMjpeg:
+      return "mjpeg";
+  }
+  return "";
+}
+
+bool CanEncode(Codec codec, Container container) {
+  // mpegtsmux has no mapping for VP9 or JPEG
+  if (container == Container::kMpegTs && (codec == Codec::kVp9 || codec == Codec::kMjpeg)) {
+    return false;
+  }
+  ClipSpec probe = {"", 0, 0, 0, 0, 0, 0, codec, container};
+  return FindEncoder(probe) != nullptr && HasElement(MuxerFactory(container));
+}
+
+bool EncodeClip(const ClipSpec& spec, const std::string& path, ClipTruth* truth) {
+  const Encoder* encoder = FindEncoder(spec);
+  if (encoder == nullptr) {
+    fprintf(stderr, "No %s encoder installed for %s\n", CodecName(spec.codec), spec.name.c_str());
+    return false;
+  }
+
+  gchar* encode = g_strdup_printf(encoder->format, spec.gop, spec.bframes);
+  gchar* launch = g_strdup_printf(
+      "videotestsrc name=source num-buffers=%d pattern=%d ! "
+      "video/x-raw,format=I420,width=%d,height=%d,framerate=%d/1 ! %s ! identity name=encoded ! "
+      "%s ! filesink location=\"%s\"",
+      spec.frames, spec.pattern, spec.width, spec.height, spec.fps, encode, MuxerFor(spec.container),
+      path.c_str());
+  g_free(encode);
+  GError* error = nullptr;
+  GstElement* pipeline = gst_parse_launch(launch, &error);
+  g_free(launch);
+  if (error != nullptr || pipeline == nullptr) {
+    fprintf(stderr, "Cannot build encoder for %s: %s\n", spec.name.c_str(), error ? error->message : "unknown");
+    if (error) g_error_free(error);
+    if (pipeline) gst_object_unref(pipeline);
+    return false;
+  }
+
+  SourceState source = {spec.vfr, GST_SECOND / static_cast<GstClockTime>(spec.fps)};
+  EncodedState encoded;
+  AddProbe(pipeline, "source", OnSourceBuffer, &source);
+  AddProbe(pipeline, "encoded", OnEncodedBuffer, &encoded);
+
+  gst_element_set_state(pipeline, GST_STATE_PLAYING);
+  GstBus* bus = gst_element_get_bus(pipeline);
+  GstMessage* message = gst_bus_timed_pop_filtered(
+      bus, GST_CLOCK_TIME_NONE, static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+  bool ok = message != nullptr && GST_MESSAGE_TYPE(message) == GST_MESSAGE_EOS;
+  if (!ok && message != nullptr) {
+    GError* failure = nullptr;
+    gst_message_parse_error(message, &failure, nullptr);
+    fprintf(stderr, "Encoding %s failed: %s\n", spec.name.c_str(), failure ? failure->message : "unknown");
+    if (failure) g_error_free(failure);
+  }
+  if (message) gst_message_unref(message);
+  gst_element_set_state(pipeline, GST_STATE_NULL);
+  gst_object_unref(bus);
+  gst_object_unref(pipeline);
+
+  if (ok && truth != nullptr) {
+    truth->encoder = encoder->factory;
+    FillTruth(source, encoded, truth);
+  }
+  return ok;
+}
+
+const std::string& FixtureDir() {
+  static const std::string dir = [] {
+    const char* configured = getenv("VIDEO_PROBE_BENCH_DIR");
+    if (configured != nullptr && configured[0] != '\0') {
+      g_mkdir_with_parents(configured, 0755);
+      return std::string(configured);
+    }
+    gchar* made = g_dir_make_tmp("video_probe_bench_XXXXXX", nullptr);
+    std::string result = made ? made : g_get_tmp_dir();
+    g_free(made);
+    return result;
+  }();
+  return dir;
+}
+
+Clip EnsureClip(const ClipSpec& spec) {
+  Clip clip = {spec, FixtureDir() + "/" + spec.name + "." + ContainerExtension(spec.container)};
+  if (g_file_test(clip.path.c_str(), G_FILE_TEST_EXISTS)) {
+    return clip;
+  }
+  // Encode next to the final name so an interrupted run leaves no
+  // truncated clip behind
+  std::string partial = clip.path + ".part";
+  if (!EncodeClip(spec, partial) || rename(partial.c_str(), clip.path.c_str()) != 0) {
+    remove(partial.c_str());
+    clip.path.clear();
+  }
+  return clip;
+}
+
+}  // namespace bench
+}  // namespace video_probe
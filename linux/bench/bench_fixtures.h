@@ -0,0 +1,86 @@
+#ifndef VIDEO_PROBE_BENCH_FIXTURES_H_
+#define VIDEO_PROBE_BENCH_FIXTURES_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Test clips encoded on the fly with videotestsrc, so benchmarks need no
+// media checked into the repository.
+
+namespace video_probe {
+namespace bench {
+
+enum class Codec { kH264, kH265, kVp9, kMpeg4, kMjpeg };
+
+enum class Container {
+  // MP4 as mp4mux writes it, with the moov box after the media data
+  kMp4,
+  // MP4 with the moov box before the media data
+  kMp4FastStart,
+  // Fragmented MP4 (moof/mdat pairs)
+  kFragmentedMp4,
+  kMatroska,
+  kMpegTs,
+};
+
+struct ClipSpec {
+  std::string name;
+  int width;
+  int height;
+  int fps;
+  int frames;
+  // Frames per keyframe interval
+  int gop;
+  // videotestsrc pattern, so clips of the same size differ in content
+  int pattern;
+  Codec codec = Codec::kH264;
+  Container container = Container::kMp4;
+  // Consecutive B-frames; ignored by codecs without them
+  int bframes = 0;
+  // Every third frame is shown twice as long, so the nominal rate is `fps`
+  // but frame durations vary
+  bool vfr = false;
+};
+
+// What the encoder actually produced, measured on the encoded stream.
+struct ClipTruth {
+  // Name of the encoder element used
+  std::string encoder;
+  int frames = 0;
+  double duration = 0;
+  // Presentation-order indices and times of keyframes
+  std::vector<int> keyframes;
+  std::vector<double> keyframe_times;
+};
+
+struct Clip {
+  ClipSpec spec;
+  std::string path;
+};
+
+// File extension for `container`, e.g. "mp4".
+const char* ContainerExtension(Container container);
+const char* ContainerName(Container container);
+const char* CodecName(Codec codec);
+
+// Whether `codec` can be stored in `container` and its encoder is
+// installed.
+bool CanEncode(Codec codec, Container container);
+
+// Encodes `spec` at `path`. Returns false and prints why on failure. When
+// `truth` is non-NULL it receives the frames and keyframes written.
+bool EncodeClip(const ClipSpec& spec, const std::string& path, ClipTruth* truth = nullptr);
+
+// Directory for generated clips: $VIDEO_PROBE_BENCH_DIR, or a new
+// temporary directory. Clips already there are reused.
+const std::string& FixtureDir();
+
+// Returns the clip for `spec` in FixtureDir(), encoding it if missing.
+// Returns an empty path on failure.
+Clip EnsureClip(const ClipSpec& spec);
+
+}  // namespace bench
+}  // namespace video_probe
+
+#endif  // VIDEO_PROBE_BENCH_FIXTURES_H_
@@ -0,0 +1,214 @@
+#include <benchmark/benchmark.h>
+#include <fcntl.h>
+#include <gst/gst.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "bench_fixtures.h"
+#include "video_probe.h"
+
+// Benchmarks of the native probe API on generated clips.
+//
+// Results are comparable across builds with Google Benchmark's
+// tools/compare.py:
+//   video_probe_bench --benchmark_out=new.json --benchmark_out_format=json
+//   compare.py benchmarks base.json new.json
+
+namespace video_probe {
+namespace bench {
+
+namespace {
+
+enum ClipIndex { kSmall, kFullHd };
+
+// Frame positions for extraction; every extraction builds a pipeline,
+// prerolls and then seeks, so these differ in how far the demuxer seeks
+// and how much is decoded past the keyframe
+enum Position { kFirstFrame, kKeyframe, kMidGop, kLastGop };
+
+const ClipSpec kClipSpecs[] = {
+    {"bench_360p", 640, 360, 30, 300, 30, 0},
+    {"bench_1080p", 1920, 1080, 30, 300, 60, 0},
+};
+
+constexpr int kBatchSize = 8;
+
+std::vector<Clip> clips;
+std::vector<Clip> batch_clips;
+
+const Clip& ClipArg(const benchmark::State& state) { return clips[static_cast<size_t>(state.range(0))]; }
+
+// Evicts `path` from the page cache so the next probe reads from storage
+void DropCache(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd >= 0) {
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+  }
+}
+
+// Attaches the median per-stage latencies of the iterations just run
+void ReportStages(benchmark::State& state) {
+  static const char* const kStageNames[VP_STAGE_COUNT] = {
+      "discovery", "pipeline_build", "preroll", "seek", "decode", "convert", "encode",
+  };
+  vp_metrics metrics;
+  get_metrics(&metrics);
+  for (int stage = 0; stage < VP_STAGE_COUNT; stage++) {
+    if (metrics.stages[stage].count > 0) {
+      state.counters[std::string(kStageNames[stage]) + "_p50_us"] = static_cast<double>(metrics.stages[stage].p50_us);
+    }
+  }
+  if (state.iterations() > 0) {
+    state.counters["bytes_read"] = benchmark::Counter(static_cast<double>(metrics.bytes_read),
+                                                      benchmark::Counter::kAvgIterations);
+  }
+}
+
+void BM_ProbeMediaInfo(benchmark::State& state) {
+  const Clip& clip = ClipArg(state);
+  bool cold = state.range(1) != 0;
+  reset_metrics();
+  for (auto _ : state) {
+    if (cold) {
+      state.PauseTiming();
+      DropCache(clip.path);
+      state.ResumeTiming();
+    }
+    vp_media_info info;
+    if (probe_media_info(clip.path.c_str(), &info) != VP_OK) {
+      state.SkipWithError("probe_media_info failed");
+      break;
+    }
+    free_media_info(&info);
+  }
+  ReportStages(state);
+}
+BENCHMARK(BM_ProbeMediaInfo)
+    ->ArgNames({"clip", "cold"})
+    ->ArgsProduct({{kSmall, kFullHd}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_GetDuration(benchmark::State& state) {
+  const Clip& clip = ClipArg(state);
+  for (auto _ : state) {
+    double duration = get_duration(clip.path.c_str());
+    if (duration <= 0) {
+      state.SkipWithError("get_duration failed");
+      break;
+    }
+    benchmark::DoNotOptimize(duration);
+  }
+}
+BENCHMARK(BM_GetDuration)->ArgName("clip")->Arg(kSmall)->Arg(kFullHd)->Unit(benchmark::kMillisecond);
+
+void BM_GetFrameCount(benchmark::State& state) {
+  const Clip& clip = ClipArg(state);
+  for (auto _ : state) {
+    int frames = get_frame_count(clip.path.c_str());
+    if (frames <= 0) {
+      state.SkipWithError("get_frame_count failed");
+      break;
+    }
+    benchmark::DoNotOptimize(frames);
+  }
+}
+BENCHMARK(BM_GetFrameCount)->ArgName("clip")->Arg(kSmall)->Arg(kFullHd)->Unit(benchmark::kMillisecond);
+
+void BM_ExtractFrame(benchmark::State& state) {
+  const Clip& clip = ClipArg(state);
+  const ClipSpec& spec = clip.spec;
+  int frame = 0;
+  switch (state.range(1)) {
+    case kKeyframe:
+      frame = spec.gop * 2;
+      break;
+    case kMidGop:
+      frame = spec.gop * 2 + spec.gop / 2;
+      break;
+    case kLastGop:
+      frame = spec.frames - spec.gop / 2;
+      break;
+    default:
+      break;
+  }
+
+  reset_metrics();
+  for (auto _ : state) {
+    uint8_t* jpeg = nullptr;
+    int size = 0;
+    if (extract_frame_ex(clip.path.c_str(), frame, nullptr, &jpeg, &size) != VP_OK) {
+      state.SkipWithError("extract_frame failed");
+      break;
+    }
+    free_frame(jpeg);
+  }
+  ReportStages(state);
+}
+BENCHMARK(BM_ExtractFrame)
+    ->ArgNames({"clip", "position"})
+    ->ArgsProduct({{kSmall, kFullHd}, {kFirstFrame, kKeyframe, kMidGop, kLastGop}})
+    ->Unit(benchmark::kMillisecond);
+
+void BM_ProbeBatch(benchmark::State& state) {
+  std::vector<const char*> paths;
+  for (const Clip& clip : batch_clips) paths.push_back(clip.path.c_str());
+  vp_batch_options options = {};
+  options.max_workers = static_cast<int>(state.range(0));
+  options.flags = state.range(1) ? VP_BATCH_THUMBNAILS : 0;
+
+  reset_metrics();
+  for (auto _ : state) {
+    vp_batch_result result;
+    if (probe_batch(paths.data(), static_cast<int>(paths.size()), &options, &result) != VP_OK) {
+      state.SkipWithError("probe_batch failed");
+      break;
+    }
+    for (int i = 0; i < result.count; i++) {
+      if (result.items[i].status != VP_OK) state.SkipWithError("a batch item failed");
+    }
+    free_batch_result(&result);
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(paths.size()));
+  ReportStages(state);
+}
+BENCHMARK(BM_ProbeBatch)
+    ->ArgNames({"workers", "thumbnails"})
+    ->ArgsProduct({{1, 4, 0}, {0, 1}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+bool PrepareClips() {
+  for (const ClipSpec& spec : kClipSpecs) {
+    Clip clip = EnsureClip(spec);
+    if (clip.path.empty()) return false;
+    clips.push_back(clip);
+  }
+  for (int i = 0; i < kBatchSize; i++) {
+    ClipSpec spec = {"bench_batch_" + std::to_string(i), 640, 360, 30, 90, 30, i};
+    Clip clip = EnsureClip(spec);
+    if (clip.path.empty()) return false;
+    batch_clips.push_back(clip);
+  }
+  return true;
+}
+
+}  // namespace
+
+}  // namespace bench
+}  // namespace video_probe
+
+int main(int argc, char** argv) {
+  gst_init(&argc, &argv);
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+  if (!video_probe::bench::PrepareClips()) return 1;
+  fprintf(stderr, "Clips in %s\n", video_probe::bench::FixtureDir().c_str());
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -0,0 +1,271 @@
+#include <gst/gst.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "bench_fixtures.h"
+#include "video_probe.h"
+
+// Generates a reproducible matrix of test clips with a ground-truth
+// manifest, and optionally checks the probe API against it.
+//
+//   video_probe_corpus [--out DIR] [--filter TEXT] [--quick] [--check]
+//
+// --quick skips the 4K and 8K clips, --filter only generates clips whose
+// name contains TEXT, and --check probes every clip afterwards and exits
+// non-zero on any mismatch. Clips are byte-identical across runs with the
+// same encoder versions, which the manifest records.
+
+namespace video_probe {
+namespace bench {
+
+namespace {
+
+// Every clip shows the moving ball, so inter frames carry real motion
+constexpr int kPattern = 18;
+
+std::string ClipName(const ClipSpec& spec) {
+  gchar* name = g_strdup_printf("%s_%dx%d_g%d_b%d%s_%s", CodecName(spec.codec), spec.width, spec.height, spec.gop,
+                                spec.bframes, spec.vfr ? "_vfr" : "", ContainerName(spec.container));
+  std::string result(name);
+  g_free(name);
+  return result;
+}
+
+class Matrix {
+ public:
+  // Adds a variant of the base clip: H.264, 640x360 at 30 fps, three
+  // seconds with a keyframe every second, no B-frames, MP4
+  ClipSpec& Add(Codec codec, Container container) {
+    ClipSpec spec = {"", 640, 360, 30, 90, 30, kPattern, codec, container};
+    specs_.push_back(spec);
+    return specs_.back();
+  }
+
+  // Names every clip and drops duplicates and unencodable combinations
+  std::vector<ClipSpec> Build() {
+    std::vector<ClipSpec> result;
+    std::set<std::string> seen;
+    for (ClipSpec spec : specs_) {
+      spec.name = ClipName(spec);
+      if (!seen.insert(spec.name).second) continue;
+      if (!CanEncode(spec.codec, spec.container)) {
+        fprintf(stderr, "skip %s: no encoder or muxer installed\n", spec.name.c_str());
+        continue;
+      }
+      result.push_back(spec);
+    }
+    return result;
+  }
+
+ private:
+  std::vector<ClipSpec> specs_;
+};
+
+std::vector<ClipSpec> Corpus(bool quick) {
+  static const Container kContainers[] = {
+      Container::kMp4, Container::kMp4FastStart, Container::kFragmentedMp4, Container::kMatroska, Container::kMpegTs,
+  };
+  static const Codec kCodecs[] = {Codec::kH264, Codec::kH265, Codec::kVp9, Codec::kMpeg4, Codec::kMjpeg};
+  Matrix matrix;
+
+  // Every codec in every container it fits
+  for (Codec codec : kCodecs) {
+    for (Container container : kContainers) matrix.Add(codec, container);
+  }
+
+  // Resolutions, one second each so 8K stays quick to encode
+  static const int kSizes[][2] = {{320, 240}, {1280, 720}, {1920, 1080}, {3840, 2160}, {7680, 4320}};
+  for (const auto& size : kSizes) {
+    if (quick && size[1] > 1080) continue;
+    ClipSpec& spec = matrix.Add(Codec::kH264, Container::kMp4);
+    spec.width = size[0];
+    spec.height = size[1];
+    spec.frames = 30;
+    spec.gop = 15;
+  }
+  matrix.Add(Codec::kH265, Container::kMp4);
+  if (!quick) {
+    ClipSpec& spec = matrix.Add(Codec::kH265, Container::kMp4);
+    spec.width = 3840;
+    spec.height = 2160;
+    spec.frames = 30;
+    spec.gop = 15;
+  }
+
+  // Keyframe intervals: intra only, short, and longer than the clip
+  for (int gop : {1, 12, 250}) {
+    for (Container container : {Container::kMp4, Container::kMatroska}) {
+      matrix.Add(Codec::kH264, container).gop = gop;
+    }
+  }
+
+  // B-frames reorder presentation against decode order
+  for (Container container : kContainers) {
+    matrix.Add(Codec::kH264, container).bframes = 2;
+  }
+  matrix.Add(Codec::kH264, Container::kMp4).bframes = 3;
+  matrix.Add(Codec::kH265, Container::kMp4).bframes = 3;
+  matrix.Add(Codec::kH265, Container::kMatroska).bframes = 3;
+  matrix.Add(Codec::kMpeg4, Container::kMp4).bframes = 2;
+
+  // Variable frame rate
+  for (Container container : {Container::kMp4, Container::kFragmentedMp4, Container::kMatroska, Container::kMpegTs}) {
+    matrix.Add(Codec::kH264, container).vfr = true;
+  }
+  return matrix.Build();
+}
+
+std::string EncoderVersion(const std::string& encoder) {
+  GstElementFactory* factory = gst_element_factory_find(encoder.c_str());
+  if (factory == nullptr) return "";
+  std::string version;
+  GstPlugin* plugin = gst_plugin_feature_get_plugin(GST_PLUGIN_FEATURE(factory));
+  if (plugin != nullptr) {
+    version = gst_plugin_get_version(plugin);
+    gst_object_unref(plugin);
+  }
+  gst_object_unref(factory);
+  return version;
+}
+
+void WriteEntry(FILE* out, const ClipSpec& spec, const std::string& file, const ClipTruth& truth, bool last) {
+  fprintf(out, "    {\n");
+  fprintf(out, "      \"name\": \"%s\",\n", spec.name.c_str());
+  fprintf(out, "      \"file\": \"%s\",\n", file.c_str());
+  fprintf(out, "      \"container\": \"%s\",\n", ContainerName(spec.container));
+  fprintf(out, "      \"codec\": \"%s\",\n", CodecName(spec.codec));
+  fprintf(out, "      \"encoder\": \"%s\",\n", truth.encoder.c_str());
+  fprintf(out, "      \"encoder_version\": \"%s\",\n", EncoderVersion(truth.encoder).c_str());
+  fprintf(out, "      \"width\": %d,\n", spec.width);
+  fprintf(out, "      \"height\": %d,\n", spec.height);
+  fprintf(out, "      \"fps\": %d,\n", spec.fps);
+  fprintf(out, "      \"vfr\": %s,\n", spec.vfr ? "true" : "false");
+  fprintf(out, "      \"gop\": %d,\n", spec.gop);
+  fprintf(out, "      \"bframes\": %d,\n", spec.bframes);
+  fprintf(out, "      \"frames\": %d,\n", truth.frames);
+  fprintf(out, "      \"duration\": %.6f,\n", truth.duration);
+  fprintf(out, "      \"keyframes\": [");
+  for (size_t i = 0; i < truth.keyframes.size(); i++) {
+    fprintf(out, "%s%d", i ? ", " : "", truth.keyframes[i]);
+  }
+  fprintf(out, "],\n      \"keyframe_times\": [");
+  for (size_t i = 0; i < truth.keyframe_times.size(); i++) {
+    fprintf(out, "%s%.6f", i ? ", " : "", truth.keyframe_times[i]);
+  }
+  fprintf(out, "]\n    }%s\n", last ? "" : ",");
+}
+
+// Probes `path` and prints every field that disagrees with `truth`.
+// Returns false on any mismatch.
+bool Check(const ClipSpec& spec, const std::string& path, const ClipTruth& truth) {
+  vp_media_info info;
+  int status = probe_media_info(path.c_str(), &info);
+  if (status != VP_OK) {
+    printf("FAIL %s: probe_media_info returned %d\n", spec.name.c_str(), status);
+    return false;
+  }
+  bool ok = true;
+  auto mismatch = [&](const char* field, const std::string& expected, const std::string& actual) {
+    printf("FAIL %s: %s is %s, expected %s\n", spec.name.c_str(), field, actual.c_str(), expected.c_str());
+    ok = false;
+  };
+  if (info.width != spec.width || info.height != spec.height) {
+    mismatch("size", std::to_string(spec.width) + "x" + std::to_string(spec.height),
+             std::to_string(info.width) + "x" + std::to_string(info.height));
+  }
+  if (info.video_codec == nullptr || strcmp(info.video_codec, CodecName(spec.codec)) != 0) {
+    mismatch("codec", CodecName(spec.codec), info.video_codec ? info.video_codec : "(null)");
+  }
+  // Containers round timestamps to their own timescale; allow one frame
+  if (std::fabs(info.duration - truth.duration) > 1.0 / spec.fps) {
+    mismatch("duration", std::to_string(truth.duration), std::to_string(info.duration));
+  }
+  // 0 means the frame count is unknown for this container
+  if (info.frame_count != 0 && info.frame_count != truth.frames) {
+    mismatch("frame_count", std::to_string(truth.frames), std::to_string(info.frame_count));
+  }
+  free_media_info(&info);
+  if (ok) printf("ok   %s\n", spec.name.c_str());
+  return ok;
+}
+
+int Run(int argc, char** argv) {
+  std::string out_dir = "corpus";
+  std::string filter;
+  bool quick = false;
+  bool check = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+      out_dir = argv[++i];
+    } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+      filter = argv[++i];
+    } else if (strcmp(argv[i], "--quick") == 0) {
+      quick = true;
+    } else if (strcmp(argv[i], "--check") == 0) {
+      check = true;
+    } else {
+      fprintf(stderr, "usage: %s [--out DIR] [--filter TEXT] [--quick] [--check]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (g_mkdir_with_parents(out_dir.c_str(), 0755) != 0) {
+    fprintf(stderr, "Cannot create %s\n", out_dir.c_str());
+    return 1;
+  }
+
+  struct Generated {
+    ClipSpec spec;
+    std::string file;
+    ClipTruth truth;
+  };
+  std::vector<Generated> generated;
+  int failures = 0;
+  for (const ClipSpec& spec : Corpus(quick)) {
+    if (!filter.empty() && spec.name.find(filter) == std::string::npos) continue;
+    Generated clip = {spec, spec.name + "." + ContainerExtension(spec.container), ClipTruth()};
+    fprintf(stderr, "encode %s\n", clip.file.c_str());
+    if (!EncodeClip(spec, out_dir + "/" + clip.file, &clip.truth)) {
+      failures++;
+      continue;
+    }
+    generated.push_back(clip);
+  }
+
+  std::string manifest_path = out_dir + "/manifest.json";
+  FILE* manifest = fopen(manifest_path.c_str(), "w");
+  if (manifest == nullptr) {
+    fprintf(stderr, "Cannot write %s\n", manifest_path.c_str());
+    return 1;
+  }
+  gchar* gst_version = gst_version_string();
+  fprintf(manifest, "{\n  \"version\": 1,\n  \"gstreamer\": \"%s\",\n  \"clips\": [\n", gst_version);
+  g_free(gst_version);
+  for (size_t i = 0; i < generated.size(); i++) {
+    WriteEntry(manifest, generated[i].spec, generated[i].file, generated[i].truth, i + 1 == generated.size());
+  }
+  fprintf(manifest, "  ]\n}\n");
+  fclose(manifest);
+  fprintf(stderr, "%zu clips and manifest in %s\n", generated.size(), out_dir.c_str());
+
+  if (check) {
+    for (const Generated& clip : generated) {
+      if (!Check(clip.spec, out_dir + "/" + clip.file, clip.truth)) failures++;
+    }
+  }
+  return failures == 0 ? 0 : 1;
+}
+
+}  // namespace
+
+}  // namespace bench
+}  // namespace video_probe
+
+int main(int argc, char** argv) {
+  gst_init(&argc, &argv);
+  return video_probe::bench::Run(argc, argv);
+}
@@ -0,0 +1,343 @@
+#include <gst/gst.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_fixtures.h"
+#include "video_probe.h"
+
+// Load test of the native API: N threads call it with a mix of probes and
+// extractions over a corpus for a fixed time, then report throughput, tail
+// latency, RSS and leaks.
+//
+//   video_probe_stress [--threads N] [--seconds S] [--corpus DIR]
+//                      [--extract-percent P] [--seed N] [--no-gst-leaks]
+//
+// Without --corpus it encodes a few clips like video_probe_bench does.
+// Leaks are counted two ways: frame buffers and results the library still
+// holds (vp_metrics.live_frames and live_results, which must be back to
+// zero once every call has returned and been freed), and GStreamer objects
+// created during the run and still alive, from the leaks tracer's
+// refcount hooks. Exits non-zero if the library leaked.
+
+namespace video_probe {
+namespace bench {
+
+namespace {
+
+enum Op { kProbe, kDuration, kFrameCount, kExtract, kOpCount };
+
+const char* const kOpNames[kOpCount] = {"probe_media_info", "get_duration", "get_frame_count", "extract_frame"};
+
+struct Options {
+  int threads = 4;
+  int seconds = 30;
+  std::string corpus;
+  int extract_percent = 40;
+  unsigned seed = 1;
+  bool gst_leaks = true;
+};
+
+struct Target {
+  std::string path;
+  int frames;
+};
+
+struct ThreadStats {
+  std::vector<int64_t> latency_us[kOpCount];
+  int64_t errors[kOpCount] = {};
+};
+
+int64_t NowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Resident set size from /proc, in bytes
+int64_t CurrentRss() {
+  FILE* statm = fopen("/proc/self/statm", "r");
+  if (statm == nullptr) return 0;
+  long pages = 0;
+  long resident = 0;
+  int fields = fscanf(statm, "%ld %ld", &pages, &resident);
+  fclose(statm);
+  return fields == 2 ? static_cast<int64_t>(resident) * sysconf(_SC_PAGESIZE) : 0;
+}
+
+int64_t PeakRss() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return static_cast<int64_t>(usage.ru_maxrss) * 1024;
+}
+
+double Mb(int64_t bytes) { return static_cast<double>(bytes) / (1024 * 1024); }
+
+// Runs one call, returning whether it succeeded
+bool RunOp(Op op, const Target& target, std::mt19937& random) {
+  switch (op) {
+    case kProbe: {
+      vp_media_info info;
+      if (probe_media_info(target.path.c_str(), &info) != VP_OK) return false;
+      free_media_info(&info);
+      return true;
+    }
+    case kDuration:
+      return get_duration(target.path.c_str()) > 0;
+    case kFrameCount:
+      return get_frame_count(target.path.c_str()) > 0;
+    case kExtract: {
+      int frame = static_cast<int>(random() % static_cast<unsigned>(std::max(target.frames, 1)));
+      uint8_t* jpeg = nullptr;
+      int size = 0;
+      if (extract_frame_ex(target.path.c_str(), frame, nullptr, &jpeg, &size) != VP_OK) return false;
+      free_frame(jpeg);
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+Op PickOp(const Options& options, std::mt19937& random) {
+  unsigned roll = random() % 100;
+  if (roll < static_cast<unsigned>(options.extract_percent)) return kExtract;
+  // The rest split 3:1:1 between the probe calls
+  switch (random() % 5) {
+    case 0:
+      return kDuration;
+    case 1:
+      return kFrameCount;
+    default:
+      return kProbe;
+  }
+}
+
+std::vector<Target> LoadCorpus(const Options& options) {
+  std::vector<Target> targets;
+  std::vector<std::string> paths;
+  if (!options.corpus.empty()) {
+    GDir* dir = g_dir_open(options.corpus.c_str(), 0, nullptr);
+    if (dir == nullptr) {
+      fprintf(stderr, "Cannot open %s\n", options.corpus.c_str());
+      return targets;
+    }
+    for (const gchar* name = g_dir_read_name(dir); name != nullptr; name = g_dir_read_name(dir)) {
+      if (g_str_has_suffix(name, ".mp4") || g_str_has_suffix(name, ".mkv") || g_str_has_suffix(name, ".ts") ||
+          g_str_has_suffix(name, ".mov")) {
+        paths.push_back(options.corpus + "/" + name);
+      }
+    }
+    g_dir_close(dir);
+    // Directory order is arbitrary; sort so a seed means the same calls
+    std::sort(paths.begin(), paths.end());
+  } else {
+    for (int i = 0; i < 4; i++) {
+      ClipSpec spec = {"stress_" + std::to_string(i), 640, 360, 30, 90, 30, i};
+      Clip clip = EnsureClip(spec);
+      if (!clip.path.empty()) paths.push_back(clip.path);
+    }
+  }
+  for (const std::string& path : paths) {
+    int frames = get_frame_count(path.c_str());
+    if (frames <= 0) {
+      fprintf(stderr, "skip %s: not probeable\n", path.c_str());
+      continue;
+    }
+    targets.push_back({path, frames});
+  }
+  return targets;
+}
+
+// The leaks tracer, if GST_TRACERS enabled it
+GstTracer* LeaksTracer() {
+  GList* tracers = gst_tracing_get_active_tracers();
+  GstTracer* found = nullptr;
+  for (GList* item = tracers; item != nullptr; item = item->next) {
+    GstTracer* tracer = GST_TRACER(item->data);
+    if (found == nullptr && strcmp(G_OBJECT_TYPE_NAME(tracer), "GstLeaksTracer") == 0) {
+      found = GST_TRACER(gst_object_ref(tracer));
+    }
+  }
+  g_list_free_full(tracers, gst_object_unref);
+  return found;
+}
+
+// Prints GStreamer objects created since the tracker started and still
+// alive, by type. Returns their number.
+int ReportGstLeaks(GstTracer* tracer) {
+  GstStructure* checkpoint = nullptr;
+  g_signal_emit_by_name(tracer, "activity-get-checkpoint", &checkpoint);
+  if (checkpoint == nullptr) return 0;
+  const GValue* created = gst_structure_get_value(checkpoint, "objects-created-list");
+  std::map<std::string, int> by_type;
+  guint count = created != nullptr ? gst_value_list_get_size(created) : 0;
+  for (guint i = 0; i < count; i++) {
+    const GstStructure* object = gst_value_get_structure(gst_value_list_get_value(created, i));
+    const gchar* type = gst_structure_get_string(object, "type-name");
+    by_type[type != nullptr ? type : "?"]++;
+  }
+  gst_structure_free(checkpoint);
+  for (const auto& entry : by_type) {
+    printf("  %-32s %d\n", entry.first.c_str(), entry.second);
+  }
+  return static_cast<int>(count);
+}
+
+int64_t Percentile(const std::vector<int64_t>& sorted, double fraction) {
+  if (sorted.empty()) return 0;
+  size_t rank = static_cast<size_t>(fraction * static_cast<double>(sorted.size()));
+  return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+bool ParseOptions(int argc, char** argv, Options* options) {
+  for (int i = 1; i < argc; i++) {
+    bool has_value = i + 1 < argc;
+    if (strcmp(argv[i], "--threads") == 0 && has_value) {
+      options->threads = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--seconds") == 0 && has_value) {
+      options->seconds = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--corpus") == 0 && has_value) {
+      options->corpus = argv[++i];
+    } else if (strcmp(argv[i], "--extract-percent") == 0 && has_value) {
+      options->extract_percent = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--seed") == 0 && has_value) {
+      options->seed = static_cast<unsigned>(strtoul(argv[++i], nullptr, 10));
+    } else if (strcmp(argv[i], "--no-gst-leaks") == 0) {
+      options->gst_leaks = false;
+    } else {
+      return false;
+    }
+  }
+  return options->threads > 0 && options->seconds > 0 && options->extract_percent >= 0 &&
+         options->extract_percent <= 100;
+}
+
+int Run(const Options& options) {
+  std::vector<Target> targets = LoadCorpus(options);
+  if (targets.empty()) {
+    fprintf(stderr, "No clips to run against\n");
+    return 1;
+  }
+
+  // Warm up every path once so plugin loading, registry caches and first
+  // use allocations are not counted as growth or leaks
+  std::mt19937 warmup(options.seed);
+  for (const Target& target : targets) {
+    for (int op = 0; op < kOpCount; op++) RunOp(static_cast<Op>(op), target, warmup);
+  }
+  GstTracer* tracer = options.gst_leaks ? LeaksTracer() : nullptr;
+  if (tracer != nullptr) g_signal_emit_by_name(tracer, "activity-start-tracking");
+  reset_metrics();
+  int64_t start_rss = CurrentRss();
+
+  printf("%d threads, %d s, %zu clips, %d%% extraction\n", options.threads, options.seconds, targets.size(),
+         options.extract_percent);
+  std::atomic<bool> stop{false};
+  std::atomic<int64_t> completed{0};
+  std::vector<ThreadStats> stats(static_cast<size_t>(options.threads));
+  std::vector<std::thread> workers;
+  int64_t started = NowUs();
+  for (int t = 0; t < options.threads; t++) {
+    workers.emplace_back([&, t] {
+      std::mt19937 random(options.seed + static_cast<unsigned>(t) + 1);
+      ThreadStats& own = stats[static_cast<size_t>(t)];
+      while (!stop.load(std::memory_order_relaxed)) {
+        const Target& target = targets[random() % targets.size()];
+        Op op = PickOp(options, random);
+        int64_t begin = NowUs();
+        bool ok = RunOp(op, target, random);
+        own.latency_us[op].push_back(NowUs() - begin);
+        if (!ok) own.errors[op]++;
+        completed.fetch_add(1, std::memory_order_relaxed);
+      }
+    });
+  }
+
+  // Sample once a second so RSS creep shows up while it happens
+  int64_t max_rss = start_rss;
+  for (int second = 1; second <= options.seconds; second++) {
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    int64_t rss = CurrentRss();
+    max_rss = std::max(max_rss, rss);
+    vp_metrics metrics;
+    get_metrics(&metrics);
+    printf("t=%3ds ops=%-8lld rss=%.1fMB live_frames=%lld live_results=%lld\n", second,
+           static_cast<long long>(completed.load()), Mb(rss), static_cast<long long>(metrics.live_frames),
+           static_cast<long long>(metrics.live_results));
+    fflush(stdout);
+  }
+  stop = true;
+  for (std::thread& worker : workers) worker.join();
+  double elapsed = static_cast<double>(NowUs() - started) / 1e6;
+
+  printf("\n%-18s %9s %7s %9s %10s %10s %10s\n", "call", "count", "errors", "ops/s", "p50_ms", "p99_ms",
+         "p999_ms");
+  int64_t total = 0;
+  for (int op = 0; op < kOpCount; op++) {
+    std::vector<int64_t> latencies;
+    int64_t errors = 0;
+    for (ThreadStats& own : stats) {
+      latencies.insert(latencies.end(), own.latency_us[op].begin(), own.latency_us[op].end());
+      errors += own.errors[op];
+    }
+    std::sort(latencies.begin(), latencies.end());
+    total += static_cast<int64_t>(latencies.size());
+    printf("%-18s %9zu %7lld %9.1f %10.2f %10.2f %10.2f\n", kOpNames[op], latencies.size(),
+           static_cast<long long>(errors), static_cast<double>(latencies.size()) / elapsed,
+           Percentile(latencies, 0.50) / 1000.0, Percentile(latencies, 0.99) / 1000.0,
+           Percentile(latencies, 0.999) / 1000.0);
+  }
+  printf("%-18s %9lld %7s %9.1f\n", "total", static_cast<long long>(total), "",
+         static_cast<double>(total) / elapsed);
+
+  int64_t end_rss = CurrentRss();
+  printf("\nrss: start %.1fMB, end %.1fMB (%+.1fMB), max sampled %.1fMB, peak %.1fMB\n", Mb(start_rss),
+         Mb(end_rss), Mb(end_rss - start_rss), Mb(max_rss), Mb(PeakRss()));
+
+  vp_metrics metrics;
+  get_metrics(&metrics);
+  printf("leaked frame buffers: %lld\nleaked results: %lld\n", static_cast<long long>(metrics.live_frames),
+         static_cast<long long>(metrics.live_results));
+  if (tracer != nullptr) {
+    printf("GStreamer objects created during the run and still alive:\n");
+    int alive = ReportGstLeaks(tracer);
+    printf("  %-32s %d\n", "total", alive);
+    gst_object_unref(tracer);
+  } else if (options.gst_leaks) {
+    printf("GStreamer leak tracking unavailable (needs the leaks tracer, GStreamer 1.18+)\n");
+  }
+  return metrics.live_frames == 0 && metrics.live_results == 0 ? 0 : 1;
+}
+
+}  // namespace
+
+}  // namespace bench
+}  // namespace video_probe
+
+int main(int argc, char** argv) {
+  video_probe::bench::Options options;
+  if (!video_probe::bench::ParseOptions(argc, argv, &options)) {
+    fprintf(stderr,
+            "usage: %s [--threads N] [--seconds S] [--corpus DIR] [--extract-percent P] [--seed N] "
+            "[--no-gst-leaks]\n",
+            argv[0]);
+    return 2;
+  }
+  // Tracers are only loaded by gst_init(), so this has to come first.
+  // An explicit GST_TRACERS wins.
+  if (options.gst_leaks) setenv("GST_TRACERS", "leaks", 0);
+  gst_init(&argc, &argv);
+  return video_probe::bench::Run(options);
+}
@@ -0,0 +1,156 @@
+#ifndef VIDEO_PROBE_LOOPBACK_HTTP_SERVER_H_
+#define VIDEO_PROBE_LOOPBACK_HTTP_SERVER_H_
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace video_probe {
+namespace test {
+
+// Minimal HTTP/1.1 server on 127.0.0.1 serving one in-memory object at
+// /video.mp4, with Range and keep-alive support. Counts requests and body
+// bytes so tests can check how much a probe transfers.
+class LoopbackHttpServer {
+ public:
+  explicit LoopbackHttpServer(std::vector<uint8_t> body, bool ranges = true)
+      : body_(std::move(body)), ranges_(ranges) {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    listen(listen_fd_, 8);
+    socklen_t len = sizeof(addr);
+    getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+    port_ = ntohs(addr.sin_port);
+    thread_ = std::thread([this] { Serve(); });
+  }
+
+  ~LoopbackHttpServer() {
+    stop_ = true;
+    thread_.join();
+    close(listen_fd_);
+  }
+
+  std::string Url(const char* path = "/video.mp4") const {
+    return "http://127.0.0.1:" + std::to_string(port_) + path;
+  }
+
+  int requests() const { return requests_; }
+  int64_t bytes_sent() const { return bytes_sent_; }
+
+  // While stalled, requests are read but not answered, like a hung server
+  void set_stalled(bool stalled) { stalled_ = stalled; }
+
+ private:
+  // Waits until `fd` is readable or the server stops
+  bool WaitReadable(int fd) {
+    while (!stop_) {
+      pollfd p = {fd, POLLIN, 0};
+      int n = poll(&p, 1, 50);
+      if (n > 0) return true;
+      if (n < 0) return false;
+    }
+    return false;
+  }
+
+  void Serve() {
+    while (WaitReadable(listen_fd_)) {
+      int fd = accept(listen_fd_, nullptr, nullptr);
+      if (fd < 0) continue;
+      HandleConnection(fd);
+      close(fd);
+    }
+  }
+
+  void HandleConnection(int fd) {
+    std::string pending;
+    char buf[4096];
+    while (WaitReadable(fd)) {
+      ssize_t n = recv(fd, buf, sizeof(buf), 0);
+      if (n <= 0) return;
+      pending.append(buf, static_cast<size_t>(n));
+      size_t end;
+      while ((end = pending.find("\r\n\r\n")) != std::string::npos) {
+        std::string request = pending.substr(0, end);
+        pending.erase(0, end + 4);
+        if (!Respond(fd, request)) return;
+      }
+    }
+  }
+
+  bool Respond(int fd, const std::string& request) {
+    requests_++;
+    while (stalled_ && !stop_) {
+      poll(nullptr, 0, 10);
+    }
+    size_t path_start = request.find(' ') + 1;
+    std::string path = request.substr(path_start, request.find(' ', path_start) - path_start);
+    if (path != "/video.mp4") {
+      return Send(fd, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n", nullptr, 0);
+    }
+
+    int64_t size = static_cast<int64_t>(body_.size());
+    int64_t first = 0;
+    int64_t last = size - 1;
+    size_t range = request.find("Range: bytes=");
+    if (ranges_ && range != std::string::npos) {
+      long long a = 0, b = -1;
+      int fields = sscanf(request.c_str() + range, "Range: bytes=%lld-%lld", &a, &b);
+      first = a;
+      if (fields == 2 && b < last) last = b;
+      if (first >= size) {
+        return Send(fd, "HTTP/1.1 416 Range Not Satisfiable\r\nContent-Length: 0\r\n\r\n", nullptr, 0);
+      }
+      std::string head = "HTTP/1.1 206 Partial Content\r\nContent-Length: " +
+                         std::to_string(last - first + 1) + "\r\nContent-Range: bytes " +
+                         std::to_string(first) + "-" + std::to_string(last) + "/" +
+                         std::to_string(size) + "\r\n\r\n";
+      return Send(fd, head, body_.data() + first, last - first + 1);
+    }
+    std::string head = "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(size) + "\r\n\r\n";
+    return Send(fd, head, body_.data(), size);
+  }
+
+  bool Send(int fd, const std::string& head, const uint8_t* data, int64_t size) {
+    if (send(fd, head.data(), head.size(), MSG_NOSIGNAL) < 0) return false;
+    int64_t sent = 0;
+    while (sent < size) {
+      ssize_t n = send(fd, data + sent, static_cast<size_t>(size - sent), MSG_NOSIGNAL);
+      // The client may hang up early, e.g. after refusing a full reply
+      if (n <= 0) return false;
+      sent += n;
+      bytes_sent_ += n;
+    }
+    return true;
+  }
+
+  std::vector<uint8_t> body_;
+  bool ranges_;
+  int listen_fd_ = -1;
+  int port_ = 0;
+  std::atomic<bool> stop_{false};
+  std::atomic<bool> stalled_{false};
+  std::atomic<int> requests_{0};
+  std::atomic<int64_t> bytes_sent_{0};
+  std::thread thread_;
+};
+
+}  // namespace test
+}  // namespace video_probe
+
+#endif  // VIDEO_PROBE_LOOPBACK_HTTP_SERVER_H_
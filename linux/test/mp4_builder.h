@@ -0,0 +1,246 @@
+#ifndef VIDEO_PROBE_MP4_BUILDER_H_
+#define VIDEO_PROBE_MP4_BUILDER_H_
+
+#include <stdlib.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+// Assembles MP4 files box by box so every field the parser reads has a
+// known value.
+
+namespace video_probe {
+namespace test {
+
+using Bytes = std::vector<uint8_t>;
+
+inline void Put16(Bytes& b, uint32_t v) {
+  b.push_back(static_cast<uint8_t>(v >> 8));
+  b.push_back(static_cast<uint8_t>(v));
+}
+
+inline void Put32(Bytes& b, uint32_t v) {
+  Put16(b, v >> 16);
+  Put16(b, v & 0xffff);
+}
+
+inline void PutZeros(Bytes& b, size_t n) { b.insert(b.end(), n, 0); }
+
+inline Bytes Box(const char* type, const Bytes& payload) {
+  Bytes b;
+  Put32(b, static_cast<uint32_t>(payload.size() + 8));
+  b.insert(b.end(), type, type + 4);
+  b.insert(b.end(), payload.begin(), payload.end());
+  return b;
+}
+
+inline Bytes Concat(std::initializer_list<Bytes> parts) {
+  Bytes b;
+  for (const Bytes& part : parts) b.insert(b.end(), part.begin(), part.end());
+  return b;
+}
+
+inline Bytes Tkhd(uint32_t track_id, int rotation) {
+  Bytes b;
+  PutZeros(b, 12);  // version/flags, creation, modification
+  Put32(b, track_id);
+  PutZeros(b, 4 + 4 + 8 + 8);  // reserved, duration, reserved, layer..volume
+  int32_t a = 0x10000, bb = 0, c = 0, d = 0x10000;
+  if (rotation == 90) { a = 0; bb = 0x10000; c = -0x10000; d = 0; }
+  Put32(b, a); Put32(b, bb); Put32(b, 0);
+  Put32(b, c); Put32(b, d); Put32(b, 0);
+  Put32(b, 0); Put32(b, 0); Put32(b, 0x40000000);
+  PutZeros(b, 8);  // width, height
+  return Box("tkhd", b);
+}
+
+inline Bytes Mdhd(uint32_t timescale, uint32_t duration, const char* lang) {
+  Bytes b;
+  PutZeros(b, 12);
+  Put32(b, timescale);
+  Put32(b, duration);
+  Put16(b, ((lang[0] - 0x60) << 10) | ((lang[1] - 0x60) << 5) | (lang[2] - 0x60));
+  PutZeros(b, 2);
+  return Box("mdhd", b);
+}
+
+inline Bytes Hdlr(const char* handler) {
+  Bytes b;
+  PutZeros(b, 8);
+  b.insert(b.end(), handler, handler + 4);
+  PutZeros(b, 13);
+  return Box("hdlr", b);
+}
+
+// Visual sample entry of `type`, with the colr and pasp boxes of Avc1()
+inline Bytes VisualEntry(const char* type, uint16_t width, uint16_t height) {
+  Bytes b;
+  PutZeros(b, 6);
+  Put16(b, 1);  // data reference index
+  PutZeros(b, 16);
+  Put16(b, width);
+  Put16(b, height);
+  PutZeros(b, 4 + 4 + 4 + 2 + 32);
+  Put16(b, 0x18);
+  Put16(b, 0xffff);
+  // colr nclx: BT.2020 primaries with PQ transfer
+  Bytes colr = {'n', 'c', 'l', 'x'};
+  Put16(colr, 9);
+  Put16(colr, 16);
+  Put16(colr, 9);
+  colr.push_back(0);
+  Bytes pasp;
+  Put32(pasp, 4);
+  Put32(pasp, 3);
+  return Box(type, Concat({b, Box("colr", colr), Box("pasp", pasp)}));
+}
+
+inline Bytes Avc1(uint16_t width, uint16_t height) { return VisualEntry("avc1", width, height); }
+
+inline Bytes Mp4a(uint16_t channels, uint32_t rate) {
+  Bytes b;
+  PutZeros(b, 6);
+  Put16(b, 1);
+  PutZeros(b, 8);  // version, revision, vendor
+  Put16(b, channels);
+  Put16(b, 16);
+  PutZeros(b, 4);
+  Put32(b, rate << 16);
+  return Box("mp4a", b);
+}
+
+// `extra` boxes (stss, ctts) are appended to the sample table
+inline Bytes Stbl(const Bytes& entry, uint32_t delta, uint32_t samples, const Bytes& extra = {}) {
+  Bytes stsd;
+  PutZeros(stsd, 4);
+  Put32(stsd, 1);
+  stsd.insert(stsd.end(), entry.begin(), entry.end());
+
+  Bytes stts;
+  PutZeros(stts, 4);
+  Put32(stts, 1);
+  Put32(stts, samples);
+  Put32(stts, delta);
+
+  Bytes stsz;
+  PutZeros(stsz, 4);
+  Put32(stsz, 1000);  // constant sample size
+  Put32(stsz, samples);
+
+  return Box("stbl", Concat({Box("stsd", stsd), Box("stts", stts), Box("stsz", stsz), extra}));
+}
+
+// Sync sample table listing the 1-based `samples`
+inline Bytes Stss(std::initializer_list<uint32_t> samples) {
+  Bytes b;
+  PutZeros(b, 4);
+  Put32(b, static_cast<uint32_t>(samples.size()));
+  for (uint32_t sample : samples) Put32(b, sample);
+  return Box("stss", b);
+}
+
+// Composition offsets as (sample count, offset) runs
+inline Bytes Ctts(std::initializer_list<std::pair<uint32_t, uint32_t>> runs) {
+  Bytes b;
+  PutZeros(b, 4);
+  Put32(b, static_cast<uint32_t>(runs.size()));
+  for (const auto& run : runs) {
+    Put32(b, run.first);
+    Put32(b, run.second);
+  }
+  return Box("ctts", b);
+}
+
+// Sample dependency table with one flags byte per sample
+inline Bytes Sdtp(std::initializer_list<uint8_t> flags) {
+  Bytes b;
+  PutZeros(b, 4);
+  b.insert(b.end(), flags.begin(), flags.end());
+  return Box("sdtp", b);
+}
+
+// Sample-to-chunk table as (first chunk, samples per chunk) runs
+inline Bytes Stsc(std::initializer_list<std::pair<uint32_t, uint32_t>> runs) {
+  Bytes b;
+  PutZeros(b, 4);
+  Put32(b, static_cast<uint32_t>(runs.size()));
+  for (const auto& run : runs) {
+    Put32(b, run.first);
+    Put32(b, run.second);
+    Put32(b, 1);  // sample description index
+  }
+  return Box("stsc", b);
+}
+
+// 32-bit chunk offset table
+inline Bytes Stco(std::initializer_list<uint32_t> offsets) {
+  Bytes b;
+  PutZeros(b, 4);
+  Put32(b, static_cast<uint32_t>(offsets.size()));
+  for (uint32_t offset : offsets) Put32(b, offset);
+  return Box("stco", b);
+}
+
+// Edit list with one edit starting at `media_time`
+inline Bytes Edts(uint32_t media_time) {
+  Bytes b;
+  PutZeros(b, 4);
+  Put32(b, 1);
+  Put32(b, 0);  // segment duration
+  Put32(b, media_time);
+  Put32(b, 0x10000);  // rate 1.0
+  return Box("edts", Box("elst", b));
+}
+
+inline Bytes Trak(uint32_t id, int rotation, const char* handler, uint32_t timescale,
+           uint32_t duration, const char* lang, const Bytes& stbl, const Bytes& edts = {}) {
+  Bytes minf = Box("minf", stbl);
+  Bytes mdia = Box("mdia", Concat({Mdhd(timescale, duration, lang), Hdlr(handler), minf}));
+  return Box("trak", Concat({Tkhd(id, rotation), edts, mdia}));
+}
+
+inline Bytes Mvhd(uint32_t timescale, uint32_t duration) {
+  Bytes b;
+  PutZeros(b, 12);
+  Put32(b, timescale);
+  Put32(b, duration);
+  PutZeros(b, 80);
+  return Box("mvhd", b);
+}
+
+inline Bytes Ftyp() {
+  Bytes b = {'i', 's', 'o', 'm'};
+  Put32(b, 0x200);
+  b.insert(b.end(), {'i', 's', 'o', 'm', 'a', 'v', 'c', '1'});
+  return Box("ftyp", b);
+}
+
+// 10 second clip: 250 frames of 25 fps video plus 48 kHz stereo audio
+inline Bytes SampleMovie(int rotation) {
+  Bytes video = Trak(1, rotation, "vide", 12800, 128000, "und",
+                     Stbl(Avc1(1920, 1080), 512, 250));
+  Bytes audio = Trak(2, 0, "soun", 48000, 480000, "eng",
+                     Stbl(Mp4a(2, 48000), 1024, 469));
+  return Box("moov", Concat({Mvhd(1000, 10000), video, audio}));
+}
+
+inline std::string WriteTemp(const Bytes& data) {
+  char path[] = "/tmp/video_probe_mp4_XXXXXX";
+  int fd = mkstemp(path);
+  EXPECT_GE(fd, 0);
+  FILE* f = fdopen(fd, "wb");
+  fwrite(data.data(), 1, data.size(), f);
+  fclose(f);
+  return path;
+}
+
+}  // namespace test
+}  // namespace video_probe
+
+#endif  // VIDEO_PROBE_MP4_BUILDER_H_
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include "../../src/video_probe_internal.h"
+
+// Tests for decode planning against the memory budgets.
+
+namespace video_probe {
+namespace test {
+
+namespace {
+
+class VideoProbeBudget : public ::testing::Test {
+ protected:
+  void TearDown() override { set_memory_budget(0, 0); }
+};
+
+}  // namespace
+
+TEST_F(VideoProbeBudget, UnlimitedBudgetKeepsFullDecode) {
+  vp_decode_plan plan;
+  ASSERT_EQ(vp_decode_plan_fit(3840, 2160, 8, 0, 0, &plan), VP_OK);
+  EXPECT_EQ(plan.scale, 1);
+  EXPECT_EQ(plan.threads, 0);
+  EXPECT_EQ(plan.estimate, vp_decode_estimate(3840, 2160, 8, 1, 0));
+}
+
+TEST_F(VideoProbeBudget, DropsThreadsBeforeScaling) {
+  int64_t single = vp_decode_estimate(1920, 1080, 8, 1, 1);
+  vp_decode_plan plan;
+  ASSERT_EQ(vp_decode_plan_fit(1920, 1080, 8, 0, single, &plan), VP_OK);
+  // Single-core machines decode single-threaded by default
+  EXPECT_LE(plan.threads, 1);
+  EXPECT_EQ(plan.scale, 1);
+  EXPECT_EQ(plan.estimate, single);
+}
+
+TEST_F(VideoProbeBudget, ScalesDownWhenThreadsAreNotEnough) {
+  int64_t single = vp_decode_estimate(3840, 2160, 10, 1, 1);
+  vp_decode_plan plan;
+  ASSERT_EQ(vp_decode_plan_fit(3840, 2160, 10, 0, single - 1, &plan), VP_OK);
+  EXPECT_EQ(plan.threads, 1);
+  EXPECT_GT(plan.scale, 1);
+  EXPECT_LT(plan.estimate, single);
+}
+
+TEST_F(VideoProbeBudget, KeepsRequestedThreadsWithinBudget) {
+  vp_decode_plan plan;
+  ASSERT_EQ(vp_decode_plan_fit(1920, 1080, 8, 4, 0, &plan), VP_OK);
+  EXPECT_EQ(plan.threads, 4);
+  EXPECT_EQ(plan.estimate, vp_decode_estimate(1920, 1080, 8, 1, 4));
+
+  int64_t two = vp_decode_estimate(1920, 1080, 8, 1, 2);
+  ASSERT_EQ(vp_decode_plan_fit(1920, 1080, 8, 4, two, &plan), VP_OK);
+  EXPECT_EQ(plan.threads, 1);
+  EXPECT_EQ(plan.scale, 1);
+
+  vp_call_options options = {};
+  options.decoder_threads = 3;
+  vp_call call;
+  vp_call_init(&call, &options);
+  ASSERT_EQ(vp_budget_acquire(&call, 640, 480, 8, &plan), VP_OK);
+  EXPECT_EQ(plan.threads, 3);
+  vp_budget_release(&call, &plan);
+}
+
+TEST_F(VideoProbeBudget, RejectsDecodesThatCannotFit) {
+  vp_decode_plan plan;
+  EXPECT_EQ(vp_decode_plan_fit(3840, 2160, 8, 0, 1024, &plan), VP_ERROR_OVER_BUDGET);
+}
+
+TEST_F(VideoProbeBudget, GlobalBudgetCountsRunningDecodes) {
+  int64_t single = vp_decode_estimate(1280, 720, 8, 1, 1);
+  int64_t scaled = vp_decode_estimate(1280, 720, 8, 8, 1);
+  ASSERT_EQ(set_memory_budget(single + scaled, 0), VP_OK);
+
+  vp_call call;
+  vp_call_init(&call, NULL);
+  vp_decode_plan first;
+  ASSERT_EQ(vp_budget_acquire(&call, 1280, 720, 8, &first), VP_OK);
+  EXPECT_EQ(first.scale, 1);
+
+  // What is left only fits a downscaled decode
+  vp_decode_plan second;
+  ASSERT_EQ(vp_budget_acquire(&call, 1280, 720, 8, &second), VP_OK);
+  EXPECT_GT(second.scale, 1);
+  vp_decode_plan third;
+  EXPECT_EQ(vp_budget_acquire(&call, 3840, 2160, 8, &third), VP_ERROR_OVER_BUDGET);
+
+  vp_budget_release(&call, &first);
+  vp_budget_release(&call, &second);
+  ASSERT_EQ(vp_budget_acquire(&call, 1280, 720, 8, &first), VP_OK);
+  EXPECT_EQ(first.scale, 1);
+  vp_budget_release(&call, &first);
+}
+
+TEST_F(VideoProbeBudget, CallOptionsOverrideDefaultAndReportPeak) {
+  ASSERT_EQ(set_memory_budget(0, 1024), VP_OK);
+  int64_t peak = -1;
+  vp_call_options options = {};
+  options.peak_memory = &peak;
+
+  vp_call call;
+  vp_call_init(&call, &options);
+  EXPECT_EQ(call.memory_budget, 1024);
+  EXPECT_EQ(peak, 0);
+
+  options.memory_budget = vp_decode_estimate(640, 480, 8, 1, 0);
+  vp_call_init(&call, &options);
+  vp_decode_plan small;
+  vp_decode_plan large;
+  ASSERT_EQ(vp_budget_acquire(&call, 320, 240, 8, &small), VP_OK);
+  ASSERT_EQ(vp_budget_acquire(&call, 640, 480, 8, &large), VP_OK);
+  vp_budget_release(&call, &large);
+  vp_budget_release(&call, &small);
+  EXPECT_EQ(peak, large.estimate);
+}
+
+TEST_F(VideoProbeBudget, RejectsNegativeBudgets) {
+  EXPECT_EQ(set_memory_budget(-1, 0), VP_ERROR_INVALID_ARGUMENT);
+  EXPECT_EQ(set_memory_budget(0, -1), VP_ERROR_INVALID_ARGUMENT);
+  EXPECT_EQ(vp_budget_request_default(), 0);
+}
+
+}  // namespace test
+}  // namespace video_probe
@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include "../../src/video_probe_internal.h"
+
+// Tests for cancellation tokens and call deadlines.
+
+namespace video_probe {
+namespace test {
+
+namespace {
+
+void CountWake(void* data) { ++*static_cast<int*>(data); }
+
+}  // namespace
+
+TEST(VideoProbeCancel, WakesRegisteredWaitersOnce) {
+  vp_cancel_token* token = cancel_token_new();
+  int wakes = 0;
+  vp_cancel_waker waker = {CountWake, &wakes, nullptr};
+  vp_cancel_add_waker(token, &waker);
+  EXPECT_FALSE(cancel_token_is_cancelled(token));
+
+  cancel_token_cancel(token);
+  cancel_token_cancel(token);
+  EXPECT_TRUE(cancel_token_is_cancelled(token));
+  EXPECT_EQ(wakes, 1);
+  vp_cancel_remove_waker(token, &waker);
+
+  // Waits that start after cancellation are woken immediately
+  int late = 0;
+  vp_cancel_waker late_waker = {CountWake, &late, nullptr};
+  vp_cancel_add_waker(token, &late_waker);
+  EXPECT_EQ(late, 1);
+  vp_cancel_remove_waker(token, &late_waker);
+  cancel_token_free(token);
+}
+
+TEST(VideoProbeCancel, RemovedWakersAreNotCalled) {
+  vp_cancel_token* token = cancel_token_new();
+  int first = 0, second = 0;
+  vp_cancel_waker a = {CountWake, &first, nullptr};
+  vp_cancel_waker b = {CountWake, &second, nullptr};
+  vp_cancel_add_waker(token, &a);
+  vp_cancel_add_waker(token, &b);
+  vp_cancel_remove_waker(token, &a);
+  cancel_token_cancel(token);
+  EXPECT_EQ(first, 0);
+  EXPECT_EQ(second, 1);
+  vp_cancel_remove_waker(token, &b);
+  cancel_token_free(token);
+}
+
+TEST(VideoProbeCancel, ChecksCallState) {
+  vp_call call;
+  vp_call_init(&call, nullptr);
+  EXPECT_EQ(vp_call_check(&call), VP_OK);
+  EXPECT_EQ(vp_call_check(nullptr), VP_OK);
+  EXPECT_EQ(vp_call_remaining_us(&call, 1234), 1234);
+
+  vp_call_options options = {};
+  options.timeout_ms = 20;
+  vp_call_init(&call, &options);
+  int64_t remaining = vp_call_remaining_us(&call, 0);
+  EXPECT_GT(remaining, 0);
+  EXPECT_LE(remaining, 20000);
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  EXPECT_EQ(vp_call_check(&call), VP_ERROR_TIMEOUT);
+  EXPECT_EQ(vp_call_remaining_us(&call, 1234), 0);
+
+  // Cancellation wins over an expired deadline
+  options.cancel = cancel_token_new();
+  cancel_token_cancel(options.cancel);
+  vp_call_init(&call, &options);
+  EXPECT_EQ(vp_call_check(&call), VP_ERROR_CANCELLED);
+  cancel_token_free(options.cancel);
+}
+
+}  // namespace test
+}  // namespace video_probe
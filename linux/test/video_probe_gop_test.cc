@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "../../src/video_probe_internal.h"
+
+// Tests for GOP analysis and seek costs from a sample index.
+
+namespace video_probe {
+namespace test {
+
+namespace {
+
+constexpr double kFrame = 0.04;
+
+// Decode-order samples of 1000 bytes shown at frame slots `shown`, with
+// keyframes at the decode indices in `keys`
+std::vector<vp_mp4_sample> Samples(const std::vector<int>& shown, const std::vector<int>& keys) {
+  std::vector<vp_mp4_sample> samples;
+  for (int slot : shown) {
+    vp_mp4_sample sample = {};
+    sample.time = slot * kFrame;
+    sample.size = 1000;
+    samples.push_back(sample);
+  }
+  for (int key : keys) {
+    samples[key].flags |= VP_MP4_SAMPLE_SYNC;
+  }
+  return samples;
+}
+
+class VideoProbeGop : public ::testing::Test {
+ protected:
+  void SetUp() override { arena_ = vp_arena_new(0); }
+  void TearDown() override { vp_arena_free(arena_); }
+
+  int Analyze(const std::vector<vp_mp4_sample>& samples) {
+    return vp_gop_analyze(samples.data(), static_cast<int>(samples.size()), arena_, &info_);
+  }
+
+  vp_arena* arena_ = nullptr;
+  vp_gop_info info_ = {};
+};
+
+}  // namespace
+
+TEST_F(VideoProbeGop, AllIntraFramesCostOneDecode) {
+  ASSERT_EQ(Analyze(Samples({0, 1, 2, 3}, {0, 1, 2, 3})), VP_OK);
+  EXPECT_TRUE(info_.all_intra);
+  EXPECT_FALSE(info_.has_b_frames);
+  EXPECT_EQ(info_.keyframe_count, 4);
+  EXPECT_EQ(info_.gop_frames_max, 1);
+  EXPECT_EQ(info_.seek_frames_max, 1);
+  EXPECT_DOUBLE_EQ(info_.seek_frames_mean, 1.0);
+  EXPECT_NEAR(info_.gop_seconds_max, kFrame, 1e-9);
+}
+
+TEST_F(VideoProbeGop, CountsFramesFromTheKeyframe) {
+  // Two closed GOPs of 5 and 3 P-frames
+  ASSERT_EQ(Analyze(Samples({0, 1, 2, 3, 4, 5, 6, 7}, {0, 5})), VP_OK);
+  EXPECT_FALSE(info_.all_intra);
+  EXPECT_FALSE(info_.open_gop);
+  EXPECT_EQ(info_.gop_frames_min, 3);
+  EXPECT_EQ(info_.gop_frames_p50, 3);
+  EXPECT_EQ(info_.gop_frames_p90, 5);
+  EXPECT_EQ(info_.gop_frames_max, 5);
+  EXPECT_EQ(info_.seek_frames_max, 5);
+  EXPECT_NEAR(info_.gop_seconds_max, 5 * kFrame, 1e-9);
+  EXPECT_NEAR(info_.gop_seconds_mean, 4 * kFrame, 1e-9);
+
+  vp_seek_cost cost;
+  ASSERT_EQ(gop_seek_cost(&info_, 4.5 * kFrame, &cost), VP_OK);
+  EXPECT_DOUBLE_EQ(cost.time, 4 * kFrame);
+  EXPECT_DOUBLE_EQ(cost.keyframe_time, 0.0);
+  EXPECT_EQ(cost.frames, 5);
+  EXPECT_EQ(cost.bytes, 5000);
+
+  ASSERT_EQ(gop_seek_cost(&info_, 5 * kFrame, &cost), VP_OK);
+  EXPECT_EQ(cost.frames, 1);
+  ASSERT_EQ(gop_seek_cost(&info_, 100.0, &cost), VP_OK);
+  EXPECT_DOUBLE_EQ(cost.time, 7 * kFrame);
+  EXPECT_EQ(cost.frames, 3);
+  ASSERT_EQ(gop_seek_cost(&info_, -1.0, &cost), VP_OK);
+  EXPECT_DOUBLE_EQ(cost.time, 0.0);
+}
+
+TEST_F(VideoProbeGop, ReorderedFramesCountInDecodeOrder) {
+  // I P B B: the B-frames are shown before the P-frame they follow
+  ASSERT_EQ(Analyze(Samples({0, 3, 1, 2}, {0})), VP_OK);
+  EXPECT_TRUE(info_.has_b_frames);
+  EXPECT_FALSE(info_.open_gop);
+
+  vp_seek_cost cost;
+  ASSERT_EQ(gop_seek_cost(&info_, 1 * kFrame, &cost), VP_OK);
+  EXPECT_EQ(cost.frames, 3);
+  ASSERT_EQ(gop_seek_cost(&info_, 3 * kFrame, &cost), VP_OK);
+  EXPECT_EQ(cost.frames, 2);
+}
+
+TEST_F(VideoProbeGop, LeadingFramesDecodeFromThePreviousGop) {
+  // I P P | I B B P: the second GOP's B-frames are shown before its I-frame
+  ASSERT_EQ(Analyze(Samples({0, 1, 2, 5, 3, 4, 6}, {0, 3})), VP_OK);
+  EXPECT_TRUE(info_.open_gop);
+
+  vp_seek_cost cost;
+  ASSERT_EQ(gop_seek_cost(&info_, 3 * kFrame, &cost), VP_OK);
+  EXPECT_DOUBLE_EQ(cost.keyframe_time, 0.0);
+  EXPECT_EQ(cost.frames, 5);
+  ASSERT_EQ(gop_seek_cost(&info_, 5 * kFrame, &cost), VP_OK);
+  EXPECT_EQ(cost.frames, 1);
+}
+
+TEST_F(VideoProbeGop, TreatsAnUnmarkedIndexAsOneGop) {
+  ASSERT_EQ(Analyze(Samples({0, 1, 2}, {})), VP_OK);
+  EXPECT_EQ(info_.keyframe_count, 0);
+  EXPECT_FALSE(info_.all_intra);
+  EXPECT_EQ(info_.gop_frames_max, 3);
+  EXPECT_EQ(info_.seek_frames_max, 3);
+}
+
+TEST_F(VideoProbeGop, RejectsEmptyInput) {
+  EXPECT_EQ(vp_gop_analyze(nullptr, 0, arena_, &info_), VP_ERROR_INVALID_ARGUMENT);
+  vp_seek_cost cost;
+  EXPECT_EQ(gop_seek_cost(&info_, 0.0, &cost), VP_ERROR_NOT_FOUND);
+}
+
+}  // namespace test
+}  // namespace video_probe
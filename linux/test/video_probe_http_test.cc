@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include "../../src/video_probe_internal.h"
+#include "loopback_http_server.h"
+#include "mp4_builder.h"
+
+// Tests for the HTTP range reader against a loopback server.
+
+namespace video_probe {
+namespace test {
+
+namespace {
+
+constexpr int64_t kBlock = 64 * 1024;
+
+Bytes Pattern(size_t size) {
+  Bytes b(size);
+  for (size_t i = 0; i < size; i++) b[i] = static_cast<uint8_t>(i * 7 + i / 251);
+  return b;
+}
+
+}  // namespace
+
+TEST(VideoProbeHttp, ProbesMoovAtEndWithoutFullDownload) {
+  Bytes movie = Concat({Ftyp(), Box("mdat", Bytes(16 << 20, 0)), SampleMovie(0)});
+  LoopbackHttpServer server(movie);
+  vp_reader reader;
+  ASSERT_EQ(vp_reader_open_http(&reader, server.Url().c_str(), nullptr), VP_OK);
+  EXPECT_EQ(reader.size, static_cast<int64_t>(movie.size()));
+
+  vp_arena* arena = vp_arena_new(0);
+  vp_media_info info = {};
+  ASSERT_EQ(vp_mp4_probe(&reader, arena, &info), VP_OK);
+  EXPECT_EQ(info.width, 1920);
+  EXPECT_DOUBLE_EQ(info.duration, 10.0);
+
+  vp_http_stats stats;
+  vp_reader_http_stats(&reader, &stats);
+  EXPECT_LE(stats.requests, 3);
+  EXPECT_LT(server.bytes_sent(), 1 << 20);
+  vp_reader_close(&reader);
+  vp_arena_free(arena);
+}
+
+TEST(VideoProbeHttp, ServesRepeatedReadsFromCache) {
+  Bytes body = Pattern(40 * kBlock);
+  LoopbackHttpServer server(body);
+  vp_reader reader;
+  ASSERT_EQ(vp_reader_open_http(&reader, server.Url().c_str(), nullptr), VP_OK);
+
+  Bytes buf(1000);
+  int64_t offset = 20 * kBlock + 123;
+  ASSERT_EQ(vp_reader_read_full(&reader, offset, buf.data(), 1000), 0);
+  int after_first = server.requests();
+  ASSERT_EQ(vp_reader_read_full(&reader, offset, buf.data(), 1000), 0);
+  EXPECT_EQ(server.requests(), after_first);
+  EXPECT_EQ(memcmp(buf.data(), body.data() + offset, 1000), 0);
+  vp_reader_close(&reader);
+}
+
+TEST(VideoProbeHttp, CoalescesMissingBlocksIntoOneRequest) {
+  Bytes body = Pattern(40 * kBlock);
+  LoopbackHttpServer server(body);
+  vp_reader reader;
+  ASSERT_EQ(vp_reader_open_http(&reader, server.Url().c_str(), nullptr), VP_OK);
+  int before = server.requests();
+
+  // Spans four uncached blocks, read out of sequence (no read-ahead)
+  Bytes buf(3 * kBlock + 10);
+  int64_t offset = 30 * kBlock - 5;
+  ASSERT_EQ(vp_reader_read_full(&reader, offset, buf.data(), static_cast<int64_t>(buf.size())), 0);
+  EXPECT_EQ(server.requests(), before + 1);
+  EXPECT_EQ(memcmp(buf.data(), body.data() + offset, buf.size()), 0);
+
+  // Last partial block of the object
+  Bytes tail(100);
+  ASSERT_EQ(vp_reader_read_full(&reader, static_cast<int64_t>(body.size()) - 100, tail.data(), 100), 0);
+  EXPECT_EQ(memcmp(tail.data(), body.data() + body.size() - 100, 100), 0);
+  vp_reader_close(&reader);
+}
+
+TEST(VideoProbeHttp, ReportsMissingObject) {
+  LoopbackHttpServer server(Pattern(100));
+  vp_reader reader;
+  EXPECT_EQ(vp_reader_open_http(&reader, server.Url("/missing.mp4").c_str(), nullptr), VP_ERROR_NOT_FOUND);
+}
+
+TEST(VideoProbeHttp, RefusesFullDownloadWithoutRangeSupport) {
+  LoopbackHttpServer large(Pattern(8 << 20), false);
+  vp_reader reader;
+  EXPECT_EQ(vp_reader_open_http(&reader, large.Url().c_str(), nullptr), VP_ERROR_UNSUPPORTED);
+  EXPECT_LT(large.bytes_sent(), 8 << 20);
+
+  // Small objects arrive whole in the first reply
+  Bytes body = Pattern(1000);
+  LoopbackHttpServer small(body, false);
+  ASSERT_EQ(vp_reader_open_http(&reader, small.Url().c_str(), nullptr), VP_OK);
+  EXPECT_EQ(reader.size, 1000);
+  Bytes buf(10);
+  ASSERT_EQ(vp_reader_read_full(&reader, 990, buf.data(), 10), 0);
+  EXPECT_EQ(memcmp(buf.data(), body.data() + 990, 10), 0);
+  vp_reader_close(&reader);
+}
+
+TEST(VideoProbeHttp, StopsFetchingOnceCancelled) {
+  Bytes body = Pattern(40 * kBlock);
+  LoopbackHttpServer server(body);
+  vp_cancel_token* token = cancel_token_new();
+  vp_call_options options = {};
+  options.cancel = token;
+  vp_call call;
+  vp_call_init(&call, &options);
+
+  vp_reader reader;
+  ASSERT_EQ(vp_reader_open_http(&reader, server.Url().c_str(), &call), VP_OK);
+  int before = server.requests();
+  cancel_token_cancel(token);
+  Bytes buf(100);
+  EXPECT_EQ(vp_reader_read_full(&reader, 30 * kBlock, buf.data(), 100), -1);
+  EXPECT_EQ(server.requests(), before);
+  vp_reader_close(&reader);
+
+  EXPECT_EQ(vp_reader_open_http(&reader, server.Url().c_str(), &call), VP_ERROR_CANCELLED);
+  EXPECT_EQ(server.requests(), before);
+  cancel_token_free(token);
+}
+
+TEST(VideoProbeHttp, AbortsStalledTransferOnCancel) {
+  LoopbackHttpServer server(Pattern(40 * kBlock));
+  vp_cancel_token* token = cancel_token_new();
+  vp_call_options options = {};
+  options.cancel = token;
+  vp_call call;
+  vp_call_init(&call, &options);
+  vp_reader reader;
+  ASSERT_EQ(vp_reader_open_http(&reader, server.Url().c_str(), &call), VP_OK);
+
+  server.set_stalled(true);
+  std::thread canceller([token] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    cancel_token_cancel(token);
+  });
+  auto start = std::chrono::steady_clock::now();
+  Bytes buf(100);
+  EXPECT_EQ(vp_reader_read_full(&reader, 30 * kBlock, buf.data(), 100), -1);
+  // The stall itself would last until the 10 s low-speed limit
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(500));
+  canceller.join();
+  server.set_stalled(false);
+  vp_reader_close(&reader);
+  cancel_token_free(token);
+}
+
+TEST(VideoProbeHttp, ReportsExpiredDeadline) {
+  LoopbackHttpServer server(Pattern(100));
+  vp_call_options options = {};
+  options.timeout_ms = 1;
+  vp_call call;
+  vp_call_init(&call, &options);
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  vp_reader reader;
+  EXPECT_EQ(vp_reader_open_http(&reader, server.Url().c_str(), &call), VP_ERROR_TIMEOUT);
+  EXPECT_EQ(server.requests(), 0);
+}
+
+}  // namespace test
+}  // namespace video_probe
@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "../../src/video_probe_internal.h"
+#include "mp4_builder.h"
+
+// Tests for the local file backends of the native parsers.
+
+namespace video_probe {
+namespace test {
+
+namespace {
+
+Bytes Pattern(size_t size) {
+  Bytes b(size);
+  for (size_t i = 0; i < size; i++) b[i] = static_cast<uint8_t>(i * 13 + i / 509);
+  return b;
+}
+
+const char* BackendName(const testing::TestParamInfo<int>& info) {
+  switch (info.param) {
+    case VP_IO_PREAD: return "Pread";
+    case VP_IO_MMAP: return "Mmap";
+    default: return "IoUring";
+  }
+}
+
+class VideoProbeIo : public testing::TestWithParam<int> {
+ protected:
+  void SetUp() override {
+    if (GetParam() == VP_IO_URING && !vp_io_uring_available()) {
+      GTEST_SKIP() << "io_uring is not available";
+    }
+  }
+
+  void TearDown() override {
+    if (!path_.empty()) remove(path_.c_str());
+  }
+
+  void Open(const Bytes& data) {
+    path_ = WriteTemp(data);
+    ASSERT_EQ(vp_reader_open_file_with(&reader_, path_.c_str(), GetParam()), VP_OK);
+    ASSERT_NE(reader_.stats, nullptr);
+  }
+
+  std::string path_;
+  vp_reader reader_ = {};
+};
+
+}  // namespace
+
+TEST_P(VideoProbeIo, ReadsMatchTheFile) {
+  Bytes data = Pattern((1 << 20) + 123);
+  Open(data);
+  EXPECT_EQ(reader_.size, static_cast<int64_t>(data.size()));
+
+  // Inside the head, across the head window, a small miss, a large miss,
+  // inside the tail and the last bytes
+  const int64_t reads[][2] = {
+      {0, 8}, {65530, 20}, {500000, 100}, {300000, 200000}, {900000, 4000}, {(1 << 20) + 73, 50},
+  };
+  for (const auto& read : reads) {
+    Bytes buf(static_cast<size_t>(read[1]));
+    ASSERT_EQ(vp_reader_read_full(&reader_, read[0], buf.data(), read[1]), 0) << read[0];
+    EXPECT_EQ(memcmp(buf.data(), data.data() + read[0], buf.size()), 0) << read[0];
+  }
+
+  uint8_t past_end[100];
+  EXPECT_EQ(vp_reader_read_full(&reader_, (1 << 20) + 100, past_end, 100), -1);
+  EXPECT_EQ(reader_.read_at(reader_.opaque, (1 << 20) + 123, past_end, 1), 0);
+  vp_reader_close(&reader_);
+}
+
+TEST_P(VideoProbeIo, ProbesMoovAtEndInFewRoundTrips) {
+  Open(Concat({Ftyp(), Box("mdat", Bytes(16 << 20, 0)), SampleMovie(0)}));
+  vp_arena* arena = vp_arena_new(0);
+  vp_media_info info = {};
+  ASSERT_EQ(vp_mp4_probe(&reader_, arena, &info), VP_OK);
+  EXPECT_EQ(info.width, 1920);
+  EXPECT_DOUBLE_EQ(info.duration, 10.0);
+
+  // Head and tail: one syscall with io_uring, two with pread, page
+  // faults only with mmap
+  const vp_io_stats* stats = reader_.stats;
+  EXPECT_GT(stats->reads, 4);
+  EXPECT_LE(stats->read_syscalls, GetParam() == VP_IO_URING ? 1 : 2);
+  EXPECT_LT(stats->bytes_fetched, 1 << 20);
+  vp_reader_close(&reader_);
+  vp_arena_free(arena);
+}
+
+TEST_P(VideoProbeIo, CoalescesSmallReads) {
+  Bytes data = Pattern(4 << 20);
+  Open(data);
+  int64_t before = reader_.stats->read_syscalls;
+
+  // 200 box-header sized reads within one chunk in the middle of the file
+  for (int i = 0; i < 200; i++) {
+    uint8_t header[16];
+    int64_t offset = (2 << 20) + i * 100;
+    ASSERT_EQ(vp_reader_read_full(&reader_, offset, header, sizeof(header)), 0);
+    ASSERT_EQ(memcmp(header, data.data() + offset, sizeof(header)), 0);
+  }
+  EXPECT_LE(reader_.stats->read_syscalls - before, 1);
+  EXPECT_EQ(reader_.stats->bytes_read, 200 * 16);
+  vp_reader_close(&reader_);
+}
+
+INSTANTIATE_TEST_SUITE_P(Backends, VideoProbeIo, testing::Values(VP_IO_PREAD, VP_IO_MMAP, VP_IO_URING),
+                         BackendName);
+
+TEST(VideoProbeIoBackend, SelectsDefaultBackend) {
+  EXPECT_EQ(vp_io_set_backend(42), VP_ERROR_INVALID_ARGUMENT);
+  EXPECT_EQ(vp_io_set_backend(VP_IO_URING), vp_io_uring_available() ? VP_OK : VP_ERROR_UNSUPPORTED);
+  ASSERT_EQ(vp_io_set_backend(VP_IO_MMAP), VP_OK);
+
+  std::string path = WriteTemp(Pattern(1000));
+  vp_io_stats before;
+  vp_io_global_stats(&before);
+  vp_reader reader;
+  ASSERT_EQ(vp_reader_open_file(&reader, path.c_str()), VP_OK);
+  uint8_t buf[10];
+  ASSERT_EQ(vp_reader_read_full(&reader, 990, buf, 10), 0);
+  // Served from the mapping
+  EXPECT_EQ(reader.stats->read_syscalls, 0);
+  vp_reader_close(&reader);
+
+  vp_io_stats after;
+  vp_io_global_stats(&after);
+  EXPECT_EQ(after.files - before.files, 1);
+  EXPECT_EQ(after.bytes_read - before.bytes_read, 10);
+  EXPECT_EQ(vp_io_set_backend(VP_IO_AUTO), VP_OK);
+  remove(path.c_str());
+}
+
+}  // namespace test
+}  // namespace video_probe
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "../../src/video_probe_internal.h"
+
+// Tests for the stage histograms and counters.
+
+namespace video_probe {
+namespace test {
+
+namespace {
+
+vp_metrics Snapshot() {
+  vp_metrics metrics;
+  get_metrics(&metrics);
+  return metrics;
+}
+
+}  // namespace
+
+TEST(VideoProbeMetrics, ReportsPercentilesWithinBucketResolution) {
+  reset_metrics();
+  int64_t total = 0;
+  for (int64_t ms = 1; ms <= 100; ms++) {
+    vp_metrics_record(VP_STAGE_DECODE, ms * 1000);
+    total += ms * 1000;
+  }
+  vp_metrics metrics = Snapshot();
+  const vp_stage_metrics& decode = metrics.stages[VP_STAGE_DECODE];
+  EXPECT_EQ(decode.count, 100);
+  EXPECT_EQ(decode.total_us, total);
+  EXPECT_NEAR(decode.p50_us, 50000, 50000 / 16);
+  EXPECT_NEAR(decode.p90_us, 90000, 90000 / 16);
+  EXPECT_NEAR(decode.p99_us, 99000, 99000 / 16);
+  EXPECT_EQ(metrics.stages[VP_STAGE_ENCODE].count, 0);
+}
+
+TEST(VideoProbeMetrics, ResetStartsNewWindow) {
+  vp_metrics_record(VP_STAGE_SEEK, 10);
+  reset_metrics();
+  EXPECT_EQ(Snapshot().stages[VP_STAGE_SEEK].count, 0);
+
+  vp_metrics_record(VP_STAGE_SEEK, 3);
+  vp_metrics metrics = Snapshot();
+  EXPECT_EQ(metrics.stages[VP_STAGE_SEEK].count, 1);
+  EXPECT_EQ(metrics.stages[VP_STAGE_SEEK].p50_us, 3);
+}
+
+TEST(VideoProbeMetrics, SumsThreadsAndKeepsCountsOfExitedOnes) {
+  reset_metrics();
+  // Two rounds, so the second reuses the shards of the first
+  for (int round = 0; round < 2; round++) {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++) {
+      threads.emplace_back([] {
+        for (int i = 0; i < 1000; i++) {
+          vp_metrics_record(VP_STAGE_PREROLL, 20);
+          vp_metrics_count(VP_COUNTER_BYTES_READ, 5);
+        }
+      });
+    }
+    for (std::thread& thread : threads) thread.join();
+  }
+  vp_metrics metrics = Snapshot();
+  EXPECT_EQ(metrics.stages[VP_STAGE_PREROLL].count, 16000);
+  EXPECT_EQ(metrics.stages[VP_STAGE_PREROLL].total_us, 16000 * 20);
+  EXPECT_EQ(metrics.bytes_read, 16000 * 5);
+}
+
+TEST(VideoProbeMetrics, CountsReaderBytesAndArenaBlocks) {
+  reset_metrics();
+  vp_arena* arena = vp_arena_new(64);
+  ASSERT_NE(vp_arena_alloc(arena, 32), nullptr);
+  ASSERT_NE(vp_arena_alloc(arena, 1000), nullptr);
+  vp_arena_free(arena);
+
+  uint8_t data[256] = {};
+  uint8_t buf[100];
+  vp_reader reader;
+  ASSERT_EQ(vp_reader_open_memory(&reader, data, sizeof(data)), VP_OK);
+  ASSERT_EQ(vp_reader_read_full(&reader, 50, buf, sizeof(buf)), 0);
+  vp_reader_close(&reader);
+
+  vp_metrics metrics = Snapshot();
+  EXPECT_EQ(metrics.allocations, 3);
+  EXPECT_EQ(metrics.bytes_read, 100);
+}
+
+TEST(VideoProbeMetrics, TracksLiveFramesAndArenasAcrossReset) {
+  int64_t frames = Snapshot().live_frames;
+  int64_t arenas = Snapshot().live_results;
+  uint8_t* frame = vp_frame_alloc(64);
+  vp_arena* arena = vp_arena_new(0);
+  vp_arena* merged = vp_arena_new(0);
+  vp_arena_merge(arena, merged);
+  reset_metrics();
+
+  vp_metrics metrics = Snapshot();
+  EXPECT_EQ(metrics.live_frames, frames + 1);
+  EXPECT_EQ(metrics.live_results, arenas + 1);
+
+  // Released on another thread than the one that allocated
+  std::thread([frame, arena] {
+    vp_frame_free(frame);
+    vp_arena_free(arena);
+  }).join();
+  metrics = Snapshot();
+  EXPECT_EQ(metrics.live_frames, frames);
+  EXPECT_EQ(metrics.live_results, arenas);
+  EXPECT_EQ(metrics.allocations, 0);
+}
+
+}  // namespace test
+}  // namespace video_probe
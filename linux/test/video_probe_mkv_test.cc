@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <initializer_list>
+#include <string>
+
+#include "../../src/video_probe_internal.h"
+#include "mp4_builder.h"
+
+// Tests for the native Matroska attachment reader.
+
+namespace video_probe {
+namespace test {
+
+namespace {
+
+const Bytes kJpeg = {0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 0xFF, 0xD9};
+const Bytes kPng = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n', 0, 0, 0, 0};
+
+// Element with an ID of 1 to 4 bytes and an 8-byte size
+Bytes Element(uint32_t id, const Bytes& payload) {
+  Bytes b;
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    if ((id >> shift) != 0) b.push_back(static_cast<uint8_t>(id >> shift));
+  }
+  b.push_back(0x01);
+  uint64_t size = payload.size();
+  for (int shift = 48; shift >= 0; shift -= 8) b.push_back(static_cast<uint8_t>(size >> shift));
+  b.insert(b.end(), payload.begin(), payload.end());
+  return b;
+}
+
+Bytes String(uint32_t id, const std::string& value) { return Element(id, Bytes(value.begin(), value.end())); }
+
+Bytes Uint(uint32_t id, uint64_t value) {
+  Bytes b;
+  for (int shift = 56; shift >= 0; shift -= 8) b.push_back(static_cast<uint8_t>(value >> shift));
+  return Element(id, b);
+}
+
+Bytes AttachedFile(const std::string& name, const std::string& mime, const Bytes& data) {
+  return Element(0x61A7, Concat({String(0x466E, name), String(0x4660, mime), Element(0x465C, data)}));
+}
+
+Bytes Header() { return Element(0x1A45DFA3, String(0x4282, "matroska")); }
+
+Bytes Cluster() { return Element(0x1F43B675, Bytes(256, 0)); }
+
+int Cover(const Bytes& file, vp_arena* arena, vp_embedded_image* image) {
+  vp_reader reader;
+  int status = vp_reader_open_memory(&reader, file.data(), static_cast<int64_t>(file.size()));
+  if (status == VP_OK) {
+    status = vp_mkv_cover(&reader, arena, image);
+    vp_reader_close(&reader);
+  }
+  return status;
+}
+
+class VideoProbeMkv : public ::testing::Test {
+ protected:
+  void SetUp() override { arena_ = vp_arena_new(0); }
+  void TearDown() override { vp_arena_free(arena_); }
+
+  vp_arena* arena_ = nullptr;
+  vp_embedded_image image_ = {};
+};
+
+}  // namespace
+
+TEST_F(VideoProbeMkv, PrefersTheCoverAttachment) {
+  Bytes attachments = Element(0x1941A469, Concat({
+    AttachedFile("font.ttf", "font/ttf", Bytes(64, 1)),
+    AttachedFile("small_cover.jpg", "image/jpeg", kJpeg),
+    AttachedFile("cover.png", "image/png", kPng),
+  }));
+  Bytes file = Concat({Header(), Element(0x18538067, Concat({attachments, Cluster()}))});
+
+  ASSERT_EQ(Cover(file, arena_, &image_), VP_OK);
+  EXPECT_EQ(image_.format, VP_IMAGE_PNG);
+  ASSERT_EQ(image_.size, kPng.size());
+  EXPECT_EQ(memcmp(image_.data, kPng.data(), kPng.size()), 0);
+}
+
+TEST_F(VideoProbeMkv, FollowsTheSeekHeadPastTheClusters) {
+  // SeekHead, then a cluster, then Attachments; the SeekHead's size does
+  // not depend on the position it holds
+  auto seek_head_at = [](uint64_t position) {
+    return Element(0x114D9B74, Element(0x4DBB, Concat({
+      Element(0x53AB, {0x19, 0x41, 0xA4, 0x69}), Uint(0x53AC, position)})));
+  };
+  Bytes cluster = Cluster();
+  Bytes seek_head = seek_head_at(seek_head_at(0).size() + cluster.size());
+  Bytes attachments = Element(0x1941A469, AttachedFile("photo.jpg", "image/jpeg", kJpeg));
+  Bytes file = Concat({Header(), Element(0x18538067, Concat({seek_head, cluster, attachments}))});
+
+  ASSERT_EQ(Cover(file, arena_, &image_), VP_OK);
+  EXPECT_EQ(image_.format, VP_IMAGE_JPEG);
+  EXPECT_EQ(image_.size, kJpeg.size());
+}
+
+TEST_F(VideoProbeMkv, ReportsFilesWithoutImages) {
+  Bytes fonts = Element(0x1941A469, AttachedFile("cover.jpg", "image/jpeg", Bytes(16, 0)));
+  EXPECT_EQ(Cover(Concat({Header(), Element(0x18538067, Concat({fonts, Cluster()}))}), arena_, &image_),
+            VP_ERROR_NOT_FOUND);
+  EXPECT_EQ(Cover(Concat({Header(), Element(0x18538067, Cluster())}), arena_, &image_), VP_ERROR_NOT_FOUND);
+  EXPECT_EQ(Cover(Bytes(256, 0x47), arena_, &image_), VP_ERROR_UNSUPPORTED);
+  EXPECT_EQ(image_.data, nullptr);
+}
+
+}  // namespace test
+}  // namespace video_probe
@@ -0,0 +1,456 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "../../src/video_probe_internal.h"
+#include "mp4_builder.h"
+
+// Tests for the native ISO-BMFF parser.
+
+namespace video_probe {
+namespace test {
+
+namespace {
+
+int Probe(const Bytes& data, vp_arena* arena, vp_media_info* info) {
+  std::string path = WriteTemp(data);
+  vp_reader reader;
+  int status = vp_reader_open_file(&reader, path.c_str());
+  if (status == VP_OK) {
+    status = vp_mp4_probe(&reader, arena, info);
+    vp_reader_close(&reader);
+  }
+  remove(path.c_str());
+  return status;
+}
+
+// Cursor over a byte vector exposed through vp_io_callbacks
+struct CallbackSource {
+  const Bytes* data;
+  int64_t position = 0;
+  int seeks = 0;
+
+  static int64_t Read(void* opaque, uint8_t* buf, int64_t size) {
+    auto* self = static_cast<CallbackSource*>(opaque);
+    int64_t left = static_cast<int64_t>(self->data->size()) - self->position;
+    int64_t n = size < left ? size : left;
+    if (n <= 0) return 0;
+    memcpy(buf, self->data->data() + self->position, static_cast<size_t>(n));
+    self->position += n;
+    return n;
+  }
+
+  static int Seek(void* opaque, int64_t offset) {
+    auto* self = static_cast<CallbackSource*>(opaque);
+    if (offset < 0 || offset > static_cast<int64_t>(self->data->size())) return -1;
+    self->position = offset;
+    self->seeks++;
+    return 0;
+  }
+
+  static int64_t Size(void* opaque) {
+    return static_cast<int64_t>(static_cast<CallbackSource*>(opaque)->data->size());
+  }
+};
+
+}  // namespace
+
+TEST(VideoProbeMp4, ParsesMoovAtStart) {
+  Bytes mdat = Box("mdat", Bytes(4096, 0xAB));
+  vp_arena* arena = vp_arena_new(0);
+  vp_media_info info = {};
+
+  ASSERT_EQ(Probe(Concat({Ftyp(), SampleMovie(0), mdat}), arena, &info), VP_OK);
+  EXPECT_DOUBLE_EQ(info.duration, 10.0);
+  EXPECT_EQ(info.has_video, 1);
+  EXPECT_STREQ(info.video_codec, "h264");
+  EXPECT_EQ(info.width, 1920);
+  EXPECT_EQ(info.height, 1080);
+  EXPECT_EQ(info.fps_num, 25);
+  EXPECT_EQ(info.fps_den, 1);
+  EXPECT_EQ(info.frame_count, 250);
+  EXPECT_EQ(info.par_num, 4);
+  EXPECT_EQ(info.par_den, 3);
+  EXPECT_EQ(info.color_primaries, 9);
+  EXPECT_EQ(info.transfer, 16);
+  EXPECT_EQ(info.is_hdr, 1);
+  EXPECT_EQ(info.bit_depth, 8);
+
+  ASSERT_EQ(info.stream_count, 2);
+  const vp_stream_info& audio = info.streams[1];
+  EXPECT_EQ(audio.type, VP_STREAM_AUDIO);
+  EXPECT_STREQ(audio.codec, "aac");
+  EXPECT_STREQ(audio.language, "eng");
+  EXPECT_EQ(audio.channels, 2);
+  EXPECT_EQ(audio.sample_rate, 48000);
+  EXPECT_EQ(info.streams[0].language, nullptr);
+
+  vp_arena_free(arena);
+}
+
+TEST(VideoProbeMp4, ParsesMoovAtEndAndRotation) {
+  Bytes mdat = Box("mdat", Bytes(1 << 16, 0));
+  vp_arena* arena = vp_arena_new(0);
+  vp_media_info info = {};
+
+  ASSERT_EQ(Probe(Concat({Ftyp(), mdat, SampleMovie(90)}), arena, &info), VP_OK);
+  EXPECT_EQ(info.rotation, 90);
+  EXPECT_EQ(info.frame_count, 250);
+
+  vp_arena_free(arena);
+}
+
+TEST(VideoProbeMp4, RejectsNonIsoData) {
+  Bytes junk(1024, 0x47);  // looks like an MPEG-TS sync byte pattern
+  vp_arena* arena = vp_arena_new(0);
+  vp_media_info info = {};
+
+  EXPECT_EQ(Probe(junk, arena, &info), VP_ERROR_UNSUPPORTED);
+
+  vp_arena_free(arena);
+}
+
+TEST(VideoProbeMp4, ReportsMissingFile) {
+  vp_reader reader;
+  EXPECT_EQ(vp_reader_open_file(&reader, "/nonexistent/video.mp4"), VP_ERROR_NOT_FOUND);
+}
+
+TEST(VideoProbeMp4, ParsesFromMemory) {
+  Bytes movie = Concat({Ftyp(), Box("mdat", Bytes(4096, 0)), SampleMovie(0)});
+  vp_arena* arena = vp_arena_new(0);
+  vp_media_info info = {};
+  vp_reader reader;
+
+  ASSERT_EQ(vp_reader_open_memory(&reader, movie.data(), static_cast<int64_t>(movie.size())), VP_OK);
+  EXPECT_EQ(reader.data, movie.data());
+  ASSERT_EQ(vp_mp4_probe(&reader, arena, &info), VP_OK);
+  EXPECT_EQ(info.width, 1920);
+  EXPECT_EQ(info.frame_count, 250);
+  vp_reader_close(&reader);
+
+  vp_arena_free(arena);
+}
+
+TEST(VideoProbeMp4, ParsesThroughCallbacks) {
+  Bytes movie = Concat({Ftyp(), SampleMovie(0), Box("mdat", Bytes(4096, 0))});
+  CallbackSource source{&movie};
+  vp_io_callbacks io = {&source, CallbackSource::Read, CallbackSource::Seek, CallbackSource::Size};
+  vp_arena* arena = vp_arena_new(0);
+  vp_media_info info = {};
+  vp_reader reader;
+
+  ASSERT_EQ(vp_reader_open_io(&reader, &io), VP_OK);
+  EXPECT_EQ(reader.size, static_cast<int64_t>(movie.size()));
+  ASSERT_EQ(vp_mp4_probe(&reader, arena, &info), VP_OK);
+  EXPECT_EQ(info.stream_count, 2);
+  EXPECT_GT(source.seeks, 0);
+  vp_reader_close(&reader);
+
+  vp_arena_free(arena);
+}
+
+TEST(VideoProbeMp4, RejectsInvalidReaderArguments) {
+  vp_reader reader;
+  vp_io_callbacks io = {};
+  uint8_t byte = 0;
+  EXPECT_EQ(vp_reader_open_memory(&reader, nullptr, 10), VP_ERROR_INVALID_ARGUMENT);
+  EXPECT_EQ(vp_reader_open_memory(&reader, &byte, 0), VP_ERROR_INVALID_ARGUMENT);
+  EXPECT_EQ(vp_reader_open_io(&reader, &io), VP_ERROR_INVALID_ARGUMENT);
+}
+
+TEST(VideoProbeMp4Keyframes, ReadsSyncSamplesInPresentationTime) {
+  // 25 fps with a keyframe every 50 frames; B-frames delay presentation by
+  // two frames, which the edit list takes back
+  Bytes extra = Concat({Stss({1, 51, 101, 151, 201}), Ctts({{250, 1024}})});
+  Bytes video = Trak(1, 0, "vide", 12800, 128000, "und", Stbl(Avc1(1920, 1080), 512, 250, extra), Edts(1024));
+  Bytes movie = Concat({Ftyp(), Box("moov", Concat({Mvhd(1000, 10000), video})), Box("mdat", Bytes(64, 0))});
+  std::string path = WriteTemp(movie);
+  vp_arena* arena = vp_arena_new(0);
+  vp_reader reader;
+  ASSERT_EQ(vp_reader_open_file(&reader, path.c_str()), VP_OK);
+
+  double* times = nullptr;
+  int count = 0;
+  ASSERT_EQ(vp_mp4_keyframes(&reader, arena, &times, &count), VP_OK);
+  ASSERT_EQ(count, 5);
+  for (int i = 0; i < count; i++) {
+    EXPECT_DOUBLE_EQ(times[i], i * 2.0);
+  }
+
+  vp_reader_close(&reader);
+  remove(path.c_str());
+  vp_arena_free(arena);
+}
+
+TEST(VideoProbeMp4Keyframes, TreatsEverySampleAsSyncWithoutStss) {
+  std::string path = WriteTemp(Concat({Ftyp(), SampleMovie(0)}));
+  vp_arena* arena = vp_arena_new(0);
+  vp_reader reader;
+  ASSERT_EQ(vp_reader_open_file(&reader, path.c_str()), VP_OK);
+
+  double* times = nullptr;
+  int count = 0;
+  ASSERT_EQ(vp_mp4_keyframes(&reader, arena, &times, &count), VP_OK);
+  ASSERT_EQ(count, 250);
+  EXPECT_DOUBLE_EQ(times[1], 0.04);
+  EXPECT_DOUBLE_EQ(times[249], 9.96);
+
+  vp_reader_close(&reader);
+  remove(path.c_str());
+  vp_arena_free(arena);
+}
+
+TEST(VideoProbeMp4Keyframes, IndexesEverySampleInDecodeOrder) {
+  // I P B B P B B: the B-frames show before the P-frame decoded ahead of
+  // them and nothing refers to them
+  const uint8_t i = 0x24, p = 0x14, b = 0x18;
+  Bytes extra = Concat({Stss({1}), Ctts({{1, 512}, {1, 1536}, {2, 0}, {1, 1536}, {2, 0}}),
+                        Sdtp({i, p, b, b, p, b, b})});
+  Bytes video = Trak(1, 0, "vide", 12800, 3584, "und", Stbl(Avc1(640, 360), 512, 7, extra), Edts(512));
+  Bytes movie = Concat({Ftyp(), Box("moov", Concat({Mvhd(1000, 280), video})), Box("mdat", Bytes(64, 0))});
+  std::string path = WriteTemp(movie);
+  vp_arena* arena = vp_arena_new(0);
+  vp_reader reader;
+  ASSERT_EQ(vp_reader_open_file(&reader, path.c_str()), VP_OK);
+
+  vp_mp4_sample* samples = nullptr;
+  int count = 0;
+  ASSERT_EQ(vp_mp4_samples(&reader, arena, &samples, &count, nullptr), VP_OK);
+  ASSERT_EQ(count, 7);
+  const double frames[] = {0, 3, 1, 2, 6, 4, 5};
+  for (int n = 0; n < count; n++) {
+    EXPECT_DOUBLE_EQ(samples[n].time, frames[n] * 0.04) << n;
+    EXPECT_EQ(samples[n].size, 1000u);
+  }
+  EXPECT_EQ(samples[0].flags, VP_MP4_SAMPLE_SYNC);
+  EXPECT_EQ(samples[1].flags, 0);
+  EXPECT_EQ(samples[2].flags, VP_MP4_SAMPLE_DISPOSABLE);
+  EXPECT_EQ(samples[6].flags, VP_MP4_SAMPLE_DISPOSABLE);
+  // Only one of the seven samples is a sync sample
+  EXPECT_EQ(vp_mp4_intra_samples(&reader, arena, &samples, &count, nullptr), VP_ERROR_UNSUPPORTED);
+  EXPECT_EQ(samples, nullptr);
+
+  vp_reader_close(&reader);
+  remove(path.c_str());
+  vp_arena_free(arena);
+}
+
+TEST(VideoProbeMp4Keyframes, LocatesSamplesFromTheChunkTables) {
+  // Motion JPEG in three chunks of 2, 2 and 1 samples
+  Bytes extra = Concat({Stsc({{1, 2}, {3, 1}}), Stco({4096, 8192, 16384})});
+  Bytes video = Trak(1, 0, "vide", 12800, 2560, "und", Stbl(VisualEntry("jpeg", 320, 240), 512, 5, extra));
+  Bytes movie = Concat({Ftyp(), Box("moov", Concat({Mvhd(1000, 200), video}))});
+  std::string path = WriteTemp(movie);
+  vp_arena* arena = vp_arena_new(0);
+  vp_reader reader;
+  ASSERT_EQ(vp_reader_open_file(&reader, path.c_str()), VP_OK);
+
+  vp_mp4_sample* samples = nullptr;
+  int count = 0;
+  vp_stream_info stream;
+  ASSERT_EQ(vp_mp4_intra_samples(&reader, arena, &samples, &count, &stream), VP_OK);
+  ASSERT_EQ(count, 5);
+  const int64_t offsets[] = {4096, 5096, 8192, 9192, 16384};
+  for (int n = 0; n < count; n++) {
+    EXPECT_EQ(samples[n].offset, offsets[n]) << n;
+    EXPECT_EQ(samples[n].flags, VP_MP4_SAMPLE_SYNC);
+  }
+  EXPECT_STREQ(stream.codec, "mjpeg");
+  EXPECT_EQ(stream.width, 320);
+  EXPECT_EQ(stream.height, 240);
+
+  vp_reader_close(&reader);
+  remove(path.c_str());
+  vp_arena_free(arena);
+}
+
+TEST(VideoProbeMp4Keyframes, RejectsNonIsoData) {
+  std::string path = WriteTemp(Bytes(256, 0x47));
+  vp_arena* arena = vp_arena_new(0);
+  vp_reader reader;
+  ASSERT_EQ(vp_reader_open_file(&reader, path.c_str()), VP_OK);
+
+  double* times = nullptr;
+  int count = 0;
+  EXPECT_EQ(vp_mp4_keyframes(&reader, arena, &times, &count), VP_ERROR_UNSUPPORTED);
+  EXPECT_EQ(count, 0);
+
+  vp_reader_close(&reader);
+  remove(path.c_str());
+  vp_arena_free(arena);
+}
+
+TEST(VideoProbeMp4Partial, FindsMoovAtEndFromHeadAndTail) {
+  Bytes mdat = Box("mdat", Bytes(4 << 20, 0));
+  Bytes movie = Concat({Ftyp(), mdat, SampleMovie(0)});
+  const int64_t total = static_cast<int64_t>(movie.size());
+  std::string path = WriteTemp(movie);
+  vp_arena* arena = vp_arena_new(0);
+  vp_media_info info = {};
+  vp_byte_range needed[VP_MP4_MAX_NEEDED];
+  int needed_count = 0;
+  vp_reader reader;
+
+  // Nothing downloaded yet: ask for both ends of the file
+  vp_byte_range none[1] = {};
+  ASSERT_EQ(vp_reader_open_partial(&reader, path.c_str(), total, none, 0), VP_OK);
+  ASSERT_EQ(vp_mp4_probe_partial(&reader, arena, &info, needed, &needed_count), VP_ERROR_NEED_DATA);
+  vp_byte_range missing[8];
+  ASSERT_EQ(vp_reader_partial_missing(&reader, needed, needed_count, missing, 8), 2);
+  EXPECT_EQ(missing[0].offset, 0);
+  EXPECT_EQ(missing[1].offset + missing[1].length, total);
+  vp_reader_close(&reader);
+
+  // Head and tail are enough to answer
+  ASSERT_EQ(vp_reader_open_partial(&reader, path.c_str(), total, missing, 2), VP_OK);
+  ASSERT_EQ(vp_mp4_probe_partial(&reader, arena, &info, needed, &needed_count), VP_OK);
+  EXPECT_EQ(info.width, 1920);
+  EXPECT_DOUBLE_EQ(info.duration, 10.0);
+  vp_reader_close(&reader);
+
+  remove(path.c_str());
+  vp_arena_free(arena);
+}
+
+TEST(VideoProbeMp4Partial, RequestsRestOfTruncatedMoov) {
+  Bytes movie = Concat({Ftyp(), SampleMovie(0), Box("mdat", Bytes(4096, 0))});
+  const int64_t total = static_cast<int64_t>(movie.size());
+  // Sequential download that stopped inside moov
+  Bytes head(movie.begin(), movie.begin() + 100);
+  std::string path = WriteTemp(head);
+  vp_arena* arena = vp_arena_new(0);
+  vp_media_info info = {};
+  vp_byte_range needed[VP_MP4_MAX_NEEDED];
+  int needed_count = 0;
+  vp_reader reader;
+
+  ASSERT_EQ(vp_reader_open_partial(&reader, path.c_str(), total, nullptr, 0), VP_OK);
+  ASSERT_EQ(vp_mp4_probe_partial(&reader, arena, &info, needed, &needed_count), VP_ERROR_NEED_DATA);
+  vp_byte_range missing[8];
+  ASSERT_EQ(vp_reader_partial_missing(&reader, needed, needed_count, missing, 8), 1);
+  EXPECT_EQ(missing[0].offset, 100);
+  // Up to the end of moov, which starts right after ftyp
+  EXPECT_EQ(missing[0].offset + missing[0].length,
+            static_cast<int64_t>(Ftyp().size() + SampleMovie(0).size()));
+  vp_reader_close(&reader);
+
+  remove(path.c_str());
+  vp_arena_free(arena);
+}
+
+TEST(VideoProbeMp4Partial, MissingRangesSkipPresentBytes) {
+  Bytes data(1000, 0);
+  std::string path = WriteTemp(data);
+  vp_byte_range have[] = {{100, 100}, {150, 100}, {600, 50}};
+  vp_reader reader;
+  ASSERT_EQ(vp_reader_open_partial(&reader, path.c_str(), 1000, have, 3), VP_OK);
+
+  vp_byte_range wanted[] = {{0, 700}};
+  vp_byte_range missing[8];
+  ASSERT_EQ(vp_reader_partial_missing(&reader, wanted, 1, missing, 8), 3);
+  EXPECT_EQ(missing[0].offset, 0);
+  EXPECT_EQ(missing[0].length, 100);
+  EXPECT_EQ(missing[1].offset, 250);
+  EXPECT_EQ(missing[1].length, 350);
+  EXPECT_EQ(missing[2].offset, 650);
+  EXPECT_EQ(missing[2].length, 50);
+
+  uint8_t buf[16];
+  EXPECT_EQ(vp_reader_read_full(&reader, 120, buf, 16), 0);
+  EXPECT_EQ(vp_reader_read_full(&reader, 240, buf, 16), VP_READ_UNAVAILABLE);
+  vp_reader_close(&reader);
+  remove(path.c_str());
+}
+
+namespace {
+
+const Bytes kJpeg = {0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 0xFF, 0xD9};
+const Bytes kPng = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n', 0, 0, 0, 0};
+
+// iTunes-style cover item holding `images`, each as a data box of `type`
+Bytes Covr(std::initializer_list<std::pair<uint32_t, Bytes>> images) {
+  Bytes covr;
+  for (const auto& image : images) {
+    Bytes data;
+    Put32(data, image.first);
+    PutZeros(data, 4);  // locale
+    data.insert(data.end(), image.second.begin(), image.second.end());
+    covr = Concat({covr, Box("data", data)});
+  }
+  return Box("covr", covr);
+}
+
+int Cover(const Bytes& movie, vp_arena* arena, vp_embedded_image* image) {
+  vp_reader reader;
+  int status = vp_reader_open_memory(&reader, movie.data(), static_cast<int64_t>(movie.size()));
+  if (status == VP_OK) {
+    status = vp_mp4_cover(&reader, arena, image);
+    vp_reader_close(&reader);
+  }
+  return status;
+}
+
+}  // namespace
+
+TEST(VideoProbeMp4Cover, ReadsTheFirstCoverImage) {
+  Bytes meta = Concat({Bytes(4, 0), Hdlr("mdir"), Box("ilst", Covr({{14, kPng}, {13, kJpeg}}))});
+  Bytes moov = Box("moov", Concat({Mvhd(1000, 10000), Box("udta", Box("meta", meta))}));
+  Bytes movie = Concat({Ftyp(), moov, Box("mdat", Bytes(64, 0))});
+  vp_arena* arena = vp_arena_new(0);
+
+  vp_embedded_image image = {};
+  ASSERT_EQ(Cover(movie, arena, &image), VP_OK);
+  EXPECT_EQ(image.format, VP_IMAGE_PNG);
+  ASSERT_EQ(image.size, kPng.size());
+  EXPECT_EQ(memcmp(image.data, kPng.data(), kPng.size()), 0);
+
+  vp_arena_free(arena);
+}
+
+TEST(VideoProbeMp4Cover, ReadsQuickTimeMetaAndCameraThumbnails) {
+  // QuickTime meta has no version and flags; the type code says nothing
+  Bytes quicktime = Box("meta", Concat({Hdlr("mdta"), Box("ilst", Covr({{0, kJpeg}}))}));
+  Bytes moov = Box("moov", Concat({Mvhd(1000, 10000), quicktime}));
+  vp_arena* arena = vp_arena_new(0);
+  vp_embedded_image image = {};
+  ASSERT_EQ(Cover(Concat({Ftyp(), moov}), arena, &image), VP_OK);
+  EXPECT_EQ(image.format, VP_IMAGE_JPEG);
+  EXPECT_EQ(image.size, kJpeg.size());
+
+  Bytes canon = Box("udta", Box("CNTH", Box("CNDA", kJpeg)));
+  moov = Box("moov", Concat({Mvhd(1000, 10000), canon}));
+  ASSERT_EQ(Cover(Concat({Ftyp(), moov}), arena, &image), VP_OK);
+  EXPECT_EQ(image.format, VP_IMAGE_JPEG);
+  EXPECT_EQ(memcmp(image.data, kJpeg.data(), kJpeg.size()), 0);
+
+  vp_arena_free(arena);
+}
+
+TEST(VideoProbeMp4Cover, ReportsFilesWithoutImages) {
+  vp_arena* arena = vp_arena_new(0);
+  vp_embedded_image image = {};
+  EXPECT_EQ(Cover(Concat({Ftyp(), SampleMovie(0)}), arena, &image), VP_ERROR_NOT_FOUND);
+  EXPECT_EQ(image.data, nullptr);
+  EXPECT_EQ(Cover(Bytes(256, 0x47), arena, &image), VP_ERROR_UNSUPPORTED);
+  vp_arena_free(arena);
+}
+
+TEST(VideoProbeArena, MergeKeepsAllocationsAlive) {
+  vp_arena* dst = vp_arena_new(64);
+  vp_arena* src = vp_arena_new(64);
+  char* a = vp_arena_strdup(dst, "first");
+  char* b = vp_arena_strdup(src, "second");
+  void* big = vp_arena_alloc(src, 1000);
+  ASSERT_NE(big, nullptr);
+
+  vp_arena_merge(dst, src);
+  EXPECT_STREQ(a, "first");
+  EXPECT_STREQ(b, "second");
+
+  vp_arena_free(dst);
+}
+
+}  // namespace test
+}  // namespace video_probe
@@ -27,5 +27,18 @@ TEST(VideoProbePlugin, GetPlatformVersion) {
   EXPECT_THAT(fl_value_get_string(result), testing::StartsWith("Linux "));
 }
 
+TEST(VideoProbePlugin, RejectsMissingArgumentsWithTheStatus) {
+  g_autoptr(FlValue) args = fl_value_new_map();
+  fl_value_set_string_take(args, "frameNum", fl_value_new_int(3));
+  vp_call_options options = {};
+  g_autoptr(FlMethodResponse) response = handle_extract_frame(args, &options);
+  ASSERT_TRUE(FL_IS_METHOD_ERROR_RESPONSE(response));
+  FlMethodErrorResponse* error = FL_METHOD_ERROR_RESPONSE(response);
+  EXPECT_STREQ(fl_method_error_response_get_code(error), "probeError");
+  FlValue* details = fl_method_error_response_get_details(error);
+  ASSERT_EQ(fl_value_get_type(details), FL_VALUE_TYPE_INT);
+  EXPECT_EQ(fl_value_get_int(details), VP_ERROR_INVALID_ARGUMENT);
+}
+
 }  // namespace test
 }  // namespace video_probe
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+#include "../../src/video_probe_internal.h"
+
+// Tests for the frame buffer pool.
+
+namespace video_probe {
+namespace test {
+
+namespace {
+
+class VideoProbePool : public ::testing::Test {
+ protected:
+  // Start and end empty with the default limit
+  void SetUp() override {
+    set_frame_pool_limit(0);
+    set_frame_pool_limit(32 << 20);
+  }
+  void TearDown() override { SetUp(); }
+
+  static int64_t Allocations() {
+    vp_metrics metrics;
+    get_metrics(&metrics);
+    return metrics.allocations;
+  }
+};
+
+}  // namespace
+
+TEST_F(VideoProbePool, ReusesFreedFramesOfTheSameClass) {
+  uint8_t* first = vp_frame_alloc(100000);
+  ASSERT_NE(first, nullptr);
+  memset(first, 1, 100000);
+  vp_frame_free(first);
+  EXPECT_EQ(vp_frame_pool_bytes(), 128 * 1024);
+
+  reset_metrics();
+  // Any size up to the class size fits the same buffer
+  uint8_t* second = vp_frame_alloc(120000);
+  EXPECT_EQ(second, first);
+  memset(second, 2, 120000);
+  EXPECT_EQ(Allocations(), 0);
+  EXPECT_EQ(vp_frame_pool_bytes(), 0);
+
+  uint8_t* smaller = vp_frame_alloc(50000);
+  EXPECT_NE(smaller, first);
+  EXPECT_EQ(Allocations(), 1);
+  vp_frame_free(second);
+  vp_frame_free(smaller);
+}
+
+TEST_F(VideoProbePool, KeepsFramesAlignedAsMalloc) {
+  uint8_t* frame = vp_frame_alloc(1);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(frame) % alignof(max_align_t), 0u);
+  vp_frame_free(frame);
+}
+
+TEST_F(VideoProbePool, DoesNotPoolFramesAboveTheLargestClass) {
+  uint8_t* frame = vp_frame_alloc((16 << 20) + 1);
+  ASSERT_NE(frame, nullptr);
+  vp_frame_free(frame);
+  EXPECT_EQ(vp_frame_pool_bytes(), 0);
+}
+
+TEST_F(VideoProbePool, StaysWithinTheLimit) {
+  ASSERT_EQ(set_frame_pool_limit(64 * 1024), VP_OK);
+  uint8_t* a = vp_frame_alloc(40000);
+  uint8_t* b = vp_frame_alloc(40000);
+  vp_frame_free(a);
+  vp_frame_free(b);
+  EXPECT_EQ(vp_frame_pool_bytes(), 64 * 1024);
+
+  // Lowering the limit releases what no longer fits
+  ASSERT_EQ(set_frame_pool_limit(4096), VP_OK);
+  EXPECT_EQ(vp_frame_pool_bytes(), 0);
+  ASSERT_EQ(set_frame_pool_limit(0), VP_OK);
+  vp_frame_free(vp_frame_alloc(10));
+  EXPECT_EQ(vp_frame_pool_bytes(), 0);
+}
+
+TEST_F(VideoProbePool, BalancesLiveFrames) {
+  vp_metrics before;
+  get_metrics(&before);
+  uint8_t* frame = vp_frame_alloc(5000);
+  vp_frame_free(frame);
+  frame = vp_frame_alloc(5000);
+
+  vp_metrics metrics;
+  get_metrics(&metrics);
+  EXPECT_EQ(metrics.live_frames, before.live_frames + 1);
+  vp_frame_free(frame);
+  get_metrics(&metrics);
+  EXPECT_EQ(metrics.live_frames, before.live_frames);
+}
+
+TEST_F(VideoProbePool, RejectsNegativeLimit) {
+  EXPECT_EQ(set_frame_pool_limit(-1), VP_ERROR_INVALID_ARGUMENT);
+}
+
+}  // namespace test
+}  // namespace video_probe
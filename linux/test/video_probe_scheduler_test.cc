@@ -0,0 +1,197 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../src/video_probe_internal.h"
+
+// Tests for the request scheduler, with a fake decoder in place of the
+// platform one.
+
+namespace video_probe {
+namespace test {
+
+namespace {
+
+struct Finished {
+  int64_t id;
+  int status;
+};
+
+// State shared with the fake run function, which has no context argument
+struct FakeDecoder {
+  std::mutex lock;
+  std::condition_variable changed;
+  // Paths in the order the workers ran them
+  std::vector<std::string> ran;
+  std::vector<Finished> finished;
+  // Requests for "/block" wait here until released or cancelled
+  bool released = false;
+  bool blocking = false;
+};
+
+FakeDecoder* decoder;
+
+void FakeRun(const vp_request* request, const vp_call_options* options, vp_request_result* result) {
+  std::unique_lock<std::mutex> hold(decoder->lock);
+  decoder->ran.push_back(request->path);
+  if (std::string(request->path) == "/block") {
+    decoder->blocking = true;
+    decoder->changed.notify_all();
+    while (!decoder->released && !cancel_token_is_cancelled(options->cancel)) {
+      decoder->changed.wait_for(hold, std::chrono::milliseconds(1));
+    }
+    decoder->blocking = false;
+    result->status = decoder->released ? VP_OK : VP_ERROR_CANCELLED;
+    return;
+  }
+  result->status = VP_OK;
+}
+
+void Collect(vp_request_result* result, void*) {
+  std::lock_guard<std::mutex> hold(decoder->lock);
+  decoder->finished.push_back({result->id, result->status});
+  decoder->changed.notify_all();
+  free_request_result(result);
+}
+
+class VideoProbeScheduler : public testing::Test {
+ protected:
+  void SetUp() override {
+    decoder = &fake_;
+    scheduler_ = vp_scheduler_new(1, FakeRun, Collect, nullptr);
+    ASSERT_NE(scheduler_, nullptr);
+  }
+
+  void TearDown() override {
+    scheduler_free(scheduler_);
+    decoder = nullptr;
+  }
+
+  int64_t Submit(const char* path, int priority, int64_t slot = 0, int64_t timeout_ms = 0) {
+    vp_request request = {};
+    request.kind = VP_REQUEST_MEDIA_INFO;
+    request.path = path;
+    request.priority = priority;
+    request.slot = slot;
+    request.timeout_ms = timeout_ms;
+    return scheduler_submit(scheduler_, &request);
+  }
+
+  // Occupies the only worker until Release()
+  int64_t Block(int64_t slot = 0) {
+    int64_t id = Submit("/block", VP_PRIORITY_VISIBLE, slot);
+    std::unique_lock<std::mutex> hold(fake_.lock);
+    fake_.changed.wait(hold, [this] { return fake_.blocking; });
+    return id;
+  }
+
+  void Release() {
+    std::lock_guard<std::mutex> hold(fake_.lock);
+    fake_.released = true;
+    fake_.changed.notify_all();
+  }
+
+  void WaitFinished(size_t count) {
+    std::unique_lock<std::mutex> hold(fake_.lock);
+    ASSERT_TRUE(fake_.changed.wait_for(hold, std::chrono::seconds(5),
+                                       [&] { return fake_.finished.size() >= count; }));
+  }
+
+  int StatusOf(int64_t id) {
+    std::lock_guard<std::mutex> hold(fake_.lock);
+    for (const Finished& f : fake_.finished) {
+      if (f.id == id) return f.status;
+    }
+    return 1;
+  }
+
+  FakeDecoder fake_;
+  vp_scheduler* scheduler_ = nullptr;
+};
+
+}  // namespace
+
+TEST_F(VideoProbeScheduler, RunsMostUrgentClassFirst) {
+  Block();
+  Submit("/background", VP_PRIORITY_BACKGROUND);
+  Submit("/prefetch", VP_PRIORITY_PREFETCH);
+  Submit("/visible-1", VP_PRIORITY_VISIBLE);
+  Submit("/visible-2", VP_PRIORITY_VISIBLE);
+  Release();
+  WaitFinished(5);
+  EXPECT_EQ(fake_.ran, (std::vector<std::string>{"/block", "/visible-1", "/visible-2", "/prefetch", "/background"}));
+}
+
+TEST_F(VideoProbeScheduler, LatestRequestOnASlotWins) {
+  Block();
+  int64_t first = Submit("/first", VP_PRIORITY_VISIBLE, 7);
+  // Dropped at once, without waiting for the worker
+  int64_t second = Submit("/second", VP_PRIORITY_VISIBLE, 7);
+  EXPECT_EQ(StatusOf(first), VP_ERROR_CANCELLED);
+  Release();
+  WaitFinished(3);
+  EXPECT_EQ(StatusOf(second), VP_OK);
+  EXPECT_EQ(fake_.ran, (std::vector<std::string>{"/block", "/second"}));
+}
+
+TEST_F(VideoProbeScheduler, SupersedingCancelsRunningRequest) {
+  int64_t running = Block(3);
+  int64_t next = Submit("/next", VP_PRIORITY_VISIBLE, 3);
+  WaitFinished(2);
+  EXPECT_EQ(StatusOf(running), VP_ERROR_CANCELLED);
+  EXPECT_EQ(StatusOf(next), VP_OK);
+}
+
+TEST_F(VideoProbeScheduler, ReprioritizesQueuedRequests) {
+  Block();
+  int64_t a = Submit("/a", VP_PRIORITY_BACKGROUND);
+  int64_t b = Submit("/b", VP_PRIORITY_BACKGROUND);
+  EXPECT_EQ(scheduler_set_priority(scheduler_, b, VP_PRIORITY_VISIBLE), VP_OK);
+  EXPECT_EQ(scheduler_set_priority(scheduler_, b, 9), VP_ERROR_INVALID_ARGUMENT);
+  Release();
+  WaitFinished(3);
+  EXPECT_EQ(fake_.ran, (std::vector<std::string>{"/block", "/b", "/a"}));
+  EXPECT_EQ(scheduler_set_priority(scheduler_, a, VP_PRIORITY_VISIBLE), VP_ERROR_NOT_FOUND);
+}
+
+TEST_F(VideoProbeScheduler, CancelsAndExpiresQueuedRequests) {
+  Block();
+  int64_t cancelled = Submit("/cancelled", VP_PRIORITY_VISIBLE);
+  int64_t expired = Submit("/expired", VP_PRIORITY_VISIBLE, 0, 1);
+  EXPECT_EQ(scheduler_cancel(scheduler_, cancelled), VP_OK);
+  EXPECT_EQ(StatusOf(cancelled), VP_ERROR_CANCELLED);
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  Release();
+  WaitFinished(3);
+  EXPECT_EQ(StatusOf(expired), VP_ERROR_TIMEOUT);
+  EXPECT_EQ(fake_.ran, (std::vector<std::string>{"/block"}));
+  EXPECT_EQ(scheduler_cancel(scheduler_, cancelled), VP_ERROR_NOT_FOUND);
+}
+
+TEST_F(VideoProbeScheduler, FreeReportsQueuedRequests) {
+  int64_t running = Block();
+  int64_t queued = Submit("/queued", VP_PRIORITY_BACKGROUND);
+  scheduler_free(scheduler_);
+  scheduler_ = nullptr;
+  EXPECT_EQ(StatusOf(running), VP_ERROR_CANCELLED);
+  EXPECT_EQ(StatusOf(queued), VP_ERROR_CANCELLED);
+  EXPECT_EQ(fake_.ran, (std::vector<std::string>{"/block"}));
+}
+
+TEST_F(VideoProbeScheduler, RejectsInvalidRequests) {
+  EXPECT_EQ(Submit(nullptr, VP_PRIORITY_VISIBLE), VP_ERROR_INVALID_ARGUMENT);
+  EXPECT_EQ(Submit("/a", 3), VP_ERROR_INVALID_ARGUMENT);
+  vp_request frame = {};
+  frame.kind = VP_REQUEST_FRAME;
+  frame.path = "/a";
+  frame.frame_num = -1;
+  EXPECT_EQ(scheduler_submit(scheduler_, &frame), VP_ERROR_INVALID_ARGUMENT);
+}
+
+}  // namespace test
+}  // namespace video_probe
@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../src/video_probe_internal.h"
+
+// Tests for the span ring and its Chrome trace export.
+
+namespace video_probe {
+namespace test {
+
+namespace {
+
+std::string Dump() {
+  char* json = nullptr;
+  int64_t size = 0;
+  EXPECT_EQ(trace_dump(&json, &size), VP_OK);
+  std::string result(json, static_cast<size_t>(size));
+  free_trace(json);
+  return result;
+}
+
+size_t Count(const std::string& haystack, const std::string& needle) {
+  size_t count = 0;
+  for (size_t at = haystack.find(needle); at != std::string::npos; at = haystack.find(needle, at + 1)) {
+    count++;
+  }
+  return count;
+}
+
+class VideoProbeTrace : public testing::Test {
+ protected:
+  void TearDown() override { trace_stop(); }
+};
+
+}  // namespace
+
+TEST_F(VideoProbeTrace, RecordsNothingUntilStarted) {
+  ASSERT_EQ(trace_start(16), VP_OK);
+  trace_stop();
+  vp_trace_span(0, "ignored", 1, 2);
+  EXPECT_FALSE(vp_trace_enabled());
+  std::string json = Dump();
+  EXPECT_EQ(json.find("ignored"), std::string::npos);
+  EXPECT_NE(json.find("\"traceEvents\":["), std::string::npos);
+}
+
+TEST_F(VideoProbeTrace, WritesCompleteEventsWithThreadIds) {
+  ASSERT_EQ(trace_start(16), VP_OK);
+  vp_trace_span(0, "preroll", 100, 350);
+  vp_trace_span(42, "decode", 200, 260);
+  std::string json = Dump();
+
+  std::string own = "\"tid\":" + std::to_string(vp_trace_thread_id());
+  EXPECT_NE(json.find("{\"name\":\"preroll\",\"cat\":\"video_probe\",\"ph\":\"X\",\"ts\":100,\"dur\":250,"),
+            std::string::npos);
+  EXPECT_NE(json.find(own + "}"), std::string::npos);
+  EXPECT_NE(json.find("\"name\":\"decode\""), std::string::npos);
+  EXPECT_NE(json.find("\"tid\":42}"), std::string::npos);
+  // The calling thread is still alive, so it gets a name
+  EXPECT_NE(json.find("\"name\":\"thread_name\",\"ph\":\"M\""), std::string::npos);
+}
+
+TEST_F(VideoProbeTrace, KeepsNewestEventsWhenFull) {
+  static const char* const kNames[] = {"s0", "s1", "s2", "s3", "s4", "s5", "s6", "s7", "s8", "s9"};
+  ASSERT_EQ(trace_start(4), VP_OK);
+  for (int i = 0; i < 10; i++) vp_trace_span(0, kNames[i], i, i + 1);
+  std::string json = Dump();
+  EXPECT_EQ(Count(json, "\"ph\":\"X\""), 4u);
+  EXPECT_EQ(json.find("\"s5\""), std::string::npos);
+  EXPECT_NE(json.find("\"s6\""), std::string::npos);
+  EXPECT_NE(json.find("\"s9\""), std::string::npos);
+
+  // Restarting discards the previous recording
+  ASSERT_EQ(trace_start(4), VP_OK);
+  EXPECT_EQ(Count(Dump(), "\"ph\":\"X\""), 0u);
+}
+
+TEST_F(VideoProbeTrace, RestartsAndDumpsWhileThreadsRecord) {
+  ASSERT_EQ(trace_start(64), VP_OK);
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&stop] {
+      while (!stop.load()) vp_trace_span(0, "bus wait", 1, 2);
+    });
+  }
+  for (int i = 0; i < 20; i++) {
+    ASSERT_EQ(trace_start(64), VP_OK);
+    EXPECT_LE(Count(Dump(), "\"ph\":\"X\""), 64u);
+  }
+  stop = true;
+  for (std::thread& thread : threads) thread.join();
+}
+
+TEST_F(VideoProbeTrace, RejectsInvalidArguments) {
+  EXPECT_EQ(trace_start(-1), VP_ERROR_INVALID_ARGUMENT);
+  int64_t size = 0;
+  EXPECT_EQ(trace_dump(nullptr, &size), VP_ERROR_INVALID_ARGUMENT);
+}
+
+}  // namespace test
+}  // namespace video_probe
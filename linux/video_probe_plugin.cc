@@ -5,6 +5,7 @@
 #include <sys/utsname.h>
 
 #include <cstring>
+#include <vector>
 
 #include "video_probe_plugin_private.h"
 
@@ -14,10 +15,134 @@
 
 struct _VideoProbePlugin {
   GObject parent_instance;
+
+  // Cancel tokens of the calls running on workers, keyed by the call id
+  // sent from Dart. Only used on the main thread.
+  GHashTable* calls;
 };
 
 G_DEFINE_TYPE(VideoProbePlugin, video_probe_plugin, g_object_get_type())
 
+// A method call answered on a worker thread.
+typedef struct {
+  MethodWorker worker;
+  FlMethodCall* method_call;
+  vp_call_options options;
+  // 0 if the call cannot be cancelled.
+  gint64 call_id;
+} MethodTask;
+
+static void method_task_free(gpointer data) {
+  MethodTask* task = static_cast<MethodTask*>(data);
+  if (task->options.cancel != nullptr) {
+    cancel_token_free(task->options.cancel);
+  }
+  g_object_unref(task->method_call);
+  g_free(task);
+}
+
+// Runs on a GTask worker thread, so decoding never blocks the main loop.
+static void method_task_run(GTask* task, gpointer source_object,
+                            gpointer task_data, GCancellable* cancellable) {
+  MethodTask* method_task = static_cast<MethodTask*>(task_data);
+  FlMethodResponse* response = method_task->worker(
+      fl_method_call_get_args(method_task->method_call),
+      &method_task->options);
+  g_task_return_pointer(task, response, g_object_unref);
+}
+
+// Back on the main thread: forgets the call and sends its response.
+static void method_task_done(GObject* source_object, GAsyncResult* result,
+                             gpointer user_data) {
+  VideoProbePlugin* self = VIDEO_PROBE_PLUGIN(source_object);
+  GTask* task = G_TASK(result);
+  MethodTask* method_task =
+      static_cast<MethodTask*>(g_task_get_task_data(task));
+  if (method_task->call_id != 0 &&
+      g_hash_table_lookup(self->calls, &method_task->call_id) ==
+          method_task->options.cancel) {
+    g_hash_table_remove(self->calls, &method_task->call_id);
+  }
+
+  g_autoptr(FlMethodResponse) response =
+      FL_METHOD_RESPONSE(g_task_propagate_pointer(task, nullptr));
+  fl_method_call_respond(method_task->method_call, response, nullptr);
+}
+
+static const gchar* string_arg(FlValue* args, const char* key) {
+  FlValue* value = fl_value_lookup_string(args, key);
+  return value != nullptr && fl_value_get_type(value) == FL_VALUE_TYPE_STRING
+             ? fl_value_get_string(value)
+             : nullptr;
+}
+
+static int64_t int_arg(FlValue* args, const char* key, int64_t fallback) {
+  FlValue* value = fl_value_lookup_string(args, key);
+  return value != nullptr && fl_value_get_type(value) == FL_VALUE_TYPE_INT
+             ? fl_value_get_int(value)
+             : fallback;
+}
+
+static bool bool_arg(FlValue* args, const char* key) {
+  FlValue* value = fl_value_lookup_string(args, key);
+  return value != nullptr && fl_value_get_type(value) == FL_VALUE_TYPE_BOOL &&
+         fl_value_get_bool(value);
+}
+
+// Failure of the whole call. Dart reads the VP_* status from the details.
+static FlMethodResponse* status_error(int status) {
+  g_autoptr(FlValue) details = fl_value_new_int(status);
+  return FL_METHOD_RESPONSE(
+      fl_method_error_response_new("probeError", nullptr, details));
+}
+
+static FlMethodResponse* success(FlValue* result) {
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+// Queues `method_call` on a worker. The arguments must be a map; a
+// "callId" makes the call cancellable and "timeoutMs" sets its deadline.
+static void run_on_worker(VideoProbePlugin* self, FlMethodCall* method_call,
+                          MethodWorker worker) {
+  FlValue* args = fl_method_call_get_args(method_call);
+  if (fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
+    g_autoptr(FlMethodResponse) response =
+        status_error(VP_ERROR_INVALID_ARGUMENT);
+    fl_method_call_respond(method_call, response, nullptr);
+    return;
+  }
+
+  MethodTask* method_task = g_new0(MethodTask, 1);
+  method_task->worker = worker;
+  method_task->method_call = FL_METHOD_CALL(g_object_ref(method_call));
+  method_task->options.timeout_ms = MAX(int_arg(args, "timeoutMs", 0), 0);
+  method_task->call_id = int_arg(args, "callId", 0);
+  if (method_task->call_id != 0) {
+    method_task->options.cancel = cancel_token_new();
+    gint64* key = g_new(gint64, 1);
+    *key = method_task->call_id;
+    g_hash_table_replace(self->calls, key, method_task->options.cancel);
+  }
+
+  GTask* task = g_task_new(self, nullptr, method_task_done, nullptr);
+  g_task_set_task_data(task, method_task, method_task_free);
+  g_task_run_in_thread(task, method_task_run);
+  g_object_unref(task);
+}
+
+// Cancels the running call with the "callId" of `args`, if any.
+static FlMethodResponse* cancel_call(VideoProbePlugin* self, FlValue* args) {
+  if (fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+    gint64 call_id = int_arg(args, "callId", 0);
+    vp_cancel_token* token = static_cast<vp_cancel_token*>(
+        g_hash_table_lookup(self->calls, &call_id));
+    if (token != nullptr) {
+      cancel_token_cancel(token);
+    }
+  }
+  return success(nullptr);
+}
+
 // Called when a method call is received from Flutter.
 static void video_probe_plugin_handle_method_call(
     VideoProbePlugin* self,
@@ -28,6 +153,26 @@ static void video_probe_plugin_handle_method_call(
 
   if (strcmp(method, "getPlatformVersion") == 0) {
     response = get_platform_version();
+  } else if (strcmp(method, "getDuration") == 0) {
+    run_on_worker(self, method_call, handle_get_duration);
+    return;
+  } else if (strcmp(method, "getFrameCount") == 0) {
+    run_on_worker(self, method_call, handle_get_frame_count);
+    return;
+  } else if (strcmp(method, "getMediaInfo") == 0) {
+    run_on_worker(self, method_call, handle_get_media_info);
+    return;
+  } else if (strcmp(method, "probeBatch") == 0) {
+    run_on_worker(self, method_call, handle_probe_batch);
+    return;
+  } else if (strcmp(method, "extractFrame") == 0) {
+    run_on_worker(self, method_call, handle_extract_frame);
+    return;
+  } else if (strcmp(method, "extractFrames") == 0) {
+    run_on_worker(self, method_call, handle_extract_frames);
+    return;
+  } else if (strcmp(method, "cancel") == 0) {
+    response = cancel_call(self, fl_method_call_get_args(method_call));
   } else {
     response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
   }
@@ -43,7 +188,267 @@ FlMethodResponse* get_platform_version() {
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
+// get_duration() and get_frame_count() take no call options, and Dart
+// sends none for them
+FlMethodResponse* handle_get_duration(FlValue* args,
+                                      const vp_call_options* /* options */) {
+  const gchar* path = string_arg(args, "path");
+  if (path == nullptr) {
+    return status_error(VP_ERROR_INVALID_ARGUMENT);
+  }
+  g_autoptr(FlValue) result = fl_value_new_float(get_duration(path));
+  return success(result);
+}
+
+FlMethodResponse* handle_get_frame_count(
+    FlValue* args, const vp_call_options* /* options */) {
+  const gchar* path = string_arg(args, "path");
+  if (path == nullptr) {
+    return status_error(VP_ERROR_INVALID_ARGUMENT);
+  }
+  g_autoptr(FlValue) result = fl_value_new_int(get_frame_count(path));
+  return success(result);
+}
+
+FlMethodResponse* handle_extract_frame(FlValue* args,
+                                       const vp_call_options* options) {
+  const gchar* path = string_arg(args, "path");
+  int64_t frame_num = int_arg(args, "frameNum", -1);
+  if (path == nullptr || frame_num < 0 || frame_num > G_MAXINT) {
+    return status_error(VP_ERROR_INVALID_ARGUMENT);
+  }
+
+  uint8_t* data = nullptr;
+  int size = 0;
+  int status = extract_frame_ex(path, static_cast<int>(frame_num), options,
+                                &data, &size);
+  if (status != VP_OK) {
+    return status_error(status);
+  }
+  g_autoptr(FlValue) result = fl_value_new_uint8_list(data, size);
+  free_frame(data);
+  return success(result);
+}
+
+FlMethodResponse* handle_extract_frames(FlValue* args,
+                                        const vp_call_options* options) {
+  const gchar* path = string_arg(args, "path");
+  FlValue* frames = fl_value_lookup_string(args, "frameNums");
+  if (path == nullptr || frames == nullptr) {
+    return status_error(VP_ERROR_INVALID_ARGUMENT);
+  }
+  // Same range as extract_frame's frameNum, checked per element
+  std::vector<int> frame_nums;
+  if (fl_value_get_type(frames) == FL_VALUE_TYPE_INT32_LIST) {
+    const int32_t* values = fl_value_get_int32_list(frames);
+    for (size_t i = 0; i < fl_value_get_length(frames); i++) {
+      if (values[i] < 0) {
+        return status_error(VP_ERROR_INVALID_ARGUMENT);
+      }
+      frame_nums.push_back(values[i]);
+    }
+  } else if (fl_value_get_type(frames) == FL_VALUE_TYPE_LIST) {
+    for (size_t i = 0; i < fl_value_get_length(frames); i++) {
+      FlValue* value = fl_value_get_list_value(frames, i);
+      if (fl_value_get_type(value) != FL_VALUE_TYPE_INT) {
+        return status_error(VP_ERROR_INVALID_ARGUMENT);
+      }
+      int64_t frame_num = fl_value_get_int(value);
+      if (frame_num < 0 || frame_num > G_MAXINT) {
+        return status_error(VP_ERROR_INVALID_ARGUMENT);
+      }
+      frame_nums.push_back(static_cast<int>(frame_num));
+    }
+  } else {
+    return status_error(VP_ERROR_INVALID_ARGUMENT);
+  }
+
+  vp_frames_options frames_options = {};
+  frames_options.max_workers =
+      static_cast<int>(int_arg(args, "maxWorkers", 0));
+  frames_options.call = *options;
+  frames_options.call.decoder_threads =
+      static_cast<int>(int_arg(args, "decoderThreads", 0));
+  vp_frames_result frames_result = {};
+  int status = extract_frames(path, frame_nums.data(),
+                              static_cast<int>(frame_nums.size()),
+                              &frames_options, &frames_result);
+  if (status != VP_OK) {
+    return status_error(status);
+  }
+
+  // One {status, data} map per requested frame, in request order
+  g_autoptr(FlValue) result = fl_value_new_list();
+  for (int i = 0; i < frames_result.count; i++) {
+    const vp_frame_item* item = &frames_result.items[i];
+    FlValue* entry = fl_value_new_map();
+    fl_value_set_string_take(entry, "status", fl_value_new_int(item->status));
+    if (item->status == VP_OK && item->data != nullptr) {
+      fl_value_set_string_take(entry, "data",
+                               fl_value_new_uint8_list(item->data, item->size));
+    }
+    fl_value_append_take(result, entry);
+  }
+  free_frames_result(&frames_result);
+  return success(result);
+}
+
+// Copies a stream into a map keyed by the MediaStreamInfo field names.
+static FlValue* stream_info_value(const vp_stream_info* stream) {
+  FlValue* value = fl_value_new_map();
+  fl_value_set_string_take(value, "type", fl_value_new_int(stream->type));
+  fl_value_set_string_take(value, "codec", fl_value_new_string(stream->codec));
+  if (stream->language != nullptr) {
+    fl_value_set_string_take(value, "language",
+                             fl_value_new_string(stream->language));
+  }
+  fl_value_set_string_take(value, "bitrate", fl_value_new_int(stream->bitrate));
+  fl_value_set_string_take(value, "width", fl_value_new_int(stream->width));
+  fl_value_set_string_take(value, "height", fl_value_new_int(stream->height));
+  fl_value_set_string_take(value, "pixelAspectNum",
+                           fl_value_new_int(stream->par_num));
+  fl_value_set_string_take(value, "pixelAspectDen",
+                           fl_value_new_int(stream->par_den));
+  fl_value_set_string_take(value, "frameRateNum",
+                           fl_value_new_int(stream->fps_num));
+  fl_value_set_string_take(value, "frameRateDen",
+                           fl_value_new_int(stream->fps_den));
+  fl_value_set_string_take(value, "rotation",
+                           fl_value_new_int(stream->rotation));
+  fl_value_set_string_take(value, "bitDepth",
+                           fl_value_new_int(stream->bit_depth));
+  fl_value_set_string_take(value, "colorPrimaries",
+                           fl_value_new_int(stream->color_primaries));
+  fl_value_set_string_take(value, "transfer",
+                           fl_value_new_int(stream->transfer));
+  fl_value_set_string_take(value, "isHdr",
+                           fl_value_new_bool(stream->is_hdr != 0));
+  fl_value_set_string_take(value, "channels",
+                           fl_value_new_int(stream->channels));
+  fl_value_set_string_take(value, "sampleRate",
+                           fl_value_new_int(stream->sample_rate));
+  return value;
+}
+
+// Copies `info` into a map keyed by the VideoInfo field names.
+static FlValue* media_info_value(const vp_media_info* info) {
+  FlValue* value = fl_value_new_map();
+  if (info->container != nullptr) {
+    fl_value_set_string_take(value, "container",
+                             fl_value_new_string(info->container));
+  }
+  fl_value_set_string_take(value, "duration",
+                           fl_value_new_float(info->duration));
+  fl_value_set_string_take(value, "bitrate", fl_value_new_int(info->bitrate));
+  fl_value_set_string_take(value, "frameCount",
+                           fl_value_new_int(info->frame_count));
+  fl_value_set_string_take(value, "hasVideo",
+                           fl_value_new_bool(info->has_video != 0));
+  if (info->video_codec != nullptr) {
+    fl_value_set_string_take(value, "videoCodec",
+                             fl_value_new_string(info->video_codec));
+  }
+  fl_value_set_string_take(value, "width", fl_value_new_int(info->width));
+  fl_value_set_string_take(value, "height", fl_value_new_int(info->height));
+  fl_value_set_string_take(value, "pixelAspectNum",
+                           fl_value_new_int(info->par_num));
+  fl_value_set_string_take(value, "pixelAspectDen",
+                           fl_value_new_int(info->par_den));
+  fl_value_set_string_take(value, "frameRateNum",
+                           fl_value_new_int(info->fps_num));
+  fl_value_set_string_take(value, "frameRateDen",
+                           fl_value_new_int(info->fps_den));
+  fl_value_set_string_take(value, "rotation", fl_value_new_int(info->rotation));
+  fl_value_set_string_take(value, "bitDepth",
+                           fl_value_new_int(info->bit_depth));
+  fl_value_set_string_take(value, "colorPrimaries",
+                           fl_value_new_int(info->color_primaries));
+  fl_value_set_string_take(value, "transfer", fl_value_new_int(info->transfer));
+  fl_value_set_string_take(value, "isHdr",
+                           fl_value_new_bool(info->is_hdr != 0));
+  FlValue* streams = fl_value_new_list();
+  for (int i = 0; i < info->stream_count; i++) {
+    fl_value_append_take(streams, stream_info_value(&info->streams[i]));
+  }
+  fl_value_set_string_take(value, "streams", streams);
+  return value;
+}
+
+FlMethodResponse* handle_get_media_info(FlValue* args,
+                                        const vp_call_options* options) {
+  const gchar* path = string_arg(args, "path");
+  if (path == nullptr) {
+    return status_error(VP_ERROR_INVALID_ARGUMENT);
+  }
+  vp_media_info info = {};
+  int status = probe_media_info_ex(path, options, &info);
+  if (status != VP_OK) {
+    return status_error(status);
+  }
+  g_autoptr(FlValue) result = media_info_value(&info);
+  free_media_info(&info);
+  return success(result);
+}
+
+FlMethodResponse* handle_probe_batch(FlValue* args,
+                                     const vp_call_options* options) {
+  FlValue* list = fl_value_lookup_string(args, "paths");
+  if (list == nullptr || fl_value_get_type(list) != FL_VALUE_TYPE_LIST) {
+    return status_error(VP_ERROR_INVALID_ARGUMENT);
+  }
+  std::vector<const char*> paths;
+  for (size_t i = 0; i < fl_value_get_length(list); i++) {
+    FlValue* value = fl_value_get_list_value(list, i);
+    if (fl_value_get_type(value) != FL_VALUE_TYPE_STRING) {
+      return status_error(VP_ERROR_INVALID_ARGUMENT);
+    }
+    paths.push_back(fl_value_get_string(value));
+  }
+
+  vp_batch_options batch_options = {};
+  if (bool_arg(args, "thumbnails")) {
+    batch_options.flags |= VP_BATCH_THUMBNAILS;
+  }
+  if (bool_arg(args, "preferEmbeddedThumbnails")) {
+    batch_options.flags |= VP_BATCH_EMBEDDED_THUMBNAILS;
+  }
+  batch_options.max_workers = static_cast<int>(int_arg(args, "maxWorkers", 0));
+  batch_options.thumbnail_frame =
+      static_cast<int>(int_arg(args, "thumbnailFrame", 0));
+  batch_options.call = *options;
+  vp_batch_result batch_result = {};
+  int status = probe_batch(paths.data(), static_cast<int>(paths.size()),
+                           &batch_options, &batch_result);
+
+  // One {status, info?, thumbnail?} map per path, in request order; a
+  // failed batch gives every path its status, as through FFI
+  g_autoptr(FlValue) result = fl_value_new_list();
+  for (size_t i = 0; i < paths.size(); i++) {
+    FlValue* entry = fl_value_new_map();
+    if (status != VP_OK) {
+      fl_value_set_string_take(entry, "status", fl_value_new_int(status));
+    } else {
+      const vp_batch_item* item = &batch_result.items[i];
+      fl_value_set_string_take(entry, "status", fl_value_new_int(item->status));
+      if (item->status == VP_OK) {
+        fl_value_set_string_take(entry, "info", media_info_value(&item->info));
+      }
+      if (item->thumbnail != nullptr && item->thumbnail_size > 0) {
+        fl_value_set_string_take(
+            entry, "thumbnail",
+            fl_value_new_uint8_list(item->thumbnail, item->thumbnail_size));
+      }
+    }
+    fl_value_append_take(result, entry);
+  }
+  free_batch_result(&batch_result);
+  return success(result);
+}
+
 static void video_probe_plugin_dispose(GObject* object) {
+  VideoProbePlugin* self = VIDEO_PROBE_PLUGIN(object);
+  // Running tasks hold a reference, so no call is left in the table
+  g_clear_pointer(&self->calls, g_hash_table_destroy);
   G_OBJECT_CLASS(video_probe_plugin_parent_class)->dispose(object);
 }
 
@@ -51,7 +456,10 @@ static void video_probe_plugin_class_init(VideoProbePluginClass* klass) {
   G_OBJECT_CLASS(klass)->dispose = video_probe_plugin_dispose;
 }
 
-static void video_probe_plugin_init(VideoProbePlugin* self) {}
+static void video_probe_plugin_init(VideoProbePlugin* self) {
+  self->calls =
+      g_hash_table_new_full(g_int64_hash, g_int64_equal, g_free, nullptr);
+}
 
 static void method_call_cb(FlMethodChannel* channel, FlMethodCall* method_call,
                            gpointer user_data) {
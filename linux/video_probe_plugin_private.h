@@ -1,6 +1,7 @@
 #include <flutter_linux/flutter_linux.h>
 
 #include "include/video_probe/video_probe_plugin.h"
+#include "../src/video_probe.h"
 
 // This file exposes some plugin internals for unit testing. See
 // https://github.com/flutter/flutter/issues/88724 for current limitations
@@ -8,3 +9,38 @@
 
 // Handles the getPlatformVersion method call.
 FlMethodResponse *get_platform_version();
+
+// Answers a method call from its argument map. Runs on a worker thread;
+// `options` carry the call's deadline and cancel token. Failures are error
+// responses with code "probeError" and the VP_* status as details.
+typedef FlMethodResponse *(*MethodWorker)(FlValue *args,
+                                          const vp_call_options *options);
+
+// getDuration {path}: the duration in seconds, -1.0 on error. Ignores
+// `options`.
+FlMethodResponse *handle_get_duration(FlValue *args,
+                                      const vp_call_options *options);
+
+// getFrameCount {path}: the frame count, -1 on error. Ignores `options`.
+FlMethodResponse *handle_get_frame_count(FlValue *args,
+                                         const vp_call_options *options);
+
+// getMediaInfo {path}: a map keyed by the VideoInfo field names, with
+// "streams" a list of maps keyed by the MediaStreamInfo field names.
+FlMethodResponse *handle_get_media_info(FlValue *args,
+                                        const vp_call_options *options);
+
+// probeBatch {paths, thumbnails?, thumbnailFrame?, preferEmbeddedThumbnails?,
+// maxWorkers?}: a list of {status, info?, thumbnail?} maps in request order,
+// with info as for getMediaInfo.
+FlMethodResponse *handle_probe_batch(FlValue *args,
+                                     const vp_call_options *options);
+
+// extractFrame {path, frameNum}: the JPEG as a Uint8List.
+FlMethodResponse *handle_extract_frame(FlValue *args,
+                                       const vp_call_options *options);
+
+// extractFrames {path, frameNums, maxWorkers?, decoderThreads?}: a list of
+// {status, data?} maps in request order.
+FlMethodResponse *handle_extract_frames(FlValue *args,
+                                        const vp_call_options *options);
@@ -4,11 +4,17 @@
 // A very short-lived memory allocator for demonstration
 // In production, use your platform's video decoding logic here.
 
+// Size of the dummy frames. benchmark/native overrides it to measure
+// copies of realistic JPEG sizes.
+#ifndef VP_STUB_FRAME_SIZE
+#define VP_STUB_FRAME_SIZE 100
+#endif
+
 EXPORT intptr_t sum(intptr_t a, intptr_t b) {
     return a + b;
 }
 
-EXPORT double get_duration(char* path) {
+EXPORT double get_duration(const char* path) {
     // TODO: Implement actual video duration extraction
     // This requires linking against a library like FFmpeg, or using platform specific APIs (AVFoundation, MediaMetadataRetriever, etc.)
     // For now, return a dummy value.
@@ -16,19 +22,20 @@ EXPORT double get_duration(char* path) {
     return 120.5; // Dummy 120.5 seconds
 }
 
-EXPORT int get_frame_count(char* path) {
+EXPORT int get_frame_count(const char* path) {
     // TODO: Implement actual frame count
     if (path == NULL) return -1;
     return 3000; // Dummy 3000 frames
 }
 
-EXPORT uint8_t* extract_frame(char* path, int frameNum, int* outSize) {
+EXPORT uint8_t* extract_frame(const char* path, int frameNum, int* outSize) {
     // TODO: Implement actual frame extraction
+    (void)frameNum;
     // For now, return a dummy buffer representing a "red pixel" or similar, or just random bytes.
     if (path == NULL) return NULL;
     
-    // Create a dummy 100-byte buffer
-    int size = 100;
+    // Create a dummy buffer
+    int size = VP_STUB_FRAME_SIZE;
     uint8_t* buffer = (uint8_t*)malloc(size);
     if (buffer == NULL) return NULL;
 
@@ -47,3 +54,485 @@ EXPORT void free_frame(uint8_t* buffer) {
         free(buffer);
     }
 }
+
+EXPORT int probe_media_info(const char* path, vp_media_info* out) {
+    // TODO: Implement actual media probing
+    if (out == NULL) return VP_ERROR_INVALID_ARGUMENT;
+    memset(out, 0, sizeof(*out));
+    if (path == NULL) return VP_ERROR_INVALID_ARGUMENT;
+
+    out->duration = 120.5;
+    out->frame_count = 3000;
+    out->has_video = 1;
+    out->video_codec = "h264";
+    out->width = 1920;
+    out->height = 1080;
+    out->par_num = 1;
+    out->par_den = 1;
+    out->fps_num = 25;
+    out->fps_den = 1;
+    out->bit_depth = 8;
+    out->color_primaries = 2;
+    out->transfer = 2;
+    return VP_OK;
+}
+
+EXPORT void free_media_info(vp_media_info* info) {
+    if (info != NULL) {
+        memset(info, 0, sizeof(*info));
+    }
+}
+
+EXPORT int probe_media_info_buffer(const uint8_t* data, int64_t size, vp_media_info* out) {
+    // TODO: Implement actual in-memory probing
+    if (data == NULL || size <= 0) {
+        if (out != NULL) memset(out, 0, sizeof(*out));
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+    return probe_media_info("", out);
+}
+
+EXPORT int probe_media_info_io(const vp_io_callbacks* io, vp_media_info* out) {
+    // TODO: Implement actual callback probing
+    if (io == NULL || io->read == NULL || io->seek == NULL) {
+        if (out != NULL) memset(out, 0, sizeof(*out));
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+    return probe_media_info("", out);
+}
+
+EXPORT uint8_t* extract_frame_buffer(const uint8_t* data, int64_t size, int frameNum, int* outSize) {
+    // TODO: Implement actual in-memory extraction
+    if (data == NULL || size <= 0) return NULL;
+    return extract_frame("", frameNum, outSize);
+}
+
+EXPORT uint8_t* extract_frame_io(const vp_io_callbacks* io, int frameNum, int* outSize) {
+    // TODO: Implement actual callback extraction
+    if (io == NULL || io->read == NULL || io->seek == NULL) return NULL;
+    return extract_frame("", frameNum, outSize);
+}
+
+EXPORT int probe_media_info_partial(const char* path, int64_t total_size, const vp_byte_range* available, int available_count, vp_media_info* out, vp_byte_range* needed, int needed_capacity, int* needed_count) {
+    // TODO: Implement actual partial-file probing
+    (void)available;
+    (void)available_count;
+    (void)needed;
+    (void)needed_capacity;
+    if (needed_count != NULL) *needed_count = 0;
+    if (total_size <= 0) {
+        if (out != NULL) memset(out, 0, sizeof(*out));
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+    return probe_media_info(path, out);
+}
+
+EXPORT int probe_needed_ranges(const char* path, int64_t total_size, const vp_byte_range* available, int available_count, vp_byte_range* needed, int needed_capacity, int* needed_count) {
+    // TODO: Implement actual partial-file probing
+    (void)available;
+    (void)available_count;
+    (void)needed;
+    (void)needed_capacity;
+    if (needed_count != NULL) *needed_count = 0;
+    if (path == NULL || total_size <= 0) return VP_ERROR_INVALID_ARGUMENT;
+    return VP_OK;
+}
+
+EXPORT int probe_batch(const char* const* paths, int count, const vp_batch_options* options, vp_batch_result* out) {
+    // TODO: Implement actual batch probing
+    (void)options;
+    if (out == NULL) return VP_ERROR_INVALID_ARGUMENT;
+    memset(out, 0, sizeof(*out));
+    if (paths == NULL || count < 0) return VP_ERROR_INVALID_ARGUMENT;
+
+    vp_batch_item* items = (vp_batch_item*)calloc(count > 0 ? count : 1, sizeof(vp_batch_item));
+    if (items == NULL) return VP_ERROR_NO_MEMORY;
+    for (int i = 0; i < count; i++) {
+        items[i].status = probe_media_info(paths[i], &items[i].info);
+    }
+    out->count = count;
+    out->items = items;
+    out->arena = items;
+    return VP_OK;
+}
+
+EXPORT void free_batch_result(vp_batch_result* result) {
+    if (result != NULL) {
+        free(result->arena);
+        memset(result, 0, sizeof(*result));
+    }
+}
+
+EXPORT int set_io_backend(int backend) {
+    // TODO: Implement native file I/O backends
+    if (backend < VP_IO_AUTO || backend > VP_IO_URING) return VP_ERROR_INVALID_ARGUMENT;
+    return backend == VP_IO_URING ? VP_ERROR_UNSUPPORTED : VP_OK;
+}
+
+EXPORT void get_io_stats(vp_io_stats* out) {
+    // TODO: Report native file I/O counters
+    if (out != NULL) memset(out, 0, sizeof(*out));
+}
+
+struct vp_cancel_token {
+    int cancelled;
+};
+
+EXPORT vp_cancel_token* cancel_token_new(void) {
+    return (vp_cancel_token*)calloc(1, sizeof(vp_cancel_token));
+}
+
+EXPORT void cancel_token_cancel(vp_cancel_token* token) {
+    if (token != NULL) token->cancelled = 1;
+}
+
+EXPORT int cancel_token_is_cancelled(const vp_cancel_token* token) {
+    return token != NULL && token->cancelled;
+}
+
+EXPORT void cancel_token_free(vp_cancel_token* token) {
+    free(token);
+}
+
+EXPORT int probe_media_info_ex(const char* path, const vp_call_options* options, vp_media_info* out) {
+    // TODO: Honour the deadline and cancel pending work
+    if (options != NULL && cancel_token_is_cancelled(options->cancel)) {
+        if (out != NULL) memset(out, 0, sizeof(*out));
+        return VP_ERROR_CANCELLED;
+    }
+    return probe_media_info(path, out);
+}
+
+EXPORT int probe_media_info_buffer_ex(const uint8_t* data, int64_t size, const vp_call_options* options, vp_media_info* out) {
+    if (options != NULL && cancel_token_is_cancelled(options->cancel)) {
+        if (out != NULL) memset(out, 0, sizeof(*out));
+        return VP_ERROR_CANCELLED;
+    }
+    return probe_media_info_buffer(data, size, out);
+}
+
+EXPORT int probe_media_info_io_ex(const vp_io_callbacks* io, const vp_call_options* options, vp_media_info* out) {
+    if (options != NULL && cancel_token_is_cancelled(options->cancel)) {
+        if (out != NULL) memset(out, 0, sizeof(*out));
+        return VP_ERROR_CANCELLED;
+    }
+    return probe_media_info_io(io, out);
+}
+
+EXPORT int extract_frame_ex(const char* path, int frameNum, const vp_call_options* options, uint8_t** out, int* outSize) {
+    // TODO: Honour the deadline and cancel pending work
+    if (out == NULL || outSize == NULL) return VP_ERROR_INVALID_ARGUMENT;
+    *out = NULL;
+    *outSize = 0;
+    if (options != NULL && cancel_token_is_cancelled(options->cancel)) return VP_ERROR_CANCELLED;
+    *out = extract_frame(path, frameNum, outSize);
+    return *out != NULL ? VP_OK : VP_ERROR_FAILED;
+}
+
+EXPORT int extract_frame_buffer_ex(const uint8_t* data, int64_t size, int frameNum, const vp_call_options* options, uint8_t** out, int* outSize) {
+    if (out == NULL || outSize == NULL) return VP_ERROR_INVALID_ARGUMENT;
+    *out = NULL;
+    *outSize = 0;
+    if (options != NULL && cancel_token_is_cancelled(options->cancel)) return VP_ERROR_CANCELLED;
+    *out = extract_frame_buffer(data, size, frameNum, outSize);
+    return *out != NULL ? VP_OK : VP_ERROR_FAILED;
+}
+
+EXPORT int extract_frame_io_ex(const vp_io_callbacks* io, int frameNum, const vp_call_options* options, uint8_t** out, int* outSize) {
+    if (out == NULL || outSize == NULL) return VP_ERROR_INVALID_ARGUMENT;
+    *out = NULL;
+    *outSize = 0;
+    if (options != NULL && cancel_token_is_cancelled(options->cancel)) return VP_ERROR_CANCELLED;
+    *out = extract_frame_io(io, frameNum, outSize);
+    return *out != NULL ? VP_OK : VP_ERROR_FAILED;
+}
+
+struct vp_scheduler {
+    vp_request_callback callback;
+    void* user_data;
+    int64_t next_id;
+};
+
+EXPORT vp_scheduler* scheduler_new(int max_workers, vp_request_callback callback, void* user_data) {
+    // TODO: Run requests on worker threads in priority order
+    (void)max_workers;
+    if (callback == NULL) return NULL;
+    vp_scheduler* scheduler = (vp_scheduler*)calloc(1, sizeof(vp_scheduler));
+    if (scheduler == NULL) return NULL;
+    scheduler->callback = callback;
+    scheduler->user_data = user_data;
+    return scheduler;
+}
+
+EXPORT int64_t scheduler_submit(vp_scheduler* scheduler, const vp_request* request) {
+    // Runs the request at once on the calling thread
+    if (scheduler == NULL || request == NULL || request->path == NULL) return VP_ERROR_INVALID_ARGUMENT;
+    vp_request_result* result = (vp_request_result*)calloc(1, sizeof(vp_request_result));
+    if (result == NULL) return VP_ERROR_NO_MEMORY;
+    result->id = ++scheduler->next_id;
+    if (request->kind == VP_REQUEST_FRAME) {
+        result->frame = extract_frame(request->path, request->frame_num, &result->frame_size);
+        result->status = result->frame != NULL ? VP_OK : VP_ERROR_FAILED;
+        result->frame_format = result->frame != NULL ? VP_IMAGE_JPEG : 0;
+    } else {
+        result->status = probe_media_info(request->path, &result->info);
+    }
+    int64_t id = result->id;
+    scheduler->callback(result, scheduler->user_data);
+    return id;
+}
+
+EXPORT int scheduler_set_priority(vp_scheduler* scheduler, int64_t id, int priority) {
+    // Requests never wait in the stub
+    (void)id;
+    (void)priority;
+    return scheduler == NULL ? VP_ERROR_INVALID_ARGUMENT : VP_ERROR_NOT_FOUND;
+}
+
+EXPORT int scheduler_cancel(vp_scheduler* scheduler, int64_t id) {
+    (void)id;
+    return scheduler == NULL ? VP_ERROR_INVALID_ARGUMENT : VP_ERROR_NOT_FOUND;
+}
+
+EXPORT void scheduler_free(vp_scheduler* scheduler) {
+    free(scheduler);
+}
+
+EXPORT void free_request_result(vp_request_result* result) {
+    if (result == NULL) return;
+    free_media_info(&result->info);
+    free_frame(result->frame);
+    free(result);
+}
+
+EXPORT void get_metrics(vp_metrics* out) {
+    // TODO: Time the stages once there is a real decoder
+    if (out != NULL) memset(out, 0, sizeof(*out));
+}
+
+EXPORT void reset_metrics(void) {
+}
+
+EXPORT int trace_start(int capacity) {
+    // TODO: Record spans once there is a real decoder
+    return capacity < 0 ? VP_ERROR_INVALID_ARGUMENT : VP_OK;
+}
+
+EXPORT void trace_stop(void) {
+}
+
+EXPORT int trace_dump(char** out, int64_t* outSize) {
+    if (out == NULL || outSize == NULL) return VP_ERROR_INVALID_ARGUMENT;
+    static const char empty[] = "{\"traceEvents\":[]}\n";
+    *out = (char*)malloc(sizeof(empty));
+    if (*out == NULL) return VP_ERROR_NO_MEMORY;
+    memcpy(*out, empty, sizeof(empty));
+    *outSize = (int64_t)sizeof(empty) - 1;
+    return VP_OK;
+}
+
+EXPORT void free_trace(char* json) {
+    free(json);
+}
+
+EXPORT int set_memory_budget(int64_t global_bytes, int64_t request_bytes) {
+    // TODO: Plan decodes against the budgets once there is a real decoder
+    return global_bytes < 0 || request_bytes < 0 ? VP_ERROR_INVALID_ARGUMENT : VP_OK;
+}
+
+EXPORT int extract_frame_into(const char* path, int frameNum, const vp_call_options* options, uint8_t* dst, int capacity, int* outSize) {
+    if (outSize == NULL || capacity < 0 || (dst == NULL && capacity > 0)) return VP_ERROR_INVALID_ARGUMENT;
+    *outSize = 0;
+    uint8_t* frame = NULL;
+    int status = extract_frame_ex(path, frameNum, options, &frame, outSize);
+    if (status != VP_OK) return status;
+    if (*outSize > capacity) {
+        status = VP_ERROR_BUFFER_TOO_SMALL;
+    } else {
+        memcpy(dst, frame, *outSize);
+    }
+    free_frame(frame);
+    return status;
+}
+
+EXPORT int set_frame_pool_limit(int64_t bytes) {
+    // TODO: Pool frame buffers once frames come from a real decoder
+    return bytes < 0 ? VP_ERROR_INVALID_ARGUMENT : VP_OK;
+}
+
+EXPORT int extract_frames(const char* path, const int* frame_nums, int count, const vp_frames_options* options,
+                          vp_frames_result* out) {
+    // TODO: Implement actual frame set extraction
+    (void)options;
+    if (out == NULL) return VP_ERROR_INVALID_ARGUMENT;
+    memset(out, 0, sizeof(*out));
+    if (path == NULL || (frame_nums == NULL && count > 0) || count < 0) return VP_ERROR_INVALID_ARGUMENT;
+
+    vp_frame_item* items = (vp_frame_item*)calloc(count > 0 ? count : 1, sizeof(vp_frame_item));
+    if (items == NULL) return VP_ERROR_NO_MEMORY;
+    for (int i = 0; i < count; i++) {
+        items[i].status = VP_ERROR_UNSUPPORTED;
+    }
+    out->count = count;
+    out->items = items;
+    out->arena = items;
+    return VP_OK;
+}
+
+EXPORT void free_frames_result(vp_frames_result* result) {
+    if (result != NULL) {
+        free(result->arena);
+        memset(result, 0, sizeof(*result));
+    }
+}
+
+struct vp_frame_iterator {
+    char* path;
+    vp_call_options call;
+    int next_frame;
+    int step;
+    int end_frame;
+};
+
+EXPORT int frame_iterator_open(const char* path, const vp_iterator_options* options, vp_frame_iterator** out) {
+    // TODO: Decode frames from one pipeline once there is a real decoder
+    if (out == NULL) return VP_ERROR_INVALID_ARGUMENT;
+    *out = NULL;
+    if (path == NULL || (options != NULL && (options->start_frame < 0 || options->step < 0 || options->end_frame < 0 ||
+                                             !(options->interval >= 0.0) || options->queue_size < 0 ||
+                                             (options->format != VP_FRAME_JPEG && options->format != VP_FRAME_RGBA)))) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+    if (options != NULL && options->format == VP_FRAME_RGBA) return VP_ERROR_UNSUPPORTED;
+    vp_frame_iterator* iterator = (vp_frame_iterator*)calloc(1, sizeof(vp_frame_iterator));
+    if (iterator == NULL) return VP_ERROR_NO_MEMORY;
+    iterator->path = (char*)malloc(strlen(path) + 1);
+    if (iterator->path == NULL) {
+        free(iterator);
+        return VP_ERROR_NO_MEMORY;
+    }
+    strcpy(iterator->path, path);
+    if (options != NULL) iterator->call = options->call;
+    iterator->next_frame = options != NULL ? options->start_frame : 0;
+    iterator->step = options != NULL && options->step > 1 ? options->step : 1;
+    if (options != NULL && options->interval > 0.0) {
+        int step = (int)(options->interval * 25.0 + 0.5);
+        iterator->step = step > 1 ? step : 1;
+    }
+    iterator->end_frame = options != NULL && options->end_frame > 0 ? options->end_frame : get_frame_count(path);
+    *out = iterator;
+    return VP_OK;
+}
+
+EXPORT int frame_iterator_next(vp_frame_iterator* iterator, vp_frame* frame) {
+    if (iterator == NULL || frame == NULL) return VP_ERROR_INVALID_ARGUMENT;
+    memset(frame, 0, sizeof(*frame));
+    if (iterator->next_frame >= iterator->end_frame) return VP_END_OF_STREAM;
+    int status = extract_frame_ex(iterator->path, iterator->next_frame, &iterator->call, &frame->data, &frame->size);
+    if (status != VP_OK) return status;
+    frame->frame_num = iterator->next_frame;
+    frame->timestamp = iterator->next_frame / 25.0;
+    iterator->next_frame += iterator->step;
+    return VP_OK;
+}
+
+EXPORT int frame_iterator_next_batch(vp_frame_iterator* iterator, vp_frame* frames, int capacity, int* count) {
+    if (count != NULL) *count = 0;
+    if (iterator == NULL || frames == NULL || capacity < 1 || count == NULL) return VP_ERROR_INVALID_ARGUMENT;
+    int status = frame_iterator_next(iterator, &frames[0]);
+    if (status != VP_OK) return status;
+    *count = 1;
+    return VP_OK;
+}
+
+EXPORT void frame_iterator_close(vp_frame_iterator* iterator) {
+    if (iterator != NULL) {
+        free(iterator->path);
+        free(iterator);
+    }
+}
+
+EXPORT int video_probe_warmup(void) {
+    // TODO: Initialize the decoder framework once there is one
+    return VP_OK;
+}
+
+EXPORT int set_plugin_allowlist(const char* const* names, int count) {
+    // TODO: Restrict plugin loading once there is a plugin framework
+    if (count < 0 || (names == NULL && count > 0)) return VP_ERROR_INVALID_ARGUMENT;
+    return VP_OK;
+}
+
+struct vp_discovery_service {
+    vp_discovery_callback callback;
+    void* user_data;
+    int64_t next_id;
+};
+
+EXPORT vp_discovery_service* discovery_service_new(int max_in_flight, int64_t timeout_ms, vp_discovery_callback callback, void* user_data) {
+    // TODO: Discover on a background thread with several files in flight
+    if (callback == NULL || max_in_flight < 0 || timeout_ms < 0) return NULL;
+    vp_discovery_service* service = (vp_discovery_service*)calloc(1, sizeof(vp_discovery_service));
+    if (service == NULL) return NULL;
+    service->callback = callback;
+    service->user_data = user_data;
+    return service;
+}
+
+EXPORT int64_t discovery_service_submit(vp_discovery_service* service, const char* path) {
+    // Discovers at once on the calling thread
+    if (service == NULL || path == NULL || path[0] == '\0') return VP_ERROR_INVALID_ARGUMENT;
+    vp_discovery_result* result = (vp_discovery_result*)calloc(1, sizeof(vp_discovery_result));
+    if (result == NULL) return VP_ERROR_NO_MEMORY;
+    result->id = ++service->next_id;
+    result->status = probe_media_info(path, &result->info);
+    int64_t id = result->id;
+    service->callback(result, service->user_data);
+    return id;
+}
+
+EXPORT int discovery_service_cancel(vp_discovery_service* service, int64_t id) {
+    // Discoveries never wait in the stub
+    (void)id;
+    return service == NULL ? VP_ERROR_INVALID_ARGUMENT : VP_ERROR_NOT_FOUND;
+}
+
+EXPORT void discovery_service_free(vp_discovery_service* service) {
+    free(service);
+}
+
+EXPORT void free_discovery_result(vp_discovery_result* result) {
+    if (result == NULL) return;
+    free_media_info(&result->info);
+    free(result);
+}
+
+EXPORT int analyze_gop(const char* path, const vp_call_options* options, vp_gop_info* out) {
+    // TODO: Read the keyframe structure from the container index
+    (void)options;
+    if (out == NULL) return VP_ERROR_INVALID_ARGUMENT;
+    memset(out, 0, sizeof(*out));
+    if (path == NULL || path[0] == '\0') return VP_ERROR_INVALID_ARGUMENT;
+    return VP_ERROR_UNSUPPORTED;
+}
+
+EXPORT int gop_seek_cost(const vp_gop_info* info, double seconds, vp_seek_cost* out) {
+    (void)seconds;
+    if (info == NULL || out == NULL) return VP_ERROR_INVALID_ARGUMENT;
+    return VP_ERROR_NOT_FOUND;
+}
+
+EXPORT void free_gop_info(vp_gop_info* info) {
+    if (info != NULL) memset(info, 0, sizeof(*info));
+}
+
+EXPORT int get_embedded_thumbnail(const char* path, const vp_call_options* options, uint8_t** out, int* out_size,
+                                  int* out_format) {
+    // TODO: Read cover art and camera thumbnails from the container
+    (void)options;
+    if (out_size) *out_size = 0;
+    if (out) *out = NULL;
+    if (out_format) *out_format = 0;
+    if (path == NULL || path[0] == '\0' || out == NULL || out_size == NULL) return VP_ERROR_INVALID_ARGUMENT;
+    return VP_ERROR_UNSUPPORTED;
+}
@@ -12,26 +12,737 @@
 extern "C" {
 #endif
 
+// Status codes returned by the extended probe API.
+#define VP_OK 0
+#define VP_ERROR_INVALID_ARGUMENT -1
+#define VP_ERROR_NOT_FOUND -2
+#define VP_ERROR_UNSUPPORTED -3
+#define VP_ERROR_FAILED -4
+#define VP_ERROR_NO_MEMORY -5
+// The data needed to answer is not available yet (partial downloads).
+#define VP_ERROR_NEED_DATA -6
+// The call's cancel token was cancelled.
+#define VP_ERROR_CANCELLED -7
+// The call ran past its deadline.
+#define VP_ERROR_TIMEOUT -8
+// Decoding would need more memory than the call's or the global budget
+// allows, even downscaled.
+#define VP_ERROR_OVER_BUDGET -9
+// The caller's buffer is too small; the size it needs is reported instead.
+#define VP_ERROR_BUFFER_TOO_SMALL -10
+// Not an error: frame_iterator_next() has returned every frame.
+#define VP_END_OF_STREAM 1
+
+// Stream types reported in vp_stream_info.type.
+#define VP_STREAM_VIDEO 0
+#define VP_STREAM_AUDIO 1
+#define VP_STREAM_SUBTITLE 2
+
+// Description of a single elementary stream.
+// Video-only fields are zero for audio and subtitle streams and vice versa.
+typedef struct vp_stream_info {
+    int type;
+    // Short codec name, e.g. "h264", "hevc", "aac". Never NULL.
+    const char* codec;
+    // ISO 639 language code, or NULL if unknown.
+    const char* language;
+    // Bits per second, 0 if unknown.
+    int64_t bitrate;
+    int width;
+    int height;
+    int par_num;
+    int par_den;
+    int fps_num;
+    int fps_den;
+    // Clockwise display rotation in degrees (0, 90, 180 or 270).
+    int rotation;
+    int bit_depth;
+    // ISO/IEC 23001-8 colour primaries and transfer characteristics codes,
+    // 2 (unspecified) if unknown.
+    int color_primaries;
+    int transfer;
+    int is_hdr;
+    int channels;
+    int sample_rate;
+} vp_stream_info;
+
+// Everything known about a media file, gathered in a single probe.
+// The top-level video fields describe the primary video stream; streams
+// lists every stream in the file, including that one.
+// All pointers reference memory owned by the info; release it with
+// free_media_info().
+typedef struct vp_media_info {
+    // Container media type, e.g. "video/quicktime", or NULL if unknown.
+    const char* container;
+    double duration;
+    int64_t bitrate;
+    int64_t frame_count;
+    int has_video;
+    const char* video_codec;
+    int width;
+    int height;
+    int par_num;
+    int par_den;
+    int fps_num;
+    int fps_den;
+    int rotation;
+    int bit_depth;
+    int color_primaries;
+    int transfer;
+    int is_hdr;
+    int stream_count;
+    vp_stream_info* streams;
+    // Backing storage for the strings and streams above. Do not touch.
+    void* arena;
+} vp_media_info;
+
+// Cancellation token, see cancel_token_new(). Cancelling it aborts every
+// call it was passed to: pipelines are shut down and waits are woken, and
+// the calls return VP_ERROR_CANCELLED.
+typedef struct vp_cancel_token vp_cancel_token;
+
+// Per-call limits for the *_ex functions. A NULL options pointer or a
+// zeroed struct keeps the default behaviour.
+typedef struct vp_call_options {
+    // Deadline for the whole call in milliseconds; the call returns
+    // VP_ERROR_TIMEOUT once it passes. 0 keeps the built-in per-stage
+    // timeouts (5 s discovery, 10 s preroll, 5 s seek).
+    int64_t timeout_ms;
+    // May be NULL. Must outlive the call.
+    vp_cancel_token* cancel;
+    // Native memory the call's decodes may use, in bytes. A decode that
+    // would not fit runs single-threaded and downscaled before conversion,
+    // or fails with VP_ERROR_OVER_BUDGET. 0 uses the default from
+    // set_memory_budget().
+    int64_t memory_budget;
+    // If not NULL, receives the most native memory attributed to a single
+    // decode of the call, in bytes (0 if it decoded nothing).
+    int64_t* peak_memory;
+    // Threads of each video decoder the call runs (e.g. avdec_* max-threads),
+    // 0 for the decoder's default. Memory budgets may lower it.
+    int decoder_threads;
+} vp_call_options;
+
+// Flags for vp_batch_options.flags.
+// Also extract a JPEG thumbnail of each file with a video stream.
+#define VP_BATCH_THUMBNAILS 1
+// Skip the native container parsers and always use the platform framework.
+#define VP_BATCH_GSTREAMER_ONLY 2
+// With VP_BATCH_THUMBNAILS, use the image a file stores (see
+// get_embedded_thumbnail()), also for files without video, and extract a
+// frame only for video files that store none.
+#define VP_BATCH_EMBEDDED_THUMBNAILS 4
+
+// Formats of images stored in media files.
+#define VP_IMAGE_JPEG 1
+#define VP_IMAGE_PNG 2
+
+typedef struct vp_batch_options {
+    int flags;
+    // Number of worker threads, 0 for one per CPU core.
+    int max_workers;
+    // Frame number used for thumbnails when VP_BATCH_THUMBNAILS is set.
+    int thumbnail_frame;
+    // Deadline and cancellation for the whole batch. Files not finished in
+    // time report VP_ERROR_TIMEOUT or VP_ERROR_CANCELLED.
+    vp_call_options call;
+} vp_batch_options;
+
+// Result for one input path.
+typedef struct vp_batch_item {
+    // VP_OK or a VP_ERROR_* code; info is zeroed unless VP_OK.
+    int status;
+    // Owned by the batch result; do not pass to free_media_info().
+    vp_media_info info;
+    // Image bytes, or NULL if not requested or extraction failed.
+    const uint8_t* thumbnail;
+    int thumbnail_size;
+    // VP_IMAGE_JPEG, or VP_IMAGE_PNG for a stored PNG; 0 without a thumbnail.
+    int thumbnail_format;
+} vp_batch_item;
+
+typedef struct vp_batch_result {
+    int count;
+    // items[i] describes paths[i].
+    vp_batch_item* items;
+    // Backing storage for every item. Do not touch.
+    void* arena;
+} vp_batch_result;
+
+typedef struct vp_frames_options {
+    // Number of pipelines decoding in parallel, 0 for one per CPU core.
+    // Each takes a run of frames that decode from the same keyframe.
+    int max_workers;
+    // Deadline, cancellation and memory budget for the whole call. With
+    // decoder_threads 0 the cores are split between the pipelines.
+    vp_call_options call;
+} vp_frames_options;
+
+// Result for one requested frame.
+typedef struct vp_frame_item {
+    // VP_OK or a VP_ERROR_* code; data is NULL unless VP_OK.
+    int status;
+    // JPEG bytes, owned by the frames result. Repeated frame numbers share
+    // the same bytes.
+    const uint8_t* data;
+    int size;
+} vp_frame_item;
+
+typedef struct vp_frames_result {
+    int count;
+    // items[i] is frame_nums[i].
+    vp_frame_item* items;
+    // Backing storage for every item. Do not touch.
+    void* arena;
+} vp_frames_result;
+
+// A byte range of a file, e.g. a downloaded or still missing part.
+typedef struct vp_byte_range {
+    int64_t offset;
+    int64_t length;
+} vp_byte_range;
+
+// Caller-supplied byte source for data that is not a local file, e.g. an
+// encrypted blob or an archive member. Callbacks are invoked from the
+// calling thread and from framework streaming threads, but never
+// concurrently, and only until the function that was given the table
+// returns.
+typedef struct vp_io_callbacks {
+    void* opaque;
+    // Reads up to `size` bytes at the current position.
+    // Returns the number of bytes read, 0 at end of data, -1 on error.
+    int64_t (*read)(void* opaque, uint8_t* buf, int64_t size);
+    // Moves the current position to absolute `offset`.
+    // Returns 0 on success, -1 on error.
+    int (*seek)(void* opaque, int64_t offset);
+    // Returns the total size in bytes, or -1 if unknown. May be NULL.
+    int64_t (*size)(void* opaque);
+} vp_io_callbacks;
+
+// I/O backends of the native container parsers, see set_io_backend().
+// io_uring where the kernel allows it, else pread.
+#define VP_IO_AUTO 0
+// pread with posix_fadvise readahead hints.
+#define VP_IO_PREAD 1
+// Memory-mapped file with madvise hints.
+#define VP_IO_MMAP 2
+// io_uring batched reads (Linux 5.1+).
+#define VP_IO_URING 3
+
+// Local file I/O counters of the native container parsers.
+typedef struct vp_io_stats {
+    // Files opened.
+    int64_t files;
+    // Read requests and bytes handed to the parsers.
+    int64_t reads;
+    int64_t bytes_read;
+    // Bytes transferred from storage, including the prefetched head and
+    // tail of each file.
+    int64_t bytes_fetched;
+    // Blocking read syscalls (pread, io_uring_enter). Page faults of
+    // memory-mapped files are not counted.
+    int64_t read_syscalls;
+    // Readahead hints (posix_fadvise, madvise).
+    int64_t hint_syscalls;
+} vp_io_stats;
+
+// Priority classes of scheduled requests, most urgent first. A worker
+// always takes the oldest request of the most urgent non-empty class.
+#define VP_PRIORITY_VISIBLE 0
+#define VP_PRIORITY_PREFETCH 1
+#define VP_PRIORITY_BACKGROUND 2
+
+// Kinds of scheduled requests.
+#define VP_REQUEST_MEDIA_INFO 0
+#define VP_REQUEST_FRAME 1
+
+// Flags for vp_request.flags.
+// For VP_REQUEST_FRAME, return the image the file stores (see
+// get_embedded_thumbnail()) instead of frame frame_num, and extract the
+// frame only for files that store none.
+#define VP_REQUEST_EMBEDDED_THUMBNAIL 1
+
+// Scheduler of probe and extraction requests, see scheduler_new().
+typedef struct vp_scheduler vp_scheduler;
+
+typedef struct vp_request {
+    // VP_REQUEST_MEDIA_INFO or VP_REQUEST_FRAME.
+    int kind;
+    // Copied by scheduler_submit().
+    const char* path;
+    // Frame to extract for VP_REQUEST_FRAME.
+    int frame_num;
+    // VP_PRIORITY_*.
+    int priority;
+    // View slot (e.g. a grid cell) the request is for, 0 for none. A new
+    // request on a slot supersedes the previous one: it is dropped if still
+    // queued and cancelled if running, and completes with
+    // VP_ERROR_CANCELLED.
+    int64_t slot;
+    // Deadline in milliseconds from submission, 0 for none.
+    int64_t timeout_ms;
+    // VP_REQUEST_* flags.
+    int flags;
+} vp_request;
+
+typedef struct vp_request_result {
+    // As returned by scheduler_submit().
+    int64_t id;
+    // VP_OK or a VP_ERROR_* code.
+    int status;
+    // VP_REQUEST_MEDIA_INFO results; zeroed unless VP_OK.
+    vp_media_info info;
+    // VP_REQUEST_FRAME results: image bytes, or NULL unless VP_OK.
+    uint8_t* frame;
+    int frame_size;
+    // Microseconds spent queued before a worker took the request.
+    int64_t queued_us;
+    // Native memory attributed to the request's decode, in bytes.
+    int64_t peak_memory;
+    // VP_IMAGE_JPEG, or VP_IMAGE_PNG for a stored PNG; 0 without a frame.
+    int frame_format;
+} vp_request_result;
+
+// Receives every finished request, from a worker thread or, for requests
+// dropped before they started, from the thread that dropped them.
+// Release the result with free_request_result().
+typedef void (*vp_request_callback)(vp_request_result* result, void* user_data);
+
+// Stages of probing and extraction timed by the metrics, see
+// get_metrics(). Only stages that complete are timed; decode, convert
+// and encode time the frame that is returned.
+// Discovery: native container parsing or a GstDiscoverer pass.
+#define VP_STAGE_DISCOVERY 0
+// Creating and linking the extraction pipeline.
+#define VP_STAGE_PIPELINE_BUILD 1
+// First transition to PAUSED, up to the first prerolled frame.
+#define VP_STAGE_PREROLL 2
+// Flushing seek, up to the first buffer reaching the decoder.
+#define VP_STAGE_SEEK 3
+// Decoding, up to the first decoded frame.
+#define VP_STAGE_DECODE 4
+// Colorspace conversion to I420.
+#define VP_STAGE_CONVERT 5
+// JPEG encoding.
+#define VP_STAGE_ENCODE 6
+#define VP_STAGE_COUNT 7
+
+typedef struct vp_stage_metrics {
+    // Completed runs of the stage.
+    int64_t count;
+    int64_t total_us;
+    // Latency percentiles in microseconds, within 1/16 of the exact value.
+    int64_t p50_us;
+    int64_t p90_us;
+    int64_t p99_us;
+} vp_stage_metrics;
+
+typedef struct vp_metrics {
+    // Indexed by VP_STAGE_*.
+    vp_stage_metrics stages[VP_STAGE_COUNT];
+    // Bytes handed to parsers and demuxers by the plugin's readers (local
+    // files probed natively, memory, callbacks and HTTP). Files GStreamer
+    // opens itself are not counted.
+    int64_t bytes_read;
+    // Heap allocations for results and parser state: arena blocks and
+    // frame buffers not served from the frame pool.
+    int64_t allocations;
+    // Frame buffers not yet released with free_frame(). Unlike the fields
+    // above these are current levels, so reset_metrics() leaves them alone.
+    int64_t live_frames;
+    // Media infos, batch results and request results not yet freed, plus
+    // those of calls still running.
+    int64_t live_results;
+} vp_metrics;
+
+// Sequential frame reader, see frame_iterator_open().
+typedef struct vp_frame_iterator vp_frame_iterator;
+
+// vp_iterator_options.format: how frames are returned.
+// JPEG at quality 90.
+#define VP_FRAME_JPEG 0
+// 8-bit RGBA rows of width * 4 bytes, without padding.
+#define VP_FRAME_RGBA 1
+
+typedef struct vp_iterator_options {
+    // First frame to return.
+    int start_frame;
+    // Return every step-th frame from start_frame, 0 or 1 for every frame.
+    int step;
+    // Frame after the last one to return, 0 to read to the end.
+    int end_frame;
+    // Seconds between frames, e.g. 1.0 for one frame per second, instead
+    // of step; 0 to use step. Each sample returns the frame showing at
+    // that time. Frames no sample needs are dropped before conversion
+    // and, for MP4, not decoded where the index shows nothing depends on
+    // them.
+    double interval;
+    // Frames decoded ahead of frame_iterator_next(), 0 for the default of 4.
+    // Decoding pauses while the queue is full.
+    int queue_size;
+    // VP_FRAME_*.
+    int format;
+    // Cancellation and memory budget for the life of the iterator;
+    // timeout_ms bounds the open and each frame_iterator_next() call.
+    // peak_memory must outlive the iterator.
+    vp_call_options call;
+} vp_iterator_options;
+
+// One frame returned by frame_iterator_next().
+typedef struct vp_frame {
+    int frame_num;
+    // Presentation time in seconds.
+    double timestamp;
+    // JPEG or RGBA bytes, see vp_iterator_options.format; release with
+    // free_frame().
+    uint8_t* data;
+    int size;
+    int width;
+    int height;
+} vp_frame;
+
+// Long-lived metadata discovery, see discovery_service_new().
+typedef struct vp_discovery_service vp_discovery_service;
+
+typedef struct vp_discovery_result {
+    // As returned by discovery_service_submit().
+    int64_t id;
+    // VP_OK or a VP_ERROR_* code.
+    int status;
+    // Zeroed unless VP_OK.
+    vp_media_info info;
+    // Microseconds spent queued before the discovery started.
+    int64_t queued_us;
+} vp_discovery_result;
+
+// Receives every finished discovery from the service thread or, for
+// queued ones cancelled by discovery_service_cancel(), from the cancelling
+// thread. Release the result with free_discovery_result().
+typedef void (*vp_discovery_callback)(vp_discovery_result* result, void* user_data);
+
+// Cost of showing one frame after a seek, see analyze_gop().
+typedef struct vp_seek_cost {
+    // Presentation time of the frame in seconds.
+    double time;
+    // Presentation time of the keyframe a seek to the frame decodes from.
+    double keyframe_time;
+    // Frames decoded from that keyframe up to and including this one, in
+    // decode order: 1 for a keyframe.
+    int frames;
+    // Coded size of those frames in bytes, 0 if the index has no sizes.
+    int64_t bytes;
+} vp_seek_cost;
+
+// Keyframe structure of a video track, read from the container index.
+typedef struct vp_gop_info {
+    int frame_count;
+    int keyframe_count;
+    // Every frame is a keyframe (MJPEG, ProRes, ...): any frame is one
+    // decode away.
+    int all_intra;
+    // Frames are decoded in a different order than shown (B-frames).
+    int has_b_frames;
+    // Some GOP starts with frames shown before its keyframe, which refer
+    // to the previous GOP; seeking to them decodes both.
+    int open_gop;
+    // Frames per GOP, keyframe to keyframe.
+    int gop_frames_min;
+    int gop_frames_p50;
+    int gop_frames_p90;
+    int gop_frames_max;
+    // Seconds per GOP.
+    double gop_seconds_mean;
+    double gop_seconds_max;
+    // Frames decoded to show one frame, over every frame.
+    double seek_frames_mean;
+    int seek_frames_max;
+    // One entry per frame in presentation order; see gop_seek_cost().
+    vp_seek_cost* costs;
+    // Backing storage for costs. Do not touch.
+    void* arena;
+} vp_gop_info;
+
 // A dummy function to test FFI integration
 EXPORT intptr_t sum(intptr_t a, intptr_t b);
 
 // Returns the duration of the video in seconds.
 // Returns -1.0 on error.
-EXPORT double get_duration(char* path);
+EXPORT double get_duration(const char* path);
 
 // Returns the total number of frames in the video.
 // Returns -1 on error.
-EXPORT int get_frame_count(char* path);
+EXPORT int get_frame_count(const char* path);
 
 // Extracts a specific frame as a JPG/PNG buffer.
 // Returns a pointer to the buffer. The caller is responsible for freeing it using free_frame().
 // Sets *outSize to the size of the buffer.
 // Returns NULL on error.
-EXPORT uint8_t* extract_frame(char* path, int frameNum, int* outSize);
+EXPORT uint8_t* extract_frame(const char* path, int frameNum, int* outSize);
 
-// Frees the buffer returned by extract_frame.
+// Frees the buffer returned by extract_frame. Freed buffers are pooled and
+// reused by later extractions, see set_frame_pool_limit().
 EXPORT void free_frame(uint8_t* buffer);
 
+// Probes container, video, audio and subtitle metadata in a single pass.
+// Fills *out on success; the caller must release it with free_media_info().
+// Returns VP_OK or a VP_ERROR_* code. *out is zeroed on error.
+EXPORT int probe_media_info(const char* path, vp_media_info* out);
+
+// Releases the memory held by a vp_media_info filled by probe_media_info().
+EXPORT void free_media_info(vp_media_info* info);
+
+// Like probe_media_info(), reading from `size` bytes at `data` instead of
+// a file. The buffer is only read during the call and is not copied.
+EXPORT int probe_media_info_buffer(const uint8_t* data, int64_t size, vp_media_info* out);
+
+// Like probe_media_info(), reading through caller-supplied callbacks.
+EXPORT int probe_media_info_io(const vp_io_callbacks* io, vp_media_info* out);
+
+// Like extract_frame(), decoding from `size` bytes at `data`.
+// Release the result with free_frame().
+EXPORT uint8_t* extract_frame_buffer(const uint8_t* data, int64_t size, int frameNum, int* outSize);
+
+// Like extract_frame(), decoding through caller-supplied callbacks.
+// Release the result with free_frame().
+EXPORT uint8_t* extract_frame_io(const vp_io_callbacks* io, int frameNum, int* outSize);
+
+// Probes a file that is still being downloaded.
+// `path` holds the bytes received so far at their final offsets, either
+// written sequentially or into a sparse file of `total_size` bytes.
+// `available` lists the ranges already written; if NULL, the first
+// (current file length) bytes are taken as present.
+// Returns VP_OK as soon as the metadata can be read from the present
+// ranges. Otherwise returns VP_ERROR_NEED_DATA and writes the ranges still
+// missing to `needed` (up to `needed_capacity`), with the total number in
+// *needed_count. Only MP4/MOV is supported; other formats return
+// VP_ERROR_UNSUPPORTED once their header is present.
+EXPORT int probe_media_info_partial(const char* path, int64_t total_size, const vp_byte_range* available, int available_count, vp_media_info* out, vp_byte_range* needed, int needed_capacity, int* needed_count);
+
+// Reports the ranges probe_media_info_partial() still needs, so downloads
+// can fetch them first. Returns VP_OK with *needed_count == 0 once
+// everything is present.
+EXPORT int probe_needed_ranges(const char* path, int64_t total_size, const vp_byte_range* available, int available_count, vp_byte_range* needed, int needed_capacity, int* needed_count);
+
+// Probes `count` files in parallel on native worker threads.
+// options may be NULL for defaults. Fills *out with one item per path, all
+// allocated from a single arena; release it with free_batch_result().
+// Returns VP_OK unless the arguments are invalid; per-file failures are
+// reported in each item's status.
+EXPORT int probe_batch(const char* const* paths, int count, const vp_batch_options* options, vp_batch_result* out);
+
+// Releases everything held by a vp_batch_result filled by probe_batch().
+EXPORT void free_batch_result(vp_batch_result* result);
+
+// Selects how the native container parsers read local files from now on.
+// Returns VP_OK, VP_ERROR_UNSUPPORTED if the backend is not available on
+// this system, or VP_ERROR_INVALID_ARGUMENT.
+EXPORT int set_io_backend(int backend);
+
+// Fills *out with the process-wide I/O counters since startup. Diff two
+// snapshots to measure a single call.
+EXPORT void get_io_stats(vp_io_stats* out);
+
+// Creates a cancellation token. Release it with cancel_token_free() once
+// no call using it is running.
+EXPORT vp_cancel_token* cancel_token_new(void);
+
+// Cancels every running and future call given `token`. Thread-safe and
+// idempotent; calls notice within milliseconds.
+EXPORT void cancel_token_cancel(vp_cancel_token* token);
+
+EXPORT int cancel_token_is_cancelled(const vp_cancel_token* token);
+
+EXPORT void cancel_token_free(vp_cancel_token* token);
+
+// probe_media_info() with a deadline and cancellation; options may be NULL.
+EXPORT int probe_media_info_ex(const char* path, const vp_call_options* options, vp_media_info* out);
+
+// probe_media_info_buffer() with a deadline and cancellation.
+EXPORT int probe_media_info_buffer_ex(const uint8_t* data, int64_t size, const vp_call_options* options, vp_media_info* out);
+
+// probe_media_info_io() with a deadline and cancellation.
+EXPORT int probe_media_info_io_ex(const vp_io_callbacks* io, const vp_call_options* options, vp_media_info* out);
+
+// extract_frame() with a deadline and cancellation. On VP_OK, *out holds a
+// JPEG of *outSize bytes to release with free_frame(); otherwise *out is
+// NULL and the status says why.
+EXPORT int extract_frame_ex(const char* path, int frameNum, const vp_call_options* options, uint8_t** out, int* outSize);
+
+// extract_frame_buffer() with a deadline and cancellation.
+EXPORT int extract_frame_buffer_ex(const uint8_t* data, int64_t size, int frameNum, const vp_call_options* options, uint8_t** out, int* outSize);
+
+// extract_frame_io() with a deadline and cancellation.
+EXPORT int extract_frame_io_ex(const vp_io_callbacks* io, int frameNum, const vp_call_options* options, uint8_t** out, int* outSize);
+
+// Creates a scheduler running requests on `max_workers` threads (0 for
+// one per CPU core) and reporting them to `callback`.
+// Returns NULL on failure.
+EXPORT vp_scheduler* scheduler_new(int max_workers, vp_request_callback callback, void* user_data);
+
+// Queues `request` and returns its id (> 0), or a VP_ERROR_* code.
+EXPORT int64_t scheduler_submit(vp_scheduler* scheduler, const vp_request* request);
+
+// Moves a queued request to another VP_PRIORITY_* class, behind the
+// requests already there. Returns VP_OK, or VP_ERROR_NOT_FOUND once the
+// request has started.
+EXPORT int scheduler_set_priority(vp_scheduler* scheduler, int64_t id, int priority);
+
+// Cancels a queued or running request; it completes with
+// VP_ERROR_CANCELLED. Returns VP_OK or VP_ERROR_NOT_FOUND once finished.
+EXPORT int scheduler_cancel(vp_scheduler* scheduler, int64_t id);
+
+// Cancels every request, waits for the workers to stop and frees the
+// scheduler. Requests that had not started are reported with
+// VP_ERROR_CANCELLED before this returns.
+EXPORT void scheduler_free(vp_scheduler* scheduler);
+
+// Releases a result passed to a vp_request_callback.
+EXPORT void free_request_result(vp_request_result* result);
+
+// Snapshot of the stage timings and counters since the last
+// reset_metrics(), over every thread. Recording is always on and costs a
+// few relaxed atomic adds per stage.
+EXPORT void get_metrics(vp_metrics* out);
+
+// Starts a new measurement window for get_metrics().
+EXPORT void reset_metrics(void);
+
+// Starts recording spans of every stage, GStreamer state change and bus
+// wait, with thread ids, into a ring of `capacity` events (0 for 65536).
+// The oldest events are overwritten once it is full. Restarting discards
+// the previous recording.
+// Returns VP_OK, VP_ERROR_INVALID_ARGUMENT or VP_ERROR_NO_MEMORY.
+EXPORT int trace_start(int capacity);
+
+// Stops recording; the events stay available to trace_dump().
+EXPORT void trace_stop(void);
+
+// Writes the recorded events as Chrome trace event JSON, loadable in
+// Perfetto or chrome://tracing, to a NUL-terminated string at *out of
+// *outSize bytes. Release it with free_trace(). Works while recording.
+EXPORT int trace_dump(char** out, int64_t* outSize);
+
+EXPORT void free_trace(char* json);
+
+// Limits native memory for decoding. `global_bytes` caps the estimated
+// memory of all decodes running at once; `request_bytes` is the budget of
+// calls that do not set vp_call_options.memory_budget. 0 means unlimited.
+// Returns VP_OK or VP_ERROR_INVALID_ARGUMENT for negative values.
+EXPORT int set_memory_budget(int64_t global_bytes, int64_t request_bytes);
+
+// extract_frame_ex() into `capacity` bytes at `dst`, which the caller owns,
+// so extraction allocates no frame buffer. On VP_OK, *outSize is the JPEG
+// size. If it does not fit, returns VP_ERROR_BUFFER_TOO_SMALL with the
+// size needed in *outSize; a retry decodes the frame again, so callers
+// should keep the buffer and grow it rather than size it per frame.
+EXPORT int extract_frame_into(const char* path, int frameNum, const vp_call_options* options, uint8_t* dst, int capacity, int* outSize);
+
+// Caps the bytes of freed frames kept for reuse (32 MiB by default),
+// releasing what is over the new limit. 0 disables pooling.
+// Returns VP_OK or VP_ERROR_INVALID_ARGUMENT for a negative limit.
+EXPORT int set_frame_pool_limit(int64_t bytes);
+
+// Extract several frames of one video as JPEGs, e.g. for a storyboard.
+// Frames are sorted and grouped into runs that decode from the same
+// keyframe; each run costs one seek, and runs are spread over parallel
+// pipelines. `options` may be NULL. Returns VP_OK once every frame has a
+// status in *out, or an error for the whole call (bad arguments, the
+// video cannot be opened). Release *out with free_frames_result().
+EXPORT int extract_frames(const char* path, const int* frame_nums, int count, const vp_frames_options* options,
+                          vp_frames_result* out);
+
+// Releases everything held by a vp_frames_result filled by extract_frames().
+EXPORT void free_frames_result(vp_frames_result* result);
+
+// Opens `path` for reading frames in order from one long-lived pipeline,
+// e.g. to feed every Nth frame of a video to a model. `options` may be
+// NULL. On VP_OK, *out must be released with frame_iterator_close().
+EXPORT int frame_iterator_open(const char* path, const vp_iterator_options* options, vp_frame_iterator** out);
+
+// Waits for the next frame and moves it to *frame. Returns VP_OK,
+// VP_END_OF_STREAM once every frame has been returned, or an error after
+// which the iterator can only be closed.
+EXPORT int frame_iterator_next(vp_frame_iterator* iterator, vp_frame* frame);
+
+// Like frame_iterator_next(), returning up to `capacity` frames at once:
+// waits for the first, then adds those already decoded without waiting.
+// Returns VP_OK with *count >= 1, VP_END_OF_STREAM with *count == 0, or an
+// error. Frames returned before an error are kept; the error comes with
+// the next call.
+EXPORT int frame_iterator_next_batch(vp_frame_iterator* iterator, vp_frame* frames, int capacity, int* count);
+
+// Stops decoding and releases the iterator. Frames already returned stay
+// valid. Accepts NULL.
+EXPORT void frame_iterator_close(vp_frame_iterator* iterator);
+
+
+// Initializes the platform framework (GStreamer: gst_init and the plugin
+// registry) and loads the demuxers, decoders and encoder of the common
+// formats on a background thread, so the first probe or thumbnail after
+// launch does not pay for them. Returns at once; calls made meanwhile wait
+// only for what they need. Later calls do nothing. Returns VP_OK, or
+// VP_ERROR_FAILED if the thread could not be started.
+EXPORT int video_probe_warmup(void);
+
+// Restricts the platform framework to `count` named plugins (GStreamer
+// plugin names, e.g. "isomp4", "matroska", "libav", "videoparsersbad"),
+// besides those the library's own pipelines use, so formats and hardware
+// decoders an app does not need are never loaded. 0 keeps every plugin.
+// Must be called before anything initializes GStreamer, including
+// video_probe_warmup(); returns VP_ERROR_FAILED afterwards, VP_OK or
+// VP_ERROR_INVALID_ARGUMENT.
+EXPORT int set_plugin_allowlist(const char* const* names, int count);
+
+// Starts a discovery service: a thread running the platform's metadata
+// discovery (GStreamer: GstDiscoverer) on its own event loop, with up to
+// `max_in_flight` files in flight at once (0 for 4), each given up after
+// `timeout_ms` (0 for 5 s; GStreamer accepts 1 s to 1 h). Unlike
+// probe_media_info() it never uses the native container parser.
+// Returns NULL on failure.
+EXPORT vp_discovery_service* discovery_service_new(int max_in_flight, int64_t timeout_ms, vp_discovery_callback callback, void* user_data);
+
+// Queues a path or URI and returns its id (> 0), or a VP_ERROR_* code.
+EXPORT int64_t discovery_service_submit(vp_discovery_service* service, const char* path);
+
+// Cancels a queued or running discovery; it completes with
+// VP_ERROR_CANCELLED. Returns VP_OK or VP_ERROR_NOT_FOUND once finished.
+EXPORT int discovery_service_cancel(vp_discovery_service* service, int64_t id);
+
+// Cancels every discovery, waits for the thread to stop and frees the
+// service. Discoveries that had not started are not reported.
+EXPORT void discovery_service_free(vp_discovery_service* service);
+
+// Releases a result passed to a vp_discovery_callback.
+EXPORT void free_discovery_result(vp_discovery_result* result);
+
+// Reads the keyframe structure of the first video track of `path` from the
+// container index without decoding anything: GOP lengths, B-frames, open
+// GOPs and, for every frame, what a seek to it costs. Lets callers choose
+// between accurate seeks and snapping to the nearest keyframe. `options`
+// may be NULL. Returns VP_OK, VP_ERROR_UNSUPPORTED for containers without
+// a native index parser (MP4/MOV only for now) or fragmented files, or an
+// error. Release *out with free_gop_info().
+EXPORT int analyze_gop(const char* path, const vp_call_options* options, vp_gop_info* out);
+
+// Cost of showing the frame at `seconds`, i.e. the last frame shown at or
+// before it (the first frame for earlier times). Returns VP_OK, or
+// VP_ERROR_NOT_FOUND if `info` has no frames.
+EXPORT int gop_seek_cost(const vp_gop_info* info, double seconds, vp_seek_cost* out);
+
+// Releases everything held by a vp_gop_info filled by analyze_gop().
+EXPORT void free_gop_info(vp_gop_info* info);
+
+// Reads the cover art or camera thumbnail stored in `path` (local file or
+// http(s) URL) with the native parsers, without decoding anything:
+// covr in an MP4/MOV/M4V ilst or Canon's CNTH thumbnail, or a Matroska/WebM
+// image attachment, covers first. *out receives the image bytes, to be
+// released with free_frame(), and *out_format (may be NULL) VP_IMAGE_JPEG
+// or VP_IMAGE_PNG.
+// Returns VP_OK, VP_ERROR_NOT_FOUND if the file stores no image,
+// VP_ERROR_UNSUPPORTED for other containers, or an error.
+EXPORT int get_embedded_thumbnail(const char* path, const vp_call_options* options, uint8_t** out, int* out_size,
+                                  int* out_format);
+
 #ifdef __cplusplus
 }
 #endif
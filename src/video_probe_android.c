@@ -243,7 +243,7 @@ EXPORT intptr_t sum(intptr_t a, intptr_t b) {
     return a + b;
 }
 
-EXPORT double get_duration(char* path) {
+EXPORT double get_duration(const char* path) {
     if (path == NULL) return -1.0;
     
     int should_detach = 0;
@@ -272,7 +272,7 @@ EXPORT double get_duration(char* path) {
     return durationMs / 1000.0;
 }
 
-EXPORT int get_frame_count(char* path) {
+EXPORT int get_frame_count(const char* path) {
     if (path == NULL) return -1;
     
     int should_detach = 0;
@@ -315,7 +315,7 @@ EXPORT int get_frame_count(char* path) {
     return frameCount;
 }
 
-EXPORT uint8_t* extract_frame(char* path, int frameNum, int* outSize) {
+EXPORT uint8_t* extract_frame(const char* path, int frameNum, int* outSize) {
     if (path == NULL || outSize == NULL) return NULL;
     *outSize = 0;
     
@@ -0,0 +1,129 @@
+/**
+ * Arena allocator for FFI result structs.
+ *
+ * Results such as vp_media_info own a variable number of strings and
+ * stream records. Allocating them from one arena keeps the layout flat
+ * and lets the caller release everything with a single call.
+ */
+
+#include "video_probe_internal.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_ALIGN 8
+#define ARENA_DEFAULT_BLOCK 4096
+
+typedef struct vp_arena_block {
+    struct vp_arena_block* next;
+    size_t capacity;
+    size_t used;
+    // Followed by `capacity` bytes of storage.
+} vp_arena_block;
+
+struct vp_arena {
+    vp_arena_block* head;
+    size_t block_size;
+};
+
+static size_t align_up(size_t size) {
+    return (size + (ARENA_ALIGN - 1)) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+static vp_arena_block* block_new(size_t capacity) {
+    vp_arena_block* block = (vp_arena_block*)calloc(1, align_up(sizeof(vp_arena_block)) + capacity);
+    if (block == NULL) {
+        return NULL;
+    }
+    vp_metrics_count(VP_COUNTER_ALLOCATIONS, 1);
+    block->capacity = capacity;
+    return block;
+}
+
+static unsigned char* block_data(vp_arena_block* block) {
+    return (unsigned char*)block + align_up(sizeof(vp_arena_block));
+}
+
+vp_arena* vp_arena_new(size_t block_size) {
+    vp_arena* arena = (vp_arena*)calloc(1, sizeof(vp_arena));
+    if (arena == NULL) {
+        return NULL;
+    }
+    vp_metrics_count(VP_COUNTER_ALLOCATIONS, 1);
+    vp_metrics_count(VP_COUNTER_LIVE_ARENAS, 1);
+    arena->block_size = block_size > 0 ? align_up(block_size) : ARENA_DEFAULT_BLOCK;
+    return arena;
+}
+
+void* vp_arena_alloc(vp_arena* arena, size_t size) {
+    if (arena == NULL) {
+        return NULL;
+    }
+    size = align_up(size > 0 ? size : 1);
+
+    vp_arena_block* head = arena->head;
+    if (head == NULL || head->capacity - head->used < size) {
+        // Oversized requests get a dedicated block so the arena never
+        // wastes a whole default block on them.
+        size_t capacity = size > arena->block_size ? size : arena->block_size;
+        vp_arena_block* block = block_new(capacity);
+        if (block == NULL) {
+            return NULL;
+        }
+        block->next = head;
+        arena->head = block;
+        head = block;
+    }
+
+    void* ptr = block_data(head) + head->used;
+    head->used += size;
+    return ptr;
+}
+
+char* vp_arena_strdup(vp_arena* arena, const char* str) {
+    if (str == NULL) {
+        return NULL;
+    }
+    size_t len = strlen(str);
+    char* copy = (char*)vp_arena_alloc(arena, len + 1);
+    if (copy != NULL) {
+        memcpy(copy, str, len + 1);
+    }
+    return copy;
+}
+
+void vp_arena_free(vp_arena* arena) {
+    if (arena == NULL) {
+        return;
+    }
+    vp_arena_block* block = arena->head;
+    while (block != NULL) {
+        vp_arena_block* next = block->next;
+        free(block);
+        block = next;
+    }
+    vp_metrics_count(VP_COUNTER_LIVE_ARENAS, -1);
+    free(arena);
+}
+
+void vp_arena_merge(vp_arena* dst, vp_arena* src) {
+    if (dst == NULL || src == NULL) {
+        return;
+    }
+    // Append behind dst's current head so dst keeps filling its own
+    // partially used block first.
+    vp_arena_block* tail = src->head;
+    if (tail != NULL) {
+        while (tail->next != NULL) {
+            tail = tail->next;
+        }
+        if (dst->head != NULL) {
+            tail->next = dst->head->next;
+            dst->head->next = src->head;
+        } else {
+            dst->head = src->head;
+        }
+    }
+    vp_metrics_count(VP_COUNTER_LIVE_ARENAS, -1);
+    free(src);
+}
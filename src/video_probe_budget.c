@@ -0,0 +1,137 @@
+/**
+ * Memory budgets for decoding.
+ *
+ * Decoder memory cannot be capped from outside GStreamer, so each decode
+ * is estimated up front from the frame size and planned to fit: the
+ * decoder's frame threading goes first (every thread holds a frame), then
+ * the frame is scaled down before conversion and encoding. Estimates of
+ * running decodes are reserved against the global budget, which rejects
+ * new decodes rather than letting them queue on memory that is not there.
+ */
+
+// sysconf(_SC_NPROCESSORS_ONLN)
+#define _DEFAULT_SOURCE
+
+#include "video_probe_internal.h"
+
+#include <pthread.h>
+#include <unistd.h>
+
+// Reference frames plus the decoder's output pool, enough for typical
+// H.264/HEVC streams
+#define DECODE_POOL_FRAMES 8
+// libav frame threading does not use more than this
+#define MAX_DECODE_THREADS 16
+
+static const int scales[] = { 1, 2, 4, 8 };
+
+static pthread_mutex_t budget_lock = PTHREAD_MUTEX_INITIALIZER;
+static int64_t global_budget;
+static int64_t request_budget;
+static int64_t reserved;
+
+static int default_threads(void) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores < 1) {
+        return 1;
+    }
+    return cores > MAX_DECODE_THREADS ? MAX_DECODE_THREADS : (int)cores;
+}
+
+// A raw 4:2:0 frame
+static int64_t frame_bytes(int width, int height, int bit_depth) {
+    int64_t bytes = (int64_t)width * height * 3 / 2;
+    return bit_depth > 8 ? bytes * 2 : bytes;
+}
+
+int64_t vp_decode_estimate(int width, int height, int bit_depth, int scale, int threads) {
+    if (width <= 0 || height <= 0) {
+        return 0;
+    }
+    if (scale < 1) {
+        scale = 1;
+    }
+    if (threads <= 0) {
+        threads = default_threads();
+    }
+    int64_t decoded = frame_bytes(width, height, bit_depth) * (DECODE_POOL_FRAMES + threads);
+    // Scaled and converted I420 frame, jpegenc's working copy, then the
+    // JPEG and the copy handed to the caller at up to half a frame each
+    int64_t converted = frame_bytes(width / scale, height / scale, 8);
+    return decoded + converted * 3;
+}
+
+int vp_decode_plan_fit(int width, int height, int bit_depth, int threads, int64_t budget, vp_decode_plan* plan) {
+    plan->scale = 1;
+    plan->threads = threads > 0 ? threads : 0;
+    plan->estimate = vp_decode_estimate(width, height, bit_depth, 1, plan->threads);
+    if (budget <= 0 || plan->estimate <= budget) {
+        return VP_OK;
+    }
+    plan->threads = 1;
+    for (size_t i = 0; i < sizeof(scales) / sizeof(scales[0]); i++) {
+        plan->scale = scales[i];
+        plan->estimate = vp_decode_estimate(width, height, bit_depth, plan->scale, 1);
+        if (plan->estimate <= budget) {
+            return VP_OK;
+        }
+    }
+    return VP_ERROR_OVER_BUDGET;
+}
+
+int vp_budget_acquire(const vp_call* call, int width, int height, int bit_depth, vp_decode_plan* plan) {
+    int64_t budget = call != NULL ? call->memory_budget : vp_budget_request_default();
+    int threads = call != NULL ? call->decoder_threads : 0;
+
+    pthread_mutex_lock(&budget_lock);
+    if (global_budget > 0) {
+        int64_t left = global_budget - reserved;
+        if (left <= 0) {
+            left = 1;
+        }
+        if (budget <= 0 || left < budget) {
+            budget = left;
+        }
+    }
+    int status = vp_decode_plan_fit(width, height, bit_depth, threads, budget, plan);
+    if (status == VP_OK && budget > 0 && plan->estimate == 0) {
+        // Nothing to estimate from; at least avoid per-thread frames
+        plan->threads = 1;
+    }
+    if (status == VP_OK) {
+        reserved += plan->estimate;
+    }
+    pthread_mutex_unlock(&budget_lock);
+    return status;
+}
+
+void vp_budget_release(const vp_call* call, const vp_decode_plan* plan) {
+    pthread_mutex_lock(&budget_lock);
+    reserved -= plan->estimate;
+    pthread_mutex_unlock(&budget_lock);
+
+    // Batch workers share a call, so keep the largest
+    if (call != NULL && call->peak_memory != NULL) {
+        int64_t peak = __atomic_load_n(call->peak_memory, __ATOMIC_RELAXED);
+        while (plan->estimate > peak &&
+               !__atomic_compare_exchange_n(call->peak_memory, &peak, plan->estimate, 0, __ATOMIC_RELAXED,
+                                            __ATOMIC_RELAXED)) {
+        }
+    }
+}
+
+int64_t vp_budget_request_default(void) {
+    // Read by every call, so without the lock
+    return __atomic_load_n(&request_budget, __ATOMIC_RELAXED);
+}
+
+int set_memory_budget(int64_t global_bytes, int64_t request_bytes) {
+    if (global_bytes < 0 || request_bytes < 0) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+    pthread_mutex_lock(&budget_lock);
+    global_budget = global_bytes;
+    __atomic_store_n(&request_budget, request_bytes, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&budget_lock);
+    return VP_OK;
+}
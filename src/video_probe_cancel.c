@@ -0,0 +1,134 @@
+/**
+ * Cancellation tokens and per-call deadlines.
+ *
+ * A token is a flag plus a list of wakers. Blocking waits (a GStreamer bus,
+ * a discoverer main context) register a waker that interrupts them, so a
+ * cancelled call returns as soon as its current wait is woken rather than
+ * when that wait would have timed out.
+ */
+
+// clock_gettime
+#define _POSIX_C_SOURCE 200809L
+
+#include "video_probe_internal.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+struct vp_cancel_token {
+    int cancelled;
+    // Guards wakers, and makes cancel and waker removal mutually exclusive
+    pthread_mutex_t lock;
+    vp_cancel_waker* wakers;
+};
+
+vp_cancel_token* cancel_token_new(void) {
+    vp_cancel_token* token = (vp_cancel_token*)calloc(1, sizeof(vp_cancel_token));
+    if (token == NULL) {
+        return NULL;
+    }
+    pthread_mutex_init(&token->lock, NULL);
+    return token;
+}
+
+void cancel_token_cancel(vp_cancel_token* token) {
+    if (token == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&token->lock);
+    if (!token->cancelled) {
+        __atomic_store_n(&token->cancelled, 1, __ATOMIC_RELEASE);
+        for (vp_cancel_waker* waker = token->wakers; waker != NULL; waker = waker->next) {
+            waker->wake(waker->data);
+        }
+    }
+    pthread_mutex_unlock(&token->lock);
+}
+
+int cancel_token_is_cancelled(const vp_cancel_token* token) {
+    return token != NULL && __atomic_load_n(&token->cancelled, __ATOMIC_ACQUIRE);
+}
+
+void cancel_token_free(vp_cancel_token* token) {
+    if (token == NULL) {
+        return;
+    }
+    pthread_mutex_destroy(&token->lock);
+    free(token);
+}
+
+void vp_cancel_add_waker(vp_cancel_token* token, vp_cancel_waker* waker) {
+    if (token == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&token->lock);
+    waker->next = token->wakers;
+    token->wakers = waker;
+    if (token->cancelled) {
+        waker->wake(waker->data);
+    }
+    pthread_mutex_unlock(&token->lock);
+}
+
+void vp_cancel_remove_waker(vp_cancel_token* token, vp_cancel_waker* waker) {
+    if (token == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&token->lock);
+    for (vp_cancel_waker** link = &token->wakers; *link != NULL; link = &(*link)->next) {
+        if (*link == waker) {
+            *link = waker->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&token->lock);
+}
+
+int64_t vp_monotonic_us(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+void vp_call_init(vp_call* call, const vp_call_options* options) {
+    memset(call, 0, sizeof(*call));
+    call->memory_budget = vp_budget_request_default();
+    if (options == NULL) {
+        return;
+    }
+    call->cancel = options->cancel;
+    if (options->memory_budget > 0) {
+        call->memory_budget = options->memory_budget;
+    }
+    call->peak_memory = options->peak_memory;
+    call->decoder_threads = options->decoder_threads > 0 ? options->decoder_threads : 0;
+    if (call->peak_memory != NULL) {
+        *call->peak_memory = 0;
+    }
+    if (options->timeout_ms > 0) {
+        call->deadline_us = vp_monotonic_us() + options->timeout_ms * 1000;
+    }
+}
+
+int vp_call_check(const vp_call* call) {
+    if (call == NULL) {
+        return VP_OK;
+    }
+    if (cancel_token_is_cancelled(call->cancel)) {
+        return VP_ERROR_CANCELLED;
+    }
+    if (call->deadline_us > 0 && vp_monotonic_us() >= call->deadline_us) {
+        return VP_ERROR_TIMEOUT;
+    }
+    return VP_OK;
+}
+
+int64_t vp_call_remaining_us(const vp_call* call, int64_t fallback_us) {
+    if (call == NULL || call->deadline_us == 0) {
+        return fallback_us;
+    }
+    int64_t left = call->deadline_us - vp_monotonic_us();
+    return left > 0 ? left : 0;
+}
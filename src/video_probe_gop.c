@@ -0,0 +1,194 @@
+/**
+ * GOP structure and seek costs from a container's sample index.
+ *
+ * A seek lands on the last keyframe shown at or before the target and
+ * decodes forward in decode order until the target comes out, so a frame
+ * costs its distance in decode order from that keyframe. Leading frames of
+ * an open GOP are shown before their own keyframe and so count from the
+ * previous GOP's.
+ */
+
+#include "video_probe_internal.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    double time;
+    // Decode order
+    int index;
+} shown_frame;
+
+static int compare_shown(const void* a, const void* b) {
+    const shown_frame* x = (const shown_frame*)a;
+    const shown_frame* y = (const shown_frame*)b;
+    if (x->time != y->time) {
+        return x->time < y->time ? -1 : 1;
+    }
+    return x->index - y->index;
+}
+
+static int compare_ints(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of `count` sorted values
+static int percentile(const int* sorted, int count, int percent) {
+    int rank = (count * percent + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+int vp_gop_analyze(const vp_mp4_sample* samples, int count, vp_arena* arena, vp_gop_info* out) {
+    if (out == NULL) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+    memset(out, 0, sizeof(*out));
+    if (samples == NULL || count <= 0 || arena == NULL) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+
+    vp_seek_cost* costs = (vp_seek_cost*)vp_arena_alloc(arena, sizeof(vp_seek_cost) * (size_t)count);
+    // Coded bytes before each sample, in decode order
+    int64_t* offsets = (int64_t*)malloc(sizeof(int64_t) * ((size_t)count + 1));
+    int* keys = (int*)malloc(sizeof(int) * (size_t)count);
+    int* gop_frames = (int*)malloc(sizeof(int) * (size_t)count);
+    shown_frame* shown = (shown_frame*)malloc(sizeof(shown_frame) * (size_t)count);
+    if (costs == NULL || offsets == NULL || keys == NULL || gop_frames == NULL || shown == NULL) {
+        free(offsets);
+        free(keys);
+        free(gop_frames);
+        free(shown);
+        return VP_ERROR_NO_MEMORY;
+    }
+
+    // Decode order: sizes, keyframes and reordering
+    double first_time = samples[0].time;
+    double last_time = samples[0].time;
+    int key_count = 0;
+    offsets[0] = 0;
+    for (int i = 0; i < count; i++) {
+        offsets[i + 1] = offsets[i] + samples[i].size;
+        if (samples[i].time < last_time) {
+            out->has_b_frames = 1;
+        }
+        if (samples[i].time > last_time) {
+            last_time = samples[i].time;
+        }
+        if (samples[i].time < first_time) {
+            first_time = samples[i].time;
+        }
+        if (samples[i].flags & VP_MP4_SAMPLE_SYNC) {
+            keys[key_count++] = i;
+        }
+        shown[i].time = samples[i].time;
+        shown[i].index = i;
+    }
+    // A stream has to start somewhere; treat the first sample as the only
+    // keyframe of an index that marks none
+    int marked = key_count > 0;
+    if (!marked) {
+        keys[key_count++] = 0;
+    }
+
+    // GOPs run from one keyframe to the next in decode order, the last one
+    // to the end of the stream, one frame past the last frame shown
+    double frame_duration = count > 1 ? (last_time - first_time) / (count - 1) : 0.0;
+    double gop_seconds_total = 0.0;
+    for (int g = 0; g < key_count; g++) {
+        int start = keys[g];
+        int end = g + 1 < key_count ? keys[g + 1] : count;
+        gop_frames[g] = end - start;
+
+        double start_time = samples[start].time;
+        double end_time = g + 1 < key_count ? samples[end].time : last_time + frame_duration;
+        double seconds = end_time > start_time ? end_time - start_time : 0.0;
+        gop_seconds_total += seconds;
+        if (seconds > out->gop_seconds_max) {
+            out->gop_seconds_max = seconds;
+        }
+
+        // The first GOP has nothing before it to refer to
+        for (int i = start + 1; g > 0 && i < end && !out->open_gop; i++) {
+            if (samples[i].time < start_time) {
+                out->open_gop = 1;
+            }
+        }
+    }
+    qsort(gop_frames, (size_t)key_count, sizeof(int), compare_ints);
+    out->gop_frames_min = gop_frames[0];
+    out->gop_frames_p50 = percentile(gop_frames, key_count, 50);
+    out->gop_frames_p90 = percentile(gop_frames, key_count, 90);
+    out->gop_frames_max = gop_frames[key_count - 1];
+    out->gop_seconds_mean = gop_seconds_total / key_count;
+
+    // Presentation order: each frame decodes from the last keyframe shown
+    // at or before it, or from the first one for frames shown earlier
+    qsort(shown, (size_t)count, sizeof(shown_frame), compare_shown);
+    int key = keys[0];
+    int64_t seek_frames_total = 0;
+    for (int n = 0; n < count; n++) {
+        int index = shown[n].index;
+        if (marked ? (samples[index].flags & VP_MP4_SAMPLE_SYNC) != 0 : index == 0) {
+            key = index;
+        }
+        vp_seek_cost* cost = &costs[n];
+        cost->time = shown[n].time;
+        cost->keyframe_time = samples[key].time;
+        if (index >= key) {
+            cost->frames = index - key + 1;
+            cost->bytes = offsets[index + 1] - offsets[key];
+        } else {
+            cost->frames = 1;
+            cost->bytes = samples[index].size;
+        }
+        seek_frames_total += cost->frames;
+        if (cost->frames > out->seek_frames_max) {
+            out->seek_frames_max = cost->frames;
+        }
+    }
+
+    out->frame_count = count;
+    out->keyframe_count = marked ? key_count : 0;
+    out->all_intra = marked && key_count == count;
+    out->seek_frames_mean = (double)seek_frames_total / count;
+    out->costs = costs;
+
+    free(offsets);
+    free(keys);
+    free(gop_frames);
+    free(shown);
+    return VP_OK;
+}
+
+int gop_seek_cost(const vp_gop_info* info, double seconds, vp_seek_cost* out) {
+    if (info == NULL || out == NULL) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+    if (info->costs == NULL || info->frame_count <= 0) {
+        return VP_ERROR_NOT_FOUND;
+    }
+
+    // Last frame shown at or before `seconds`
+    int low = 0;
+    int high = info->frame_count - 1;
+    while (low < high) {
+        int mid = low + (high - low + 1) / 2;
+        if (info->costs[mid].time <= seconds) {
+            low = mid;
+        } else {
+            high = mid - 1;
+        }
+    }
+    *out = info->costs[low];
+    return VP_OK;
+}
+
+void free_gop_info(vp_gop_info* info) {
+    if (info == NULL) {
+        return;
+    }
+    vp_arena_free((vp_arena*)info->arena);
+    memset(info, 0, sizeof(*info));
+}
@@ -0,0 +1,444 @@
+/**
+ * HTTP(S) reader for the native container parsers and GStreamer.
+ *
+ * Remote media is read with Range requests through a small block cache, so
+ * a probe transfers the header, the index and the bytes it decodes instead
+ * of the whole object. Missing blocks of one read are fetched with a single
+ * request, sequential access reads ahead, and concurrent readers wait for
+ * an in-flight fetch instead of issuing their own.
+ */
+
+// strdup
+#define _POSIX_C_SOURCE 200809L
+
+#include "video_probe_internal.h"
+
+#include <curl/curl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define HTTP_BLOCK_SIZE (64 * 1024)
+#define HTTP_CACHE_BLOCKS 64
+// Extra blocks fetched when reads continue where the previous one ended
+#define HTTP_READAHEAD_BLOCKS 4
+// Reads larger than this bypass the cache instead of flushing it
+#define HTTP_MAX_CACHED_READ_BLOCKS (HTTP_CACHE_BLOCKS / 2)
+
+typedef struct {
+    // Block number, -1 if the slot is free
+    int64_t index;
+    uint64_t last_used;
+    int64_t length;
+    uint8_t* data;
+} http_block;
+
+typedef struct {
+    CURL* curl;
+    char* url;
+    pthread_mutex_t lock;
+    http_block blocks[HTTP_CACHE_BLOCKS];
+    uint64_t clock;
+    int64_t size;
+    // Offset right after the previous read, to detect sequential access
+    int64_t next_offset;
+    // Aborts transfers when cancelled or out of time; may be NULL
+    const vp_call* call;
+    // Shuts the connection down on cancel so a blocked transfer wakes at once
+    vp_cancel_waker waker;
+    pthread_mutex_t socket_lock;
+    curl_socket_t socket;
+    vp_http_stats stats;
+} http_reader;
+
+// Destination of one range request
+typedef struct {
+    uint8_t* buf;
+    int64_t capacity;
+    int64_t received;
+    // From Content-Range, -1 if absent
+    int64_t total_size;
+    // The reply was longer than requested and was cut off
+    int overflow;
+} http_transfer;
+
+static pthread_once_t curl_once = PTHREAD_ONCE_INIT;
+
+static void curl_init_once(void) {
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+}
+
+int vp_is_http_url(const char* path) {
+    return path != NULL &&
+        (strncasecmp(path, "http://", 7) == 0 || strncasecmp(path, "https://", 8) == 0);
+}
+
+static size_t on_body(char* data, size_t size, size_t nmemb, void* user_data) {
+    http_transfer* transfer = (http_transfer*)user_data;
+    size_t n = size * nmemb;
+    // A server ignoring the Range header would send the whole object;
+    // abort rather than download it.
+    if (transfer->received + (int64_t)n > transfer->capacity) {
+        transfer->overflow = 1;
+        return 0;
+    }
+    memcpy(transfer->buf + transfer->received, data, n);
+    transfer->received += (int64_t)n;
+    return n;
+}
+
+static size_t on_header(char* data, size_t size, size_t nmemb, void* user_data) {
+    http_transfer* transfer = (http_transfer*)user_data;
+    size_t n = size * nmemb;
+    // "Content-Range: bytes 0-65535/1234567"
+    if (n > 14 && strncasecmp(data, "Content-Range:", 14) == 0) {
+        const char* slash = (const char*)memchr(data, '/', n);
+        if (slash != NULL && slash[1] != '*') {
+            transfer->total_size = strtoll(slash + 1, NULL, 10);
+        }
+    }
+    return n;
+}
+
+// libcurl progress callback: abort the transfer once the call is over.
+// Covers what the socket shutdown in wake_transfer() cannot, such as a
+// name lookup.
+static int on_progress(void* user_data, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow) {
+    (void)dltotal;
+    (void)dlnow;
+    (void)ultotal;
+    (void)ulnow;
+    return vp_call_check(((http_reader*)user_data)->call) != VP_OK;
+}
+
+// Track the connection's socket so cancellation can shut it down
+static curl_socket_t on_open_socket(void* user_data, curlsocktype purpose, struct curl_sockaddr* address) {
+    (void)purpose;
+    http_reader* http = (http_reader*)user_data;
+    curl_socket_t fd = socket(address->family, address->socktype, address->protocol);
+    pthread_mutex_lock(&http->socket_lock);
+    http->socket = fd;
+    pthread_mutex_unlock(&http->socket_lock);
+    return fd;
+}
+
+static int on_close_socket(void* user_data, curl_socket_t fd) {
+    http_reader* http = (http_reader*)user_data;
+    pthread_mutex_lock(&http->socket_lock);
+    if (http->socket == fd) {
+        http->socket = CURL_SOCKET_BAD;
+    }
+    pthread_mutex_unlock(&http->socket_lock);
+    return close(fd);
+}
+
+static void wake_transfer(void* data) {
+    http_reader* http = (http_reader*)data;
+    pthread_mutex_lock(&http->socket_lock);
+    if (http->socket != CURL_SOCKET_BAD) {
+        shutdown(http->socket, SHUT_RDWR);
+    }
+    pthread_mutex_unlock(&http->socket_lock);
+}
+
+// Fetch [offset, offset + length) into buf. Returns the HTTP status code,
+// or -1 on transport errors. A 200 reply means the server ignored the
+// range; transfer->overflow tells whether it was cut off.
+static long fetch_range(http_reader* http, int64_t offset, int64_t length, uint8_t* buf, http_transfer* transfer) {
+    char range[64];
+    snprintf(range, sizeof(range), "%lld-%lld", (long long)offset, (long long)(offset + length - 1));
+
+    memset(transfer, 0, sizeof(*transfer));
+    transfer->buf = buf;
+    transfer->capacity = length;
+    transfer->total_size = -1;
+    if (vp_call_check(http->call) != VP_OK) {
+        return -1;
+    }
+
+    // Bound the whole transfer by the call's deadline, if any (0 = none)
+    int64_t remaining_ms = http->call != NULL && http->call->deadline_us > 0
+        ? vp_call_remaining_us(http->call, 0) / 1000 + 1 : 0;
+    curl_easy_setopt(http->curl, CURLOPT_TIMEOUT_MS, (long)remaining_ms);
+    curl_easy_setopt(http->curl, CURLOPT_RANGE, range);
+    curl_easy_setopt(http->curl, CURLOPT_WRITEDATA, transfer);
+    curl_easy_setopt(http->curl, CURLOPT_HEADERDATA, transfer);
+
+    int64_t start = vp_monotonic_us();
+    CURLcode code = curl_easy_perform(http->curl);
+    vp_trace_span(0, "http range request", start, vp_monotonic_us());
+    long status = 0;
+    curl_easy_getinfo(http->curl, CURLINFO_RESPONSE_CODE, &status);
+    http->stats.requests++;
+    http->stats.bytes_received += transfer->received;
+
+    if (code != CURLE_OK && !(code == CURLE_WRITE_ERROR && transfer->overflow)) {
+        return -1;
+    }
+    return status;
+}
+
+static http_block* find_block(http_reader* http, int64_t index) {
+    for (int i = 0; i < HTTP_CACHE_BLOCKS; i++) {
+        if (http->blocks[i].index == index) {
+            return &http->blocks[i];
+        }
+    }
+    return NULL;
+}
+
+static http_block* evict_block(http_reader* http) {
+    http_block* victim = &http->blocks[0];
+    for (int i = 0; i < HTTP_CACHE_BLOCKS; i++) {
+        http_block* block = &http->blocks[i];
+        if (block->index < 0) {
+            return block;
+        }
+        if (block->last_used < victim->last_used) {
+            victim = block;
+        }
+    }
+    return victim;
+}
+
+// Store `length` bytes starting at block `first` in the cache
+static void cache_blocks(http_reader* http, int64_t first, const uint8_t* data, int64_t length) {
+    for (int64_t pos = 0; pos < length; pos += HTTP_BLOCK_SIZE) {
+        int64_t index = first + pos / HTTP_BLOCK_SIZE;
+        int64_t n = length - pos < HTTP_BLOCK_SIZE ? length - pos : HTTP_BLOCK_SIZE;
+        http_block* block = find_block(http, index);
+        if (block == NULL) {
+            block = evict_block(http);
+        }
+        if (block->data == NULL) {
+            block->data = (uint8_t*)malloc(HTTP_BLOCK_SIZE);
+            if (block->data == NULL) {
+                return;
+            }
+        }
+        memcpy(block->data, data + pos, (size_t)n);
+        block->index = index;
+        block->length = n;
+        block->last_used = ++http->clock;
+    }
+}
+
+// Fetch blocks [first, first + count) with one request and cache them
+static int fetch_blocks(http_reader* http, int64_t first, int64_t count) {
+    int64_t offset = first * HTTP_BLOCK_SIZE;
+    int64_t length = count * HTTP_BLOCK_SIZE;
+    if (offset + length > http->size) {
+        length = http->size - offset;
+    }
+    uint8_t* buf = (uint8_t*)malloc((size_t)length);
+    if (buf == NULL) {
+        return -1;
+    }
+
+    http_transfer transfer;
+    long status = fetch_range(http, offset, length, buf, &transfer);
+    int ok = status == 206 && transfer.received == length;
+    if (ok) {
+        cache_blocks(http, first, buf, length);
+    }
+    free(buf);
+    return ok ? 0 : -1;
+}
+
+static int64_t http_read_at(void* opaque, int64_t offset, void* buf, int64_t size) {
+    http_reader* http = (http_reader*)opaque;
+    if (offset < 0) {
+        return -1;
+    }
+    if (offset >= http->size || size <= 0) {
+        return 0;
+    }
+    if (size > http->size - offset) {
+        size = http->size - offset;
+    }
+
+    pthread_mutex_lock(&http->lock);
+    int64_t first = offset / HTTP_BLOCK_SIZE;
+    int64_t last = (offset + size - 1) / HTTP_BLOCK_SIZE;
+    int64_t result = size;
+
+    if (last - first + 1 > HTTP_MAX_CACHED_READ_BLOCKS) {
+        // Large reads (a big moov) go straight to the caller's buffer
+        http_transfer transfer;
+        long status = fetch_range(http, offset, size, (uint8_t*)buf, &transfer);
+        result = status == 206 && transfer.received == size ? size : -1;
+    } else {
+        // Mark cached blocks first so fetching the rest cannot evict them
+        for (int64_t index = first; index <= last; index++) {
+            http_block* block = find_block(http, index);
+            if (block != NULL) {
+                block->last_used = ++http->clock;
+                http->stats.cache_hits++;
+            }
+        }
+
+        int64_t last_block = (http->size - 1) / HTTP_BLOCK_SIZE;
+        int64_t index = first;
+        while (index <= last && result >= 0) {
+            if (find_block(http, index) != NULL) {
+                index++;
+                continue;
+            }
+            // Coalesce the run of missing blocks into one request
+            int64_t run = 1;
+            while (index + run <= last && find_block(http, index + run) == NULL) {
+                run++;
+            }
+            http->stats.cache_misses += run;
+            if (index + run > last && offset == http->next_offset) {
+                int64_t ahead = last_block - (index + run - 1);
+                run += ahead < HTTP_READAHEAD_BLOCKS ? ahead : HTTP_READAHEAD_BLOCKS;
+            }
+            if (fetch_blocks(http, index, run) != 0) {
+                result = -1;
+            }
+            index += run;
+        }
+
+        for (int64_t index = first; index <= last && result >= 0; index++) {
+            http_block* block = find_block(http, index);
+            if (block == NULL) {
+                result = -1;
+                break;
+            }
+            int64_t block_start = index * HTTP_BLOCK_SIZE;
+            int64_t from = offset > block_start ? offset - block_start : 0;
+            int64_t to = offset + size - block_start;
+            if (to > block->length) to = block->length;
+            memcpy((uint8_t*)buf + (block_start + from - offset), block->data + from, (size_t)(to - from));
+        }
+    }
+
+    if (result > 0) {
+        http->next_offset = offset + result;
+    }
+    pthread_mutex_unlock(&http->lock);
+    return result;
+}
+
+static void http_close(void* opaque) {
+    http_reader* http = (http_reader*)opaque;
+    if (http->call != NULL) {
+        vp_cancel_remove_waker(http->call->cancel, &http->waker);
+    }
+    if (http->curl != NULL) {
+        curl_easy_cleanup(http->curl);
+    }
+    for (int i = 0; i < HTTP_CACHE_BLOCKS; i++) {
+        free(http->blocks[i].data);
+    }
+    pthread_mutex_destroy(&http->lock);
+    pthread_mutex_destroy(&http->socket_lock);
+    free(http->url);
+    free(http);
+}
+
+int vp_reader_open_http(vp_reader* reader, const char* url, const vp_call* call) {
+    if (reader == NULL || !vp_is_http_url(url)) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+    memset(reader, 0, sizeof(*reader));
+    pthread_once(&curl_once, curl_init_once);
+
+    http_reader* http = (http_reader*)calloc(1, sizeof(http_reader));
+    if (http == NULL) {
+        return VP_ERROR_NO_MEMORY;
+    }
+    pthread_mutex_init(&http->lock, NULL);
+    pthread_mutex_init(&http->socket_lock, NULL);
+    http->socket = CURL_SOCKET_BAD;
+    for (int i = 0; i < HTTP_CACHE_BLOCKS; i++) {
+        http->blocks[i].index = -1;
+    }
+    http->call = call;
+    if (call != NULL) {
+        http->waker.wake = wake_transfer;
+        http->waker.data = http;
+        vp_cancel_add_waker(call->cancel, &http->waker);
+    }
+    http->url = strdup(url);
+    http->curl = curl_easy_init();
+    if (http->url == NULL || http->curl == NULL) {
+        http_close(http);
+        return VP_ERROR_NO_MEMORY;
+    }
+
+    CURL* curl = http->curl;
+    curl_easy_setopt(curl, CURLOPT_URL, http->url);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 5L);
+    // Give up on stalled transfers: under 1 KiB/s for 10 seconds
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1024L);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, 10L);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, on_body);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, on_header);
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, on_progress);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, http);
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+    curl_easy_setopt(curl, CURLOPT_OPENSOCKETFUNCTION, on_open_socket);
+    curl_easy_setopt(curl, CURLOPT_OPENSOCKETDATA, http);
+    curl_easy_setopt(curl, CURLOPT_CLOSESOCKETFUNCTION, on_close_socket);
+    curl_easy_setopt(curl, CURLOPT_CLOSESOCKETDATA, http);
+
+    // The first request learns the size from Content-Range and fills the
+    // head blocks, where every container starts.
+    int64_t length = (int64_t)HTTP_BLOCK_SIZE * (1 + HTTP_READAHEAD_BLOCKS);
+    uint8_t* buf = (uint8_t*)malloc((size_t)length);
+    if (buf == NULL) {
+        http_close(http);
+        return VP_ERROR_NO_MEMORY;
+    }
+    http_transfer transfer;
+    long status = fetch_range(http, 0, length, buf, &transfer);
+
+    int result = VP_OK;
+    if (status == 206 && transfer.total_size > 0) {
+        http->size = transfer.total_size;
+    } else if (status == 200 && !transfer.overflow) {
+        // No range support, but the whole object fit in the first reply
+        http->size = transfer.received;
+    } else if (status == 200) {
+        result = VP_ERROR_UNSUPPORTED;
+    } else if (status == 404 || status == 410) {
+        result = VP_ERROR_NOT_FOUND;
+    } else if (status == 416) {
+        // Empty object
+        result = VP_ERROR_UNSUPPORTED;
+    } else if (vp_call_check(call) != VP_OK) {
+        result = vp_call_check(call);
+    } else {
+        result = VP_ERROR_FAILED;
+    }
+    if (result == VP_OK) {
+        cache_blocks(http, 0, buf, transfer.received);
+        http->next_offset = transfer.received;
+    }
+    free(buf);
+    if (result != VP_OK) {
+        http_close(http);
+        return result;
+    }
+
+    reader->opaque = http;
+    reader->read_at = http_read_at;
+    reader->close = http_close;
+    reader->size = http->size;
+    return VP_OK;
+}
+
+void vp_reader_http_stats(const vp_reader* reader, vp_http_stats* out) {
+    http_reader* http = (http_reader*)reader->opaque;
+    pthread_mutex_lock(&http->lock);
+    *out = http->stats;
+    pthread_mutex_unlock(&http->lock);
+}
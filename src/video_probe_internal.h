@@ -0,0 +1,368 @@
+/**
+ * Internal helpers shared by the platform implementations.
+ *
+ * Nothing in here is part of the FFI surface; keep it free of platform
+ * dependencies so every backend can compile it.
+ */
+
+#ifndef VIDEO_PROBE_INTERNAL_H_
+#define VIDEO_PROBE_INTERNAL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "video_probe.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// Arena allocator
+// ============================================================================
+
+// Bump allocator backing result structs handed across the FFI boundary.
+// Every allocation is zeroed and 8-byte aligned, and the whole arena is
+// released with a single vp_arena_free().
+typedef struct vp_arena vp_arena;
+
+vp_arena* vp_arena_new(size_t block_size);
+void* vp_arena_alloc(vp_arena* arena, size_t size);
+char* vp_arena_strdup(vp_arena* arena, const char* str);
+void vp_arena_free(vp_arena* arena);
+
+// Move every block of `src` into `dst` and free `src`. Lets worker threads
+// fill private arenas and hand the result over as one.
+void vp_arena_merge(vp_arena* dst, vp_arena* src);
+
+// ============================================================================
+// Cancellation and deadlines
+// ============================================================================
+
+// Run once when a token is cancelled, to interrupt a blocking wait (post
+// to a bus, wake a main context). Called with the token locked, so it must
+// not block or touch the token.
+typedef struct vp_cancel_waker {
+    void (*wake)(void* data);
+    void* data;
+    struct vp_cancel_waker* next;
+} vp_cancel_waker;
+
+// Registers `waker` for the duration of a wait, running it at once if the
+// token is already cancelled. After vp_cancel_remove_waker() returns the
+// waker is no longer called. Both accept a NULL token.
+void vp_cancel_add_waker(vp_cancel_token* token, vp_cancel_waker* waker);
+void vp_cancel_remove_waker(vp_cancel_token* token, vp_cancel_waker* waker);
+
+// Deadline and cancellation of one API call, passed down to every stage.
+// A NULL call never expires.
+typedef struct vp_call {
+    vp_cancel_token* cancel;
+    // vp_monotonic_us() at which the call times out, 0 for none
+    int64_t deadline_us;
+    // Bytes each decode may use, 0 for no limit
+    int64_t memory_budget;
+    // vp_call_options.peak_memory
+    int64_t* peak_memory;
+    // Decoder threads per pipeline, 0 for the decoder's default
+    int decoder_threads;
+} vp_call;
+
+int64_t vp_monotonic_us(void);
+
+// Starts the clock for `options`, which may be NULL.
+void vp_call_init(vp_call* call, const vp_call_options* options);
+
+// VP_OK, VP_ERROR_CANCELLED or VP_ERROR_TIMEOUT.
+int vp_call_check(const vp_call* call);
+
+// Microseconds left before the deadline, never negative, or `fallback_us`
+// for calls without one.
+int64_t vp_call_remaining_us(const vp_call* call, int64_t fallback_us);
+
+// ============================================================================
+// Memory budgets
+// ============================================================================
+
+// How to run a decode so it fits its budget
+typedef struct vp_decode_plan {
+    // Divisor of width and height applied before conversion: 1, 2, 4 or 8
+    int scale;
+    // Decoder threads, 0 to leave the decoder's default
+    int threads;
+    // Bytes attributed to the decode at its peak
+    int64_t estimate;
+} vp_decode_plan;
+
+// Bytes a decode of a width x height frame needs: the decoder's reference
+// and output frames, one more per decoder thread, then conversion and JPEG
+// encoding at 1/scale size. `threads` 0 means one per CPU core.
+int64_t vp_decode_estimate(int width, int height, int bit_depth, int scale, int threads);
+
+// Picks the least degraded plan whose estimate fits `budget` bytes (0 for
+// none), starting from `threads` decoder threads (0 for the default).
+// Returns VP_ERROR_OVER_BUDGET with the cheapest plan in *plan if none
+// fits.
+int vp_decode_plan_fit(int width, int height, int bit_depth, int threads, int64_t budget, vp_decode_plan* plan);
+
+// Plans a decode within the call's budget and what is left of the global
+// one, starting from the call's decoder threads, and reserves its estimate
+// globally. `call` may be NULL. Unknown
+// dimensions (0) are planned single-threaded when a budget is set. On
+// VP_OK the caller must pass the plan to vp_budget_release().
+int vp_budget_acquire(const vp_call* call, int width, int height, int bit_depth, vp_decode_plan* plan);
+
+// Returns the plan's reservation and reports it to the call's peak_memory.
+void vp_budget_release(const vp_call* call, const vp_decode_plan* plan);
+
+// The per-request default set by set_memory_budget()
+int64_t vp_budget_request_default(void);
+
+// ============================================================================
+// Request scheduler
+// ============================================================================
+
+// Executes one scheduled request on a worker thread, setting
+// result->status and the payload. `options` carries the request's cancel
+// token and what is left of its deadline.
+typedef void (*vp_scheduler_run)(const vp_request* request, const vp_call_options* options,
+                                 vp_request_result* result);
+
+// scheduler_new() with `workers` > 0 threads and the platform function
+// that runs requests.
+vp_scheduler* vp_scheduler_new(int workers, vp_scheduler_run run, vp_request_callback callback, void* user_data);
+
+// ============================================================================
+// Metrics
+// ============================================================================
+
+// Counters kept next to the stage timings
+#define VP_COUNTER_BYTES_READ 0
+#define VP_COUNTER_ALLOCATIONS 1
+// Levels rather than totals: reset_metrics() does not zero these
+#define VP_COUNTER_LIVE_FRAMES 2
+#define VP_COUNTER_LIVE_ARENAS 3
+
+// Records one completed run of a VP_STAGE_* into the calling thread's
+// histogram. Lock-free.
+void vp_metrics_record(int stage, int64_t elapsed_us);
+
+// Adds `n` to a VP_COUNTER_* of the calling thread.
+void vp_metrics_count(int counter, int64_t n);
+
+// ============================================================================
+// Frame pool
+// ============================================================================
+
+// Frame buffers handed to callers, recycled through a size-classed pool.
+// Counted in vp_metrics.live_frames, and in allocations when the pool had
+// no buffer to reuse.
+uint8_t* vp_frame_alloc(size_t size);
+void vp_frame_free(uint8_t* frame);
+
+// Bytes of freed frames the pool holds for reuse
+int64_t vp_frame_pool_bytes(void);
+
+// ============================================================================
+// Tracing
+// ============================================================================
+
+// Whether trace_start() is recording. Lets callers skip work that only
+// feeds the trace.
+int vp_trace_enabled(void);
+
+// Id of the calling thread in the trace (the kernel tid on Linux).
+int64_t vp_trace_thread_id(void);
+
+// Records a span between two vp_monotonic_us() readings on `thread`, or on
+// the calling thread when 0. `name` must be a string literal. A no-op
+// unless tracing.
+void vp_trace_span(int64_t thread, const char* name, int64_t start_us, int64_t end_us);
+
+// ============================================================================
+// Readers
+// ============================================================================
+
+// read_at() result for bytes a partial reader does not hold yet
+#define VP_READ_UNAVAILABLE -2
+
+// Random-access byte source for the native container parsers.
+typedef struct vp_reader {
+    void* opaque;
+    // Reads up to `size` bytes at `offset` into `buf`.
+    // Returns the number of bytes read, 0 at end of file, -1 on error, or
+    // VP_READ_UNAVAILABLE if the range has not been downloaded yet.
+    int64_t (*read_at)(void* opaque, int64_t offset, void* buf, int64_t size);
+    void (*close)(void* opaque);
+    // Total size in bytes, -1 if unknown.
+    int64_t size;
+    // The whole source when it is already in memory, else NULL. Lets
+    // consumers wrap ranges instead of copying them.
+    const uint8_t* data;
+    // I/O counters of this reader, or NULL if it does not keep any.
+    const vp_io_stats* stats;
+} vp_reader;
+
+// Opens a local file (plain path or file:// URI) with the backend chosen
+// by vp_io_set_backend(). Returns VP_OK or an error.
+// The head and tail of the file are prefetched at open, in parallel where
+// the backend allows it, and small reads are served from cached windows
+// so that a box walk costs a couple of storage round trips.
+int vp_reader_open_file(vp_reader* reader, const char* path);
+
+// Like vp_reader_open_file() with an explicit VP_IO_* backend. Falls back
+// to pread if the backend cannot be set up for this file.
+int vp_reader_open_file_with(vp_reader* reader, const char* path, int backend);
+
+// Selects the backend of later vp_reader_open_file() calls. Returns VP_OK,
+// VP_ERROR_UNSUPPORTED if the backend is not available on this system, or
+// VP_ERROR_INVALID_ARGUMENT.
+int vp_io_set_backend(int backend);
+
+// Non-zero if the kernel lets this process use io_uring.
+int vp_io_uring_available(void);
+
+// Process-wide counters of every file reader opened so far.
+void vp_io_global_stats(vp_io_stats* out);
+
+// Reads from `size` bytes at `data`, which must outlive the reader.
+int vp_reader_open_memory(vp_reader* reader, const uint8_t* data, int64_t size);
+
+// Reads through caller-supplied callbacks, which must outlive the reader.
+// Not safe for concurrent use; callers serialize access.
+int vp_reader_open_io(vp_reader* reader, const vp_io_callbacks* io);
+
+// Reads the downloaded `available` ranges of a file that will eventually
+// be `total_size` bytes; see probe_media_info_partial().
+int vp_reader_open_partial(vp_reader* reader, const char* path, int64_t total_size,
+                           const vp_byte_range* available, int available_count);
+
+// Writes the parts of `wanted` that a partial reader does not hold to `out`
+// (up to `capacity`, sorted and merged). Returns the total number of
+// missing ranges. `reader` must come from vp_reader_open_partial().
+int vp_reader_partial_missing(const vp_reader* reader, const vp_byte_range* wanted, int wanted_count,
+                              vp_byte_range* out, int capacity);
+
+// Counters of an HTTP reader, for tests and diagnostics
+typedef struct vp_http_stats {
+    int64_t requests;
+    int64_t bytes_received;
+    int64_t cache_hits;
+    int64_t cache_misses;
+} vp_http_stats;
+
+// Non-zero if `path` is an http:// or https:// URL
+int vp_is_http_url(const char* path);
+
+// Reads an HTTP(S) URL with Range requests through a block cache. Safe for
+// concurrent use. Returns VP_OK, VP_ERROR_NOT_FOUND for 404/410,
+// VP_ERROR_UNSUPPORTED if the server cannot serve ranges of a larger
+// object, or VP_ERROR_FAILED.
+// Transfers are aborted once `call` (may be NULL, must outlive the reader)
+// is cancelled or out of time; reads then fail and open returns
+// VP_ERROR_CANCELLED or VP_ERROR_TIMEOUT.
+int vp_reader_open_http(vp_reader* reader, const char* url, const vp_call* call);
+
+// `reader` must come from vp_reader_open_http().
+void vp_reader_http_stats(const vp_reader* reader, vp_http_stats* out);
+
+// Reads exactly `size` bytes at `offset`. Returns 0 on success,
+// VP_READ_UNAVAILABLE if part of the range is not downloaded yet, or -1.
+int vp_reader_read_full(vp_reader* reader, int64_t offset, void* buf, int64_t size);
+
+void vp_reader_close(vp_reader* reader);
+
+// ============================================================================
+// Native container parsers
+// ============================================================================
+
+// Probes an ISO-BMFF file (MP4, MOV, M4V, 3GP) from its box structure
+// without decoding anything. Strings and streams are allocated from `arena`.
+// Returns VP_OK, VP_ERROR_UNSUPPORTED if the data is not ISO-BMFF or lacks
+// the metadata needed for a complete answer, or VP_ERROR_FAILED on I/O error.
+int vp_mp4_probe(vp_reader* reader, vp_arena* arena, vp_media_info* out);
+
+// Most ranges vp_mp4_probe_partial() asks for in one round
+#define VP_MP4_MAX_NEEDED 4
+
+// Like vp_mp4_probe() for partial readers. When bytes it needs are not
+// available yet, returns VP_ERROR_NEED_DATA and fills `needed` with up to
+// VP_MP4_MAX_NEEDED ranges to fetch: the head and tail while moov has not
+// been located, then the exact box ranges.
+int vp_mp4_probe_partial(vp_reader* reader, vp_arena* arena, vp_media_info* out,
+                         vp_byte_range* needed, int* needed_count);
+
+// Presentation times in seconds of the sync samples of the first video
+// track, in decode order, allocated from `arena`. Without a sync sample
+// table every sample is one. Returns VP_OK, VP_ERROR_UNSUPPORTED for data
+// that is not ISO-BMFF, has no video or is fragmented, or an error.
+int vp_mp4_keyframes(vp_reader* reader, vp_arena* arena, double** times, int* count);
+
+// vp_mp4_sample.flags
+#define VP_MP4_SAMPLE_SYNC 1
+// No other sample depends on it (sdtp), so a decoder may skip it
+#define VP_MP4_SAMPLE_DISPOSABLE 2
+
+typedef struct vp_mp4_sample {
+    // Presentation time in seconds
+    double time;
+    // Coded size in bytes, 0 if unknown
+    uint32_t size;
+    int flags;
+    // File offset of the coded bytes, 0 if unknown
+    int64_t offset;
+} vp_mp4_sample;
+
+// Every sample of the first video track in decode order, allocated from
+// `arena`, and with a non-NULL `stream` that track's description.
+// Returns as vp_mp4_keyframes().
+int vp_mp4_samples(vp_reader* reader, vp_arena* arena, vp_mp4_sample** samples, int* count,
+                   vp_stream_info* stream);
+
+// Like vp_mp4_samples() for a first video track whose sync sample table
+// lists every sample, or that has none. Any other track is rejected with
+// VP_ERROR_UNSUPPORTED before its table is built.
+int vp_mp4_intra_samples(vp_reader* reader, vp_arena* arena, vp_mp4_sample** samples, int* count,
+                         vp_stream_info* stream);
+
+// ============================================================================
+// GOP analysis
+// ============================================================================
+
+// Fills `out` from `count` samples in decode order, with its costs
+// allocated from `arena` (out->arena is left NULL). Samples whose times
+// tie keep their decode order. Returns VP_OK, VP_ERROR_INVALID_ARGUMENT
+// for no samples, or VP_ERROR_NO_MEMORY.
+int vp_gop_analyze(const vp_mp4_sample* samples, int count, vp_arena* arena, vp_gop_info* out);
+
+// ============================================================================
+// Embedded images
+// ============================================================================
+
+typedef struct vp_embedded_image {
+    // Copied into the arena the parser was given
+    const uint8_t* data;
+    size_t size;
+    // VP_IMAGE_*
+    int format;
+} vp_embedded_image;
+
+// VP_IMAGE_* of `data` by its signature, 0 for other formats
+int vp_image_format(const uint8_t* data, size_t size);
+
+// Cover art (covr in an ilst) of ISO-BMFF data, else the thumbnail Canon
+// cameras store in udta/CNTH. Returns VP_OK, VP_ERROR_NOT_FOUND if moov
+// stores no JPEG or PNG, VP_ERROR_UNSUPPORTED for data that is not
+// ISO-BMFF, or an error.
+int vp_mp4_cover(vp_reader* reader, vp_arena* arena, vp_embedded_image* out);
+
+// The cover among the image attachments of Matroska/WebM data: cover.*,
+// then cover_land.*, then small_cover*, then the first other JPEG or PNG.
+// Returns as vp_mp4_cover().
+int vp_mkv_cover(vp_reader* reader, vp_arena* arena, vp_embedded_image* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // VIDEO_PROBE_INTERNAL_H_
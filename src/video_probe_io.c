@@ -0,0 +1,950 @@
+/**
+ * Byte readers for the native container parsers.
+ *
+ * The parsers only ever ask for small ranges (box headers, index tables),
+ * so readers expose positioned reads rather than a stream interface.
+ *
+ * Local files go through one of three backends (pread, mmap, io_uring).
+ * All of them prefetch the head and tail of the file, where the
+ * container index lives, and the pread and io_uring backends serve small
+ * reads from cached windows, so walking a few dozen boxes costs two or
+ * three storage round trips instead of one per box.
+ */
+
+// pread, strdup, O_CLOEXEC and the posix_*advise hints
+#define _POSIX_C_SOURCE 200809L
+// syscall() for io_uring
+#define _DEFAULT_SOURCE
+
+#include "video_probe_internal.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define VP_HAVE_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+// ============================================================================
+// I/O counters
+// ============================================================================
+
+static vp_io_stats global_stats;
+
+// Adds `n` to a counter of `file` and to the process-wide total
+#define COUNT(file, field, n)                                                   \
+    do {                                                                        \
+        (file)->stats.field += (n);                                             \
+        __atomic_fetch_add(&global_stats.field, (int64_t)(n), __ATOMIC_RELAXED); \
+    } while (0)
+
+void vp_io_global_stats(vp_io_stats* out) {
+    if (out == NULL) {
+        return;
+    }
+    out->files = __atomic_load_n(&global_stats.files, __ATOMIC_RELAXED);
+    out->reads = __atomic_load_n(&global_stats.reads, __ATOMIC_RELAXED);
+    out->bytes_read = __atomic_load_n(&global_stats.bytes_read, __ATOMIC_RELAXED);
+    out->bytes_fetched = __atomic_load_n(&global_stats.bytes_fetched, __ATOMIC_RELAXED);
+    out->read_syscalls = __atomic_load_n(&global_stats.read_syscalls, __ATOMIC_RELAXED);
+    out->hint_syscalls = __atomic_load_n(&global_stats.hint_syscalls, __ATOMIC_RELAXED);
+}
+
+// ============================================================================
+// Local files
+// ============================================================================
+
+// Granularity of cached reads; smaller misses read the whole aligned chunk
+#define FILE_CHUNK (64 * 1024)
+// Prefetched at open: ftyp and a moov at the start
+#define FILE_HEAD (64 * 1024)
+// Prefetched at open: a moov at the end
+#define FILE_TAIL (256 * 1024)
+// Head, tail and the chunks of the two most recent misses
+#define FILE_WINDOWS 4
+#define FILE_FIRST_CHUNK 2
+
+// A cached range of the file
+typedef struct {
+    int64_t offset;
+    // Bytes the window covers, 0 for an unused slot
+    int64_t span;
+    // Bytes actually held once filled (less than span if the file shrank)
+    int64_t length;
+    int filled;
+    uint8_t* data;
+} file_window;
+
+// One read of a batch
+typedef struct {
+    int64_t offset;
+    void* buf;
+    int64_t length;
+    // Bytes read, or -1 on error
+    int64_t result;
+} file_request;
+
+#ifdef VP_HAVE_IO_URING
+typedef struct {
+    int fd;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    struct io_uring_sqe* sqes;
+    struct io_uring_cqe* cqes;
+    void* sq_ring;
+    size_t sq_ring_size;
+    void* cq_ring;
+    size_t cq_ring_size;
+    size_t sqes_size;
+} file_ring;
+#endif
+
+typedef struct {
+    int fd;
+    int backend;
+    int64_t size;
+    // Whole file when memory-mapped
+    uint8_t* map;
+#ifdef VP_HAVE_IO_URING
+    file_ring* ring;
+#endif
+    // Head, tail, then chunk windows reused round-robin
+    file_window windows[FILE_WINDOWS];
+    int next_chunk;
+    vp_io_stats stats;
+} file_reader;
+
+static int default_backend = VP_IO_AUTO;
+
+#ifdef VP_HAVE_IO_URING
+
+// Most reads submitted in one batch
+#define RING_ENTRIES 4
+// Waits for reads still in flight after io_uring_enter fails for good
+#define RING_REAP_ATTEMPTS 8
+// io_uring_enter calls refused with EAGAIN or EBUSY before giving up
+#define RING_BUSY_ATTEMPTS 8
+
+static void ring_destroy(file_ring* ring) {
+    if (ring->sqes != NULL) {
+        munmap(ring->sqes, ring->sqes_size);
+    }
+    if (ring->cq_ring != NULL && ring->cq_ring != ring->sq_ring) {
+        munmap(ring->cq_ring, ring->cq_ring_size);
+    }
+    if (ring->sq_ring != NULL) {
+        munmap(ring->sq_ring, ring->sq_ring_size);
+    }
+    if (ring->fd >= 0) {
+        close(ring->fd);
+    }
+    free(ring);
+}
+
+static void* ring_map(file_ring* ring, size_t size, off_t offset) {
+    void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, ring->fd, offset);
+    return map == MAP_FAILED ? NULL : map;
+}
+
+// Sets up a ring through the raw syscalls, so liburing is not needed.
+// Returns NULL if io_uring is unavailable, e.g. blocked by a seccomp
+// policy or an old kernel.
+static file_ring* ring_create(void) {
+    file_ring* ring = (file_ring*)calloc(1, sizeof(file_ring));
+    if (ring == NULL) {
+        return NULL;
+    }
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring->fd = (int)syscall(__NR_io_uring_setup, RING_ENTRIES, &params);
+    if (ring->fd < 0) {
+        free(ring);
+        return NULL;
+    }
+
+    ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    int single_mmap = 0;
+#ifdef IORING_FEAT_SINGLE_MMAP
+    single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+#endif
+    if (single_mmap && ring->cq_ring_size > ring->sq_ring_size) {
+        ring->sq_ring_size = ring->cq_ring_size;
+    }
+    ring->sq_ring = ring_map(ring, ring->sq_ring_size, IORING_OFF_SQ_RING);
+    ring->cq_ring = single_mmap ? ring->sq_ring : ring_map(ring, ring->cq_ring_size, IORING_OFF_CQ_RING);
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = (struct io_uring_sqe*)ring_map(ring, ring->sqes_size, IORING_OFF_SQES);
+    if (ring->sq_ring == NULL || ring->cq_ring == NULL || ring->sqes == NULL) {
+        ring_destroy(ring);
+        return NULL;
+    }
+
+    uint8_t* sq = (uint8_t*)ring->sq_ring;
+    ring->sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned*)(sq + params.sq_off.array);
+    uint8_t* cq = (uint8_t*)ring->cq_ring;
+    ring->cq_head = (unsigned*)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    return ring;
+}
+
+// Records the completions posted so far. Returns how many there were.
+static int ring_reap(file_ring* ring, file_request* requests, int count) {
+    int reaped = 0;
+    unsigned head = *ring->cq_head;
+    while (head != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+        struct io_uring_cqe* cqe = &ring->cqes[head & *ring->cq_mask];
+        if (cqe->user_data < (uint64_t)count) {
+            requests[cqe->user_data].result = cqe->res;
+        }
+        reaped++;
+        head++;
+    }
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+    return reaped;
+}
+
+// Submits every request and waits for all of them with a single
+// io_uring_enter. Returns 0, or -1 once the ring fails; the results are
+// then incomplete.
+static int ring_read(file_reader* file, file_request* requests, int count) {
+    file_ring* ring = file->ring;
+    struct iovec iov[RING_ENTRIES];
+    unsigned tail = *ring->sq_tail;
+    for (int i = 0; i < count; i++) {
+        unsigned index = tail & *ring->sq_mask;
+        struct io_uring_sqe* sqe = &ring->sqes[index];
+        memset(sqe, 0, sizeof(*sqe));
+        iov[i].iov_base = requests[i].buf;
+        iov[i].iov_len = (size_t)requests[i].length;
+        // READV rather than READ keeps Linux 5.1 to 5.5 working
+        sqe->opcode = IORING_OP_READV;
+        sqe->fd = file->fd;
+        sqe->addr = (uint64_t)(uintptr_t)&iov[i];
+        sqe->len = 1;
+        sqe->off = (uint64_t)requests[i].offset;
+        sqe->user_data = (uint64_t)i;
+        ring->sq_array[index] = index;
+        requests[i].result = -1;
+        tail++;
+    }
+    __atomic_store_n(ring->sq_tail, tail, __ATOMIC_RELEASE);
+
+    unsigned to_submit = (unsigned)count;
+    int completed = 0;
+    int busy = 0;
+    while (completed < count) {
+        int n = (int)syscall(__NR_io_uring_enter, ring->fd, to_submit, (unsigned)(count - completed),
+                             IORING_ENTER_GETEVENTS, NULL, 0);
+        COUNT(file, read_syscalls, 1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if ((errno == EAGAIN || errno == EBUSY) && ++busy < RING_BUSY_ATTEMPTS) {
+                // EBUSY means the completion queue is full: drain it so
+                // the kernel can post again
+                completed += ring_reap(ring, requests, count);
+                continue;
+            }
+            if (to_submit == (unsigned)count) {
+                // Take the entries back so the next batch starts clean
+                __atomic_store_n(ring->sq_tail, tail - to_submit, __ATOMIC_RELEASE);
+                return -1;
+            }
+            // Reads in flight still target the callers' buffers: wait for
+            // them, within a bound, before the caller falls back to pread
+            int in_flight = count - (int)to_submit - completed;
+            for (int attempt = 0; attempt < RING_REAP_ATTEMPTS && in_flight > 0; attempt++) {
+                n = (int)syscall(__NR_io_uring_enter, ring->fd, 0, (unsigned)in_flight, IORING_ENTER_GETEVENTS,
+                                 NULL, 0);
+                COUNT(file, read_syscalls, 1);
+                if (n < 0 && errno != EINTR) {
+                    break;
+                }
+                in_flight -= ring_reap(ring, requests, count);
+            }
+            return -1;
+        }
+        to_submit -= (unsigned)n < to_submit ? (unsigned)n : to_submit;
+        completed += ring_reap(ring, requests, count);
+    }
+    return 0;
+}
+
+int vp_io_uring_available(void) {
+    // 0 unknown, 1 available, -1 not
+    static int state = 0;
+    int known = __atomic_load_n(&state, __ATOMIC_ACQUIRE);
+    if (known == 0) {
+        file_ring* ring = ring_create();
+        known = ring != NULL ? 1 : -1;
+        if (ring != NULL) {
+            ring_destroy(ring);
+        }
+        __atomic_store_n(&state, known, __ATOMIC_RELEASE);
+    }
+    return known > 0;
+}
+
+#else
+
+int vp_io_uring_available(void) {
+    return 0;
+}
+
+#endif  // VP_HAVE_IO_URING
+
+int vp_io_set_backend(int backend) {
+    if (backend < VP_IO_AUTO || backend > VP_IO_URING) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+    if (backend == VP_IO_URING && !vp_io_uring_available()) {
+        return VP_ERROR_UNSUPPORTED;
+    }
+    __atomic_store_n(&default_backend, backend, __ATOMIC_RELAXED);
+    return VP_OK;
+}
+
+// pread until `length` bytes or end of file. Returns the bytes read, or -1
+// if nothing could be read.
+static int64_t file_pread(file_reader* file, int64_t offset, void* buf, int64_t length) {
+    int64_t done = 0;
+    while (done < length) {
+        ssize_t n = pread(file->fd, (uint8_t*)buf + done, (size_t)(length - done), (off_t)(offset + done));
+        COUNT(file, read_syscalls, 1);
+        if (n == 0) {
+            break;
+        }
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return done > 0 ? done : -1;
+        }
+        done += n;
+    }
+    return done;
+}
+
+// Performs a batch of reads: in parallel through io_uring when the file
+// has a ring, else one pread after the other.
+static void file_fetch(file_reader* file, file_request* requests, int count) {
+#ifdef VP_HAVE_IO_URING
+    if (file->ring != NULL && ring_read(file, requests, count) != 0) {
+        ring_destroy(file->ring);
+        file->ring = NULL;
+        file->backend = VP_IO_PREAD;
+    }
+    if (file->ring != NULL) {
+        for (int i = 0; i < count; i++) {
+            file_request* request = &requests[i];
+            if (request->result < 0) {
+                request->result = 0;
+            }
+            // Finish short reads and retry failed ones synchronously
+            if (request->result < request->length) {
+                int64_t more = file_pread(file, request->offset + request->result,
+                                          (uint8_t*)request->buf + request->result,
+                                          request->length - request->result);
+                if (more > 0) {
+                    request->result += more;
+                } else if (request->result == 0 && more < 0) {
+                    request->result = -1;
+                }
+            }
+            if (request->result > 0) {
+                COUNT(file, bytes_fetched, request->result);
+            }
+        }
+        return;
+    }
+#endif
+    for (int i = 0; i < count; i++) {
+        requests[i].result = file_pread(file, requests[i].offset, requests[i].buf, requests[i].length);
+        if (requests[i].result > 0) {
+            COUNT(file, bytes_fetched, requests[i].result);
+        }
+    }
+}
+
+// Fills `count` windows with one batch. Windows that fail are dropped.
+static void file_fill(file_reader* file, file_window** windows, int count) {
+    file_request requests[FILE_WINDOWS];
+    for (int i = 0; i < count; i++) {
+        requests[i].offset = windows[i]->offset;
+        requests[i].buf = windows[i]->data;
+        requests[i].length = windows[i]->span;
+    }
+    file_fetch(file, requests, count);
+    for (int i = 0; i < count; i++) {
+        windows[i]->filled = 1;
+        windows[i]->length = requests[i].result > 0 ? requests[i].result : 0;
+        if (requests[i].result < 0) {
+            windows[i]->span = 0;
+        }
+    }
+}
+
+// The window holding `offset`, filled on first use, or NULL.
+static file_window* file_find_window(file_reader* file, int64_t offset) {
+    for (int i = 0; i < FILE_WINDOWS; i++) {
+        file_window* window = &file->windows[i];
+        if (window->span > 0 && offset >= window->offset && offset < window->offset + window->span) {
+            if (!window->filled) {
+                file_fill(file, &window, 1);
+                if (window->span == 0) {
+                    return NULL;
+                }
+            }
+            return window;
+        }
+    }
+    return NULL;
+}
+
+// Reads the chunk around `offset` into the least recently filled chunk
+// window, so the next small reads nearby need no syscall.
+static file_window* file_load_chunk(file_reader* file, int64_t offset) {
+    file_window* window = &file->windows[FILE_FIRST_CHUNK + file->next_chunk];
+    file->next_chunk = (file->next_chunk + 1) % (FILE_WINDOWS - FILE_FIRST_CHUNK);
+    if (window->data == NULL) {
+        window->data = (uint8_t*)malloc(FILE_CHUNK);
+        if (window->data == NULL) {
+            return NULL;
+        }
+    }
+    window->offset = offset & ~(int64_t)(FILE_CHUNK - 1);
+    window->span = file->size - window->offset < FILE_CHUNK ? file->size - window->offset : FILE_CHUNK;
+    window->filled = 0;
+    file_fill(file, &window, 1);
+    return window->span > 0 ? window : NULL;
+}
+
+static int64_t file_read_at(void* opaque, int64_t offset, void* buf, int64_t size) {
+    file_reader* file = (file_reader*)opaque;
+    if (offset < 0 || size < 0) {
+        return -1;
+    }
+    if (offset >= file->size || size == 0) {
+        return 0;
+    }
+    if (size > file->size - offset) {
+        size = file->size - offset;
+    }
+    COUNT(file, reads, 1);
+
+    if (file->map != NULL) {
+        memcpy(buf, file->map + offset, (size_t)size);
+        COUNT(file, bytes_read, size);
+        return size;
+    }
+
+    file_window* window = file_find_window(file, offset);
+    if (window == NULL) {
+        if (size >= FILE_CHUNK) {
+            // Large reads, e.g. a moov outside the tail, go straight to the caller
+            file_request request = { offset, buf, size, 0 };
+            file_fetch(file, &request, 1);
+            if (request.result > 0) {
+                COUNT(file, bytes_read, request.result);
+            }
+            return request.result;
+        }
+        window = file_load_chunk(file, offset);
+        if (window == NULL) {
+            return -1;
+        }
+    }
+
+    // Short read at the window end; vp_reader_read_full() asks for the rest
+    int64_t n = window->offset + window->length - offset;
+    if (n <= 0) {
+        return 0;
+    }
+    if (n > size) {
+        n = size;
+    }
+    memcpy(buf, window->data + (offset - window->offset), (size_t)n);
+    COUNT(file, bytes_read, n);
+    return n;
+}
+
+static void file_close(void* opaque) {
+    file_reader* file = (file_reader*)opaque;
+    if (file->map != NULL) {
+        munmap(file->map, (size_t)file->size);
+    }
+#ifdef VP_HAVE_IO_URING
+    if (file->ring != NULL) {
+        ring_destroy(file->ring);
+    }
+#endif
+    for (int i = 0; i < FILE_WINDOWS; i++) {
+        free(file->windows[i].data);
+    }
+    close(file->fd);
+    free(file);
+}
+
+// Maps the whole file and hints the head and tail. Returns 0 or -1.
+static int file_map(file_reader* file, int64_t tail_offset) {
+    if (file->size <= 0 || (uint64_t)file->size > (uint64_t)SIZE_MAX) {
+        return -1;
+    }
+    void* map = mmap(NULL, (size_t)file->size, PROT_READ, MAP_PRIVATE, file->fd, 0);
+    if (map == MAP_FAILED) {
+        return -1;
+    }
+    file->map = (uint8_t*)map;
+    int64_t page = (int64_t)sysconf(_SC_PAGESIZE);
+    int64_t tail_page = page > 0 ? tail_offset / page * page : 0;
+    // Box walks jump around; only the hinted ranges should be read ahead
+    posix_madvise(map, (size_t)file->size, POSIX_MADV_RANDOM);
+    posix_madvise(map, (size_t)(file->size < FILE_HEAD ? file->size : FILE_HEAD), POSIX_MADV_WILLNEED);
+    posix_madvise(file->map + tail_page, (size_t)(file->size - tail_page), POSIX_MADV_WILLNEED);
+    COUNT(file, hint_syscalls, 3);
+    return 0;
+}
+
+// Sets up the head and tail windows and starts reading them.
+static void file_prefetch(file_reader* file, int64_t tail_offset) {
+    file_window* head = &file->windows[0];
+    file_window* tail = &file->windows[1];
+    head->span = file->size < FILE_HEAD ? file->size : FILE_HEAD;
+    tail->offset = tail_offset;
+    tail->span = file->size > FILE_HEAD ? file->size - tail_offset : 0;
+
+    file_window* batch[2];
+    int count = 0;
+    file_window* windows[2] = { head, tail };
+    for (int i = 0; i < 2; i++) {
+        if (windows[i]->span <= 0) {
+            continue;
+        }
+        windows[i]->data = (uint8_t*)malloc((size_t)windows[i]->span);
+        if (windows[i]->data == NULL) {
+            windows[i]->span = 0;
+            continue;
+        }
+        batch[count++] = windows[i];
+    }
+
+#ifdef VP_HAVE_IO_URING
+    if (file->ring != NULL) {
+        // Both ends in parallel with a single syscall
+        file_fill(file, batch, count);
+        return;
+    }
+#endif
+    // pread: let the kernel fetch the tail while the head is read, and
+    // keep it from reading ahead past the chunks we ask for
+    posix_fadvise(file->fd, 0, 0, POSIX_FADV_RANDOM);
+    COUNT(file, hint_syscalls, 1);
+    if (tail->span > 0) {
+        posix_fadvise(file->fd, (off_t)tail->offset, (off_t)tail->span, POSIX_FADV_WILLNEED);
+        COUNT(file, hint_syscalls, 1);
+    }
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Turn "file:///a%20b.mp4" into "/a b.mp4". Returns a malloc'd string.
+static char* filename_from_path(const char* path) {
+    if (strncmp(path, "file://", 7) != 0) {
+        return strdup(path);
+    }
+
+    const char* src = path + 7;
+    // Skip an optional "localhost" authority
+    if (strncmp(src, "localhost/", 10) == 0) {
+        src += 9;
+    }
+
+    char* filename = (char*)malloc(strlen(src) + 1);
+    if (filename == NULL) {
+        return NULL;
+    }
+    char* dst = filename;
+    while (*src) {
+        int hi, lo;
+        if (src[0] == '%' && (hi = hex_value(src[1])) >= 0 && (lo = hex_value(src[2])) >= 0) {
+            *dst++ = (char)(hi * 16 + lo);
+            src += 3;
+        } else {
+            *dst++ = *src++;
+        }
+    }
+    *dst = '\0';
+    return filename;
+}
+
+int vp_reader_open_file(vp_reader* reader, const char* path) {
+    return vp_reader_open_file_with(reader, path, __atomic_load_n(&default_backend, __ATOMIC_RELAXED));
+}
+
+int vp_reader_open_file_with(vp_reader* reader, const char* path, int backend) {
+    if (reader == NULL || path == NULL || path[0] == '\0') {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+    memset(reader, 0, sizeof(*reader));
+
+    char* filename = filename_from_path(path);
+    if (filename == NULL) {
+        return VP_ERROR_NO_MEMORY;
+    }
+    int fd = open(filename, O_RDONLY | O_CLOEXEC);
+    free(filename);
+    if (fd < 0) {
+        return errno == ENOENT ? VP_ERROR_NOT_FOUND : VP_ERROR_FAILED;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return VP_ERROR_UNSUPPORTED;
+    }
+
+    file_reader* file = (file_reader*)calloc(1, sizeof(file_reader));
+    if (file == NULL) {
+        close(fd);
+        return VP_ERROR_NO_MEMORY;
+    }
+    file->fd = fd;
+    file->size = (int64_t)st.st_size;
+    COUNT(file, files, 1);
+
+    if (backend == VP_IO_AUTO) {
+        backend = vp_io_uring_available() ? VP_IO_URING : VP_IO_PREAD;
+    }
+    int64_t tail_offset = file->size - FILE_TAIL > FILE_HEAD ? file->size - FILE_TAIL : FILE_HEAD;
+    if (backend == VP_IO_MMAP && file_map(file, tail_offset) != 0) {
+        backend = VP_IO_PREAD;
+    }
+#ifdef VP_HAVE_IO_URING
+    if (backend == VP_IO_URING && (file->ring = ring_create()) == NULL) {
+        backend = VP_IO_PREAD;
+    }
+#else
+    if (backend == VP_IO_URING) {
+        backend = VP_IO_PREAD;
+    }
+#endif
+    file->backend = backend;
+    if (backend != VP_IO_MMAP) {
+        file_prefetch(file, tail_offset);
+    }
+
+    reader->opaque = file;
+    reader->read_at = file_read_at;
+    reader->close = file_close;
+    reader->size = file->size;
+    reader->stats = &file->stats;
+    return VP_OK;
+}
+
+typedef struct {
+    const uint8_t* data;
+    int64_t size;
+} memory_reader;
+
+static int64_t memory_read_at(void* opaque, int64_t offset, void* buf, int64_t size) {
+    memory_reader* memory = (memory_reader*)opaque;
+    if (offset < 0) {
+        return -1;
+    }
+    if (offset >= memory->size) {
+        return 0;
+    }
+    if (size > memory->size - offset) {
+        size = memory->size - offset;
+    }
+    memcpy(buf, memory->data + offset, (size_t)size);
+    return size;
+}
+
+static void memory_close(void* opaque) {
+    free(opaque);
+}
+
+int vp_reader_open_memory(vp_reader* reader, const uint8_t* data, int64_t size) {
+    if (reader == NULL || data == NULL || size <= 0) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+    memset(reader, 0, sizeof(*reader));
+
+    memory_reader* memory = (memory_reader*)malloc(sizeof(memory_reader));
+    if (memory == NULL) {
+        return VP_ERROR_NO_MEMORY;
+    }
+    memory->data = data;
+    memory->size = size;
+
+    reader->opaque = memory;
+    reader->read_at = memory_read_at;
+    reader->close = memory_close;
+    reader->size = size;
+    reader->data = data;
+    return VP_OK;
+}
+
+typedef struct {
+    vp_io_callbacks io;
+    // Position the callbacks are at, so sequential reads skip the seek
+    int64_t position;
+} callback_reader;
+
+static int64_t callback_read_at(void* opaque, int64_t offset, void* buf, int64_t size) {
+    callback_reader* callbacks = (callback_reader*)opaque;
+    if (callbacks->position != offset) {
+        if (callbacks->io.seek(callbacks->io.opaque, offset) != 0) {
+            callbacks->position = -1;
+            return -1;
+        }
+        callbacks->position = offset;
+    }
+    int64_t n = callbacks->io.read(callbacks->io.opaque, (uint8_t*)buf, size);
+    if (n < 0) {
+        callbacks->position = -1;
+        return -1;
+    }
+    callbacks->position += n;
+    return n;
+}
+
+static void callback_close(void* opaque) {
+    free(opaque);
+}
+
+int vp_reader_open_io(vp_reader* reader, const vp_io_callbacks* io) {
+    if (reader == NULL || io == NULL || io->read == NULL || io->seek == NULL) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+    memset(reader, 0, sizeof(*reader));
+
+    callback_reader* callbacks = (callback_reader*)malloc(sizeof(callback_reader));
+    if (callbacks == NULL) {
+        return VP_ERROR_NO_MEMORY;
+    }
+    callbacks->io = *io;
+    // Unknown until the first seek
+    callbacks->position = -1;
+
+    reader->opaque = callbacks;
+    reader->read_at = callback_read_at;
+    reader->close = callback_close;
+    reader->size = io->size != NULL ? io->size(io->opaque) : -1;
+    if (reader->size < 0) {
+        reader->size = -1;
+    }
+    return VP_OK;
+}
+
+typedef struct {
+    vp_reader file;
+    // Downloaded ranges, sorted by offset and merged
+    vp_byte_range* ranges;
+    int count;
+} partial_reader;
+
+static int compare_ranges(const void* a, const void* b) {
+    int64_t x = ((const vp_byte_range*)a)->offset;
+    int64_t y = ((const vp_byte_range*)b)->offset;
+    return x < y ? -1 : x > y;
+}
+
+// Sort and merge overlapping or touching ranges in place; drops empty ones.
+// Returns the new count.
+static int normalize_ranges(vp_byte_range* ranges, int count) {
+    qsort(ranges, (size_t)count, sizeof(vp_byte_range), compare_ranges);
+    int merged = 0;
+    for (int i = 0; i < count; i++) {
+        if (ranges[i].length <= 0) continue;
+        if (merged > 0) {
+            vp_byte_range* last = &ranges[merged - 1];
+            if (ranges[i].offset <= last->offset + last->length) {
+                int64_t end = ranges[i].offset + ranges[i].length;
+                if (end > last->offset + last->length) {
+                    last->length = end - last->offset;
+                }
+                continue;
+            }
+        }
+        ranges[merged++] = ranges[i];
+    }
+    return merged;
+}
+
+static int partial_contains(const partial_reader* partial, int64_t offset, int64_t size) {
+    for (int i = 0; i < partial->count; i++) {
+        const vp_byte_range* r = &partial->ranges[i];
+        if (offset >= r->offset && offset + size <= r->offset + r->length) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int64_t partial_read_at(void* opaque, int64_t offset, void* buf, int64_t size) {
+    partial_reader* partial = (partial_reader*)opaque;
+    if (!partial_contains(partial, offset, size)) {
+        return VP_READ_UNAVAILABLE;
+    }
+    return partial->file.read_at(partial->file.opaque, offset, buf, size);
+}
+
+static void partial_close(void* opaque) {
+    partial_reader* partial = (partial_reader*)opaque;
+    vp_reader_close(&partial->file);
+    free(partial->ranges);
+    free(partial);
+}
+
+int vp_reader_open_partial(vp_reader* reader, const char* path, int64_t total_size,
+                           const vp_byte_range* available, int available_count) {
+    if (total_size <= 0 || available_count < 0 || (available == NULL && available_count > 0)) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+
+    vp_reader file;
+    int status = vp_reader_open_file(&file, path);
+    if (status != VP_OK) {
+        return status;
+    }
+
+    partial_reader* partial = (partial_reader*)calloc(1, sizeof(partial_reader));
+    int count = available != NULL ? available_count : 1;
+    vp_byte_range* ranges = (vp_byte_range*)malloc(sizeof(vp_byte_range) * (size_t)(count > 0 ? count : 1));
+    if (partial == NULL || ranges == NULL) {
+        free(partial);
+        free(ranges);
+        vp_reader_close(&file);
+        return VP_ERROR_NO_MEMORY;
+    }
+
+    if (available != NULL) {
+        memcpy(ranges, available, sizeof(vp_byte_range) * (size_t)count);
+    } else {
+        // Sequential download: everything written so far is present
+        ranges[0].offset = 0;
+        ranges[0].length = file.size;
+    }
+    // Never trust ranges past what is actually on disk
+    for (int i = 0; i < count; i++) {
+        if (ranges[i].offset < 0) ranges[i].length = 0;
+        if (ranges[i].offset + ranges[i].length > file.size) {
+            ranges[i].length = file.size - ranges[i].offset;
+        }
+    }
+
+    partial->file = file;
+    partial->ranges = ranges;
+    partial->count = normalize_ranges(ranges, count);
+
+    memset(reader, 0, sizeof(*reader));
+    reader->opaque = partial;
+    reader->read_at = partial_read_at;
+    reader->close = partial_close;
+    reader->size = total_size;
+    reader->stats = file.stats;
+    return VP_OK;
+}
+
+int vp_reader_partial_missing(const vp_reader* reader, const vp_byte_range* wanted, int wanted_count,
+                              vp_byte_range* out, int capacity) {
+    const partial_reader* partial = (const partial_reader*)reader->opaque;
+
+    vp_byte_range* sorted = (vp_byte_range*)malloc(sizeof(vp_byte_range) * (size_t)(wanted_count > 0 ? wanted_count : 1));
+    if (sorted == NULL) {
+        return 0;
+    }
+    for (int i = 0; i < wanted_count; i++) {
+        sorted[i] = wanted[i];
+        // Clamp to the final file size
+        if (sorted[i].offset < 0) sorted[i].length = 0;
+        if (sorted[i].offset + sorted[i].length > reader->size) {
+            sorted[i].length = reader->size - sorted[i].offset;
+        }
+    }
+    int count = normalize_ranges(sorted, wanted_count);
+
+    int missing = 0;
+    for (int i = 0; i < count; i++) {
+        int64_t pos = sorted[i].offset;
+        int64_t end = sorted[i].offset + sorted[i].length;
+        // Walk the present ranges and emit the gaps between them
+        for (int j = 0; j < partial->count && pos < end; j++) {
+            const vp_byte_range* have = &partial->ranges[j];
+            int64_t have_end = have->offset + have->length;
+            if (have_end <= pos || have->offset >= end) continue;
+            if (have->offset > pos) {
+                if (missing < capacity) {
+                    out[missing].offset = pos;
+                    out[missing].length = have->offset - pos;
+                }
+                missing++;
+            }
+            pos = have_end;
+        }
+        if (pos < end) {
+            if (missing < capacity) {
+                out[missing].offset = pos;
+                out[missing].length = end - pos;
+            }
+            missing++;
+        }
+    }
+    free(sorted);
+    return missing;
+}
+
+int vp_reader_read_full(vp_reader* reader, int64_t offset, void* buf, int64_t size) {
+    unsigned char* dst = (unsigned char*)buf;
+    while (size > 0) {
+        int64_t n = reader->read_at(reader->opaque, offset, dst, size);
+        if (n == VP_READ_UNAVAILABLE) {
+            return VP_READ_UNAVAILABLE;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        vp_metrics_count(VP_COUNTER_BYTES_READ, n);
+        dst += n;
+        offset += n;
+        size -= n;
+    }
+    return 0;
+}
+
+void vp_reader_close(vp_reader* reader) {
+    if (reader == NULL) {
+        return;
+    }
+    if (reader->close != NULL) {
+        reader->close(reader->opaque);
+    }
+    memset(reader, 0, sizeof(*reader));
+}
@@ -8,15 +8,136 @@
 #include <gst/gst.h>
 #include <gst/pbutils/pbutils.h>
 #include <gst/app/gstappsink.h>
+#include <gst/app/gstappsrc.h>
+#include <gst/video/video.h>
+#include <glib/gstdio.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-// Forward declarations from video_probe.h
-double get_duration(const char* path);
-int get_frame_count(const char* path);
-unsigned char* extract_frame(const char* path, int frame_num, int* out_size);
-void free_frame(unsigned char* data);
+#include "video_probe_internal.h"
+
+// Plugins the pipelines here name directly, kept whatever the allowlist
+static const char* const required_plugins[] = {
+    "coreelements", "app", "playback", "typefindfunctions", "pbtypes",
+    "videoconvertscale", "videoconvert", "videoscale", "jpeg", NULL,
+};
+
+// Elements video_probe_warmup() loads; those not installed are skipped
+static const char* const warmup_elements[] = {
+    "uridecodebin", "decodebin", "typefind", "filesrc", "appsrc", "appsink",
+    "qtdemux", "matroskademux", "h264parse", "h265parse", "avdec_h264", "avdec_h265",
+    "videoconvert", "videoscale", "jpegenc", NULL,
+};
+
+static GMutex allowlist_lock;
+// Plugins kept besides required_plugins, NULL to keep every plugin
+static gchar** plugin_allowlist;
+static gboolean gst_initialized;
+
+static gboolean plugin_allowed(const gchar* name) {
+    return g_strv_contains(required_plugins, name) || g_strv_contains((const gchar* const*)plugin_allowlist, name);
+}
+
+// Drops the plugins not allowed from the registry before anything loads
+// them, so autoplugging never picks (or initializes) their elements
+static void apply_plugin_allowlist(void) {
+    GstRegistry* registry = gst_registry_get();
+    GList* plugins = gst_registry_get_plugin_list(registry);
+    for (GList* l = plugins; l != NULL; l = l->next) {
+        GstPlugin* plugin = GST_PLUGIN(l->data);
+        if (!plugin_allowed(gst_plugin_get_name(plugin))) {
+            gst_registry_remove_plugin(registry, plugin);
+        }
+    }
+    gst_plugin_list_free(plugins);
+}
+
+// Initialize GStreamer exactly once, from whichever thread gets here first
+static void ensure_gst_init(void) {
+    static gsize initialized = 0;
+    if (g_once_init_enter(&initialized)) {
+        int64_t start = vp_monotonic_us();
+        gst_init(NULL, NULL);
+        g_mutex_lock(&allowlist_lock);
+        if (plugin_allowlist != NULL) {
+            apply_plugin_allowlist();
+        }
+        gst_initialized = TRUE;
+        g_mutex_unlock(&allowlist_lock);
+        vp_trace_span(0, "gst_init", start, vp_monotonic_us());
+        g_once_init_leave(&initialized, 1);
+    }
+}
+
+static gpointer warmup_thread(gpointer data) {
+    (void)data;
+    ensure_gst_init();
+    int64_t start = vp_monotonic_us();
+    // Creating an element loads its plugin and initializes its class, the
+    // slow part of the first pipeline (libav alone registers hundreds of
+    // decoders)
+    for (int i = 0; warmup_elements[i] != NULL; i++) {
+        GstElementFactory* factory = gst_element_factory_find(warmup_elements[i]);
+        if (factory == NULL) {
+            continue;
+        }
+        GstElement* element = gst_element_factory_create(factory, NULL);
+        if (element != NULL) {
+            gst_object_unref(element);
+        }
+        gst_object_unref(factory);
+    }
+    GstPlugin* typefinders = gst_plugin_load_by_name("typefindfunctions");
+    if (typefinders != NULL) {
+        gst_object_unref(typefinders);
+    }
+    vp_trace_span(0, "warmup", start, vp_monotonic_us());
+    return NULL;
+}
+
+int video_probe_warmup(void) {
+    static gsize started = 0;
+    static int status = VP_OK;
+    if (g_once_init_enter(&started)) {
+        GThread* thread = g_thread_try_new("vp-warmup", warmup_thread, NULL, NULL);
+        if (thread != NULL) {
+            g_thread_unref(thread);
+        } else {
+            status = VP_ERROR_FAILED;
+        }
+        g_once_init_leave(&started, 1);
+    }
+    return status;
+}
+
+int set_plugin_allowlist(const char* const* names, int count) {
+    if (count < 0 || (names == NULL && count > 0)) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+    for (int i = 0; i < count; i++) {
+        if (names[i] == NULL) {
+            return VP_ERROR_INVALID_ARGUMENT;
+        }
+    }
+
+    int status = VP_OK;
+    g_mutex_lock(&allowlist_lock);
+    if (gst_initialized) {
+        status = VP_ERROR_FAILED;
+    } else {
+        g_strfreev(plugin_allowlist);
+        plugin_allowlist = NULL;
+        if (count > 0) {
+            plugin_allowlist = g_new0(gchar*, count + 1);
+            for (int i = 0; i < count; i++) {
+                plugin_allowlist[i] = g_strdup(names[i]);
+            }
+        }
+    }
+    g_mutex_unlock(&allowlist_lock);
+    return status;
+}
 
 // Helper to create file URI from path
 static char* path_to_uri(const char* path) {
@@ -39,104 +160,359 @@ static char* path_to_uri(const char* path) {
     return uri;
 }
 
-// Get video duration in seconds using GstDiscoverer
-double get_duration(const char* path) {
-    if (path == NULL || strlen(path) == 0) {
-        return -1.0;
+static const char* const stage_names[VP_STAGE_COUNT] = {
+    "discovery", "pipeline build", "preroll", "seek", "decode", "convert", "encode",
+};
+
+// Records a completed VP_STAGE_* in the metrics and, while tracing, as a
+// span on `thread` (0 for the calling thread)
+static void stage_done(int64_t thread, int stage, int64_t start, int64_t end) {
+    vp_metrics_record(stage, end - start);
+    vp_trace_span(thread, stage_names[stage], start, end);
+}
+
+// ============================================================================
+// Reader sources
+// ============================================================================
+
+// Data that is not a local file (memory buffers, caller callbacks) is served
+// to GStreamer through an "appsrc://" source in random-access mode, so
+// demuxers can seek exactly as they would in a file.
+#define READER_SOURCE_URI "appsrc://"
+#define READER_SOURCE_CHUNK (64 * 1024)
+
+typedef struct {
+    vp_reader* reader;
+    // need-data and seek-data may arrive on different threads
+    GMutex lock;
+    int64_t offset;
+} reader_feed;
+
+static void reader_feed_free(gpointer data) {
+    reader_feed* feed = (reader_feed*)data;
+    g_mutex_clear(&feed->lock);
+    g_free(feed);
+}
+
+static void reader_feed_need_data(GstAppSrc* src, guint length, gpointer user_data) {
+    reader_feed* feed = (reader_feed*)user_data;
+    vp_reader* reader = feed->reader;
+    if (length == 0 || length > 4 * READER_SOURCE_CHUNK) {
+        length = READER_SOURCE_CHUNK;
     }
 
-    static gboolean gst_initialized = FALSE;
-    if (!gst_initialized) {
-        gst_init(NULL, NULL);
-        gst_initialized = TRUE;
+    g_mutex_lock(&feed->lock);
+    int64_t offset = feed->offset;
+    GstBuffer* buffer = NULL;
+    int64_t n = 0;
+
+    if (reader->data != NULL) {
+        // Wrap the caller's memory instead of copying it; it outlives the
+        // pipeline because every pipeline is torn down before we return.
+        n = reader->size - offset < (int64_t)length ? reader->size - offset : (int64_t)length;
+        if (n > 0) {
+            buffer = gst_buffer_new_wrapped_full(GST_MEMORY_FLAG_READONLY,
+                (gpointer)(reader->data + offset), (gsize)n, 0, (gsize)n, NULL, NULL);
+        }
+    } else {
+        buffer = gst_buffer_new_allocate(NULL, length, NULL);
+        GstMapInfo map;
+        if (buffer && gst_buffer_map(buffer, &map, GST_MAP_WRITE)) {
+            n = reader->read_at(reader->opaque, offset, map.data, (int64_t)length);
+            gst_buffer_unmap(buffer, &map);
+        }
+        if (n > 0) {
+            gst_buffer_set_size(buffer, (gssize)n);
+        }
     }
 
-    char* uri = path_to_uri(path);
-    if (uri == NULL) {
-        return -1.0;
+    if (n > 0) {
+        feed->offset += n;
+        vp_metrics_count(VP_COUNTER_BYTES_READ, n);
+    }
+    g_mutex_unlock(&feed->lock);
+
+    if (n <= 0) {
+        if (buffer) gst_buffer_unref(buffer);
+        gst_app_src_end_of_stream(src);
+        return;
+    }
+    GST_BUFFER_OFFSET(buffer) = (guint64)offset;
+    gst_app_src_push_buffer(src, buffer);
+}
+
+static gboolean reader_feed_seek_data(GstAppSrc* src, guint64 offset, gpointer user_data) {
+    (void)src;
+    reader_feed* feed = (reader_feed*)user_data;
+    if (feed->reader->size >= 0 && offset > (guint64)feed->reader->size) {
+        return FALSE;
+    }
+    g_mutex_lock(&feed->lock);
+    feed->offset = (int64_t)offset;
+    g_mutex_unlock(&feed->lock);
+    return TRUE;
+}
+
+// "source-setup" handler shared by GstDiscoverer and uridecodebin
+static void reader_source_setup(GstElement* owner, GstElement* source, gpointer user_data) {
+    (void)owner;
+    if (!GST_IS_APP_SRC(source)) {
+        return;
+    }
+
+    vp_reader* reader = (vp_reader*)user_data;
+    reader_feed* feed = g_new0(reader_feed, 1);
+    feed->reader = reader;
+    g_mutex_init(&feed->lock);
+
+    g_object_set(source,
+        "stream-type", GST_APP_STREAM_TYPE_RANDOM_ACCESS,
+        "format", GST_FORMAT_BYTES,
+        NULL);
+    gst_app_src_set_size(GST_APP_SRC(source), reader->size);
+
+    GstAppSrcCallbacks callbacks = {0};
+    callbacks.need_data = reader_feed_need_data;
+    callbacks.seek_data = reader_feed_seek_data;
+    gst_app_src_set_callbacks(GST_APP_SRC(source), &callbacks, feed, reader_feed_free);
+}
+
+// ============================================================================
+// Discovery and decoding
+// ============================================================================
+
+typedef struct {
+    GstDiscovererInfo* info;
+    gboolean finished;
+} discovery;
+
+static void on_discovered(GstDiscoverer* discoverer, GstDiscovererInfo* info, GError* error, gpointer user_data) {
+    (void)discoverer;
+    (void)error;
+    discovery* state = (discovery*)user_data;
+    if (info != NULL && state->info == NULL) {
+        state->info = gst_discoverer_info_ref(info);
+    }
+}
+
+static void on_discovery_finished(GstDiscoverer* discoverer, gpointer user_data) {
+    (void)discoverer;
+    ((discovery*)user_data)->finished = TRUE;
+}
+
+static void wake_context(void* data) {
+    g_main_context_wakeup((GMainContext*)data);
+}
+
+static gboolean on_deadline(gpointer user_data) {
+    (void)user_data;
+    return G_SOURCE_REMOVE;
+}
+
+// Run GstDiscoverer on a URI, or on `source` when it is not NULL (uri must
+// then be READER_SOURCE_URI). Discovery runs asynchronously on a private
+// main context so cancelling `call` (may be NULL) or reaching its deadline
+// stops it at once.
+// On VP_OK, *out holds the info; caller must unref it.
+static int discover_uri(const char* uri, vp_reader* source, const vp_call* call, GstDiscovererInfo** out) {
+    *out = NULL;
+    int status = vp_call_check(call);
+    if (status != VP_OK) {
+        return status;
     }
 
+    // The discoverer accepts 1 s to 1 h; shorter deadlines are enforced by
+    // the loop below
+    GstClockTime timeout = (GstClockTime)vp_call_remaining_us(call, 5 * G_USEC_PER_SEC) * GST_USECOND;
+    timeout = CLAMP(timeout, GST_SECOND, 3600 * GST_SECOND);
+
+    GMainContext* context = g_main_context_new();
+    g_main_context_push_thread_default(context);
+
     GError* error = NULL;
-    GstDiscoverer* discoverer = gst_discoverer_new(5 * GST_SECOND, &error);
+    GstDiscoverer* discoverer = gst_discoverer_new(timeout, &error);
     if (error) {
         g_error_free(error);
-        g_free(uri);
-        return -1.0;
+        if (discoverer) g_object_unref(discoverer);
+        g_main_context_pop_thread_default(context);
+        g_main_context_unref(context);
+        return VP_ERROR_FAILED;
     }
 
-    GstDiscovererInfo* info = gst_discoverer_discover_uri(discoverer, uri, &error);
-    g_free(uri);
+    discovery state = { NULL, FALSE };
+    g_signal_connect(discoverer, "discovered", G_CALLBACK(on_discovered), &state);
+    g_signal_connect(discoverer, "finished", G_CALLBACK(on_discovery_finished), &state);
+    if (source) {
+        g_signal_connect(discoverer, "source-setup", G_CALLBACK(reader_source_setup), source);
+    }
 
-    if (error) {
-        g_error_free(error);
-        g_object_unref(discoverer);
-        return -1.0;
+    GSource* deadline = NULL;
+    if (call != NULL && call->deadline_us > 0) {
+        int64_t remaining_ms = vp_call_remaining_us(call, 0) / 1000 + 1;
+        deadline = g_timeout_source_new((guint)MIN(remaining_ms, (int64_t)G_MAXUINT));
+        g_source_set_callback(deadline, on_deadline, NULL, NULL);
+        g_source_attach(deadline, context);
     }
+    vp_cancel_waker waker = { wake_context, context, NULL };
+    vp_cancel_add_waker(call ? call->cancel : NULL, &waker);
 
-    if (info == NULL) {
-        g_object_unref(discoverer);
-        return -1.0;
+    int64_t start = vp_monotonic_us();
+    gst_discoverer_start(discoverer);
+    if (!gst_discoverer_discover_uri_async(discoverer, uri)) {
+        state.finished = TRUE;
+    }
+    while (!state.finished && (status = vp_call_check(call)) == VP_OK) {
+        g_main_context_iteration(context, TRUE);
+    }
+    vp_trace_span(0, "discoverer wait", start, vp_monotonic_us());
+    // Also tears down a discovery still running after cancellation
+    start = vp_monotonic_us();
+    gst_discoverer_stop(discoverer);
+    vp_trace_span(0, "discoverer stop", start, vp_monotonic_us());
+
+    vp_cancel_remove_waker(call ? call->cancel : NULL, &waker);
+    if (deadline) {
+        g_source_destroy(deadline);
+        g_source_unref(deadline);
+    }
+    g_object_unref(discoverer);
+    g_main_context_pop_thread_default(context);
+    g_main_context_unref(context);
+
+    if (status != VP_OK || state.info == NULL) {
+        if (state.info) gst_discoverer_info_unref(state.info);
+        return status != VP_OK ? status : VP_ERROR_FAILED;
     }
 
-    GstDiscovererResult result = gst_discoverer_info_get_result(info);
+    GstDiscovererResult result = gst_discoverer_info_get_result(state.info);
     if (result != GST_DISCOVERER_OK) {
-        gst_discoverer_info_unref(info);
-        g_object_unref(discoverer);
-        return -1.0;
+        gst_discoverer_info_unref(state.info);
+        return result == GST_DISCOVERER_TIMEOUT ? VP_ERROR_TIMEOUT : VP_ERROR_UNSUPPORTED;
     }
 
-    GstClockTime duration_ns = gst_discoverer_info_get_duration(info);
-    double duration_sec = (double)duration_ns / GST_SECOND;
+    *out = state.info;
+    return VP_OK;
+}
 
-    gst_discoverer_info_unref(info);
-    g_object_unref(discoverer);
+static int bit_depth_from_caps(const GstStructure* s) {
+    guint depth = 0;
+    if (gst_structure_get_uint(s, "bit-depth-luma", &depth) && depth > 0) {
+        return (int)depth;
+    }
 
-    return duration_sec;
+    const gchar* format = gst_structure_get_string(s, "format");
+    if (format) {
+        GstVideoFormat video_format = gst_video_format_from_string(format);
+        if (video_format != GST_VIDEO_FORMAT_UNKNOWN) {
+            return (int)GST_VIDEO_FORMAT_INFO_DEPTH(gst_video_format_get_info(video_format), 0);
+        }
+    }
+
+    // Parsers advertise high bit depth through the profile, e.g. "main-10"
+    const gchar* profile = gst_structure_get_string(s, "profile");
+    if (profile) {
+        if (strstr(profile, "12")) return 12;
+        if (strstr(profile, "10")) return 10;
+    }
+    return 8;
 }
 
-// Get frame count by calculating duration * fps
-int get_frame_count(const char* path) {
-    if (path == NULL || strlen(path) == 0) {
-        return -1;
+// Frame rate of the first video stream, or 30 fps if it cannot be determined
+static double discovered_fps(GstDiscovererInfo* info) {
+    double fps = 30.0;
+    GList* video_streams = gst_discoverer_info_get_video_streams(info);
+    if (video_streams) {
+        GstDiscovererVideoInfo* video_info = (GstDiscovererVideoInfo*)video_streams->data;
+        guint fps_num = gst_discoverer_video_info_get_framerate_num(video_info);
+        guint fps_den = gst_discoverer_video_info_get_framerate_denom(video_info);
+        if (fps_num > 0 && fps_den > 0) {
+            fps = (double)fps_num / (double)fps_den;
+        }
+        gst_discoverer_stream_info_list_free(video_streams);
     }
+    return fps;
+}
 
-    static gboolean gst_initialized = FALSE;
-    if (!gst_initialized) {
-        gst_init(NULL, NULL);
-        gst_initialized = TRUE;
+// Size and bit depth of the first video stream, zero if there is none
+static void discovered_frame_size(GstDiscovererInfo* info, int* width, int* height, int* bit_depth) {
+    *width = 0;
+    *height = 0;
+    *bit_depth = 0;
+    GList* video_streams = gst_discoverer_info_get_video_streams(info);
+    if (video_streams) {
+        GstDiscovererVideoInfo* video_info = (GstDiscovererVideoInfo*)video_streams->data;
+        *width = (int)gst_discoverer_video_info_get_width(video_info);
+        *height = (int)gst_discoverer_video_info_get_height(video_info);
+        GstCaps* caps = gst_discoverer_stream_info_get_caps(GST_DISCOVERER_STREAM_INFO(video_info));
+        *bit_depth = caps && gst_caps_get_size(caps) > 0 ? bit_depth_from_caps(gst_caps_get_structure(caps, 0)) : 8;
+        if (caps) gst_caps_unref(caps);
+        gst_discoverer_stream_info_list_free(video_streams);
     }
+}
 
-    char* uri = path_to_uri(path);
-    if (uri == NULL) {
-        return -1;
+// discover_uri() without a call, timed as discovery
+static void timed_discover_uri(const char* uri, vp_reader* source, GstDiscovererInfo** out) {
+    int64_t start = vp_monotonic_us();
+    if (discover_uri(uri, source, NULL, out) == VP_OK) {
+        stage_done(0, VP_STAGE_DISCOVERY, start, vp_monotonic_us());
     }
+}
 
-    GError* error = NULL;
-    GstDiscoverer* discoverer = gst_discoverer_new(5 * GST_SECOND, &error);
-    if (error) {
-        g_error_free(error);
-        g_free(uri);
-        return -1;
+// Discover a local path or file:// URI, or an http(s):// URL through the
+// range-request reader so only the bytes the demuxer asks for are fetched.
+// Returns NULL on failure; caller must unref the info.
+static GstDiscovererInfo* discover_path(const char* path) {
+    GstDiscovererInfo* info = NULL;
+    if (vp_is_http_url(path)) {
+        vp_reader reader;
+        if (vp_reader_open_http(&reader, path, NULL) != VP_OK) {
+            return NULL;
+        }
+        timed_discover_uri(READER_SOURCE_URI, &reader, &info);
+        vp_reader_close(&reader);
+        return info;
     }
 
-    GstDiscovererInfo* info = gst_discoverer_discover_uri(discoverer, uri, &error);
+    char* uri = path_to_uri(path);
+    if (uri == NULL) {
+        return NULL;
+    }
+    timed_discover_uri(uri, NULL, &info);
     g_free(uri);
+    return info;
+}
 
-    if (error) {
-        g_error_free(error);
-        g_object_unref(discoverer);
-        return -1;
+// Get video duration in seconds using GstDiscoverer
+double get_duration(const char* path) {
+    if (path == NULL || strlen(path) == 0) {
+        return -1.0;
     }
 
+    ensure_gst_init();
+
+    GstDiscovererInfo* info = discover_path(path);
     if (info == NULL) {
-        g_object_unref(discoverer);
+        return -1.0;
+    }
+
+    GstClockTime duration_ns = gst_discoverer_info_get_duration(info);
+    double duration_sec = (double)duration_ns / GST_SECOND;
+
+    gst_discoverer_info_unref(info);
+
+    return duration_sec;
+}
+
+// Get frame count by calculating duration * fps
+int get_frame_count(const char* path) {
+    if (path == NULL || strlen(path) == 0) {
         return -1;
     }
 
-    GstDiscovererResult result = gst_discoverer_info_get_result(info);
-    if (result != GST_DISCOVERER_OK) {
-        gst_discoverer_info_unref(info);
-        g_object_unref(discoverer);
+    ensure_gst_init();
+
+    GstDiscovererInfo* info = discover_path(path);
+    if (info == NULL) {
         return -1;
     }
 
@@ -144,193 +520,3202 @@ int get_frame_count(const char* path) {
     GstClockTime duration_ns = gst_discoverer_info_get_duration(info);
     double duration_sec = (double)duration_ns / GST_SECOND;
 
-    // Get video stream info for framerate
+    // Frame count only makes sense for files with a video stream
     GList* video_streams = gst_discoverer_info_get_video_streams(info);
     if (video_streams == NULL) {
         gst_discoverer_info_unref(info);
-        g_object_unref(discoverer);
         return -1;
     }
-
-    GstDiscovererVideoInfo* video_info = (GstDiscovererVideoInfo*)video_streams->data;
-    guint fps_num = gst_discoverer_video_info_get_framerate_num(video_info);
-    guint fps_den = gst_discoverer_video_info_get_framerate_denom(video_info);
-
-    double fps = 30.0; // Default fallback
-    if (fps_den > 0) {
-        fps = (double)fps_num / (double)fps_den;
-    }
-
     gst_discoverer_stream_info_list_free(video_streams);
+
+    double fps = discovered_fps(info);
     gst_discoverer_info_unref(info);
-    g_object_unref(discoverer);
 
     int frame_count = (int)(duration_sec * fps + 0.5); // Round to nearest
     return frame_count > 0 ? frame_count : -1;
 }
 
-// Extract a frame at the given frame number and return as JPEG
-unsigned char* extract_frame(const char* path, int frame_num, int* out_size) {
-    if (path == NULL || strlen(path) == 0 || frame_num < 0 || out_size == NULL) {
-        if (out_size) *out_size = 0;
-        return NULL;
+// Wakes a thread blocked in wait_async_done() on this bus
+static void wake_bus(void* data) {
+    gst_bus_post(GST_BUS(data), gst_message_new_application(NULL, gst_structure_new_empty("video-probe-wake")));
+}
+
+static int pop_async_done(GstElement* pipeline, GstBus* bus, const vp_call* call, GstClockTime fallback) {
+    for (;;) {
+        int status = vp_call_check(call);
+        if (status != VP_OK) {
+            return status;
+        }
+        GstClockTime timeout = (GstClockTime)vp_call_remaining_us(call, (int64_t)(fallback / GST_USECOND)) * GST_USECOND;
+        GstMessage* message = gst_bus_timed_pop_filtered(bus, timeout,
+            GST_MESSAGE_ASYNC_DONE | GST_MESSAGE_ERROR | GST_MESSAGE_APPLICATION);
+        if (message == NULL) {
+            status = vp_call_check(call);
+            return status != VP_OK ? status : VP_ERROR_TIMEOUT;
+        }
+        GstMessageType type = GST_MESSAGE_TYPE(message);
+        gst_message_unref(message);
+        if (type == GST_MESSAGE_ASYNC_DONE) {
+            return VP_OK;
+        }
+        if (type == GST_MESSAGE_ERROR) {
+            // Errors on a secondary stream (e.g. undecodable audio) do not
+            // stop the video branch; only give up if the pipeline did
+            GstStateChangeReturn ret = gst_element_get_state(pipeline, NULL, NULL, 0);
+            if (ret == GST_STATE_CHANGE_FAILURE) {
+                return VP_ERROR_FAILED;
+            }
+            if (ret == GST_STATE_CHANGE_SUCCESS) {
+                return VP_OK;
+            }
+        }
+        // Application messages only wake us up to check the call again
     }
+}
 
-    *out_size = 0;
+// Wait on the bus until `pipeline` completes its pending state change
+// (preroll, or a flushing seek), `call` ends, or `fallback` passes when the
+// call has no deadline of its own.
+static int wait_async_done(GstElement* pipeline, GstBus* bus, const vp_call* call, GstClockTime fallback) {
+    int64_t start = vp_monotonic_us();
+    int status = pop_async_done(pipeline, bus, call, fallback);
+    vp_trace_span(0, "bus wait", start, vp_monotonic_us());
+    return status;
+}
 
-    static gboolean gst_initialized = FALSE;
-    if (!gst_initialized) {
-        gst_init(NULL, NULL);
-        gst_initialized = TRUE;
-    }
+// First buffer since the last reset to pass an element: when, and on
+// which streaming thread
+typedef struct {
+    int64_t at;
+    int64_t thread;
+} stage_mark;
 
-    char* uri = path_to_uri(path);
-    if (uri == NULL) {
-        return NULL;
-    }
+typedef struct {
+    stage_mark decode_in;
+    stage_mark decode_out;
+    stage_mark convert_out;
+    stage_mark encode_out;
+} stage_marks;
 
-    // First, get the framerate to calculate timestamp
-    GError* error = NULL;
-    GstDiscoverer* discoverer = gst_discoverer_new(5 * GST_SECOND, &error);
-    if (error) {
-        g_error_free(error);
-        g_free(uri);
-        return NULL;
-    }
+static void stage_marks_reset(stage_marks* marks) {
+    __atomic_store_n(&marks->decode_in.at, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&marks->decode_out.at, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&marks->convert_out.at, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&marks->encode_out.at, 0, __ATOMIC_RELAXED);
+}
 
-    GstDiscovererInfo* info = gst_discoverer_discover_uri(discoverer, uri, &error);
-    if (error || info == NULL) {
-        if (error) g_error_free(error);
-        g_object_unref(discoverer);
-        g_free(uri);
-        return NULL;
+static GstPadProbeReturn mark_first_buffer(GstPad* pad, GstPadProbeInfo* info, gpointer user_data) {
+    (void)pad;
+    (void)info;
+    stage_mark* mark = (stage_mark*)user_data;
+    if (__atomic_load_n(&mark->at, __ATOMIC_RELAXED) == 0) {
+        int64_t unset = 0;
+        if (__atomic_compare_exchange_n(&mark->at, &unset, vp_monotonic_us(), FALSE, __ATOMIC_RELAXED,
+                                        __ATOMIC_RELAXED)) {
+            __atomic_store_n(&mark->thread, vp_trace_enabled() ? vp_trace_thread_id() : 0, __ATOMIC_RELAXED);
+        }
     }
+    return GST_PAD_PROBE_OK;
+}
 
-    // Check discoverer result
-    GstDiscovererResult result = gst_discoverer_info_get_result(info);
-    if (result != GST_DISCOVERER_OK) {
-        gst_discoverer_info_unref(info);
-        g_object_unref(discoverer);
-        g_free(uri);
-        return NULL;
+static void add_mark_probe(GstElement* element, const char* pad_name, stage_mark* mark) {
+    GstPad* pad = gst_element_get_static_pad(element, pad_name);
+    if (pad) {
+        gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, mark_first_buffer, mark, NULL);
+        gst_object_unref(pad);
     }
+}
 
-    // Get video duration to check if frame is valid
-    GstClockTime duration_ns = gst_discoverer_info_get_duration(info);
+// Marks the video decoder uridecodebin plugs once the stream is typed
+static void on_deep_element_added(GstBin* bin, GstBin* sub_bin, GstElement* element, gpointer user_data) {
+    (void)bin;
+    (void)sub_bin;
+    stage_marks* marks = (stage_marks*)user_data;
+    GstElementFactory* factory = gst_element_get_factory(element);
+    const gchar* klass = factory ? gst_element_factory_get_metadata(factory, GST_ELEMENT_METADATA_KLASS) : NULL;
+    if (klass && strstr(klass, "Decoder") && strstr(klass, "Video")) {
+        add_mark_probe(element, "sink", &marks->decode_in);
+        add_mark_probe(element, "src", &marks->decode_out);
+    }
+}
 
-    GList* video_streams = gst_discoverer_info_get_video_streams(info);
-    double fps = 30.0;
-    if (video_streams) {
-        GstDiscovererVideoInfo* video_info = (GstDiscovererVideoInfo*)video_streams->data;
-        guint fps_num = gst_discoverer_video_info_get_framerate_num(video_info);
-        guint fps_den = gst_discoverer_video_info_get_framerate_denom(video_info);
-        if (fps_den > 0) {
-            fps = (double)fps_num / (double)fps_den;
+// Caps the frame threads of the video decoder uridecodebin plugs, since
+// each thread holds a decoded frame of its own
+static void limit_decoder_threads(GstBin* bin, GstBin* sub_bin, GstElement* element, gpointer user_data) {
+    (void)bin;
+    (void)sub_bin;
+    static const char* const properties[] = { "max-threads", "n-threads", "threads" };
+    GstElementFactory* factory = gst_element_get_factory(element);
+    const gchar* klass = factory ? gst_element_factory_get_metadata(factory, GST_ELEMENT_METADATA_KLASS) : NULL;
+    if (klass == NULL || !strstr(klass, "Decoder") || !strstr(klass, "Video")) {
+        return;
+    }
+    for (size_t i = 0; i < G_N_ELEMENTS(properties); i++) {
+        if (g_object_class_find_property(G_OBJECT_GET_CLASS(element), properties[i])) {
+            g_object_set(element, properties[i], GPOINTER_TO_INT(user_data), NULL);
+            return;
         }
-        gst_discoverer_stream_info_list_free(video_streams);
     }
-    gst_discoverer_info_unref(info);
-    g_object_unref(discoverer);
+}
 
-    // Calculate timestamp for the frame
-    GstClockTime timestamp = (GstClockTime)((double)frame_num / fps * GST_SECOND);
+static void add_named_mark_probe(GstElement* pipeline, const char* name, stage_mark* mark) {
+    GstElement* element = gst_bin_get_by_name(GST_BIN(pipeline), name);
+    if (element) {
+        add_mark_probe(element, "src", mark);
+        gst_object_unref(element);
+    }
+}
 
-    // Check if timestamp is beyond video duration
-    if (timestamp > duration_ns) {
-        g_free(uri);
-        return NULL;
+// Stage between two marks, on the streaming thread that reached the second
+static void record_marked_stage(int stage, const stage_mark* from, const stage_mark* to) {
+    int64_t start = __atomic_load_n(&from->at, __ATOMIC_RELAXED);
+    int64_t end = __atomic_load_n(&to->at, __ATOMIC_RELAXED);
+    if (start > 0 && end >= start) {
+        stage_done(__atomic_load_n(&to->thread, __ATOMIC_RELAXED), stage, start, end);
     }
+}
+
+// Records decode, convert and encode of the frame the marks were last
+// reset for, when each of them was seen
+static void record_frame_stages(const stage_marks* marks) {
+    record_marked_stage(VP_STAGE_DECODE, &marks->decode_in, &marks->decode_out);
+    record_marked_stage(VP_STAGE_CONVERT, &marks->decode_out, &marks->convert_out);
+    record_marked_stage(VP_STAGE_ENCODE, &marks->convert_out, &marks->encode_out);
+}
+
+// Output stages of frame_pipeline_new(). Use I420 format which jpegenc
+// supports well.
+#define JPEG_OUTPUT "video/x-raw,format=I420 ! jpegenc name=encode quality=90"
+#define RGBA_OUTPUT "video/x-raw,format=RGBA"
 
-    // Build pipeline: uridecodebin ! videoconvert ! jpegenc ! appsink
-    // Use I420 format which jpegenc supports well
+// Builds uridecodebin ! videoconvert ! `output` ! appsink for `uri` (or
+// `source`, see discover_uri()), with the scaling and decoder threads of
+// `plan`. `sink_properties` configure the appsink. Returns NULL on failure.
+static GstElement* frame_pipeline_new(const char* uri, vp_reader* source, int width, int height,
+                                      const vp_decode_plan* plan, const char* output, const char* sink_properties) {
+    // Over budget, the frame is scaled down before it is converted.
+    gchar* scale_str = plan->scale > 1 && width > 0 && height > 0
+        ? g_strdup_printf("videoscale name=scale ! video/x-raw,width=%d,height=%d ! ",
+                          MAX(2, (width / plan->scale) & ~1), MAX(2, (height / plan->scale) & ~1))
+        : g_strdup("");
     gchar* pipeline_str = g_strdup_printf(
-        "uridecodebin uri=\"%s\" ! videoconvert ! video/x-raw,format=I420 ! "
-        "jpegenc quality=90 ! appsink name=sink max-buffers=1 drop=true",
-        uri
+        "uridecodebin name=decode uri=\"%s\" ! %svideoconvert name=convert ! %s ! appsink name=sink %s",
+        uri, scale_str, output, sink_properties
     );
-    g_free(uri);
+    g_free(scale_str);
 
+    GError* error = NULL;
     GstElement* pipeline = gst_parse_launch(pipeline_str, &error);
     g_free(pipeline_str);
 
     if (error || pipeline == NULL) {
         if (error) g_error_free(error);
+        if (pipeline) gst_object_unref(pipeline);
         return NULL;
     }
 
+    if (plan->threads > 0) {
+        g_signal_connect(pipeline, "deep-element-added", G_CALLBACK(limit_decoder_threads),
+                         GINT_TO_POINTER(plan->threads));
+    }
+    if (source) {
+        GstElement* decode = gst_bin_get_by_name(GST_BIN(pipeline), "decode");
+        if (decode) {
+            g_signal_connect(decode, "source-setup", G_CALLBACK(reader_source_setup), source);
+            gst_object_unref(decode);
+        }
+    }
+    return pipeline;
+}
+
+// Decode the frame at `timestamp` as a JPEG sample into *out.
+// `source` is as for discover_uri(). The frame is taken from the preroll
+// after a flushing seek, so every wait is on the bus and ends as soon as
+// `call` is cancelled. `width`, `height` and `bit_depth` describe the
+// video stream (0 if unknown) and size the decode to the call's memory
+// budget.
+// Returns VP_OK or an error; on VP_OK the caller must unref *out.
+static int pull_jpeg_sample(const char* uri, vp_reader* source, GstClockTime timestamp, int width, int height,
+                            int bit_depth, const vp_call* call, GstSample** out) {
+    *out = NULL;
+    int status = vp_call_check(call);
+    if (status != VP_OK) {
+        return status;
+    }
+    vp_decode_plan plan;
+    status = vp_budget_acquire(call, width, height, bit_depth, &plan);
+    if (status != VP_OK) {
+        return status;
+    }
+
+    int64_t start = vp_monotonic_us();
+    GstElement* pipeline = frame_pipeline_new(uri, source, width, height, &plan, JPEG_OUTPUT, "max-buffers=1 drop=true");
+    if (pipeline == NULL) {
+        vp_budget_release(call, &plan);
+        return VP_ERROR_FAILED;
+    }
+
     GstElement* sink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
     if (sink == NULL) {
         gst_object_unref(pipeline);
-        return NULL;
+        vp_budget_release(call, &plan);
+        return VP_ERROR_FAILED;
     }
 
-    // Start pipeline and seek to timestamp
-    gst_element_set_state(pipeline, GST_STATE_PAUSED);
-    
-    // Wait for pipeline to preroll
-    GstStateChangeReturn ret = gst_element_get_state(pipeline, NULL, NULL, 10 * GST_SECOND);
+    stage_marks marks;
+    memset(&marks, 0, sizeof(marks));
+    g_signal_connect(pipeline, "deep-element-added", G_CALLBACK(on_deep_element_added), &marks);
+    add_named_mark_probe(pipeline, "convert", &marks.convert_out);
+    add_named_mark_probe(pipeline, "encode", &marks.encode_out);
+
+    GstBus* bus = gst_element_get_bus(pipeline);
+    vp_cancel_waker waker = { wake_bus, bus, NULL };
+    vp_cancel_add_waker(call ? call->cancel : NULL, &waker);
+    stage_done(0, VP_STAGE_PIPELINE_BUILD, start, vp_monotonic_us());
+
+    // Preroll
+    start = vp_monotonic_us();
+    GstStateChangeReturn ret = gst_element_set_state(pipeline, GST_STATE_PAUSED);
+    vp_trace_span(0, "set_state PAUSED", start, vp_monotonic_us());
     if (ret == GST_STATE_CHANGE_FAILURE) {
-        gst_element_set_state(pipeline, GST_STATE_NULL);
-        gst_object_unref(sink);
-        gst_object_unref(pipeline);
-        return NULL;
+        status = VP_ERROR_FAILED;
+    } else if (ret == GST_STATE_CHANGE_ASYNC) {
+        status = wait_async_done(pipeline, bus, call, 10 * GST_SECOND);
     }
 
-    // Seek to the desired timestamp
-    gboolean seek_result = gst_element_seek_simple(
-        pipeline,
-        GST_FORMAT_TIME,
-        GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT,
-        timestamp
-    );
+    if (status == VP_OK) {
+        stage_done(0, VP_STAGE_PREROLL, start, vp_monotonic_us());
 
-    if (!seek_result) {
-        // Seek failed, try without KEY_UNIT flag
-        seek_result = gst_element_seek_simple(
+        // Seek to the desired timestamp. The streaming threads stay blocked
+        // on the prerolled frame until the flush, so from here the marks
+        // only see buffers of the new position.
+        stage_marks_reset(&marks);
+        start = vp_monotonic_us();
+        gboolean seek_result = gst_element_seek_simple(
             pipeline,
             GST_FORMAT_TIME,
-            GST_SEEK_FLAG_FLUSH,
+            GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT,
             timestamp
         );
-    }
 
-    // Wait for seek to complete
-    gst_element_get_state(pipeline, NULL, NULL, 5 * GST_SECOND);
-
-    // Start playing to decode the frame
-    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+        if (!seek_result) {
+            // Seek failed, try without KEY_UNIT flag
+            seek_result = gst_element_seek_simple(
+                pipeline,
+                GST_FORMAT_TIME,
+                GST_SEEK_FLAG_FLUSH,
+                timestamp
+            );
+        }
 
-    // Pull the sample with timeout
-    GstSample* sample = gst_app_sink_try_pull_sample(GST_APP_SINK(sink), 5 * GST_SECOND);
-    
-    unsigned char* frame_result = NULL;
-    
-    if (sample) {
-        GstBuffer* buffer = gst_sample_get_buffer(sample);
-        if (buffer) {
-            GstMapInfo map;
-            if (gst_buffer_map(buffer, &map, GST_MAP_READ)) {
-                frame_result = (unsigned char*)malloc(map.size);
-                if (frame_result) {
-                    memcpy(frame_result, map.data, map.size);
-                    *out_size = (int)map.size;
-                }
-                gst_buffer_unmap(buffer, &map);
+        // Wait for the pipeline to preroll again at the new position;
+        // without a seek the first frame stays prerolled
+        if (seek_result) {
+            status = wait_async_done(pipeline, bus, call, 5 * GST_SECOND);
+            if (status == VP_OK) {
+                // The span runs to the end of the bus wait so that it nests
+                // in the trace
+                int64_t now = vp_monotonic_us();
+                int64_t decode_in = __atomic_load_n(&marks.decode_in.at, __ATOMIC_RELAXED);
+                vp_metrics_record(VP_STAGE_SEEK, (decode_in > 0 ? decode_in : now) - start);
+                vp_trace_span(0, stage_names[VP_STAGE_SEEK], start, now);
+                record_frame_stages(&marks);
             }
         }
-        gst_sample_unref(sample);
     }
 
-    // Cleanup
+    if (status == VP_OK) {
+        *out = gst_app_sink_try_pull_preroll(GST_APP_SINK(sink), 0);
+        if (*out == NULL) {
+            status = VP_ERROR_FAILED;
+        }
+    }
+
+    // Drop pending messages and join the streaming threads, so cancelled
+    // work stops here rather than in the background
+    gst_bus_set_flushing(bus, TRUE);
+    int64_t teardown = vp_monotonic_us();
     gst_element_set_state(pipeline, GST_STATE_NULL);
+    vp_trace_span(0, "set_state NULL", teardown, vp_monotonic_us());
+    vp_cancel_remove_waker(call ? call->cancel : NULL, &waker);
+    gst_object_unref(bus);
     gst_object_unref(sink);
     gst_object_unref(pipeline);
+    vp_budget_release(call, &plan);
+
+    return status;
+}
+
+// What extracting a frame needs to know about its source
+typedef struct {
+    GstClockTime duration;
+    double fps;
+    int width;
+    int height;
+    int bit_depth;
+} frame_timing_info;
+
+// Duration and frame rate needed to turn a frame number into a timestamp,
+// and the frame size the decode is budgeted from.
+// Reader sources try the native parser first so the data is not demuxed
+// twice; files keep using GstDiscoverer.
+static int frame_timing(const char* uri, vp_reader* source, const vp_call* call, frame_timing_info* out) {
+    if (source) {
+        vp_arena* arena = vp_arena_new(0);
+        vp_media_info info;
+        memset(&info, 0, sizeof(info));
+        gboolean found = arena && vp_mp4_probe(source, arena, &info) == VP_OK && info.has_video;
+        if (found) {
+            out->duration = (GstClockTime)(info.duration * GST_SECOND);
+            out->fps = info.fps_num > 0 && info.fps_den > 0 ? (double)info.fps_num / info.fps_den : 30.0;
+            out->width = info.width;
+            out->height = info.height;
+            out->bit_depth = info.bit_depth;
+        }
+        vp_arena_free(arena);
+        if (found) {
+            return VP_OK;
+        }
+    }
+
+    GstDiscovererInfo* info = NULL;
+    int status = discover_uri(uri, source, call, &info);
+    if (status != VP_OK) {
+        return status;
+    }
+    out->duration = gst_discoverer_info_get_duration(info);
+    out->fps = discovered_fps(info);
+    discovered_frame_size(info, &out->width, &out->height, &out->bit_depth);
+    gst_discoverer_info_unref(info);
+    return VP_OK;
+}
+
+// Whether `data` holds one JPEG image: it starts with SOI and no second
+// image follows its EOI, as the second field of an interlaced mjpa sample
+// does
+static gboolean is_single_jpeg(const guint8* data, gsize size) {
+    if (size < 4 || data[0] != 0xFF || data[1] != 0xD8) {
+        return FALSE;
+    }
+    for (gsize i = 2; i + 3 < size; i++) {
+        if (data[i] == 0xFF && data[i + 1] == 0xD9 && data[i + 2] == 0xFF && data[i + 3] == 0xD8) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+// Whether the file at `path` starts like ISO-BMFF, from its first box
+// type, read without setting up a vp_reader
+static gboolean starts_with_mp4_box(const char* path) {
+    guint8 header[8];
+    FILE* file = g_fopen(path, "rb");
+    if (file == NULL) {
+        return FALSE;
+    }
+    gboolean complete = fread(header, 1, sizeof(header), file) == sizeof(header);
+    fclose(file);
+    static const char* const types[] = { "ftyp", "moov", "mdat", "free", "skip", "wide", "pnot" };
+    for (size_t i = 0; complete && i < G_N_ELEMENTS(types); i++) {
+        if (memcmp(header + 4, types[i], 4) == 0) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+// Codecs without inter frames, whose tracks may have every sample as a
+// sync sample
+static gboolean is_intra_codec(const char* codec) {
+    static const char* const codecs[] = { "mjpeg", "prores", "dnxhd", "png" };
+    for (size_t i = 0; codec && i < G_N_ELEMENTS(codecs); i++) {
+        if (strcmp(codec, codecs[i]) == 0) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+// Locates frame `frame_num` of an MP4/MOV source from its moov, so that
+// no GstDiscoverer pass is needed: `timing` is filled from the native
+// probe, and *timestamp is left alone for the caller to derive.
+// On an all-intra track, frame n is sample n and decodes on its own. A
+// Motion JPEG sample already is the JPEG to return, so it is read into
+// *out as stored; otherwise *timestamp and the frame size in `timing`
+// locate the sample. Only such tracks have their sample table built.
+// `source` is as for discover_uri(). Returns VP_OK, VP_ERROR_UNSUPPORTED
+// for sources that are not MP4/MOV or have no video, or the call's
+// cancellation.
+static int find_stored_frame(const char* uri, vp_reader* source, int frame_num, const vp_call* call,
+                             frame_timing_info* timing, GstClockTime* timestamp, GstSample** out) {
+    *out = NULL;
+    vp_reader file;
+    vp_reader* reader = source;
+    if (reader == NULL) {
+        // Other containers are turned away before a reader is set up
+        gchar* path = g_filename_from_uri(uri, NULL, NULL);
+        int opened = path && starts_with_mp4_box(path) ? vp_reader_open_file(&file, path) : VP_ERROR_UNSUPPORTED;
+        g_free(path);
+        if (opened != VP_OK) {
+            return VP_ERROR_UNSUPPORTED;
+        }
+        reader = &file;
+    }
+
+    vp_arena* arena = vp_arena_new(0);
+    vp_media_info info;
+    memset(&info, 0, sizeof(info));
+    int status = arena && vp_mp4_probe(reader, arena, &info) == VP_OK && info.has_video ? VP_OK : VP_ERROR_UNSUPPORTED;
+    if (status == VP_OK) {
+        timing->duration = (GstClockTime)(info.duration * GST_SECOND);
+        timing->fps = info.fps_num > 0 && info.fps_den > 0 ? (double)info.fps_num / info.fps_den : 30.0;
+        timing->width = info.width;
+        timing->height = info.height;
+        timing->bit_depth = info.bit_depth;
+        status = vp_call_check(call);
+    }
+
+    vp_mp4_sample* samples = NULL;
+    int count = 0;
+    vp_stream_info stream = { 0 };
+    // Frame n is only sample n when every sample is a sync sample shown
+    // in decode order
+    gboolean indexed = status == VP_OK && is_intra_codec(info.video_codec) &&
+        vp_mp4_intra_samples(reader, arena, &samples, &count, &stream) == VP_OK && frame_num < count;
+    for (int i = 0; indexed && i < count; i++) {
+        if (!(samples[i].flags & VP_MP4_SAMPLE_SYNC) || (i > 0 && samples[i].time <= samples[i - 1].time)) {
+            indexed = FALSE;
+        }
+    }
+
+    if (indexed) {
+        const vp_mp4_sample* sample = &samples[frame_num];
+        if (strcmp(stream.codec, "mjpeg") == 0 && sample->offset > 0 && sample->size > 0 &&
+            sample->size <= (uint32_t)G_MAXINT) {
+            int64_t start = vp_monotonic_us();
+            guint8* data = (guint8*)g_try_malloc(sample->size);
+            if (data && vp_reader_read_full(reader, sample->offset, data, sample->size) == 0 &&
+                is_single_jpeg(data, sample->size)) {
+                GstBuffer* buffer = gst_buffer_new_wrapped(data, sample->size);
+                GstCaps* caps = gst_caps_new_empty_simple("image/jpeg");
+                *out = gst_sample_new(buffer, caps, NULL, NULL);
+                gst_caps_unref(caps);
+                gst_buffer_unref(buffer);
+                vp_trace_span(0, "read stored frame", start, vp_monotonic_us());
+            } else {
+                // Not a plain JPEG (mjpb, two fields) or unreadable: decode it
+                g_free(data);
+            }
+        }
+
+        if (*out == NULL) {
+            // Halfway to the next frame, so that rounding cannot seek to a
+            // neighbour
+            double frame_duration = count > 1 ? (samples[count - 1].time - samples[0].time) / (count - 1) : 0.0;
+            double next = frame_num + 1 < count ? samples[frame_num + 1].time : sample->time + frame_duration;
+            *timestamp = (GstClockTime)((sample->time + next) / 2.0 * GST_SECOND);
+            timing->width = stream.width;
+            timing->height = stream.height;
+            timing->bit_depth = stream.bit_depth;
+        }
+    }
+
+    vp_arena_free(arena);
+    if (reader == &file) {
+        vp_reader_close(&file);
+    }
+    return status;
+}
+
+// Extract frame `frame_num` of `uri` (or `source`, see discover_uri) into
+// a new frame buffer at *out, or with a NULL `out` into the `capacity`
+// bytes at `dst`. *out_size is the JPEG size, also when it does not fit.
+static int extract_frame_from(const char* uri, vp_reader* source, int frame_num, const vp_call* call,
+                              uint8_t* dst, int capacity, unsigned char** out, int* out_size) {
+    frame_timing_info timing = { 0, 30.0, 0, 0, 0 };
+    GstClockTime timestamp = GST_CLOCK_TIME_NONE;
+    GstSample* sample = NULL;
+    int64_t start = vp_monotonic_us();
+    // MP4/MOV sources are timed from their own index, which for an
+    // all-intra track also locates the frame by itself
+    int status = find_stored_frame(uri, source, frame_num, call, &timing, &timestamp, &sample);
+    if (status == VP_ERROR_UNSUPPORTED) {
+        status = frame_timing(uri, source, call, &timing);
+    }
+    if (status != VP_OK) {
+        return status;
+    }
+    if (sample == NULL && timestamp == GST_CLOCK_TIME_NONE) {
+        // Calculate timestamp for the frame
+        timestamp = (GstClockTime)((double)frame_num / timing.fps * GST_SECOND);
+
+        // Check if timestamp is beyond video duration
+        if (timestamp > timing.duration) {
+            return VP_ERROR_INVALID_ARGUMENT;
+        }
+    }
+    stage_done(0, VP_STAGE_DISCOVERY, start, vp_monotonic_us());
+
+    if (sample == NULL) {
+        status = pull_jpeg_sample(uri, source, timestamp, timing.width, timing.height, timing.bit_depth, call,
+                                  &sample);
+        if (status != VP_OK) {
+            return status;
+        }
+    }
+
+    status = VP_ERROR_FAILED;
+    GstBuffer* buffer = gst_sample_get_buffer(sample);
+    if (buffer) {
+        GstMapInfo map;
+        if (gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+            if (out == NULL) {
+                // Reported either way, so the caller can grow the buffer
+                *out_size = (int)map.size;
+                if (map.size <= (gsize)capacity) {
+                    memcpy(dst, map.data, map.size);
+                    status = VP_OK;
+                } else {
+                    status = VP_ERROR_BUFFER_TOO_SMALL;
+                }
+            } else if ((*out = vp_frame_alloc(map.size)) != NULL) {
+                memcpy(*out, map.data, map.size);
+                *out_size = (int)map.size;
+                status = VP_OK;
+            } else {
+                status = VP_ERROR_NO_MEMORY;
+            }
+            gst_buffer_unmap(buffer, &map);
+        }
+    }
+    gst_sample_unref(sample);
+
+    return status;
+}
+
+// Extract a frame at the given frame number and return as JPEG
+unsigned char* extract_frame(const char* path, int frame_num, int* out_size) {
+    unsigned char* frame_result = NULL;
+    extract_frame_ex(path, frame_num, NULL, &frame_result, out_size);
+    return frame_result;
+}
+
+// extract_frame_from() for a path or URL
+static int extract_frame_path(const char* path, int frame_num, const vp_call_options* options, uint8_t* dst,
+                              int capacity, unsigned char** out, int* out_size) {
+    vp_call call;
+    vp_call_init(&call, options);
+
+    ensure_gst_init();
+
+    if (vp_is_http_url(path)) {
+        vp_reader reader;
+        int status = vp_reader_open_http(&reader, path, &call);
+        if (status != VP_OK) {
+            return status;
+        }
+        status = extract_frame_from(READER_SOURCE_URI, &reader, frame_num, &call, dst, capacity, out, out_size);
+        vp_reader_close(&reader);
+        return status;
+    }
+
+    char* uri = path_to_uri(path);
+    if (uri == NULL) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+
+    int status = extract_frame_from(uri, NULL, frame_num, &call, dst, capacity, out, out_size);
+    g_free(uri);
+    return status;
+}
+
+int extract_frame_ex(const char* path, int frame_num, const vp_call_options* options, unsigned char** out,
+                     int* out_size) {
+    if (out_size) *out_size = 0;
+    if (out) *out = NULL;
+    if (path == NULL || strlen(path) == 0 || frame_num < 0 || out == NULL || out_size == NULL) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+    return extract_frame_path(path, frame_num, options, NULL, 0, out, out_size);
+}
+
+int extract_frame_into(const char* path, int frame_num, const vp_call_options* options, uint8_t* dst, int capacity,
+                       int* out_size) {
+    if (out_size) *out_size = 0;
+    if (path == NULL || strlen(path) == 0 || frame_num < 0 || capacity < 0 || (dst == NULL && capacity > 0) ||
+        out_size == NULL) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+    return extract_frame_path(path, frame_num, options, dst, capacity, NULL, out_size);
+}
 
+static int extract_frame_reader(vp_reader* reader, int frame_num, const vp_call_options* options,
+                                unsigned char** out, int* out_size) {
+    vp_call call;
+    vp_call_init(&call, options);
+    ensure_gst_init();
+    int status = extract_frame_from(READER_SOURCE_URI, reader, frame_num, &call, NULL, 0, out, out_size);
+    vp_reader_close(reader);
+    return status;
+}
+
+unsigned char* extract_frame_buffer(const uint8_t* data, int64_t size, int frame_num, int* out_size) {
+    unsigned char* frame_result = NULL;
+    extract_frame_buffer_ex(data, size, frame_num, NULL, &frame_result, out_size);
+    return frame_result;
+}
+
+int extract_frame_buffer_ex(const uint8_t* data, int64_t size, int frame_num, const vp_call_options* options,
+                            unsigned char** out, int* out_size) {
+    if (out_size) *out_size = 0;
+    if (out) *out = NULL;
+    if (out == NULL || out_size == NULL || frame_num < 0) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+
+    vp_reader reader;
+    int status = vp_reader_open_memory(&reader, data, size);
+    if (status != VP_OK) {
+        return status;
+    }
+    return extract_frame_reader(&reader, frame_num, options, out, out_size);
+}
+
+unsigned char* extract_frame_io(const vp_io_callbacks* io, int frame_num, int* out_size) {
+    unsigned char* frame_result = NULL;
+    extract_frame_io_ex(io, frame_num, NULL, &frame_result, out_size);
     return frame_result;
 }
 
+int extract_frame_io_ex(const vp_io_callbacks* io, int frame_num, const vp_call_options* options,
+                        unsigned char** out, int* out_size) {
+    if (out_size) *out_size = 0;
+    if (out) *out = NULL;
+    if (out == NULL || out_size == NULL || frame_num < 0) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+
+    vp_reader reader;
+    int status = vp_reader_open_io(&reader, io);
+    if (status != VP_OK) {
+        return status;
+    }
+    return extract_frame_reader(&reader, frame_num, options, out, out_size);
+}
+
 void free_frame(unsigned char* data) {
-    if (data) {
-        free(data);
+    vp_frame_free(data);
+}
+
+// ============================================================================
+// Media info
+// ============================================================================
+
+// Map caps to the short codec names used throughout vp_stream_info
+static const char* codec_name_from_caps(vp_arena* arena, const GstCaps* caps) {
+    if (caps == NULL || gst_caps_get_size(caps) == 0) {
+        return "unknown";
+    }
+
+    const GstStructure* s = gst_caps_get_structure(caps, 0);
+    const gchar* name = gst_structure_get_name(s);
+    gint version = 0;
+
+    static const struct { const char* caps; const char* codec; } table[] = {
+        { "video/x-h264", "h264" },
+        { "video/x-h265", "hevc" },
+        { "video/x-vp8", "vp8" },
+        { "video/x-vp9", "vp9" },
+        { "video/x-av1", "av1" },
+        { "video/x-prores", "prores" },
+        { "video/x-dnxhd", "dnxhd" },
+        { "video/x-theora", "theora" },
+        { "video/x-divx", "mpeg4" },
+        { "video/x-xvid", "mpeg4" },
+        { "video/x-wmv", "wmv" },
+        { "image/jpeg", "mjpeg" },
+        { "image/png", "png" },
+        { "audio/x-ac3", "ac3" },
+        { "audio/x-eac3", "eac3" },
+        { "audio/x-opus", "opus" },
+        { "audio/x-vorbis", "vorbis" },
+        { "audio/x-flac", "flac" },
+        { "audio/x-alac", "alac" },
+        { "audio/x-dts", "dts" },
+        { "audio/x-wma", "wma" },
+        { "audio/x-raw", "pcm" },
+        { "text/x-raw", "text" },
+        { "application/x-ssa", "ass" },
+        { "application/x-ass", "ass" },
+        { "subpicture/x-dvd", "dvdsub" },
+        { "subpicture/x-pgs", "pgs" },
+    };
+    for (size_t i = 0; i < G_N_ELEMENTS(table); i++) {
+        if (strcmp(name, table[i].caps) == 0) {
+            return table[i].codec;
+        }
+    }
+
+    if (strcmp(name, "video/mpeg") == 0 && gst_structure_get_int(s, "mpegversion", &version)) {
+        return version == 4 ? "mpeg4" : (version == 2 ? "mpeg2video" : "mpeg1video");
+    }
+    if (strcmp(name, "audio/mpeg") == 0 && gst_structure_get_int(s, "mpegversion", &version)) {
+        return version == 1 ? "mp3" : "aac";
+    }
+
+    // Unknown media type: fall back to its subtype, e.g. "video/x-foo" -> "foo"
+    const char* subtype = strchr(name, '/');
+    subtype = subtype ? subtype + 1 : name;
+    if (strncmp(subtype, "x-", 2) == 0) {
+        subtype += 2;
+    }
+    return vp_arena_strdup(arena, subtype);
+}
+
+static void color_from_caps(const GstStructure* s, vp_stream_info* stream) {
+    stream->color_primaries = 2;
+    stream->transfer = 2;
+
+    const gchar* colorimetry_str = gst_structure_get_string(s, "colorimetry");
+    GstVideoColorimetry colorimetry;
+    if (colorimetry_str == NULL || !gst_video_colorimetry_from_string(&colorimetry, colorimetry_str)) {
+        return;
+    }
+
+    if (colorimetry.primaries != GST_VIDEO_COLOR_PRIMARIES_UNKNOWN) {
+        stream->color_primaries = (int)gst_video_color_primaries_to_iso(colorimetry.primaries);
+    }
+    if (colorimetry.transfer != GST_VIDEO_TRANSFER_UNKNOWN) {
+        stream->transfer = (int)gst_video_transfer_function_to_iso(colorimetry.transfer);
+    }
+    stream->is_hdr = colorimetry.transfer == GST_VIDEO_TRANSFER_SMPTE2084 ||
+                     colorimetry.transfer == GST_VIDEO_TRANSFER_ARIB_STD_B67;
+}
+
+// Parse GST_TAG_IMAGE_ORIENTATION values such as "rotate-90"
+static int rotation_from_tags(const GstTagList* tags) {
+    gchar* orientation = NULL;
+    if (tags == NULL || !gst_tag_list_get_string(tags, GST_TAG_IMAGE_ORIENTATION, &orientation)) {
+        return 0;
+    }
+    int rotation = 0;
+    const char* digits = strpbrk(orientation, "0123456789");
+    if (digits) {
+        rotation = atoi(digits) % 360;
+    }
+    g_free(orientation);
+    return rotation;
+}
+
+static int64_t bitrate_from_tags(const GstTagList* tags) {
+    guint bitrate = 0;
+    if (tags == NULL) {
+        return 0;
+    }
+    if (gst_tag_list_get_uint(tags, GST_TAG_BITRATE, &bitrate) ||
+        gst_tag_list_get_uint(tags, GST_TAG_NOMINAL_BITRATE, &bitrate)) {
+        return (int64_t)bitrate;
+    }
+    return 0;
+}
+
+static void fill_video_stream(vp_arena* arena, GstDiscovererVideoInfo* video, vp_stream_info* stream) {
+    GstDiscovererStreamInfo* base = GST_DISCOVERER_STREAM_INFO(video);
+    GstCaps* caps = gst_discoverer_stream_info_get_caps(base);
+    const GstTagList* tags = gst_discoverer_stream_info_get_tags(base);
+
+    stream->type = VP_STREAM_VIDEO;
+    stream->codec = codec_name_from_caps(arena, caps);
+    stream->width = (int)gst_discoverer_video_info_get_width(video);
+    stream->height = (int)gst_discoverer_video_info_get_height(video);
+    stream->par_num = (int)gst_discoverer_video_info_get_par_num(video);
+    stream->par_den = (int)gst_discoverer_video_info_get_par_denom(video);
+    stream->fps_num = (int)gst_discoverer_video_info_get_framerate_num(video);
+    stream->fps_den = (int)gst_discoverer_video_info_get_framerate_denom(video);
+    stream->bitrate = gst_discoverer_video_info_get_bitrate(video);
+    if (stream->bitrate == 0) {
+        stream->bitrate = bitrate_from_tags(tags);
+    }
+    stream->rotation = rotation_from_tags(tags);
+
+    if (caps && gst_caps_get_size(caps) > 0) {
+        const GstStructure* s = gst_caps_get_structure(caps, 0);
+        stream->bit_depth = bit_depth_from_caps(s);
+        color_from_caps(s, stream);
+    } else {
+        stream->bit_depth = 8;
+        stream->color_primaries = 2;
+        stream->transfer = 2;
+    }
+
+    if (caps) gst_caps_unref(caps);
+}
+
+static void fill_audio_stream(vp_arena* arena, GstDiscovererAudioInfo* audio, vp_stream_info* stream) {
+    GstDiscovererStreamInfo* base = GST_DISCOVERER_STREAM_INFO(audio);
+    GstCaps* caps = gst_discoverer_stream_info_get_caps(base);
+
+    stream->type = VP_STREAM_AUDIO;
+    stream->codec = codec_name_from_caps(arena, caps);
+    stream->language = vp_arena_strdup(arena, gst_discoverer_audio_info_get_language(audio));
+    stream->channels = (int)gst_discoverer_audio_info_get_channels(audio);
+    stream->sample_rate = (int)gst_discoverer_audio_info_get_sample_rate(audio);
+    stream->bit_depth = (int)gst_discoverer_audio_info_get_depth(audio);
+    stream->bitrate = gst_discoverer_audio_info_get_bitrate(audio);
+    if (stream->bitrate == 0) {
+        stream->bitrate = bitrate_from_tags(gst_discoverer_stream_info_get_tags(base));
+    }
+
+    if (caps) gst_caps_unref(caps);
+}
+
+static void fill_subtitle_stream(vp_arena* arena, GstDiscovererSubtitleInfo* subtitle, vp_stream_info* stream) {
+    GstCaps* caps = gst_discoverer_stream_info_get_caps(GST_DISCOVERER_STREAM_INFO(subtitle));
+
+    stream->type = VP_STREAM_SUBTITLE;
+    stream->codec = codec_name_from_caps(arena, caps);
+    stream->language = vp_arena_strdup(arena, gst_discoverer_subtitle_info_get_language(subtitle));
+
+    if (caps) gst_caps_unref(caps);
+}
+
+// Copy the primary video stream into the flattened top-level fields
+static void fill_primary_video(vp_media_info* out, const vp_stream_info* video) {
+    out->has_video = 1;
+    out->video_codec = video->codec;
+    out->width = video->width;
+    out->height = video->height;
+    out->par_num = video->par_num;
+    out->par_den = video->par_den;
+    out->fps_num = video->fps_num;
+    out->fps_den = video->fps_den;
+    out->rotation = video->rotation;
+    out->bit_depth = video->bit_depth;
+    out->color_primaries = video->color_primaries;
+    out->transfer = video->transfer;
+    out->is_hdr = video->is_hdr;
+}
+
+static int64_t file_size_from_uri(const char* uri) {
+    gchar* filename = g_filename_from_uri(uri, NULL, NULL);
+    if (filename == NULL) {
+        return 0;
+    }
+    GStatBuf st;
+    int64_t size = g_stat(filename, &st) == 0 ? (int64_t)st.st_size : 0;
+    g_free(filename);
+    return size;
+}
+
+// Convert a successful discovery into a vp_media_info backed by `arena`.
+// `size_bytes` is the size of the probed data, used when no bitrate tag
+// is present.
+static int media_info_from_discoverer(GstDiscovererInfo* info, int64_t size_bytes, vp_arena* arena, vp_media_info* out) {
+    GstClockTime duration_ns = gst_discoverer_info_get_duration(info);
+    out->duration = GST_CLOCK_TIME_IS_VALID(duration_ns) ? (double)duration_ns / GST_SECOND : 0.0;
+
+    GstDiscovererStreamInfo* top = gst_discoverer_info_get_stream_info(info);
+    if (top) {
+        if (GST_IS_DISCOVERER_CONTAINER_INFO(top)) {
+            GstCaps* caps = gst_discoverer_stream_info_get_caps(top);
+            if (caps && gst_caps_get_size(caps) > 0) {
+                out->container = vp_arena_strdup(arena, gst_structure_get_name(gst_caps_get_structure(caps, 0)));
+            }
+            if (caps) gst_caps_unref(caps);
+        }
+        gst_discoverer_stream_info_unref(top);
+    }
+
+    out->bitrate = bitrate_from_tags(gst_discoverer_info_get_tags(info));
+    if (out->bitrate == 0 && out->duration > 0.0) {
+        out->bitrate = (int64_t)((double)size_bytes * 8.0 / out->duration);
+    }
+
+    GList* streams = gst_discoverer_info_get_stream_list(info);
+    guint capacity = g_list_length(streams);
+    out->streams = (vp_stream_info*)vp_arena_alloc(arena, sizeof(vp_stream_info) * (capacity > 0 ? capacity : 1));
+    if (out->streams == NULL) {
+        gst_discoverer_stream_info_list_free(streams);
+        return VP_ERROR_NO_MEMORY;
+    }
+
+    for (GList* l = streams; l != NULL; l = l->next) {
+        GstDiscovererStreamInfo* stream_info = (GstDiscovererStreamInfo*)l->data;
+        vp_stream_info* stream = &out->streams[out->stream_count];
+
+        if (GST_IS_DISCOVERER_VIDEO_INFO(stream_info)) {
+            GstDiscovererVideoInfo* video = GST_DISCOVERER_VIDEO_INFO(stream_info);
+            // Cover art shows up as a single-image video stream; it is not
+            // a playable track.
+            if (gst_discoverer_video_info_is_image(video)) {
+                continue;
+            }
+            fill_video_stream(arena, video, stream);
+            if (!out->has_video) {
+                fill_primary_video(out, stream);
+            }
+        } else if (GST_IS_DISCOVERER_AUDIO_INFO(stream_info)) {
+            fill_audio_stream(arena, GST_DISCOVERER_AUDIO_INFO(stream_info), stream);
+        } else if (GST_IS_DISCOVERER_SUBTITLE_INFO(stream_info)) {
+            fill_subtitle_stream(arena, GST_DISCOVERER_SUBTITLE_INFO(stream_info), stream);
+        } else {
+            continue;
+        }
+        out->stream_count++;
+    }
+    gst_discoverer_stream_info_list_free(streams);
+
+    if (out->has_video && out->fps_num > 0 && out->fps_den > 0) {
+        out->frame_count = (int64_t)(out->duration * out->fps_num / out->fps_den + 0.5);
+    }
+    return VP_OK;
+}
+
+// Probe a reader source into `arena`: native parser first, then
+// GstDiscoverer through appsrc. The reader stays open.
+static int probe_reader_into_arena(vp_reader* reader, vp_arena* arena, vp_media_info* out, gboolean allow_native,
+                                   const vp_call* call) {
+    if (allow_native && vp_mp4_probe(reader, arena, out) == VP_OK) {
+        return VP_OK;
+    }
+    memset(out, 0, sizeof(*out));
+
+    ensure_gst_init();
+    GstDiscovererInfo* info = NULL;
+    int status = discover_uri(READER_SOURCE_URI, reader, call, &info);
+    if (status != VP_OK) {
+        return status == VP_ERROR_FAILED ? VP_ERROR_UNSUPPORTED : status;
+    }
+    status = media_info_from_discoverer(info, reader->size, arena, out);
+    gst_discoverer_info_unref(info);
+    return status;
+}
+
+// Probe a local file with the native container parser only. Returns
+// VP_ERROR_UNSUPPORTED when it needs a GstDiscoverer pass instead.
+static int probe_file_native(const char* path, vp_arena* arena, vp_media_info* out) {
+    vp_reader reader;
+    int status = vp_reader_open_file(&reader, path);
+    if (status == VP_ERROR_NOT_FOUND) {
+        return status;
+    }
+    if (status == VP_OK) {
+        status = vp_mp4_probe(&reader, arena, out);
+        vp_reader_close(&reader);
+        if (status == VP_OK) {
+            return VP_OK;
+        }
+        memset(out, 0, sizeof(*out));
+    }
+    return VP_ERROR_UNSUPPORTED;
+}
+
+// Probe `path` into `arena`, trying the native container parser before
+// falling back to a GstDiscoverer pass.
+static int probe_into_arena(const char* path, vp_arena* arena, vp_media_info* out, gboolean allow_native,
+                            const vp_call* call) {
+    int status = vp_call_check(call);
+    if (status != VP_OK) {
+        return status;
+    }
+
+    if (vp_is_http_url(path)) {
+        vp_reader reader;
+        status = vp_reader_open_http(&reader, path, call);
+        if (status != VP_OK) {
+            return status;
+        }
+        status = probe_reader_into_arena(&reader, arena, out, allow_native, call);
+        vp_reader_close(&reader);
+        return status;
+    }
+
+    if (allow_native) {
+        status = probe_file_native(path, arena, out);
+        if (status != VP_ERROR_UNSUPPORTED) {
+            return status;
+        }
+    }
+
+    ensure_gst_init();
+
+    char* uri = path_to_uri(path);
+    if (uri == NULL) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+
+    GstDiscovererInfo* info = NULL;
+    status = discover_uri(uri, NULL, call, &info);
+    if (status != VP_OK) {
+        if (status != VP_ERROR_CANCELLED && status != VP_ERROR_TIMEOUT) {
+            gchar* filename = g_filename_from_uri(uri, NULL, NULL);
+            status = filename && !g_file_test(filename, G_FILE_TEST_EXISTS)
+                ? VP_ERROR_NOT_FOUND : VP_ERROR_UNSUPPORTED;
+            g_free(filename);
+        }
+        g_free(uri);
+        return status;
+    }
+
+    status = media_info_from_discoverer(info, file_size_from_uri(uri), arena, out);
+    gst_discoverer_info_unref(info);
+    g_free(uri);
+    return status;
+}
+
+int probe_media_info(const char* path, vp_media_info* out) {
+    return probe_media_info_ex(path, NULL, out);
+}
+
+int probe_media_info_ex(const char* path, const vp_call_options* options, vp_media_info* out) {
+    if (out == NULL) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+    memset(out, 0, sizeof(*out));
+    if (path == NULL || strlen(path) == 0) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+
+    vp_call call;
+    vp_call_init(&call, options);
+
+    vp_arena* arena = vp_arena_new(0);
+    if (arena == NULL) {
+        return VP_ERROR_NO_MEMORY;
+    }
+
+    int64_t start = vp_monotonic_us();
+    int status = probe_into_arena(path, arena, out, TRUE, &call);
+    if (status != VP_OK) {
+        vp_arena_free(arena);
+        memset(out, 0, sizeof(*out));
+        return status;
+    }
+    stage_done(0, VP_STAGE_DISCOVERY, start, vp_monotonic_us());
+    out->arena = arena;
+    return VP_OK;
+}
+
+// Probe a reader source into a new arena. Takes ownership of `reader`.
+static int probe_reader(vp_reader* reader, const vp_call_options* options, vp_media_info* out) {
+    vp_call call;
+    vp_call_init(&call, options);
+
+    vp_arena* arena = vp_arena_new(0);
+    if (arena == NULL) {
+        vp_reader_close(reader);
+        return VP_ERROR_NO_MEMORY;
+    }
+
+    int64_t start = vp_monotonic_us();
+    int status = probe_reader_into_arena(reader, arena, out, TRUE, &call);
+    vp_reader_close(reader);
+    if (status == VP_OK) {
+        stage_done(0, VP_STAGE_DISCOVERY, start, vp_monotonic_us());
+    }
+
+    if (status != VP_OK) {
+        vp_arena_free(arena);
+        memset(out, 0, sizeof(*out));
+        return status;
+    }
+    out->arena = arena;
+    return VP_OK;
+}
+
+int probe_media_info_buffer(const uint8_t* data, int64_t size, vp_media_info* out) {
+    return probe_media_info_buffer_ex(data, size, NULL, out);
+}
+
+int probe_media_info_buffer_ex(const uint8_t* data, int64_t size, const vp_call_options* options,
+                               vp_media_info* out) {
+    if (out == NULL) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+    memset(out, 0, sizeof(*out));
+
+    vp_reader reader;
+    int status = vp_reader_open_memory(&reader, data, size);
+    if (status != VP_OK) {
+        return status;
+    }
+    return probe_reader(&reader, options, out);
+}
+
+int probe_media_info_io(const vp_io_callbacks* io, vp_media_info* out) {
+    return probe_media_info_io_ex(io, NULL, out);
+}
+
+int probe_media_info_io_ex(const vp_io_callbacks* io, const vp_call_options* options, vp_media_info* out) {
+    if (out == NULL) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+    memset(out, 0, sizeof(*out));
+
+    vp_reader reader;
+    int status = vp_reader_open_io(&reader, io);
+    if (status != VP_OK) {
+        return status;
+    }
+    return probe_reader(&reader, options, out);
+}
+
+void free_media_info(vp_media_info* info) {
+    if (info == NULL) {
+        return;
+    }
+    vp_arena_free((vp_arena*)info->arena);
+    memset(info, 0, sizeof(*info));
+}
+
+// ============================================================================
+// Partial files
+// ============================================================================
+
+// GstDiscoverer would block until its timeout on a truncated file, so
+// partial probes only use the native parser.
+int probe_media_info_partial(const char* path, int64_t total_size, const vp_byte_range* available, int available_count, vp_media_info* out, vp_byte_range* needed, int needed_capacity, int* needed_count) {
+    if (out == NULL || needed_count == NULL || needed_capacity < 0 || (needed == NULL && needed_capacity > 0)) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+    memset(out, 0, sizeof(*out));
+    *needed_count = 0;
+    if (path == NULL || strlen(path) == 0) {
+        return VP_ERROR_INVALID_ARGUMENT;
     }
+
+    vp_reader reader;
+    int status = vp_reader_open_partial(&reader, path, total_size, available, available_count);
+    if (status != VP_OK) {
+        return status;
+    }
+
+    vp_arena* arena = vp_arena_new(0);
+    if (arena == NULL) {
+        vp_reader_close(&reader);
+        return VP_ERROR_NO_MEMORY;
+    }
+
+    vp_byte_range wanted[VP_MP4_MAX_NEEDED];
+    int wanted_count = 0;
+    status = vp_mp4_probe_partial(&reader, arena, out, wanted, &wanted_count);
+    if (status == VP_ERROR_NEED_DATA) {
+        *needed_count = vp_reader_partial_missing(&reader, wanted, wanted_count, needed, needed_capacity);
+    }
+    vp_reader_close(&reader);
+
+    if (status != VP_OK) {
+        vp_arena_free(arena);
+        memset(out, 0, sizeof(*out));
+        return status;
+    }
+    out->arena = arena;
+    return VP_OK;
+}
+
+int probe_needed_ranges(const char* path, int64_t total_size, const vp_byte_range* available, int available_count, vp_byte_range* needed, int needed_capacity, int* needed_count) {
+    vp_media_info info;
+    int status = probe_media_info_partial(path, total_size, available, available_count, &info, needed, needed_capacity, needed_count);
+    if (status == VP_OK) {
+        free_media_info(&info);
+    }
+    return status == VP_ERROR_NEED_DATA ? VP_OK : status;
+}
+
+// ============================================================================
+// Discovery service
+// ============================================================================
+
+// A GstDiscoverer works through its URIs one at a time, so the service keeps
+// several, each with at most one URI in flight, on a single context thread.
+#define DEFAULT_DISCOVERY_LANES 4
+
+typedef struct {
+    int64_t id;
+    char* uri;
+    int64_t submitted_us;
+} discovery_item;
+
+typedef struct {
+    vp_discovery_service* service;
+    GstDiscoverer* discoverer;
+    // Item being discovered, NULL while idle; guarded by the service lock
+    discovery_item* current;
+    // Set by discovery_service_cancel(); guarded by the service lock
+    gboolean cancelled;
+    int64_t started_us;
+} discovery_lane;
+
+struct vp_discovery_service {
+    GMutex lock;
+    // Queued discovery_item*, oldest first; guarded by lock
+    GQueue queue;
+    int64_t next_id;
+    gboolean stopping;
+    GMainContext* context;
+    GMainLoop* loop;
+    GThread* thread;
+    discovery_lane* lanes;
+    int lane_count;
+    vp_discovery_callback callback;
+    void* user_data;
+};
+
+static void discovery_item_free(discovery_item* item) {
+    g_free(item->uri);
+    g_free(item);
+}
+
+// Hands a finished item to the callback, never under the service lock.
+// Takes ownership of `item` and of `arena` (may be NULL).
+static void complete_discovery(vp_discovery_service* service, discovery_item* item, int status, int64_t started_us,
+                               vp_arena* arena, const vp_media_info* info) {
+    vp_discovery_result* result = (vp_discovery_result*)calloc(1, sizeof(vp_discovery_result));
+    if (result == NULL) {
+        vp_arena_free(arena);
+        discovery_item_free(item);
+        return;
+    }
+    result->id = item->id;
+    result->status = status;
+    result->queued_us = (started_us > 0 ? started_us : vp_monotonic_us()) - item->submitted_us;
+    if (status == VP_OK) {
+        result->info = *info;
+        result->info.arena = arena;
+    } else {
+        vp_arena_free(arena);
+    }
+    discovery_item_free(item);
+    service->callback(result, service->user_data);
+}
+
+// Maps a finished discovery of `uri` to a VP_* status
+static int discovery_status(GstDiscovererInfo* info, const char* uri) {
+    GstDiscovererResult result = info ? gst_discoverer_info_get_result(info) : GST_DISCOVERER_ERROR;
+    if (result == GST_DISCOVERER_OK) {
+        return VP_OK;
+    }
+    if (result == GST_DISCOVERER_TIMEOUT) {
+        return VP_ERROR_TIMEOUT;
+    }
+    if (result == GST_DISCOVERER_URI_INVALID) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+    gchar* filename = g_filename_from_uri(uri, NULL, NULL);
+    int status = filename && !g_file_test(filename, G_FILE_TEST_EXISTS) ? VP_ERROR_NOT_FOUND : VP_ERROR_UNSUPPORTED;
+    g_free(filename);
+    return status;
+}
+
+// Runs `func` on the service thread. An idle source rather than
+// g_main_context_invoke(), which may run it on the calling thread before
+// the loop has started, and which from a "discovered" handler would run
+// before the discoverer is done with its previous URI.
+static void run_on_service(vp_discovery_service* service, GSourceFunc func) {
+    GSource* source = g_idle_source_new();
+    g_source_set_callback(source, func, service, NULL);
+    g_source_attach(source, service->context);
+    g_source_unref(source);
+}
+
+// Starts queued items on idle lanes. Runs on the service thread.
+static gboolean dispatch_discoveries(gpointer data) {
+    vp_discovery_service* service = (vp_discovery_service*)data;
+    for (int i = 0; i < service->lane_count; i++) {
+        discovery_lane* lane = &service->lanes[i];
+
+        g_mutex_lock(&service->lock);
+        discovery_item* item = NULL;
+        if (lane->current == NULL && !service->stopping) {
+            item = (discovery_item*)g_queue_pop_head(&service->queue);
+            lane->current = item;
+            lane->cancelled = FALSE;
+        }
+        g_mutex_unlock(&service->lock);
+        if (item == NULL) {
+            continue;
+        }
+
+        lane->started_us = vp_monotonic_us();
+        if (!gst_discoverer_discover_uri_async(lane->discoverer, item->uri)) {
+            g_mutex_lock(&service->lock);
+            lane->current = NULL;
+            g_mutex_unlock(&service->lock);
+            complete_discovery(service, item, VP_ERROR_FAILED, lane->started_us, NULL, NULL);
+            i--;
+        }
+    }
+    return G_SOURCE_REMOVE;
+}
+
+static void on_lane_discovered(GstDiscoverer* discoverer, GstDiscovererInfo* info, GError* error, gpointer user_data) {
+    (void)discoverer;
+    (void)error;
+    discovery_lane* lane = (discovery_lane*)user_data;
+    vp_discovery_service* service = lane->service;
+
+    // A lane restarted by a cancel may still report the URI it dropped
+    g_mutex_lock(&service->lock);
+    discovery_item* item = lane->current;
+    gboolean cancelled = lane->cancelled || service->stopping;
+    lane->current = NULL;
+    lane->cancelled = FALSE;
+    g_mutex_unlock(&service->lock);
+    if (item == NULL) {
+        return;
+    }
+
+    int64_t end = vp_monotonic_us();
+    int status = cancelled ? VP_ERROR_CANCELLED : discovery_status(info, item->uri);
+    vp_arena* arena = NULL;
+    vp_media_info media;
+    memset(&media, 0, sizeof(media));
+    if (status == VP_OK) {
+        arena = vp_arena_new(0);
+        status = arena ? media_info_from_discoverer(info, file_size_from_uri(item->uri), arena, &media)
+                       : VP_ERROR_NO_MEMORY;
+    }
+    if (status == VP_OK) {
+        stage_done(0, VP_STAGE_DISCOVERY, lane->started_us, end);
+    }
+    complete_discovery(service, item, status, lane->started_us, arena, &media);
+    run_on_service(service, dispatch_discoveries);
+}
+
+// Drops the URI of every cancelled lane by restarting its discoverer.
+// Runs on the service thread.
+static gboolean restart_cancelled_lanes(gpointer data) {
+    vp_discovery_service* service = (vp_discovery_service*)data;
+    for (int i = 0; i < service->lane_count; i++) {
+        discovery_lane* lane = &service->lanes[i];
+
+        g_mutex_lock(&service->lock);
+        discovery_item* item = lane->cancelled ? lane->current : NULL;
+        if (item) {
+            lane->current = NULL;
+            lane->cancelled = FALSE;
+        }
+        g_mutex_unlock(&service->lock);
+        if (item == NULL) {
+            continue;
+        }
+
+        gst_discoverer_stop(lane->discoverer);
+        gst_discoverer_start(lane->discoverer);
+        complete_discovery(service, item, VP_ERROR_CANCELLED, lane->started_us, NULL, NULL);
+    }
+    dispatch_discoveries(service);
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean stop_discovery_loop(gpointer data) {
+    g_main_loop_quit(((vp_discovery_service*)data)->loop);
+    return G_SOURCE_REMOVE;
+}
+
+static gpointer discovery_thread(gpointer data) {
+    vp_discovery_service* service = (vp_discovery_service*)data;
+    // The discoverers attach to the thread-default context when started
+    g_main_context_push_thread_default(service->context);
+    for (int i = 0; i < service->lane_count; i++) {
+        gst_discoverer_start(service->lanes[i].discoverer);
+    }
+    dispatch_discoveries(service);
+    g_main_loop_run(service->loop);
+
+    for (int i = 0; i < service->lane_count; i++) {
+        discovery_lane* lane = &service->lanes[i];
+        gst_discoverer_stop(lane->discoverer);
+        g_mutex_lock(&service->lock);
+        discovery_item* item = lane->current;
+        lane->current = NULL;
+        g_mutex_unlock(&service->lock);
+        if (item) {
+            complete_discovery(service, item, VP_ERROR_CANCELLED, lane->started_us, NULL, NULL);
+        }
+    }
+    g_main_context_pop_thread_default(service->context);
+    return NULL;
+}
+
+vp_discovery_service* discovery_service_new(int max_in_flight, int64_t timeout_ms, vp_discovery_callback callback,
+                                            void* user_data) {
+    if (callback == NULL || max_in_flight < 0 || timeout_ms < 0) {
+        return NULL;
+    }
+    ensure_gst_init();
+
+    // The discoverer accepts 1 s to 1 h
+    GstClockTime timeout = timeout_ms > 0 ? (GstClockTime)timeout_ms * GST_MSECOND : 5 * GST_SECOND;
+    timeout = CLAMP(timeout, GST_SECOND, 3600 * GST_SECOND);
+
+    vp_discovery_service* service = g_new0(vp_discovery_service, 1);
+    g_mutex_init(&service->lock);
+    g_queue_init(&service->queue);
+    service->callback = callback;
+    service->user_data = user_data;
+    service->lane_count = max_in_flight > 0 ? max_in_flight : DEFAULT_DISCOVERY_LANES;
+    service->lanes = g_new0(discovery_lane, service->lane_count);
+    for (int i = 0; i < service->lane_count; i++) {
+        discovery_lane* lane = &service->lanes[i];
+        lane->service = service;
+        GError* error = NULL;
+        lane->discoverer = gst_discoverer_new(timeout, &error);
+        if (error) {
+            g_error_free(error);
+            if (lane->discoverer) g_object_unref(lane->discoverer);
+            lane->discoverer = NULL;
+            discovery_service_free(service);
+            return NULL;
+        }
+        g_signal_connect(lane->discoverer, "discovered", G_CALLBACK(on_lane_discovered), lane);
+    }
+
+    service->context = g_main_context_new();
+    service->loop = g_main_loop_new(service->context, FALSE);
+    service->thread = g_thread_try_new("vp-discovery", discovery_thread, service, NULL);
+    if (service->thread == NULL) {
+        discovery_service_free(service);
+        return NULL;
+    }
+    return service;
+}
+
+int64_t discovery_service_submit(vp_discovery_service* service, const char* path) {
+    if (service == NULL || path == NULL || path[0] == '\0') {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+    // Other schemes (http, rtsp, ...) go to GStreamer as they are
+    char* uri = gst_uri_is_valid(path) ? g_strdup(path) : path_to_uri(path);
+    if (uri == NULL) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+
+    discovery_item* item = g_new0(discovery_item, 1);
+    item->uri = uri;
+    item->submitted_us = vp_monotonic_us();
+
+    g_mutex_lock(&service->lock);
+    item->id = ++service->next_id;
+    g_queue_push_tail(&service->queue, item);
+    int64_t id = item->id;
+    g_mutex_unlock(&service->lock);
+
+    run_on_service(service, dispatch_discoveries);
+    return id;
+}
+
+static gint compare_item_id(gconstpointer item, gconstpointer id) {
+    return ((const discovery_item*)item)->id == *(const int64_t*)id ? 0 : 1;
+}
+
+int discovery_service_cancel(vp_discovery_service* service, int64_t id) {
+    if (service == NULL || id <= 0) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+
+    g_mutex_lock(&service->lock);
+    discovery_item* queued = NULL;
+    GList* link = g_queue_find_custom(&service->queue, &id, compare_item_id);
+    if (link) {
+        queued = (discovery_item*)link->data;
+        g_queue_delete_link(&service->queue, link);
+    }
+    gboolean running = FALSE;
+    for (int i = 0; queued == NULL && i < service->lane_count; i++) {
+        discovery_lane* lane = &service->lanes[i];
+        if (lane->current && lane->current->id == id) {
+            lane->cancelled = TRUE;
+            running = TRUE;
+        }
+    }
+    g_mutex_unlock(&service->lock);
+
+    if (queued) {
+        complete_discovery(service, queued, VP_ERROR_CANCELLED, 0, NULL, NULL);
+    } else if (running) {
+        run_on_service(service, restart_cancelled_lanes);
+    }
+    return queued || running ? VP_OK : VP_ERROR_NOT_FOUND;
+}
+
+void discovery_service_free(vp_discovery_service* service) {
+    if (service == NULL) {
+        return;
+    }
+
+    g_mutex_lock(&service->lock);
+    service->stopping = TRUE;
+    g_queue_clear_full(&service->queue, (GDestroyNotify)discovery_item_free);
+    g_mutex_unlock(&service->lock);
+
+    if (service->thread) {
+        run_on_service(service, stop_discovery_loop);
+        g_thread_join(service->thread);
+    }
+    if (service->loop) g_main_loop_unref(service->loop);
+    if (service->context) g_main_context_unref(service->context);
+    for (int i = 0; i < service->lane_count; i++) {
+        if (service->lanes[i].discoverer) g_object_unref(service->lanes[i].discoverer);
+    }
+    g_free(service->lanes);
+    g_mutex_clear(&service->lock);
+    g_free(service);
+}
+
+void free_discovery_result(vp_discovery_result* result) {
+    if (result == NULL) {
+        return;
+    }
+    vp_arena_free((vp_arena*)result->info.arena);
+    free(result);
+}
+
+// ============================================================================
+// Embedded thumbnails
+// ============================================================================
+
+// The image stored in the MP4/MOV or Matroska data of `reader`, copied
+// into `arena`
+static int read_embedded_image(vp_reader* reader, vp_arena* arena, vp_embedded_image* out) {
+    int status = vp_mp4_cover(reader, arena, out);
+    if (status == VP_ERROR_UNSUPPORTED) {
+        status = vp_mkv_cover(reader, arena, out);
+    }
+    return status;
+}
+
+// read_embedded_image() for a path or URL
+static int read_embedded_image_path(const char* path, const vp_call* call, vp_arena* arena, vp_embedded_image* out) {
+    vp_reader reader;
+    int status = vp_is_http_url(path) ? vp_reader_open_http(&reader, path, call) : vp_reader_open_file(&reader, path);
+    if (status != VP_OK) {
+        return status;
+    }
+    int64_t start = vp_monotonic_us();
+    status = read_embedded_image(&reader, arena, out);
+    vp_trace_span(0, "embedded image", start, vp_monotonic_us());
+    vp_reader_close(&reader);
+    // HTTP reads fail once the call is cancelled; report why
+    if (status != VP_OK && vp_call_check(call) != VP_OK) {
+        status = vp_call_check(call);
+    }
+    return status;
+}
+
+int get_embedded_thumbnail(const char* path, const vp_call_options* options, uint8_t** out, int* out_size,
+                           int* out_format) {
+    if (out_size) *out_size = 0;
+    if (out) *out = NULL;
+    if (out_format) *out_format = 0;
+    if (path == NULL || strlen(path) == 0 || out == NULL || out_size == NULL) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+
+    vp_call call;
+    vp_call_init(&call, options);
+    vp_arena* arena = vp_arena_new(0);
+    if (arena == NULL) {
+        return VP_ERROR_NO_MEMORY;
+    }
+
+    vp_embedded_image image;
+    int status = read_embedded_image_path(path, &call, arena, &image);
+    if (status == VP_OK) {
+        if ((*out = vp_frame_alloc(image.size)) != NULL) {
+            memcpy(*out, image.data, image.size);
+            *out_size = (int)image.size;
+            if (out_format) *out_format = image.format;
+        } else {
+            status = VP_ERROR_NO_MEMORY;
+        }
+    }
+    vp_arena_free(arena);
+    return status;
+}
+
+// ============================================================================
+// Batch probing
+// ============================================================================
+
+typedef struct {
+    const char* const* paths;
+    int count;
+    vp_batch_options options;
+    // Deadline and cancellation shared by every file
+    vp_call call;
+    vp_batch_item* items;
+    // Next unclaimed index; workers take files one at a time so slow files
+    // do not hold up a whole pre-assigned slice.
+    gint next_index;
+    GMutex lock;
+    vp_arena* arena;
+    // Files the native parser cannot read go to a discovery service, started
+    // on first use, so several GstDiscoverer passes overlap while the
+    // workers carry on. The fields below are guarded by lock.
+    vp_discovery_service* service;
+    int service_lanes;
+    // Discovery id -> item index
+    GHashTable* discovering;
+    // Discovered item indices still needing a thumbnail
+    GQueue discovered;
+    // Status of discoveries cut short by cancellation or the deadline
+    int stop_status;
+    GCond changed;
+} batch_job;
+
+// Whether `item` gets a thumbnail: a frame of a video, or with
+// VP_BATCH_EMBEDDED_THUMBNAILS also the cover of an audio file
+static gboolean batch_wants_thumbnail(const batch_job* job, const vp_batch_item* item) {
+    int flags = job->options.flags;
+    return (flags & VP_BATCH_THUMBNAILS) && (item->info.has_video || (flags & VP_BATCH_EMBEDDED_THUMBNAILS));
+}
+
+static void batch_thumbnail(batch_job* job, const char* path, vp_arena* arena, vp_batch_item* item) {
+    // A stored image needs no decoder at all
+    if (job->options.flags & VP_BATCH_EMBEDDED_THUMBNAILS) {
+        vp_embedded_image image;
+        if (read_embedded_image_path(path, &job->call, arena, &image) == VP_OK && image.size <= (size_t)G_MAXINT) {
+            item->thumbnail = image.data;
+            item->thumbnail_size = (int)image.size;
+            item->thumbnail_format = image.format;
+            return;
+        }
+    }
+    if (!item->info.has_video) {
+        return;
+    }
+
+    double fps = item->info.fps_num > 0 && item->info.fps_den > 0
+        ? (double)item->info.fps_num / item->info.fps_den : 30.0;
+    double seconds = (double)job->options.thumbnail_frame / fps;
+    if (seconds > item->info.duration) {
+        return;
+    }
+
+    ensure_gst_init();
+    GstClockTime timestamp = (GstClockTime)(seconds * GST_SECOND);
+    GstSample* sample = NULL;
+    if (vp_is_http_url(path)) {
+        vp_reader reader;
+        if (vp_reader_open_http(&reader, path, &job->call) == VP_OK) {
+            pull_jpeg_sample(READER_SOURCE_URI, &reader, timestamp, item->info.width, item->info.height,
+                             item->info.bit_depth, &job->call, &sample);
+            vp_reader_close(&reader);
+        }
+    } else {
+        char* uri = path_to_uri(path);
+        if (uri == NULL) {
+            return;
+        }
+        pull_jpeg_sample(uri, NULL, timestamp, item->info.width, item->info.height, item->info.bit_depth,
+                         &job->call, &sample);
+        g_free(uri);
+    }
+    if (sample == NULL) {
+        return;
+    }
+
+    GstBuffer* buffer = gst_sample_get_buffer(sample);
+    GstMapInfo map;
+    if (buffer && gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+        uint8_t* copy = (uint8_t*)vp_arena_alloc(arena, map.size);
+        if (copy) {
+            memcpy(copy, map.data, map.size);
+            item->thumbnail = copy;
+            item->thumbnail_size = (int)map.size;
+            item->thumbnail_format = VP_IMAGE_JPEG;
+        }
+        gst_buffer_unmap(buffer, &map);
+    }
+    gst_sample_unref(sample);
+}
+
+static void on_batch_discovered(vp_discovery_result* result, void* user_data) {
+    batch_job* job = (batch_job*)user_data;
+    g_mutex_lock(&job->lock);
+    gpointer value;
+    if (g_hash_table_lookup_extended(job->discovering, &result->id, NULL, &value)) {
+        g_hash_table_remove(job->discovering, &result->id);
+        int index = GPOINTER_TO_INT(value);
+        vp_batch_item* item = &job->items[index];
+        item->status = result->status == VP_ERROR_CANCELLED && job->stop_status != VP_OK
+            ? job->stop_status : result->status;
+        if (result->status == VP_OK) {
+            item->info = result->info;
+            item->info.arena = NULL;
+            vp_arena_merge(job->arena, (vp_arena*)result->info.arena);
+            result->info.arena = NULL;
+            if (batch_wants_thumbnail(job, item)) {
+                g_queue_push_tail(&job->discovered, GINT_TO_POINTER(index));
+            }
+        }
+        g_cond_broadcast(&job->changed);
+    }
+    g_mutex_unlock(&job->lock);
+    free_discovery_result(result);
+}
+
+// Queues item `index` on the batch's discovery service. Returns FALSE if
+// the service cannot be started.
+static gboolean batch_discover(batch_job* job, int index) {
+    g_mutex_lock(&job->lock);
+    if (job->service == NULL) {
+        int64_t timeout_ms = vp_call_remaining_us(&job->call, 5 * G_USEC_PER_SEC) / 1000;
+        job->service = discovery_service_new(job->service_lanes, MAX(timeout_ms, 1), on_batch_discovered, job);
+    }
+    // The id is mapped before the lock is released, so the result cannot
+    // arrive first
+    int64_t id = job->service ? discovery_service_submit(job->service, job->paths[index]) : VP_ERROR_FAILED;
+    if (id > 0) {
+        int64_t* key = g_new(int64_t, 1);
+        *key = id;
+        g_hash_table_insert(job->discovering, key, GINT_TO_POINTER(index));
+    }
+    g_mutex_unlock(&job->lock);
+    return id > 0;
+}
+
+// Waits on job->changed until the deadline at most. Called with the lock held.
+static void batch_wait(batch_job* job) {
+    if (job->call.deadline_us > 0) {
+        g_cond_wait_until(&job->changed, &job->lock,
+                          g_get_monotonic_time() + vp_call_remaining_us(&job->call, 0));
+    } else {
+        g_cond_wait(&job->changed, &job->lock);
+    }
+}
+
+// Waits for the next discovered item needing a thumbnail. Returns its
+// index, or -1 once every discovery has finished or the batch is cancelled
+// or out of time.
+static int batch_next_discovered(batch_job* job) {
+    g_mutex_lock(&job->lock);
+    while (g_queue_is_empty(&job->discovered) && g_hash_table_size(job->discovering) > 0 &&
+           vp_call_check(&job->call) == VP_OK) {
+        batch_wait(job);
+    }
+    int index = g_queue_is_empty(&job->discovered) ? -1 : GPOINTER_TO_INT(g_queue_pop_head(&job->discovered));
+    g_mutex_unlock(&job->lock);
+    return index;
+}
+
+static void wake_batch(void* data) {
+    batch_job* job = (batch_job*)data;
+    g_mutex_lock(&job->lock);
+    g_cond_broadcast(&job->changed);
+    g_mutex_unlock(&job->lock);
+}
+
+static gpointer batch_worker(gpointer data) {
+    batch_job* job = (batch_job*)data;
+    vp_arena* arena = vp_arena_new(64 * 1024);
+    gboolean allow_native = !(job->options.flags & VP_BATCH_GSTREAMER_ONLY);
+
+    for (;;) {
+        int index = g_atomic_int_add(&job->next_index, 1);
+        if (index >= job->count) {
+            break;
+        }
+
+        vp_batch_item* item = &job->items[index];
+        const char* path = job->paths[index];
+        if (arena == NULL) {
+            item->status = VP_ERROR_NO_MEMORY;
+            continue;
+        }
+        if (path == NULL || path[0] == '\0') {
+            item->status = VP_ERROR_INVALID_ARGUMENT;
+            continue;
+        }
+
+        // Once the batch is cancelled or out of time the remaining files
+        // fail fast with the same status
+        int64_t start = vp_monotonic_us();
+        if (vp_is_http_url(path)) {
+            item->status = probe_into_arena(path, arena, &item->info, allow_native, &job->call);
+        } else {
+            item->status = vp_call_check(&job->call);
+            if (item->status == VP_OK) {
+                item->status = allow_native ? probe_file_native(path, arena, &item->info) : VP_ERROR_UNSUPPORTED;
+            }
+            if (item->status == VP_ERROR_UNSUPPORTED) {
+                if (batch_discover(job, index)) {
+                    continue;
+                }
+                item->status = probe_into_arena(path, arena, &item->info, FALSE, &job->call);
+            }
+        }
+        if (item->status != VP_OK) {
+            memset(&item->info, 0, sizeof(item->info));
+            continue;
+        }
+        stage_done(0, VP_STAGE_DISCOVERY, start, vp_monotonic_us());
+        if (batch_wants_thumbnail(job, item)) {
+            batch_thumbnail(job, path, arena, item);
+        }
+    }
+
+    // Discoveries finish on the service thread; their thumbnails are taken
+    // here once the worker runs out of files
+    if (arena && (job->options.flags & VP_BATCH_THUMBNAILS)) {
+        for (int index; (index = batch_next_discovered(job)) >= 0;) {
+            batch_thumbnail(job, job->paths[index], arena, &job->items[index]);
+        }
+    }
+
+    // Hand this worker's allocations to the result so they are released
+    // together with it.
+    g_mutex_lock(&job->lock);
+    vp_arena_merge(job->arena, arena);
+    g_mutex_unlock(&job->lock);
+    return NULL;
+}
+
+int probe_batch(const char* const* paths, int count, const vp_batch_options* options, vp_batch_result* out) {
+    if (out == NULL) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+    memset(out, 0, sizeof(*out));
+    if (paths == NULL || count < 0) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+
+    vp_arena* arena = vp_arena_new(64 * 1024);
+    if (arena == NULL) {
+        return VP_ERROR_NO_MEMORY;
+    }
+    vp_batch_item* items = (vp_batch_item*)vp_arena_alloc(arena, sizeof(vp_batch_item) * (size_t)(count > 0 ? count : 1));
+    if (items == NULL) {
+        vp_arena_free(arena);
+        return VP_ERROR_NO_MEMORY;
+    }
+
+    batch_job job;
+    memset(&job, 0, sizeof(job));
+    job.paths = paths;
+    job.count = count;
+    job.items = items;
+    job.arena = arena;
+    if (options) {
+        job.options = *options;
+    }
+    vp_call_init(&job.call, &job.options.call);
+    g_mutex_init(&job.lock);
+    g_cond_init(&job.changed);
+    job.discovering = g_hash_table_new_full(g_int64_hash, g_int64_equal, g_free, NULL);
+    g_queue_init(&job.discovered);
+
+    int workers = job.options.max_workers > 0 ? job.options.max_workers : (int)g_get_num_processors();
+    if (workers > count) {
+        workers = count;
+    }
+
+    job.service_lanes = MIN(workers, DEFAULT_DISCOVERY_LANES);
+
+    vp_cancel_waker waker = { wake_batch, &job, NULL };
+    vp_cancel_add_waker(job.call.cancel, &waker);
+    GThread** threads = g_new0(GThread*, workers > 0 ? workers : 1);
+    for (int i = 0; i < workers; i++) {
+        threads[i] = g_thread_new("vp-batch", batch_worker, &job);
+    }
+    for (int i = 0; i < workers; i++) {
+        g_thread_join(threads[i]);
+    }
+    g_free(threads);
+
+    if (job.service) {
+        g_mutex_lock(&job.lock);
+        while (g_hash_table_size(job.discovering) > 0 && vp_call_check(&job.call) == VP_OK) {
+            batch_wait(&job);
+        }
+        job.stop_status = vp_call_check(&job.call);
+        g_mutex_unlock(&job.lock);
+        // Reports discoveries still running; queued ones are dropped silently
+        discovery_service_free(job.service);
+
+        GHashTableIter iter;
+        gpointer value;
+        g_hash_table_iter_init(&iter, job.discovering);
+        while (g_hash_table_iter_next(&iter, NULL, &value)) {
+            items[GPOINTER_TO_INT(value)].status = job.stop_status;
+        }
+    }
+    vp_cancel_remove_waker(job.call.cancel, &waker);
+    g_queue_clear(&job.discovered);
+    g_hash_table_destroy(job.discovering);
+    g_cond_clear(&job.changed);
+    g_mutex_clear(&job.lock);
+
+    out->count = count;
+    out->items = items;
+    out->arena = arena;
+    return VP_OK;
+}
+
+void free_batch_result(vp_batch_result* result) {
+    if (result == NULL) {
+        return;
+    }
+    vp_arena_free((vp_arena*)result->arena);
+    memset(result, 0, sizeof(*result));
+}
+
+// ============================================================================
+// Frame sets
+// ============================================================================
+
+// Events the frame pickers below watch besides buffers
+#define PICKER_EVENTS (GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM | GST_PAD_PROBE_TYPE_EVENT_FLUSH)
+
+// Stream time of `buffer` in `segment`, the last segment on its pad, or
+// GST_CLOCK_TIME_NONE outside it. Seeks and container indexes use stream
+// time, while demuxers may timestamp in media time (qtdemux does with an
+// edit list).
+static GstClockTime buffer_stream_time(const GstSegment* segment, GstBuffer* buffer) {
+    if (!GST_BUFFER_PTS_IS_VALID(buffer)) {
+        return GST_CLOCK_TIME_NONE;
+    }
+    if (segment->format != GST_FORMAT_TIME) {
+        return GST_BUFFER_PTS(buffer);
+    }
+    return gst_segment_to_stream_time(segment, GST_FORMAT_TIME, GST_BUFFER_PTS(buffer));
+}
+
+// Without a keyframe index, frames further apart than this start a new
+// segment: seeking again is cheaper than decoding forward through a GOP
+#define SEGMENT_GAP (2 * GST_SECOND)
+
+typedef struct {
+    // The middle of the frame, so rounding cannot pick its neighbour
+    GstClockTime timestamp;
+    // Index into frame_nums
+    int index;
+} frame_target;
+
+// Consecutive targets decoded from one seek
+typedef struct {
+    int first;
+    int count;
+} frame_segment;
+
+typedef struct {
+    const char* uri;
+    vp_reader* source;
+    frame_timing_info timing;
+    // Deadline, cancellation and budget shared by every segment
+    vp_call call;
+    // Sorted by timestamp
+    frame_target* targets;
+    frame_segment* segments;
+    int segment_count;
+    int longest_segment;
+    vp_frame_item* items;
+    // Next unclaimed segment
+    gint next_segment;
+    GMutex lock;
+    vp_arena* arena;
+} frames_job;
+
+// Which decoded frames of a segment go on to be encoded, decided on the
+// streaming thread ahead of conversion
+typedef struct {
+    GMutex lock;
+    // Lets every frame through until the first segment, so the pipeline
+    // can preroll
+    gboolean pass_all;
+    // Set by the flush of the segment's seek; frames before it belong to
+    // an earlier position
+    gboolean armed;
+    const frame_target* targets;
+    int count;
+    // Targets covered by a passed frame so far
+    int covered;
+    // How many targets each passed frame covers, in order
+    int* covers;
+    int passed;
+    GstClockTime frame_duration;
+    // Last segment on the pad, which maps buffer timestamps to stream time
+    GstSegment segment;
+} frame_picker;
+
+typedef struct {
+    GstElement* pipeline;
+    GstElement* sink;
+    GstBus* bus;
+    vp_cancel_waker waker;
+    vp_decode_plan plan;
+    frame_picker picker;
+} frame_decoder;
+
+static int compare_targets(const void* a, const void* b) {
+    const frame_target* x = (const frame_target*)a;
+    const frame_target* y = (const frame_target*)b;
+    if (x->timestamp != y->timestamp) {
+        return x->timestamp < y->timestamp ? -1 : 1;
+    }
+    return x->index - y->index;
+}
+
+// Index of the last keyframe at or before `seconds`, -1 before the first
+static int keyframe_before(const double* keyframes, int count, double seconds) {
+    int low = 0;
+    int high = count;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (keyframes[mid] <= seconds) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low - 1;
+}
+
+// Drops decoded frames that no target of the segment needs, so only the
+// wanted ones are converted and encoded
+static GstPadProbeReturn pick_frames(GstPad* pad, GstPadProbeInfo* info, gpointer user_data) {
+    (void)pad;
+    frame_picker* picker = (frame_picker*)user_data;
+    if (GST_PAD_PROBE_INFO_TYPE(info) & PICKER_EVENTS) {
+        GstEvent* event = GST_PAD_PROBE_INFO_EVENT(info);
+        g_mutex_lock(&picker->lock);
+        if (GST_EVENT_TYPE(event) == GST_EVENT_FLUSH_STOP) {
+            picker->armed = picker->targets != NULL;
+        } else if (GST_EVENT_TYPE(event) == GST_EVENT_SEGMENT) {
+            gst_event_copy_segment(event, &picker->segment);
+        }
+        g_mutex_unlock(&picker->lock);
+        return GST_PAD_PROBE_OK;
+    }
+
+    GstBuffer* buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    GstPadProbeReturn ret = GST_PAD_PROBE_DROP;
+    g_mutex_lock(&picker->lock);
+    GstClockTime time = buffer_stream_time(&picker->segment, buffer);
+    if (picker->pass_all) {
+        ret = GST_PAD_PROBE_OK;
+    } else if (picker->armed && GST_CLOCK_TIME_IS_VALID(time)) {
+        GstClockTime end = time +
+            (GST_BUFFER_DURATION_IS_VALID(buffer) ? GST_BUFFER_DURATION(buffer) : picker->frame_duration);
+        // A frame covers every target up to its end, including any that
+        // fell in a gap before it
+        int covers = 0;
+        while (picker->covered + covers < picker->count && picker->targets[picker->covered + covers].timestamp < end) {
+            covers++;
+        }
+        if (covers > 0) {
+            picker->covers[picker->passed++] = covers;
+            picker->covered += covers;
+            ret = GST_PAD_PROBE_OK;
+        }
+    }
+    g_mutex_unlock(&picker->lock);
+    return ret;
+}
+
+// appsink new-sample callback: wakes the worker waiting on the bus
+static GstFlowReturn on_frame_sample(GstAppSink* sink, gpointer user_data) {
+    (void)sink;
+    wake_bus(user_data);
+    return GST_FLOW_OK;
+}
+
+static void frame_decoder_close(frame_decoder* decoder, const vp_call* call) {
+    if (decoder->pipeline == NULL) {
+        return;
+    }
+    gst_bus_set_flushing(decoder->bus, TRUE);
+    int64_t teardown = vp_monotonic_us();
+    gst_element_set_state(decoder->pipeline, GST_STATE_NULL);
+    vp_trace_span(0, "set_state NULL", teardown, vp_monotonic_us());
+    vp_cancel_remove_waker(call->cancel, &decoder->waker);
+    gst_object_unref(decoder->bus);
+    gst_object_unref(decoder->sink);
+    gst_object_unref(decoder->pipeline);
+    vp_budget_release(call, &decoder->plan);
+    decoder->pipeline = NULL;
+}
+
+// Builds the worker's pipeline and prerolls it; segments then only seek
+static int frame_decoder_open(frame_decoder* decoder, const frames_job* job) {
+    int status = vp_budget_acquire(&job->call, job->timing.width, job->timing.height, job->timing.bit_depth,
+                                   &decoder->plan);
+    if (status != VP_OK) {
+        return status;
+    }
+
+    int64_t start = vp_monotonic_us();
+    // The sink blocks rather than drops, so no picked frame is lost
+    GstElement* pipeline = frame_pipeline_new(job->uri, job->source, job->timing.width, job->timing.height,
+                                              &decoder->plan, JPEG_OUTPUT, "max-buffers=4 sync=false");
+    GstElement* sink = pipeline ? gst_bin_get_by_name(GST_BIN(pipeline), "sink") : NULL;
+    GstElement* pick = pipeline ? gst_bin_get_by_name(GST_BIN(pipeline), "scale") : NULL;
+    if (pick == NULL && pipeline) {
+        pick = gst_bin_get_by_name(GST_BIN(pipeline), "convert");
+    }
+    GstPad* pad = pick ? gst_element_get_static_pad(pick, "sink") : NULL;
+    if (pick) gst_object_unref(pick);
+    if (pad == NULL || sink == NULL) {
+        if (pad) gst_object_unref(pad);
+        if (sink) gst_object_unref(sink);
+        if (pipeline) gst_object_unref(pipeline);
+        vp_budget_release(&job->call, &decoder->plan);
+        return VP_ERROR_FAILED;
+    }
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER | PICKER_EVENTS, pick_frames, &decoder->picker, NULL);
+    gst_object_unref(pad);
+
+    decoder->pipeline = pipeline;
+    decoder->sink = sink;
+    decoder->bus = gst_element_get_bus(pipeline);
+    decoder->waker.wake = wake_bus;
+    decoder->waker.data = decoder->bus;
+    vp_cancel_add_waker(job->call.cancel, &decoder->waker);
+
+    GstAppSinkCallbacks callbacks = {0};
+    callbacks.new_sample = on_frame_sample;
+    gst_app_sink_set_callbacks(GST_APP_SINK(sink), &callbacks, decoder->bus, NULL);
+    stage_done(0, VP_STAGE_PIPELINE_BUILD, start, vp_monotonic_us());
+
+    start = vp_monotonic_us();
+    GstStateChangeReturn ret = gst_element_set_state(pipeline, GST_STATE_PAUSED);
+    vp_trace_span(0, "set_state PAUSED", start, vp_monotonic_us());
+    if (ret == GST_STATE_CHANGE_FAILURE) {
+        status = VP_ERROR_FAILED;
+    } else if (ret == GST_STATE_CHANGE_ASYNC) {
+        status = wait_async_done(pipeline, decoder->bus, &job->call, 10 * GST_SECOND);
+    }
+    if (status != VP_OK) {
+        frame_decoder_close(decoder, &job->call);
+        return status;
+    }
+    stage_done(0, VP_STAGE_PREROLL, start, vp_monotonic_us());
+    return VP_OK;
+}
+
+// Seeks to the first target of `segment` and plays through to the last,
+// storing each picked frame in `arena` for the targets it covers
+static int frame_decoder_run(frame_decoder* decoder, frames_job* job, const frame_segment* segment,
+                             vp_arena* arena) {
+    const frame_target* targets = job->targets + segment->first;
+    frame_picker* picker = &decoder->picker;
+    g_mutex_lock(&picker->lock);
+    picker->pass_all = FALSE;
+    picker->armed = FALSE;
+    picker->targets = targets;
+    picker->count = segment->count;
+    picker->covered = 0;
+    picker->passed = 0;
+    g_mutex_unlock(&picker->lock);
+
+    // Accurate, so the decoder drops what precedes the first target itself;
+    // stopping after the last target ends the segment with EOS
+    int64_t start = vp_monotonic_us();
+    if (!gst_element_seek(decoder->pipeline, 1.0, GST_FORMAT_TIME, GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE,
+                          GST_SEEK_TYPE_SET, targets[0].timestamp,
+                          GST_SEEK_TYPE_SET, targets[segment->count - 1].timestamp + 1)) {
+        return VP_ERROR_FAILED;
+    }
+    if (gst_element_set_state(decoder->pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE) {
+        return VP_ERROR_FAILED;
+    }
+
+    int status = VP_OK;
+    int filled = 0;
+    int pulled = 0;
+    while (filled < segment->count) {
+        GstSample* sample;
+        while (filled < segment->count && (sample = gst_app_sink_try_pull_sample(GST_APP_SINK(decoder->sink), 0))) {
+            g_mutex_lock(&picker->lock);
+            int covers = pulled < picker->passed ? picker->covers[pulled] : 0;
+            g_mutex_unlock(&picker->lock);
+            pulled++;
+
+            GstBuffer* buffer = gst_sample_get_buffer(sample);
+            GstMapInfo map;
+            if (covers > 0 && buffer && gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+                // Targets of the same frame share its bytes
+                uint8_t* copy = (uint8_t*)vp_arena_alloc(arena, map.size);
+                for (int i = filled; copy && i < filled + covers && i < segment->count; i++) {
+                    vp_frame_item* item = &job->items[targets[i].index];
+                    item->status = VP_OK;
+                    item->data = copy;
+                    item->size = (int)map.size;
+                }
+                if (copy) {
+                    memcpy(copy, map.data, map.size);
+                }
+                gst_buffer_unmap(buffer, &map);
+            }
+            filled += covers;
+            gst_sample_unref(sample);
+        }
+        if (filled >= segment->count || gst_app_sink_is_eos(GST_APP_SINK(decoder->sink))) {
+            break;
+        }
+
+        status = vp_call_check(&job->call);
+        if (status != VP_OK) {
+            break;
+        }
+        GstClockTime timeout = (GstClockTime)vp_call_remaining_us(&job->call, 10 * 1000000) * GST_USECOND;
+        GstMessage* message = gst_bus_timed_pop_filtered(decoder->bus, timeout,
+            GST_MESSAGE_ERROR | GST_MESSAGE_EOS | GST_MESSAGE_APPLICATION);
+        if (message == NULL) {
+            status = vp_call_check(&job->call);
+            if (status == VP_OK) {
+                status = VP_ERROR_TIMEOUT;
+            }
+            break;
+        }
+        // EOS and new samples only wake us to drain the sink
+        gboolean failed = GST_MESSAGE_TYPE(message) == GST_MESSAGE_ERROR;
+        gst_message_unref(message);
+        if (failed) {
+            status = VP_ERROR_FAILED;
+            break;
+        }
+    }
+    vp_trace_span(0, "decode segment", start, vp_monotonic_us());
+    return status;
+}
+
+static gpointer frames_worker(gpointer data) {
+    frames_job* job = (frames_job*)data;
+    vp_arena* arena = vp_arena_new(256 * 1024);
+    frame_decoder decoder;
+    memset(&decoder, 0, sizeof(decoder));
+    g_mutex_init(&decoder.picker.lock);
+    decoder.picker.covers = g_new(int, job->longest_segment);
+    decoder.picker.frame_duration = (GstClockTime)(GST_SECOND / job->timing.fps);
+    gst_segment_init(&decoder.picker.segment, GST_FORMAT_UNDEFINED);
+
+    for (;;) {
+        int index = g_atomic_int_add(&job->next_segment, 1);
+        if (index >= job->segment_count) {
+            break;
+        }
+        const frame_segment* segment = &job->segments[index];
+
+        // Once the call is cancelled or out of time the remaining segments
+        // fail fast with the same status
+        int status = arena != NULL ? vp_call_check(&job->call) : VP_ERROR_NO_MEMORY;
+        if (status == VP_OK && decoder.pipeline == NULL) {
+            decoder.picker.pass_all = TRUE;
+            decoder.picker.targets = NULL;
+            status = frame_decoder_open(&decoder, job);
+        }
+        if (status == VP_OK) {
+            status = frame_decoder_run(&decoder, job, segment, arena);
+            if (status != VP_OK) {
+                // Start over from a fresh pipeline for the next segment
+                frame_decoder_close(&decoder, &job->call);
+            }
+        }
+        for (int i = segment->first; i < segment->first + segment->count; i++) {
+            vp_frame_item* item = &job->items[job->targets[i].index];
+            if (item->data == NULL) {
+                // Decoding ended before reaching the frame
+                item->status = status != VP_OK ? status : VP_ERROR_FAILED;
+            }
+        }
+    }
+    frame_decoder_close(&decoder, &job->call);
+    g_free(decoder.picker.covers);
+    g_mutex_clear(&decoder.picker.lock);
+
+    // Hand this worker's frames to the result so they are released
+    // together with it.
+    if (arena != NULL) {
+        g_mutex_lock(&job->lock);
+        vp_arena_merge(job->arena, arena);
+        g_mutex_unlock(&job->lock);
+    }
+    return NULL;
+}
+
+// Groups the sorted targets into segments that decode from one keyframe,
+// found in `keyframes` (seconds) when known
+static void split_segments(frames_job* job, int target_count, const double* keyframes, int keyframe_count) {
+    int previous_gop = -2;
+    for (int i = 0; i < target_count; i++) {
+        GstClockTime timestamp = job->targets[i].timestamp;
+        gboolean split = i == 0;
+        if (keyframes != NULL) {
+            int gop = keyframe_before(keyframes, keyframe_count, (double)timestamp / GST_SECOND);
+            split = split || gop != previous_gop;
+            previous_gop = gop;
+        } else if (i > 0) {
+            split = timestamp - job->targets[i - 1].timestamp > SEGMENT_GAP;
+        }
+        if (split) {
+            job->segments[job->segment_count].first = i;
+            job->segments[job->segment_count].count = 0;
+            job->segment_count++;
+        }
+        frame_segment* segment = &job->segments[job->segment_count - 1];
+        segment->count++;
+        if (segment->count > job->longest_segment) {
+            job->longest_segment = segment->count;
+        }
+    }
+}
+
+// Keyframe times of an MP4 source, or NULL if the container has no index
+// the native parser reads
+static double* load_keyframes(const char* path, vp_reader* source, vp_arena* arena, int* count) {
+    double* keyframes = NULL;
+    *count = 0;
+    if (source) {
+        vp_mp4_keyframes(source, arena, &keyframes, count);
+        return keyframes;
+    }
+    vp_reader reader;
+    if (vp_reader_open_file(&reader, path) == VP_OK) {
+        vp_mp4_keyframes(&reader, arena, &keyframes, count);
+        vp_reader_close(&reader);
+    }
+    return keyframes;
+}
+
+int extract_frames(const char* path, const int* frame_nums, int count, const vp_frames_options* options,
+                   vp_frames_result* out) {
+    if (out == NULL) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+    memset(out, 0, sizeof(*out));
+    if (path == NULL || path[0] == '\0' || (frame_nums == NULL && count > 0) || count < 0) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+
+    frames_job job;
+    memset(&job, 0, sizeof(job));
+    vp_frames_options defaults;
+    memset(&defaults, 0, sizeof(defaults));
+    if (options == NULL) {
+        options = &defaults;
+    }
+    vp_call_init(&job.call, &options->call);
+    ensure_gst_init();
+
+    vp_arena* arena = vp_arena_new(64 * 1024);
+    vp_arena* scratch = vp_arena_new(0);
+    job.items = arena ? (vp_frame_item*)vp_arena_alloc(arena, sizeof(vp_frame_item) * (size_t)(count > 0 ? count : 1))
+                      : NULL;
+    if (job.items == NULL || scratch == NULL) {
+        vp_arena_free(arena);
+        vp_arena_free(scratch);
+        return VP_ERROR_NO_MEMORY;
+    }
+    job.arena = arena;
+
+    vp_reader reader;
+    char* uri = NULL;
+    int status = VP_OK;
+    if (vp_is_http_url(path)) {
+        status = vp_reader_open_http(&reader, path, &job.call);
+        if (status == VP_OK) {
+            job.source = &reader;
+            job.uri = READER_SOURCE_URI;
+        }
+    } else {
+        uri = path_to_uri(path);
+        job.uri = uri;
+        status = uri != NULL ? VP_OK : VP_ERROR_INVALID_ARGUMENT;
+    }
+
+    job.timing.fps = 30.0;
+    int64_t start = vp_monotonic_us();
+    if (status == VP_OK) {
+        status = frame_timing(job.uri, job.source, &job.call, &job.timing);
+    }
+    int keyframe_count = 0;
+    double* keyframes = status == VP_OK ? load_keyframes(path, job.source, scratch, &keyframe_count) : NULL;
+    if (status == VP_OK) {
+        stage_done(0, VP_STAGE_DISCOVERY, start, vp_monotonic_us());
+    }
+
+    if (status == VP_OK) {
+        job.targets = g_new(frame_target, count > 0 ? count : 1);
+        job.segments = g_new(frame_segment, count > 0 ? count : 1);
+        GstClockTime frame_duration = (GstClockTime)(GST_SECOND / job.timing.fps);
+        int target_count = 0;
+        for (int i = 0; i < count; i++) {
+            GstClockTime timestamp = (GstClockTime)((double)frame_nums[i] / job.timing.fps * GST_SECOND);
+            if (frame_nums[i] < 0 || timestamp > job.timing.duration) {
+                job.items[i].status = VP_ERROR_INVALID_ARGUMENT;
+                continue;
+            }
+            if (timestamp + frame_duration / 2 <= job.timing.duration) {
+                timestamp += frame_duration / 2;
+            }
+            job.targets[target_count].timestamp = timestamp;
+            job.targets[target_count].index = i;
+            target_count++;
+        }
+        qsort(job.targets, (size_t)target_count, sizeof(frame_target), compare_targets);
+        split_segments(&job, target_count, keyframes, keyframe_count);
+
+        int workers = options->max_workers > 0 ? options->max_workers : (int)g_get_num_processors();
+        if (workers > job.segment_count) {
+            workers = job.segment_count;
+        }
+        // Parallel pipelines split the cores rather than each starting a
+        // decoder thread per core
+        if (job.call.decoder_threads == 0 && workers > 1) {
+            job.call.decoder_threads = MAX(1, (int)g_get_num_processors() / workers);
+        }
+
+        g_mutex_init(&job.lock);
+        GThread** threads = g_new0(GThread*, workers > 0 ? workers : 1);
+        for (int i = 0; i < workers; i++) {
+            threads[i] = g_thread_new("vp-frames", frames_worker, &job);
+        }
+        for (int i = 0; i < workers; i++) {
+            g_thread_join(threads[i]);
+        }
+        g_free(threads);
+        g_mutex_clear(&job.lock);
+        g_free(job.targets);
+        g_free(job.segments);
+    }
+
+    if (job.source) {
+        vp_reader_close(&reader);
+    }
+    g_free(uri);
+    vp_arena_free(scratch);
+    if (status != VP_OK) {
+        vp_arena_free(arena);
+        return status;
+    }
+    out->count = count;
+    out->items = job.items;
+    out->arena = arena;
+    return VP_OK;
+}
+
+void free_frames_result(vp_frames_result* result) {
+    if (result == NULL) {
+        return;
+    }
+    vp_arena_free((vp_arena*)result->arena);
+    memset(result, 0, sizeof(*result));
+}
+
+// ============================================================================
+// Frame iterator
+// ============================================================================
+
+#define DEFAULT_ITERATOR_QUEUE 4
+
+// Where the picker is in the range: the next frame number it takes, or
+// with an interval the next sample time
+typedef struct {
+    int frame;
+    GstClockTime time;
+} pick_state;
+
+struct vp_frame_iterator {
+    vp_iterator_options options;
+    // The call that opened the iterator, which holds its memory budget
+    vp_call call;
+    char* uri;
+    vp_reader reader;
+    vp_reader* source;
+    double fps;
+    GstClockTime frame_duration;
+    // options.interval, 0 to step by frames, and when start_frame shows
+    GstClockTime interval;
+    GstClockTime start_time;
+    GstElement* pipeline;
+    GstElement* sink;
+    GstBus* bus;
+    vp_cancel_waker waker;
+    vp_decode_plan plan;
+    gboolean has_plan;
+    GMutex lock;
+    // Set while frame_iterator_next() waits on the bus, so the sink posts
+    // one wake-up per wait rather than one per frame
+    gboolean waiting;
+    // Lets the preroll frame through when a seek to the start follows
+    gboolean pass_all;
+    pick_state pick;
+    // Last segments on the picker's pad and the decoder's sink pad
+    GstSegment segment;
+    GstSegment coded_segment;
+    // Sorted stream times of coded frames the decoder skips, see
+    // plan_skipped_frames()
+    GstClockTime* skipped;
+    int skipped_count;
+    // First error, returned by every later frame_iterator_next()
+    int status;
+};
+
+static int iterator_frame_at(const vp_frame_iterator* iterator, GstClockTime time) {
+    return (int)((double)time / GST_SECOND * iterator->fps + 0.5);
+}
+
+static void pick_reset(const vp_frame_iterator* iterator, pick_state* state) {
+    state->frame = iterator->options.start_frame;
+    state->time = iterator->start_time;
+}
+
+// Whether the frame shown from `time` is taken, moving `state` past it.
+// Shared by the pad probe and plan_skipped_frames(), so the decoder only
+// skips frames the picker would drop anyway.
+static gboolean pick_frame(const vp_frame_iterator* iterator, pick_state* state, GstClockTime time) {
+    const vp_iterator_options* options = &iterator->options;
+    if (options->end_frame > 0 && iterator_frame_at(iterator, time) >= options->end_frame) {
+        return FALSE;
+    }
+    if (iterator->interval > 0) {
+        // The frame showing at the sample time; the next sample is the
+        // first one after it
+        GstClockTime end = time + iterator->frame_duration;
+        if (end <= state->time) {
+            return FALSE;
+        }
+        state->time = iterator->start_time +
+            (end - iterator->start_time + iterator->interval - 1) / iterator->interval * iterator->interval;
+        return TRUE;
+    }
+    int frame = iterator_frame_at(iterator, time);
+    if (frame < state->frame) {
+        return FALSE;
+    }
+    // A frame missing from the stream moves the step along, not back
+    state->frame = frame + options->step - (frame - options->start_frame) % options->step;
+    return TRUE;
+}
+
+// Drops decoded frames the range does not take before they are converted
+// and encoded
+static GstPadProbeReturn pick_iterated_frame(GstPad* pad, GstPadProbeInfo* info, gpointer user_data) {
+    (void)pad;
+    vp_frame_iterator* iterator = (vp_frame_iterator*)user_data;
+    if (GST_PAD_PROBE_INFO_TYPE(info) & PICKER_EVENTS) {
+        GstEvent* event = GST_PAD_PROBE_INFO_EVENT(info);
+        g_mutex_lock(&iterator->lock);
+        if (GST_EVENT_TYPE(event) == GST_EVENT_FLUSH_STOP) {
+            // The seek to the start frame restarts the count
+            iterator->pass_all = FALSE;
+            pick_reset(iterator, &iterator->pick);
+        } else if (GST_EVENT_TYPE(event) == GST_EVENT_SEGMENT) {
+            gst_event_copy_segment(event, &iterator->segment);
+        }
+        g_mutex_unlock(&iterator->lock);
+        return GST_PAD_PROBE_OK;
+    }
+
+    GstBuffer* buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    GstPadProbeReturn ret = GST_PAD_PROBE_OK;
+    g_mutex_lock(&iterator->lock);
+    if (!iterator->pass_all && GST_BUFFER_PTS_IS_VALID(buffer)) {
+        GstClockTime time = buffer_stream_time(&iterator->segment, buffer);
+        if (!GST_CLOCK_TIME_IS_VALID(time) || !pick_frame(iterator, &iterator->pick, time)) {
+            ret = GST_PAD_PROBE_DROP;
+        }
+    }
+    g_mutex_unlock(&iterator->lock);
+    return ret;
+}
+
+// Drops coded frames planned by plan_skipped_frames() before the decoder
+static GstPadProbeReturn skip_coded_frames(GstPad* pad, GstPadProbeInfo* info, gpointer user_data) {
+    (void)pad;
+    vp_frame_iterator* iterator = (vp_frame_iterator*)user_data;
+    if (GST_PAD_PROBE_INFO_TYPE(info) & PICKER_EVENTS) {
+        GstEvent* event = GST_PAD_PROBE_INFO_EVENT(info);
+        if (GST_EVENT_TYPE(event) == GST_EVENT_SEGMENT) {
+            g_mutex_lock(&iterator->lock);
+            gst_event_copy_segment(event, &iterator->coded_segment);
+            g_mutex_unlock(&iterator->lock);
+        }
+        return GST_PAD_PROBE_OK;
+    }
+
+    GstBuffer* buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    g_mutex_lock(&iterator->lock);
+    GstClockTime time = iterator->pass_all ? GST_CLOCK_TIME_NONE
+                                           : buffer_stream_time(&iterator->coded_segment, buffer);
+    g_mutex_unlock(&iterator->lock);
+    if (!GST_CLOCK_TIME_IS_VALID(time)) {
+        return GST_PAD_PROBE_OK;
+    }
+
+    // Index times are exact; allow for rounding in the demuxer
+    GstClockTime tolerance = iterator->frame_duration / 4;
+    int low = 0;
+    int high = iterator->skipped_count;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (iterator->skipped[mid] + tolerance < time) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    gboolean skip = low < iterator->skipped_count && iterator->skipped[low] <= time + tolerance;
+    return skip ? GST_PAD_PROBE_DROP : GST_PAD_PROBE_OK;
+}
+
+static void on_iterator_element_added(GstBin* bin, GstBin* sub_bin, GstElement* element, gpointer user_data) {
+    (void)bin;
+    (void)sub_bin;
+    GstElementFactory* factory = gst_element_get_factory(element);
+    const gchar* klass = factory ? gst_element_factory_get_metadata(factory, GST_ELEMENT_METADATA_KLASS) : NULL;
+    if (klass && strstr(klass, "Decoder") && strstr(klass, "Video")) {
+        GstPad* pad = gst_element_get_static_pad(element, "sink");
+        if (pad) {
+            gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER | PICKER_EVENTS, skip_coded_frames, user_data, NULL);
+            gst_object_unref(pad);
+        }
+    }
+}
+
+typedef struct {
+    GstClockTime time;
+    int index;
+} shown_sample;
+
+static int compare_shown(const void* a, const void* b) {
+    const shown_sample* x = (const shown_sample*)a;
+    const shown_sample* y = (const shown_sample*)b;
+    if (x->time != y->time) {
+        return x->time < y->time ? -1 : 1;
+    }
+    return x->index - y->index;
+}
+
+static int compare_clock_times(const void* a, const void* b) {
+    GstClockTime x = *(const GstClockTime*)a;
+    GstClockTime y = *(const GstClockTime*)b;
+    return x < y ? -1 : x > y;
+}
+
+// Works out from the container index which coded frames the decoder can
+// skip: disposable frames that are not taken, and each GOP from the last
+// frame taken from it (in decode order) to the next keyframe. Nothing taken
+// can reference those, so sparse sampling decodes about one GOP prefix per
+// sample instead of every frame. `samples` are in decode order.
+static void plan_skipped_frames(vp_frame_iterator* iterator, const vp_mp4_sample* samples, int count) {
+    shown_sample* shown = g_new(shown_sample, count);
+    guint8* taken = g_new0(guint8, count);
+    for (int i = 0; i < count; i++) {
+        shown[i].time = (GstClockTime)(samples[i].time * GST_SECOND);
+        shown[i].index = i;
+    }
+    qsort(shown, (size_t)count, sizeof(shown_sample), compare_shown);
+    pick_state state;
+    pick_reset(iterator, &state);
+    for (int i = 0; i < count; i++) {
+        taken[shown[i].index] = (guint8)pick_frame(iterator, &state, shown[i].time);
+    }
+
+    // GOPs are walked backwards so each knows whether the next one still
+    // needs its tail: leading frames of an open GOP, shown before its
+    // keyframe, may reference the frames before it
+    iterator->skipped = g_new(GstClockTime, count);
+    int skipped = 0;
+    gboolean tail_needed = FALSE;
+    int gop_end = count;
+    for (int start = count - 1; start >= 0; start--) {
+        if (start > 0 && !(samples[start].flags & VP_MP4_SAMPLE_SYNC)) {
+            continue;
+        }
+        int last_taken = -1;
+        gboolean leading_taken = FALSE;
+        for (int i = start; i < gop_end; i++) {
+            if (taken[i]) {
+                last_taken = i;
+                leading_taken = leading_taken || samples[i].time < samples[start].time;
+            }
+        }
+        int keep_until = tail_needed ? gop_end : last_taken + 1;
+        for (int i = start; i < gop_end; i++) {
+            if (i >= keep_until || ((samples[i].flags & VP_MP4_SAMPLE_DISPOSABLE) && !taken[i])) {
+                iterator->skipped[skipped++] = (GstClockTime)(samples[i].time * GST_SECOND);
+            }
+        }
+        tail_needed = leading_taken;
+        gop_end = start;
+    }
+    qsort(iterator->skipped, (size_t)skipped, sizeof(GstClockTime), compare_clock_times);
+    iterator->skipped_count = skipped;
+    g_free(shown);
+    g_free(taken);
+}
+
+// Plans skipped frames from the MP4 index of `path`, if it has one
+static void load_skip_plan(vp_frame_iterator* iterator, const char* path) {
+    vp_arena* arena = vp_arena_new(0);
+    if (arena == NULL) {
+        return;
+    }
+    vp_mp4_sample* samples = NULL;
+    int count = 0;
+    int status = VP_ERROR_UNSUPPORTED;
+    if (iterator->source) {
+        status = vp_mp4_samples(iterator->source, arena, &samples, &count, NULL);
+    } else {
+        vp_reader reader;
+        if (vp_reader_open_file(&reader, path) == VP_OK) {
+            status = vp_mp4_samples(&reader, arena, &samples, &count, NULL);
+            vp_reader_close(&reader);
+        }
+    }
+    if (status == VP_OK && count > 0) {
+        plan_skipped_frames(iterator, samples, count);
+    }
+    vp_arena_free(arena);
+}
+
+static void wake_iterator(vp_frame_iterator* iterator) {
+    g_mutex_lock(&iterator->lock);
+    if (iterator->waiting) {
+        iterator->waiting = FALSE;
+        wake_bus(iterator->bus);
+    }
+    g_mutex_unlock(&iterator->lock);
+}
+
+static GstFlowReturn on_iterator_sample(GstAppSink* sink, gpointer user_data) {
+    (void)sink;
+    wake_iterator((vp_frame_iterator*)user_data);
+    return GST_FLOW_OK;
+}
+
+static void on_iterator_eos(GstAppSink* sink, gpointer user_data) {
+    (void)sink;
+    wake_iterator((vp_frame_iterator*)user_data);
+}
+
+// Builds the iterator's pipeline and starts it at the first frame
+static int iterator_start(vp_frame_iterator* iterator, int width, int height, int bit_depth) {
+    const vp_iterator_options* options = &iterator->options;
+    int status = vp_budget_acquire(&iterator->call, width, height, bit_depth, &iterator->plan);
+    if (status != VP_OK) {
+        return status;
+    }
+    iterator->has_plan = TRUE;
+
+    int64_t start = vp_monotonic_us();
+    // The sink blocks once the queue is full, which stops the decoder
+    // until the consumer catches up
+    gchar* sink_properties = g_strdup_printf("max-buffers=%d sync=false", options->queue_size);
+    iterator->pipeline = frame_pipeline_new(iterator->uri, iterator->source, width, height, &iterator->plan,
+                                            options->format == VP_FRAME_RGBA ? RGBA_OUTPUT : JPEG_OUTPUT,
+                                            sink_properties);
+    g_free(sink_properties);
+    if (iterator->pipeline == NULL) {
+        return VP_ERROR_FAILED;
+    }
+    iterator->sink = gst_bin_get_by_name(GST_BIN(iterator->pipeline), "sink");
+    GstElement* pick = gst_bin_get_by_name(GST_BIN(iterator->pipeline), "scale");
+    if (pick == NULL) {
+        pick = gst_bin_get_by_name(GST_BIN(iterator->pipeline), "convert");
+    }
+    GstPad* pad = pick ? gst_element_get_static_pad(pick, "sink") : NULL;
+    if (pick) gst_object_unref(pick);
+    if (pad == NULL || iterator->sink == NULL) {
+        if (pad) gst_object_unref(pad);
+        return VP_ERROR_FAILED;
+    }
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER | PICKER_EVENTS, pick_iterated_frame, iterator, NULL);
+    gst_object_unref(pad);
+    if (iterator->skipped_count > 0) {
+        g_signal_connect(iterator->pipeline, "deep-element-added", G_CALLBACK(on_iterator_element_added), iterator);
+    }
+
+    iterator->bus = gst_element_get_bus(iterator->pipeline);
+    iterator->waker.wake = wake_bus;
+    iterator->waker.data = iterator->bus;
+    vp_cancel_add_waker(iterator->call.cancel, &iterator->waker);
+
+    GstAppSinkCallbacks callbacks = {0};
+    callbacks.new_sample = on_iterator_sample;
+    callbacks.eos = on_iterator_eos;
+    gst_app_sink_set_callbacks(GST_APP_SINK(iterator->sink), &callbacks, iterator, NULL);
+    stage_done(0, VP_STAGE_PIPELINE_BUILD, start, vp_monotonic_us());
+
+    start = vp_monotonic_us();
+    GstStateChangeReturn ret = gst_element_set_state(iterator->pipeline, GST_STATE_PAUSED);
+    vp_trace_span(0, "set_state PAUSED", start, vp_monotonic_us());
+    if (ret == GST_STATE_CHANGE_FAILURE) {
+        return VP_ERROR_FAILED;
+    }
+    if (ret == GST_STATE_CHANGE_ASYNC) {
+        status = wait_async_done(iterator->pipeline, iterator->bus, &iterator->call, 10 * GST_SECOND);
+        if (status != VP_OK) {
+            return status;
+        }
+    }
+    stage_done(0, VP_STAGE_PREROLL, start, vp_monotonic_us());
+
+    // Accurate, so decoding starts from the keyframe before the first frame
+    // but nothing before it is encoded; the stop position ends the range
+    // with EOS
+    if (options->start_frame > 0 || options->end_frame > 0) {
+        GstClockTime stop = (GstClockTime)(options->end_frame / iterator->fps * GST_SECOND);
+        if (!gst_element_seek(iterator->pipeline, 1.0, GST_FORMAT_TIME,
+                              GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE, GST_SEEK_TYPE_SET, iterator->start_time,
+                              options->end_frame > 0 ? GST_SEEK_TYPE_SET : GST_SEEK_TYPE_NONE, stop)) {
+            return VP_ERROR_FAILED;
+        }
+    }
+    if (gst_element_set_state(iterator->pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE) {
+        return VP_ERROR_FAILED;
+    }
+    return VP_OK;
+}
+
+int frame_iterator_open(const char* path, const vp_iterator_options* options, vp_frame_iterator** out) {
+    if (out == NULL) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+    *out = NULL;
+    if (path == NULL || path[0] == '\0' ||
+        (options != NULL && (options->start_frame < 0 || options->step < 0 || options->end_frame < 0 ||
+                             (options->end_frame > 0 && options->end_frame <= options->start_frame) ||
+                             !(options->interval >= 0.0) || options->queue_size < 0 ||
+                             (options->format != VP_FRAME_JPEG && options->format != VP_FRAME_RGBA)))) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+
+    vp_frame_iterator* iterator = g_new0(vp_frame_iterator, 1);
+    if (options != NULL) {
+        iterator->options = *options;
+    }
+    if (iterator->options.step < 1) {
+        iterator->options.step = 1;
+    }
+    if (iterator->options.queue_size == 0) {
+        iterator->options.queue_size = DEFAULT_ITERATOR_QUEUE;
+    }
+    iterator->pass_all = iterator->options.start_frame > 0 || iterator->options.end_frame > 0;
+    gst_segment_init(&iterator->segment, GST_FORMAT_UNDEFINED);
+    gst_segment_init(&iterator->coded_segment, GST_FORMAT_UNDEFINED);
+    g_mutex_init(&iterator->lock);
+    vp_call_init(&iterator->call, &iterator->options.call);
+    ensure_gst_init();
+
+    int status = VP_OK;
+    if (vp_is_http_url(path)) {
+        // The reader keeps a pointer to the call, which lives as long
+        status = vp_reader_open_http(&iterator->reader, path, &iterator->call);
+        if (status == VP_OK) {
+            iterator->source = &iterator->reader;
+            iterator->uri = g_strdup(READER_SOURCE_URI);
+        }
+    } else {
+        iterator->uri = path_to_uri(path);
+        status = iterator->uri != NULL ? VP_OK : VP_ERROR_INVALID_ARGUMENT;
+    }
+
+    frame_timing_info timing = { 0, 30.0, 0, 0, 0 };
+    int64_t start = vp_monotonic_us();
+    if (status == VP_OK) {
+        status = frame_timing(iterator->uri, iterator->source, &iterator->call, &timing);
+    }
+    if (status == VP_OK) {
+        stage_done(0, VP_STAGE_DISCOVERY, start, vp_monotonic_us());
+        iterator->fps = timing.fps;
+        iterator->frame_duration = (GstClockTime)(GST_SECOND / timing.fps);
+        iterator->interval = (GstClockTime)(iterator->options.interval * GST_SECOND);
+        iterator->start_time = (GstClockTime)(iterator->options.start_frame / timing.fps * GST_SECOND);
+        pick_reset(iterator, &iterator->pick);
+        if (iterator->start_time > timing.duration) {
+            status = VP_ERROR_INVALID_ARGUMENT;
+        }
+    }
+    // Sparse ranges skip decoding where the container index says it is safe
+    if (status == VP_OK && (iterator->options.step > 1 || iterator->interval > iterator->frame_duration)) {
+        load_skip_plan(iterator, path);
+    }
+    if (status == VP_OK) {
+        status = iterator_start(iterator, timing.width, timing.height, timing.bit_depth);
+    }
+    if (status != VP_OK) {
+        frame_iterator_close(iterator);
+        return status;
+    }
+    *out = iterator;
+    return VP_OK;
+}
+
+// Moves the frame of `sample` into *frame
+static int take_iterated_frame(const vp_frame_iterator* iterator, GstSample* sample, vp_frame* frame) {
+    GstBuffer* buffer = gst_sample_get_buffer(sample);
+    GstCaps* caps = gst_sample_get_caps(sample);
+    GstVideoInfo info;
+    gboolean raw = iterator->options.format == VP_FRAME_RGBA;
+    int width = 0;
+    int height = 0;
+    if (buffer == NULL || caps == NULL || gst_caps_get_size(caps) == 0) {
+        return VP_ERROR_FAILED;
+    }
+    // Only raw caps carry strides; JPEG caps just the size
+    if (raw) {
+        if (!gst_video_info_from_caps(&info, caps)) {
+            return VP_ERROR_FAILED;
+        }
+        width = GST_VIDEO_INFO_WIDTH(&info);
+        height = GST_VIDEO_INFO_HEIGHT(&info);
+    } else {
+        GstStructure* structure = gst_caps_get_structure(caps, 0);
+        gst_structure_get_int(structure, "width", &width);
+        gst_structure_get_int(structure, "height", &height);
+    }
+    GstMapInfo map;
+    if (!gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+        return VP_ERROR_FAILED;
+    }
+
+    // Raw rows are packed, whatever stride the converter used
+    size_t row = (size_t)width * 4;
+    size_t size = raw ? row * (size_t)height : map.size;
+    int status = VP_OK;
+    if (raw && GST_VIDEO_INFO_PLANE_OFFSET(&info, 0) + (size_t)GST_VIDEO_INFO_PLANE_STRIDE(&info, 0) * (height - 1) + row >
+                   map.size) {
+        status = VP_ERROR_FAILED;
+    } else if ((frame->data = vp_frame_alloc(size)) == NULL) {
+        status = VP_ERROR_NO_MEMORY;
+    } else if (raw) {
+        const uint8_t* src = map.data + GST_VIDEO_INFO_PLANE_OFFSET(&info, 0);
+        for (int y = 0; y < height; y++) {
+            memcpy(frame->data + row * y, src + (size_t)GST_VIDEO_INFO_PLANE_STRIDE(&info, 0) * y, row);
+        }
+    } else {
+        memcpy(frame->data, map.data, size);
+    }
+    gst_buffer_unmap(buffer, &map);
+    if (status != VP_OK) {
+        return status;
+    }
+
+    frame->size = (int)size;
+    frame->width = width;
+    frame->height = height;
+    GstClockTime time = buffer_stream_time(gst_sample_get_segment(sample), buffer);
+    if (GST_CLOCK_TIME_IS_VALID(time)) {
+        frame->frame_num = iterator_frame_at(iterator, time);
+        frame->timestamp = (double)time / GST_SECOND;
+    }
+    return VP_OK;
+}
+
+// Waits until the sink has a sample, the range ends or the call does
+static int wait_iterated_sample(vp_frame_iterator* iterator, GstSample** out) {
+    vp_call call;
+    vp_call_init(&call, &iterator->options.call);
+    int status = VP_OK;
+    for (;;) {
+        // Flag the wait first, so a frame that arrives after the pull
+        // below still wakes us
+        g_mutex_lock(&iterator->lock);
+        iterator->waiting = TRUE;
+        g_mutex_unlock(&iterator->lock);
+
+        *out = gst_app_sink_try_pull_sample(GST_APP_SINK(iterator->sink), 0);
+        if (*out != NULL) {
+            break;
+        }
+        if (gst_app_sink_is_eos(GST_APP_SINK(iterator->sink))) {
+            status = VP_END_OF_STREAM;
+            break;
+        }
+        status = vp_call_check(&call);
+        if (status != VP_OK) {
+            break;
+        }
+
+        int64_t start = vp_monotonic_us();
+        GstClockTime timeout = (GstClockTime)vp_call_remaining_us(&call, 10 * 1000000) * GST_USECOND;
+        GstMessage* message = gst_bus_timed_pop_filtered(iterator->bus, timeout,
+            GST_MESSAGE_ERROR | GST_MESSAGE_EOS | GST_MESSAGE_APPLICATION);
+        vp_trace_span(0, "bus wait", start, vp_monotonic_us());
+        if (message == NULL) {
+            status = vp_call_check(&call);
+            if (status == VP_OK) {
+                status = VP_ERROR_TIMEOUT;
+            }
+            break;
+        }
+        gboolean failed = GST_MESSAGE_TYPE(message) == GST_MESSAGE_ERROR;
+        gst_message_unref(message);
+        if (failed) {
+            status = VP_ERROR_FAILED;
+            break;
+        }
+    }
+    g_mutex_lock(&iterator->lock);
+    iterator->waiting = FALSE;
+    g_mutex_unlock(&iterator->lock);
+    return status;
+}
+
+int frame_iterator_next_batch(vp_frame_iterator* iterator, vp_frame* frames, int capacity, int* count) {
+    if (count != NULL) {
+        *count = 0;
+    }
+    if (iterator == NULL || frames == NULL || capacity < 1 || count == NULL) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+    memset(frames, 0, sizeof(vp_frame) * (size_t)capacity);
+    if (iterator->status != VP_OK) {
+        return iterator->status;
+    }
+
+    GstSample* sample = NULL;
+    int status = wait_iterated_sample(iterator, &sample);
+    // Then whatever else is already decoded, without waiting
+    while (sample != NULL) {
+        int taken = take_iterated_frame(iterator, sample, &frames[*count]);
+        gst_sample_unref(sample);
+        if (taken != VP_OK) {
+            // Frames already taken are returned; the error comes next time
+            if (*count == 0) {
+                status = taken;
+            } else {
+                iterator->status = taken;
+            }
+            break;
+        }
+        (*count)++;
+        sample = *count < capacity ? gst_app_sink_try_pull_sample(GST_APP_SINK(iterator->sink), 0) : NULL;
+    }
+
+    if (status != VP_OK && status != VP_END_OF_STREAM) {
+        iterator->status = status;
+    }
+    return status;
+}
+
+int frame_iterator_next(vp_frame_iterator* iterator, vp_frame* frame) {
+    int count = 0;
+    return frame_iterator_next_batch(iterator, frame, 1, &count);
+}
+
+void frame_iterator_close(vp_frame_iterator* iterator) {
+    if (iterator == NULL) {
+        return;
+    }
+    if (iterator->pipeline != NULL) {
+        if (iterator->bus != NULL) {
+            gst_bus_set_flushing(iterator->bus, TRUE);
+        }
+        int64_t teardown = vp_monotonic_us();
+        gst_element_set_state(iterator->pipeline, GST_STATE_NULL);
+        vp_trace_span(0, "set_state NULL", teardown, vp_monotonic_us());
+    }
+    if (iterator->bus != NULL) {
+        vp_cancel_remove_waker(iterator->call.cancel, &iterator->waker);
+        gst_object_unref(iterator->bus);
+    }
+    if (iterator->sink != NULL) {
+        gst_object_unref(iterator->sink);
+    }
+    if (iterator->pipeline != NULL) {
+        gst_object_unref(iterator->pipeline);
+    }
+    if (iterator->has_plan) {
+        vp_budget_release(&iterator->call, &iterator->plan);
+    }
+    if (iterator->source != NULL) {
+        vp_reader_close(iterator->source);
+    }
+    g_free(iterator->skipped);
+    g_free(iterator->uri);
+    g_mutex_clear(&iterator->lock);
+    g_free(iterator);
+}
+
+// ============================================================================
+// GOP analysis
+// ============================================================================
+
+int analyze_gop(const char* path, const vp_call_options* options, vp_gop_info* out) {
+    if (out == NULL) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+    memset(out, 0, sizeof(*out));
+    if (path == NULL || strlen(path) == 0) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+
+    vp_call call;
+    vp_call_init(&call, options);
+    vp_reader reader;
+    int status = vp_is_http_url(path) ? vp_reader_open_http(&reader, path, &call) : vp_reader_open_file(&reader, path);
+    if (status != VP_OK) {
+        return status;
+    }
+
+    // The sample table is only needed while analyzing
+    vp_arena* scratch = vp_arena_new(0);
+    vp_arena* arena = vp_arena_new(0);
+    if (scratch == NULL || arena == NULL) {
+        vp_arena_free(scratch);
+        vp_arena_free(arena);
+        vp_reader_close(&reader);
+        return VP_ERROR_NO_MEMORY;
+    }
+
+    int64_t start = vp_monotonic_us();
+    vp_mp4_sample* samples = NULL;
+    int count = 0;
+    status = vp_mp4_samples(&reader, scratch, &samples, &count, NULL);
+    vp_reader_close(&reader);
+    if (status == VP_OK) {
+        status = count > 0 ? vp_gop_analyze(samples, count, arena, out) : VP_ERROR_UNSUPPORTED;
+    }
+    vp_arena_free(scratch);
+    if (status != VP_OK) {
+        vp_arena_free(arena);
+        memset(out, 0, sizeof(*out));
+        return status;
+    }
+    stage_done(0, VP_STAGE_DISCOVERY, start, vp_monotonic_us());
+    out->arena = arena;
+    return VP_OK;
+}
+
+// ============================================================================
+// I/O backends
+// ============================================================================
+
+int set_io_backend(int backend) {
+    return vp_io_set_backend(backend);
+}
+
+void get_io_stats(vp_io_stats* out) {
+    vp_io_global_stats(out);
+}
+
+// ============================================================================
+// Scheduled requests
+// ============================================================================
+
+static void run_request(const vp_request* request, const vp_call_options* options, vp_request_result* result) {
+    if (request->kind == VP_REQUEST_FRAME) {
+        if (request->flags & VP_REQUEST_EMBEDDED_THUMBNAIL) {
+            result->status = get_embedded_thumbnail(request->path, options, &result->frame, &result->frame_size,
+                                                    &result->frame_format);
+            if (result->status != VP_ERROR_NOT_FOUND && result->status != VP_ERROR_UNSUPPORTED) {
+                return;
+            }
+        }
+        result->status = extract_frame_ex(request->path, request->frame_num, options, &result->frame,
+                                          &result->frame_size);
+        result->frame_format = result->status == VP_OK ? VP_IMAGE_JPEG : 0;
+    } else {
+        result->status = probe_media_info_ex(request->path, options, &result->info);
+    }
+}
+
+vp_scheduler* scheduler_new(int max_workers, vp_request_callback callback, void* user_data) {
+    int workers = max_workers > 0 ? max_workers : (int)g_get_num_processors();
+    return vp_scheduler_new(workers, run_request, callback, user_data);
 }
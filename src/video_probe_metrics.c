@@ -0,0 +1,219 @@
+/**
+ * Per-stage latency histograms and I/O counters.
+ *
+ * Every thread records into a shard of its own with relaxed atomic adds, so
+ * timing a stage never takes a lock or bounces a cache line between
+ * threads. Snapshots sum the shards. Shards of exited threads are handed to
+ * the next new thread rather than freed, which keeps their counts and
+ * bounds memory by the peak number of recording threads.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "video_probe_internal.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Log-linear buckets: values below 8 us are exact, larger ones fall into
+// one of 8 sub-buckets per power of two, so a bucket midpoint is within
+// 1/16 of any value in it. The last bucket also takes everything above
+// 2^40 us (about 12 days).
+#define SUB_BITS 3
+#define SUB_COUNT (1 << SUB_BITS)
+#define MAX_OCTAVE 40
+#define BUCKET_COUNT ((MAX_OCTAVE - SUB_BITS + 2) * SUB_COUNT)
+
+#define COUNTER_COUNT (VP_COUNTER_LIVE_ARENAS + 1)
+// Counters from here on are levels, exempt from reset_metrics()
+#define FIRST_LEVEL VP_COUNTER_LIVE_FRAMES
+
+typedef struct {
+    int64_t total_us[VP_STAGE_COUNT];
+    int64_t buckets[VP_STAGE_COUNT][BUCKET_COUNT];
+    int64_t counters[COUNTER_COUNT];
+} metrics_totals;
+
+typedef struct shard {
+    metrics_totals totals;
+    // Set while a live thread owns the shard
+    int in_use;
+    // Fixed once the shard is published
+    struct shard* next;
+} shard;
+
+static shard* shards;
+static pthread_key_t shard_key;
+static pthread_once_t shard_key_once = PTHREAD_ONCE_INIT;
+
+// Totals at the last reset_metrics(), subtracted from every snapshot so
+// recording threads never have to see a reset
+static metrics_totals baseline;
+static pthread_mutex_t baseline_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void release_shard(void* data) {
+    __atomic_store_n(&((shard*)data)->in_use, 0, __ATOMIC_RELEASE);
+}
+
+static void create_shard_key(void) {
+    pthread_key_create(&shard_key, release_shard);
+}
+
+// The calling thread's shard, or NULL if none could be allocated
+static shard* local_shard(void) {
+    pthread_once(&shard_key_once, create_shard_key);
+    shard* own = (shard*)pthread_getspecific(shard_key);
+    if (own != NULL) {
+        return own;
+    }
+
+    for (shard* s = __atomic_load_n(&shards, __ATOMIC_ACQUIRE); s != NULL; s = s->next) {
+        int idle = 0;
+        if (__atomic_compare_exchange_n(&s->in_use, &idle, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            own = s;
+            break;
+        }
+    }
+    if (own == NULL) {
+        own = (shard*)calloc(1, sizeof(shard));
+        if (own == NULL) {
+            return NULL;
+        }
+        own->in_use = 1;
+        own->next = __atomic_load_n(&shards, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&shards, &own->next, own, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        }
+    }
+    pthread_setspecific(shard_key, own);
+    return own;
+}
+
+static int bucket_of(int64_t us) {
+    if (us < SUB_COUNT) {
+        return us > 0 ? (int)us : 0;
+    }
+    int octave = 63 - __builtin_clzll((unsigned long long)us);
+    if (octave > MAX_OCTAVE) {
+        return BUCKET_COUNT - 1;
+    }
+    int sub = (int)(us >> (octave - SUB_BITS)) & (SUB_COUNT - 1);
+    return (octave - SUB_BITS + 1) * SUB_COUNT + sub;
+}
+
+// Midpoint of a bucket in microseconds
+static int64_t bucket_value(int bucket) {
+    if (bucket < SUB_COUNT) {
+        return bucket;
+    }
+    int octave = bucket / SUB_COUNT + SUB_BITS - 1;
+    int64_t width = (int64_t)1 << (octave - SUB_BITS);
+    int64_t lower = (int64_t)(SUB_COUNT + bucket % SUB_COUNT) * width;
+    return lower + width / 2;
+}
+
+void vp_metrics_record(int stage, int64_t elapsed_us) {
+    if (stage < 0 || stage >= VP_STAGE_COUNT) {
+        return;
+    }
+    shard* own = local_shard();
+    if (own == NULL) {
+        return;
+    }
+    if (elapsed_us < 0) {
+        elapsed_us = 0;
+    }
+    __atomic_fetch_add(&own->totals.total_us[stage], elapsed_us, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&own->totals.buckets[stage][bucket_of(elapsed_us)], 1, __ATOMIC_RELAXED);
+}
+
+void vp_metrics_count(int counter, int64_t n) {
+    if (counter < 0 || counter >= COUNTER_COUNT) {
+        return;
+    }
+    shard* own = local_shard();
+    if (own != NULL) {
+        __atomic_fetch_add(&own->totals.counters[counter], n, __ATOMIC_RELAXED);
+    }
+}
+
+// Sums every shard into `out`
+static void sum_shards(metrics_totals* out) {
+    memset(out, 0, sizeof(*out));
+    for (shard* s = __atomic_load_n(&shards, __ATOMIC_ACQUIRE); s != NULL; s = s->next) {
+        for (int stage = 0; stage < VP_STAGE_COUNT; stage++) {
+            out->total_us[stage] += __atomic_load_n(&s->totals.total_us[stage], __ATOMIC_RELAXED);
+            for (int b = 0; b < BUCKET_COUNT; b++) {
+                out->buckets[stage][b] += __atomic_load_n(&s->totals.buckets[stage][b], __ATOMIC_RELAXED);
+            }
+        }
+        for (int c = 0; c < COUNTER_COUNT; c++) {
+            out->counters[c] += __atomic_load_n(&s->totals.counters[c], __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// Value below which `fraction` of the `count` samples in `buckets` fall
+static int64_t percentile(const int64_t* buckets, int64_t count, double fraction) {
+    int64_t rank = (int64_t)(fraction * (double)count + 0.999999);
+    if (rank < 1) {
+        rank = 1;
+    }
+    int64_t seen = 0;
+    for (int b = 0; b < BUCKET_COUNT; b++) {
+        seen += buckets[b];
+        if (seen >= rank) {
+            return bucket_value(b);
+        }
+    }
+    return 0;
+}
+
+void get_metrics(vp_metrics* out) {
+    if (out == NULL) {
+        return;
+    }
+    memset(out, 0, sizeof(*out));
+
+    metrics_totals* now = (metrics_totals*)malloc(sizeof(metrics_totals));
+    if (now == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&baseline_lock);
+    sum_shards(now);
+    for (int stage = 0; stage < VP_STAGE_COUNT; stage++) {
+        now->total_us[stage] -= baseline.total_us[stage];
+        for (int b = 0; b < BUCKET_COUNT; b++) {
+            now->buckets[stage][b] -= baseline.buckets[stage][b];
+        }
+    }
+    for (int c = 0; c < FIRST_LEVEL; c++) {
+        now->counters[c] -= baseline.counters[c];
+    }
+    pthread_mutex_unlock(&baseline_lock);
+
+    for (int stage = 0; stage < VP_STAGE_COUNT; stage++) {
+        vp_stage_metrics* metrics = &out->stages[stage];
+        for (int b = 0; b < BUCKET_COUNT; b++) {
+            metrics->count += now->buckets[stage][b];
+        }
+        if (metrics->count == 0) {
+            continue;
+        }
+        metrics->total_us = now->total_us[stage];
+        metrics->p50_us = percentile(now->buckets[stage], metrics->count, 0.50);
+        metrics->p90_us = percentile(now->buckets[stage], metrics->count, 0.90);
+        metrics->p99_us = percentile(now->buckets[stage], metrics->count, 0.99);
+    }
+    out->bytes_read = now->counters[VP_COUNTER_BYTES_READ];
+    out->allocations = now->counters[VP_COUNTER_ALLOCATIONS];
+    out->live_frames = now->counters[VP_COUNTER_LIVE_FRAMES];
+    out->live_results = now->counters[VP_COUNTER_LIVE_ARENAS];
+    free(now);
+}
+
+void reset_metrics(void) {
+    pthread_mutex_lock(&baseline_lock);
+    sum_shards(&baseline);
+    pthread_mutex_unlock(&baseline_lock);
+}
@@ -0,0 +1,279 @@
+/**
+ * Native Matroska/WebM attachment reader.
+ *
+ * Walks the element headers at the start of the Segment up to the first
+ * Cluster, following the SeekHead when Attachments are stored after the
+ * media, and reads only the bytes of the chosen image. Nothing but element
+ * headers, the SeekHead and attachment names is read otherwise.
+ */
+
+#include "video_probe_internal.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define MKV_ID_EBML 0x1A45DFA3
+#define MKV_ID_SEGMENT 0x18538067
+#define MKV_ID_SEEK_HEAD 0x114D9B74
+#define MKV_ID_SEEK 0x4DBB
+#define MKV_ID_SEEK_ID 0x53AB
+#define MKV_ID_SEEK_POSITION 0x53AC
+#define MKV_ID_ATTACHMENTS 0x1941A469
+#define MKV_ID_ATTACHED_FILE 0x61A7
+#define MKV_ID_FILE_NAME 0x466E
+#define MKV_ID_FILE_MIME_TYPE 0x4660
+#define MKV_ID_FILE_DATA 0x465C
+#define MKV_ID_CLUSTER 0x1F43B675
+
+#define MKV_UNKNOWN_SIZE UINT64_MAX
+// SeekHeads beyond this size are treated as corrupt
+#define MKV_MAX_SEEK_HEAD_SIZE (64 * 1024)
+// Attachments beyond this size are not thumbnails
+#define MKV_MAX_IMAGE_SIZE (16 * 1024 * 1024)
+
+typedef struct {
+    uint32_t id;
+    // Payload size, MKV_UNKNOWN_SIZE for elements that run to the end of
+    // their parent
+    uint64_t size;
+    // Offset of the payload
+    int64_t data;
+} mkv_element;
+
+typedef struct {
+    int rank;
+    int64_t offset;
+    uint64_t size;
+} mkv_candidate;
+
+// Variable-length integer of at most `left` bytes at `p`. IDs keep their
+// length marker; sizes drop it, and all ones means unknown.
+// Returns its length in bytes, 0 if malformed.
+static int read_vint(const uint8_t* p, size_t left, int is_id, uint64_t* value) {
+    if (left == 0 || p[0] == 0) return 0;
+    int length = 1;
+    while (!(p[0] & (0x80 >> (length - 1)))) length++;
+    if ((size_t)length > left) return 0;
+
+    uint64_t mask = 0xFF >> length;
+    uint64_t v = is_id ? p[0] : p[0] & mask;
+    int all_ones = (p[0] & mask) == mask;
+    for (int i = 1; i < length; i++) {
+        v = (v << 8) | p[i];
+        all_ones = all_ones && p[i] == 0xFF;
+    }
+    *value = !is_id && all_ones ? MKV_UNKNOWN_SIZE : v;
+    return length;
+}
+
+// Reads the header of the element at `offset`, which must lie before
+// `end`. A known size must fit before `end` too. Returns 0 when there is
+// no valid element.
+static int read_element(vp_reader* reader, int64_t offset, int64_t end, mkv_element* out) {
+    uint8_t header[12];
+    if (end - offset < 2) return 0;
+    size_t length = end - offset < (int64_t)sizeof(header) ? (size_t)(end - offset) : sizeof(header);
+    if (vp_reader_read_full(reader, offset, header, (int64_t)length) != 0) return 0;
+
+    uint64_t id, size;
+    int id_length = read_vint(header, length, 1, &id);
+    if (id_length == 0 || id_length > 4) return 0;
+    int size_length = read_vint(header + id_length, length - (size_t)id_length, 0, &size);
+    if (size_length == 0) return 0;
+
+    out->id = (uint32_t)id;
+    out->size = size;
+    out->data = offset + id_length + size_length;
+    return size == MKV_UNKNOWN_SIZE || (out->data <= end && size <= (uint64_t)(end - out->data));
+}
+
+// Big-endian unsigned integer of up to 8 bytes
+static uint64_t read_uint(const uint8_t* p, uint64_t size) {
+    uint64_t value = 0;
+    for (uint64_t i = 0; i < size && i < 8; i++) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+// Next child element of an in-memory master element. Returns 0 when done
+// or malformed.
+static int next_child(const uint8_t** p, const uint8_t* end, uint32_t* id, const uint8_t** data, uint64_t* size) {
+    uint64_t value;
+    int id_length = read_vint(*p, (size_t)(end - *p), 1, &value);
+    if (id_length == 0 || id_length > 4) return 0;
+    *id = (uint32_t)value;
+    int size_length = read_vint(*p + id_length, (size_t)(end - *p) - (size_t)id_length, 0, size);
+    if (size_length == 0) return 0;
+    *data = *p + id_length + size_length;
+    if (*size > (uint64_t)(end - *data)) return 0;
+    *p = *data + *size;
+    return 1;
+}
+
+// Offset of Attachments from the SeekHead at `element`, or -1
+static int64_t seek_attachments(vp_reader* reader, const mkv_element* element, int64_t segment_data) {
+    if (element->size > MKV_MAX_SEEK_HEAD_SIZE) return -1;
+    uint8_t* buffer = (uint8_t*)malloc(element->size > 0 ? (size_t)element->size : 1);
+    if (buffer == NULL) return -1;
+    int64_t found = -1;
+    if (vp_reader_read_full(reader, element->data, buffer, (int64_t)element->size) == 0) {
+        const uint8_t* p = buffer;
+        const uint8_t* end = buffer + element->size;
+        uint32_t id;
+        const uint8_t* data;
+        uint64_t size;
+        while (found < 0 && next_child(&p, end, &id, &data, &size)) {
+            if (id != MKV_ID_SEEK) continue;
+            const uint8_t* q = data;
+            uint64_t seek_id = 0;
+            uint64_t position = 0;
+            int has_position = 0;
+            uint32_t child;
+            const uint8_t* value;
+            uint64_t value_size;
+            while (next_child(&q, data + size, &child, &value, &value_size)) {
+                if (child == MKV_ID_SEEK_ID) {
+                    seek_id = read_uint(value, value_size);
+                } else if (child == MKV_ID_SEEK_POSITION) {
+                    position = read_uint(value, value_size);
+                    has_position = 1;
+                }
+            }
+            // Positions are relative to the Segment's payload
+            if (seek_id == MKV_ID_ATTACHMENTS && has_position && position <= (uint64_t)(INT64_MAX - segment_data)) {
+                found = segment_data + (int64_t)position;
+            }
+        }
+    }
+    free(buffer);
+    return found;
+}
+
+// How well an attachment suits as the file's thumbnail, after the
+// Matroska cover art conventions; -1 for anything but JPEG or PNG
+static int cover_rank(const char* name, const char* mime) {
+    if (strcmp(mime, "image/jpeg") != 0 && strcmp(mime, "image/jpg") != 0 && strcmp(mime, "image/png") != 0) {
+        return -1;
+    }
+    if (strncmp(name, "cover.", 6) == 0) return 3;
+    if (strncmp(name, "cover_land.", 11) == 0) return 2;
+    if (strncmp(name, "small_cover", 11) == 0) return 1;
+    return 0;
+}
+
+// Reads a string element of up to `capacity` - 1 bytes, or leaves it empty
+static void read_string(vp_reader* reader, const mkv_element* element, char* out, size_t capacity) {
+    out[0] = '\0';
+    if (element->size < capacity && vp_reader_read_full(reader, element->data, out, (int64_t)element->size) == 0) {
+        out[element->size] = '\0';
+    }
+}
+
+static void parse_attached_file(vp_reader* reader, const mkv_element* file, mkv_candidate* out) {
+    char name[256];
+    char mime[64];
+    name[0] = '\0';
+    mime[0] = '\0';
+    int64_t data = -1;
+    uint64_t data_size = 0;
+
+    int64_t end = file->data + (int64_t)file->size;
+    mkv_element element;
+    for (int64_t offset = file->data; read_element(reader, offset, end, &element);) {
+        if (element.size == MKV_UNKNOWN_SIZE) break;
+        if (element.id == MKV_ID_FILE_NAME) {
+            read_string(reader, &element, name, sizeof(name));
+        } else if (element.id == MKV_ID_FILE_MIME_TYPE) {
+            read_string(reader, &element, mime, sizeof(mime));
+        } else if (element.id == MKV_ID_FILE_DATA) {
+            data = element.data;
+            data_size = element.size;
+        }
+        offset = element.data + (int64_t)element.size;
+    }
+
+    out->rank = data >= 0 && data_size > 0 && data_size <= MKV_MAX_IMAGE_SIZE ? cover_rank(name, mime) : -1;
+    out->offset = data;
+    out->size = data_size;
+}
+
+int vp_mkv_cover(vp_reader* reader, vp_arena* arena, vp_embedded_image* out) {
+    if (reader == NULL || arena == NULL || out == NULL) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+    memset(out, 0, sizeof(*out));
+
+    int64_t file_end = reader->size >= 0 ? reader->size : INT64_MAX;
+    mkv_element element;
+    if (!read_element(reader, 0, file_end, &element) || element.id != MKV_ID_EBML ||
+        element.size == MKV_UNKNOWN_SIZE) {
+        return VP_ERROR_UNSUPPORTED;
+    }
+    // Truncated files keep the Segment size of the complete file
+    mkv_element segment;
+    if (!read_element(reader, element.data + (int64_t)element.size, INT64_MAX, &segment) ||
+        segment.id != MKV_ID_SEGMENT) {
+        return VP_ERROR_UNSUPPORTED;
+    }
+    int64_t segment_end = segment.size == MKV_UNKNOWN_SIZE || segment.size > (uint64_t)(file_end - segment.data)
+        ? file_end
+        : segment.data + (int64_t)segment.size;
+
+    // Attachments usually precede the first Cluster; muxers that write
+    // them last point to them from the SeekHead
+    int64_t attachments = -1;
+    int64_t sought = -1;
+    for (int64_t offset = segment.data; attachments < 0 && read_element(reader, offset, segment_end, &element);) {
+        if (element.id == MKV_ID_ATTACHMENTS) {
+            attachments = offset;
+        } else if (element.id == MKV_ID_CLUSTER || element.size == MKV_UNKNOWN_SIZE) {
+            break;
+        } else if (element.id == MKV_ID_SEEK_HEAD && sought < 0) {
+            sought = seek_attachments(reader, &element, segment.data);
+        }
+        offset = element.data + (int64_t)element.size;
+    }
+    if (attachments < 0) {
+        attachments = sought;
+    }
+    if (attachments < 0 || !read_element(reader, attachments, segment_end, &element) ||
+        element.id != MKV_ID_ATTACHMENTS || element.size == MKV_UNKNOWN_SIZE) {
+        return VP_ERROR_NOT_FOUND;
+    }
+
+    mkv_candidate best = { -1, 0, 0 };
+    int64_t end = element.data + (int64_t)element.size;
+    mkv_element file;
+    for (int64_t offset = element.data; read_element(reader, offset, end, &file);) {
+        if (file.size == MKV_UNKNOWN_SIZE) break;
+        if (file.id == MKV_ID_ATTACHED_FILE) {
+            mkv_candidate candidate;
+            parse_attached_file(reader, &file, &candidate);
+            if (candidate.rank > best.rank) {
+                best = candidate;
+            }
+        }
+        offset = file.data + (int64_t)file.size;
+    }
+    if (best.rank < 0) {
+        return VP_ERROR_NOT_FOUND;
+    }
+
+    uint8_t* data = (uint8_t*)vp_arena_alloc(arena, (size_t)best.size);
+    if (data == NULL) {
+        return VP_ERROR_NO_MEMORY;
+    }
+    if (vp_reader_read_full(reader, best.offset, data, (int64_t)best.size) != 0) {
+        return VP_ERROR_FAILED;
+    }
+    // The MIME type is only a claim
+    int format = vp_image_format(data, (size_t)best.size);
+    if (format == 0) {
+        return VP_ERROR_NOT_FOUND;
+    }
+    out->data = data;
+    out->size = (size_t)best.size;
+    out->format = format;
+    return VP_OK;
+}
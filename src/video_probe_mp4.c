@@ -0,0 +1,1265 @@
+/**
+ * Native ISO-BMFF (MP4/MOV/M4V/3GP) metadata parser.
+ *
+ * Walks the top-level box headers, loads `moov` in one read and answers
+ * everything vp_media_info needs from the sample descriptions and index
+ * tables, without building a GStreamer pipeline. Anything it cannot answer
+ * completely is reported as VP_ERROR_UNSUPPORTED so callers can fall back
+ * to the platform framework.
+ */
+
+#include "video_probe_internal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FOURCC(a, b, c, d) \
+    (((uint32_t)(a) << 24) | ((uint32_t)(b) << 16) | ((uint32_t)(c) << 8) | (uint32_t)(d))
+
+// moov boxes beyond this size are treated as corrupt
+#define MP4_MAX_MOOV_SIZE (256 * 1024 * 1024)
+#define MP4_MAX_MOOF_SIZE (16 * 1024 * 1024)
+#define MP4_MAX_TRACKS 32
+
+// Partial files: bytes requested past an unavailable top-level header, so
+// a small box (usually moov) arrives together with it, and the window
+// fetched from either end while moov has not been located yet.
+#define MP4_HEADER_READAHEAD (64 * 1024)
+#define MP4_PARTIAL_HEAD_SIZE (64 * 1024)
+#define MP4_PARTIAL_TAIL_SIZE (1024 * 1024)
+
+typedef struct {
+    const uint8_t* data;
+    size_t size;
+} span;
+
+typedef struct {
+    const uint8_t* p;
+    const uint8_t* end;
+} box_iter;
+
+typedef struct {
+    uint32_t track_id;
+    uint32_t handler;
+    uint32_t timescale;
+    uint64_t duration;
+    uint64_t sample_count;
+    uint64_t sample_bytes;
+    uint64_t fragment_duration;
+    uint32_t trex_default_duration;
+    vp_stream_info stream;
+} mp4_track;
+
+typedef struct {
+    vp_arena* arena;
+    uint32_t major_brand;
+    uint32_t movie_timescale;
+    uint64_t movie_duration;
+    uint64_t fragment_duration;
+    int fragmented;
+    int track_count;
+    mp4_track tracks[MP4_MAX_TRACKS];
+    // Ranges the reader could not serve yet, for partial files
+    vp_byte_range needed[VP_MP4_MAX_NEEDED];
+    int need_count;
+    // Sample index of the first video track: INDEX_KEYFRAMES fills the
+    // sync sample times for vp_mp4_keyframes(), INDEX_SAMPLES every
+    // sample for vp_mp4_samples(), INDEX_INTRA_SAMPLES the same for
+    // vp_mp4_intra_samples() when every sample is a sync sample
+    int want_index;
+    int index_done;
+    double* keyframes;
+    int keyframe_count;
+    vp_mp4_sample* samples;
+    int sample_count;
+    // The track the index was taken from
+    int index_track;
+    // Embedded image for vp_mp4_cover()
+    int want_cover;
+    vp_embedded_image cover;
+} mp4_parser;
+
+#define INDEX_KEYFRAMES 1
+#define INDEX_SAMPLES 2
+#define INDEX_INTRA_SAMPLES 3
+
+static uint16_t rd16(const uint8_t* p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static uint32_t rd32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static uint64_t rd64(const uint8_t* p) {
+    return ((uint64_t)rd32(p) << 32) | rd32(p + 4);
+}
+
+static box_iter iter_of(span s) {
+    box_iter it = { s.data, s.data + s.size };
+    return it;
+}
+
+// Advance to the next child box. Returns 0 when exhausted or malformed.
+static int next_box(box_iter* it, uint32_t* type, span* payload) {
+    size_t left = (size_t)(it->end - it->p);
+    if (left < 8) {
+        return 0;
+    }
+    uint64_t size = rd32(it->p);
+    size_t header = 8;
+    *type = rd32(it->p + 4);
+    if (size == 1) {
+        if (left < 16) return 0;
+        size = rd64(it->p + 8);
+        header = 16;
+    } else if (size == 0) {
+        size = left;
+    }
+    if (size < header || size > left) {
+        return 0;
+    }
+    payload->data = it->p + header;
+    payload->size = (size_t)size - header;
+    it->p += size;
+    return 1;
+}
+
+static int find_box(span parent, uint32_t type, span* out) {
+    box_iter it = iter_of(parent);
+    uint32_t child_type;
+    span child;
+    while (next_box(&it, &child_type, &child)) {
+        if (child_type == type) {
+            *out = child;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Follow a path of nested box types, e.g. mdia/minf/stbl
+static int find_path(span parent, const uint32_t* types, int count, span* out) {
+    span current = parent;
+    for (int i = 0; i < count; i++) {
+        if (!find_box(current, types[i], &current)) {
+            return 0;
+        }
+    }
+    *out = current;
+    return 1;
+}
+
+static uint32_t gcd_u64(uint64_t a, uint64_t b) {
+    while (b != 0) {
+        uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return (uint32_t)a;
+}
+
+// Snap an average rate to the nearest common broadcast rate, otherwise keep
+// three decimal places.
+static void fps_from_average(double fps, int* num, int* den) {
+    static const int rates[][2] = {
+        { 24000, 1001 }, { 24, 1 }, { 25, 1 }, { 30000, 1001 }, { 30, 1 },
+        { 48, 1 }, { 50, 1 }, { 60000, 1001 }, { 60, 1 }, { 100, 1 },
+        { 120000, 1001 }, { 120, 1 },
+    };
+    for (size_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+        double rate = (double)rates[i][0] / rates[i][1];
+        if (fps > rate * 0.999 && fps < rate * 1.001) {
+            *num = rates[i][0];
+            *den = rates[i][1];
+            return;
+        }
+    }
+    uint64_t n = (uint64_t)(fps * 1000.0 + 0.5);
+    uint32_t g = n > 0 ? gcd_u64(n, 1000) : 1;
+    *num = (int)(n / g);
+    *den = (int)(1000 / g);
+}
+
+static const char* codec_from_fourcc(vp_arena* arena, uint32_t fourcc) {
+    static const struct { uint32_t fourcc; const char* codec; } table[] = {
+        { FOURCC('a', 'v', 'c', '1'), "h264" },
+        { FOURCC('a', 'v', 'c', '3'), "h264" },
+        { FOURCC('h', 'v', 'c', '1'), "hevc" },
+        { FOURCC('h', 'e', 'v', '1'), "hevc" },
+        { FOURCC('v', 'p', '0', '8'), "vp8" },
+        { FOURCC('v', 'p', '0', '9'), "vp9" },
+        { FOURCC('a', 'v', '0', '1'), "av1" },
+        { FOURCC('m', 'p', '4', 'v'), "mpeg4" },
+        { FOURCC('j', 'p', 'e', 'g'), "mjpeg" },
+        { FOURCC('m', 'j', 'p', 'a'), "mjpeg" },
+        { FOURCC('m', 'j', 'p', 'b'), "mjpeg" },
+        { FOURCC('a', 'p', 'c', 'h'), "prores" },
+        { FOURCC('a', 'p', 'c', 'n'), "prores" },
+        { FOURCC('a', 'p', 'c', 's'), "prores" },
+        { FOURCC('a', 'p', 'c', 'o'), "prores" },
+        { FOURCC('a', 'p', '4', 'h'), "prores" },
+        { FOURCC('a', 'p', '4', 'x'), "prores" },
+        { FOURCC('A', 'V', 'd', 'n'), "dnxhd" },
+        { FOURCC('A', 'V', 'd', 'h'), "dnxhd" },
+        { FOURCC('p', 'n', 'g', ' '), "png" },
+        { FOURCC('m', 'p', '4', 'a'), "aac" },
+        { FOURCC('.', 'm', 'p', '3'), "mp3" },
+        { FOURCC('a', 'c', '-', '3'), "ac3" },
+        { FOURCC('e', 'c', '-', '3'), "eac3" },
+        { FOURCC('O', 'p', 'u', 's'), "opus" },
+        { FOURCC('f', 'L', 'a', 'C'), "flac" },
+        { FOURCC('a', 'l', 'a', 'c'), "alac" },
+        { FOURCC('l', 'p', 'c', 'm'), "pcm" },
+        { FOURCC('s', 'o', 'w', 't'), "pcm" },
+        { FOURCC('t', 'w', 'o', 's'), "pcm" },
+        { FOURCC('i', 'n', '2', '4'), "pcm" },
+        { FOURCC('i', 'n', '3', '2'), "pcm" },
+        { FOURCC('f', 'l', '3', '2'), "pcm" },
+        { FOURCC('f', 'l', '6', '4'), "pcm" },
+        { FOURCC('r', 'a', 'w', ' '), "pcm" },
+        { FOURCC('t', 'x', '3', 'g'), "text" },
+        { FOURCC('w', 'v', 't', 't'), "webvtt" },
+        { FOURCC('s', 't', 'p', 'p'), "ttml" },
+        { FOURCC('c', '6', '0', '8'), "cea608" },
+    };
+    for (size_t i = 0; i < sizeof(table) / sizeof(table[0]); i++) {
+        if (table[i].fourcc == fourcc) {
+            return table[i].codec;
+        }
+    }
+
+    char name[5];
+    int len = 0;
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        char c = (char)((fourcc >> shift) & 0xff);
+        if (c != ' ' && c != '\0') {
+            name[len++] = c;
+        }
+    }
+    name[len] = '\0';
+    return len > 0 ? vp_arena_strdup(arena, name) : "unknown";
+}
+
+// Read an MPEG-4 descriptor header (tag + variable-length size)
+static int read_descriptor(const uint8_t** p, const uint8_t* end, uint8_t* tag, size_t* size) {
+    if (*p >= end) return 0;
+    *tag = *(*p)++;
+    size_t len = 0;
+    for (int i = 0; i < 4; i++) {
+        if (*p >= end) return 0;
+        uint8_t b = *(*p)++;
+        len = (len << 7) | (b & 0x7f);
+        if (!(b & 0x80)) break;
+    }
+    if (len > (size_t)(end - *p)) return 0;
+    *size = len;
+    return 1;
+}
+
+// Extract objectTypeIndication and average bitrate from an esds box
+static int parse_esds(span esds, uint8_t* object_type, uint32_t* avg_bitrate) {
+    if (esds.size < 4) return 0;
+    const uint8_t* p = esds.data + 4;
+    const uint8_t* end = esds.data + esds.size;
+    uint8_t tag;
+    size_t size;
+
+    if (!read_descriptor(&p, end, &tag, &size) || tag != 0x03 || size < 3) return 0;
+    end = p + size;
+    uint8_t flags = p[2];
+    p += 3;
+    if (flags & 0x80) p += 2;
+    if (flags & 0x40) {
+        if (p >= end) return 0;
+        p += 1 + *p;
+    }
+    if (flags & 0x20) p += 2;
+    if (p >= end) return 0;
+
+    if (!read_descriptor(&p, end, &tag, &size) || tag != 0x04 || size < 13) return 0;
+    *object_type = p[0];
+    *avg_bitrate = rd32(p + 9);
+    return 1;
+}
+
+static void parse_colr(span colr, vp_stream_info* stream) {
+    if (colr.size < 10) return;
+    uint32_t kind = rd32(colr.data);
+    if (kind != FOURCC('n', 'c', 'l', 'x') && kind != FOURCC('n', 'c', 'l', 'c')) return;
+    stream->color_primaries = rd16(colr.data + 4);
+    stream->transfer = rd16(colr.data + 6);
+}
+
+static int avc_has_high_bit_depth_fields(uint8_t profile) {
+    switch (profile) {
+        case 100: case 110: case 122: case 244: case 44:
+        case 83: case 86: case 118: case 128: case 138: case 139: case 134: case 135:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+// High profiles append chroma format and bit depth after the parameter sets
+static int bit_depth_from_avcc(span avcc) {
+    const uint8_t* p = avcc.data;
+    const uint8_t* end = avcc.data + avcc.size;
+    if (avcc.size < 7 || !avc_has_high_bit_depth_fields(p[1])) return 8;
+
+    int sps_count = p[5] & 0x1f;
+    p += 6;
+    for (int i = 0; i < sps_count; i++) {
+        if (end - p < 2) return 8;
+        p += 2 + rd16(p);
+    }
+    if (end - p < 1) return 8;
+    int pps_count = *p++;
+    for (int i = 0; i < pps_count; i++) {
+        if (end - p < 2) return 8;
+        p += 2 + rd16(p);
+    }
+    if (end - p < 2) return 8;
+    return (p[1] & 0x07) + 8;
+}
+
+static void parse_visual_entry(mp4_track* track, uint32_t fourcc, span entry) {
+    vp_stream_info* stream = &track->stream;
+    // SampleEntry (8) + VisualSampleEntry fixed fields (70)
+    if (entry.size < 78) return;
+    stream->width = rd16(entry.data + 24);
+    stream->height = rd16(entry.data + 26);
+    stream->par_num = 1;
+    stream->par_den = 1;
+    stream->bit_depth = 8;
+    stream->color_primaries = 2;
+    stream->transfer = 2;
+
+    span children = { entry.data + 78, entry.size - 78 };
+    span box;
+    if (find_box(children, FOURCC('a', 'v', 'c', 'C'), &box)) {
+        stream->bit_depth = bit_depth_from_avcc(box);
+    }
+    if (find_box(children, FOURCC('h', 'v', 'c', 'C'), &box) && box.size >= 18) {
+        stream->bit_depth = (box.data[17] & 0x07) + 8;
+    }
+    if (find_box(children, FOURCC('v', 'p', 'c', 'C'), &box) && box.size >= 10) {
+        // FullBox header, profile, level, then bitDepth in the high nibble
+        stream->bit_depth = box.data[6] >> 4;
+        stream->color_primaries = box.data[7];
+        stream->transfer = box.data[8];
+    }
+    if (find_box(children, FOURCC('a', 'v', '1', 'C'), &box) && box.size >= 3) {
+        int high_bitdepth = (box.data[2] >> 6) & 1;
+        int twelve_bit = (box.data[2] >> 5) & 1;
+        stream->bit_depth = twelve_bit ? 12 : (high_bitdepth ? 10 : 8);
+    }
+    if (find_box(children, FOURCC('c', 'o', 'l', 'r'), &box)) {
+        parse_colr(box, stream);
+    }
+    if (find_box(children, FOURCC('p', 'a', 's', 'p'), &box) && box.size >= 8) {
+        uint32_t h = rd32(box.data);
+        uint32_t v = rd32(box.data + 4);
+        if (h > 0 && v > 0) {
+            stream->par_num = (int)h;
+            stream->par_den = (int)v;
+        }
+    }
+    if (find_box(children, FOURCC('b', 't', 'r', 't'), &box) && box.size >= 12) {
+        stream->bitrate = rd32(box.data + 8);
+    }
+    if (fourcc == FOURCC('m', 'p', '4', 'v') && find_box(children, FOURCC('e', 's', 'd', 's'), &box)) {
+        uint8_t object_type = 0;
+        uint32_t avg_bitrate = 0;
+        if (parse_esds(box, &object_type, &avg_bitrate)) {
+            if (object_type >= 0x60 && object_type <= 0x65) stream->codec = "mpeg2video";
+            else if (object_type == 0x6A) stream->codec = "mpeg1video";
+            else if (object_type == 0x6C) stream->codec = "mjpeg";
+            if (stream->bitrate == 0) stream->bitrate = avg_bitrate;
+        }
+    }
+    // PQ and HLG are the two HDR transfer functions in use
+    stream->is_hdr = stream->transfer == 16 || stream->transfer == 18;
+}
+
+static void parse_audio_entry(mp4_track* track, uint32_t fourcc, span entry) {
+    vp_stream_info* stream = &track->stream;
+    // SampleEntry (8) + AudioSampleEntry fixed fields (20)
+    if (entry.size < 28) return;
+    uint16_t version = rd16(entry.data + 8);
+    stream->channels = rd16(entry.data + 16);
+    stream->bit_depth = rd16(entry.data + 18);
+    stream->sample_rate = (int)(rd32(entry.data + 24) >> 16);
+
+    size_t children_offset = 28;
+    if (version == 1) {
+        children_offset += 16;
+    } else if (version == 2 && entry.size >= 64) {
+        // QuickTime sound description v2 stores a float64 rate and a
+        // 32-bit channel count
+        union { uint64_t u; double d; } rate;
+        rate.u = rd64(entry.data + 32);
+        stream->sample_rate = (int)(rate.d + 0.5);
+        stream->channels = (int)rd32(entry.data + 40);
+        stream->bit_depth = (int)rd32(entry.data + 48);
+        children_offset += 36;
+    }
+    if (entry.size < children_offset) return;
+
+    span children = { entry.data + children_offset, entry.size - children_offset };
+    span box;
+    if (find_box(children, FOURCC('b', 't', 'r', 't'), &box) && box.size >= 12) {
+        stream->bitrate = rd32(box.data + 8);
+    }
+    if (fourcc == FOURCC('m', 'p', '4', 'a')) {
+        // QuickTime nests esds inside a 'wave' box
+        span wave;
+        int found = find_box(children, FOURCC('e', 's', 'd', 's'), &box) ||
+                    (find_box(children, FOURCC('w', 'a', 'v', 'e'), &wave) &&
+                     find_box(wave, FOURCC('e', 's', 'd', 's'), &box));
+        uint8_t object_type = 0;
+        uint32_t avg_bitrate = 0;
+        if (found && parse_esds(box, &object_type, &avg_bitrate)) {
+            if (object_type == 0x69 || object_type == 0x6B) stream->codec = "mp3";
+            if (stream->bitrate == 0) stream->bitrate = avg_bitrate;
+        }
+    }
+}
+
+// Encrypted entries ('encv', 'enca') carry the real format in sinf/frma
+static uint32_t original_format(uint32_t fourcc, span entry, size_t children_offset) {
+    if (fourcc != FOURCC('e', 'n', 'c', 'v') && fourcc != FOURCC('e', 'n', 'c', 'a')) {
+        return fourcc;
+    }
+    if (entry.size < children_offset) return fourcc;
+    span children = { entry.data + children_offset, entry.size - children_offset };
+    span sinf, frma;
+    if (find_box(children, FOURCC('s', 'i', 'n', 'f'), &sinf) &&
+        find_box(sinf, FOURCC('f', 'r', 'm', 'a'), &frma) && frma.size >= 4) {
+        return rd32(frma.data);
+    }
+    return fourcc;
+}
+
+static void parse_stsd(mp4_parser* parser, mp4_track* track, span stsd) {
+    if (stsd.size < 8 || rd32(stsd.data + 4) == 0) return;
+    span entries = { stsd.data + 8, stsd.size - 8 };
+    box_iter it = iter_of(entries);
+    uint32_t fourcc;
+    span entry;
+    if (!next_box(&it, &fourcc, &entry)) return;
+
+    vp_stream_info* stream = &track->stream;
+    if (stream->type == VP_STREAM_VIDEO) {
+        fourcc = original_format(fourcc, entry, 78);
+        stream->codec = codec_from_fourcc(parser->arena, fourcc);
+        parse_visual_entry(track, fourcc, entry);
+    } else if (stream->type == VP_STREAM_AUDIO) {
+        fourcc = original_format(fourcc, entry, 28);
+        stream->codec = codec_from_fourcc(parser->arena, fourcc);
+        parse_audio_entry(track, fourcc, entry);
+    } else {
+        stream->codec = codec_from_fourcc(parser->arena, fourcc);
+    }
+}
+
+// Derive frame rate from the time-to-sample table
+static void parse_stts(mp4_track* track, span stts) {
+    if (stts.size < 8 || track->stream.type != VP_STREAM_VIDEO) return;
+    uint32_t entries = rd32(stts.data + 4);
+    if (entries == 1 && stts.size >= 16) {
+        uint32_t delta = rd32(stts.data + 12);
+        if (delta > 0 && track->timescale > 0) {
+            uint32_t g = gcd_u64(track->timescale, delta);
+            track->stream.fps_num = (int)(track->timescale / g);
+            track->stream.fps_den = (int)(delta / g);
+        }
+    }
+}
+
+static void parse_stsz(mp4_track* track, span stsz) {
+    if (stsz.size < 12) return;
+    uint32_t sample_size = rd32(stsz.data + 4);
+    uint32_t count = rd32(stsz.data + 8);
+    track->sample_count = count;
+    if (sample_size != 0) {
+        track->sample_bytes = (uint64_t)sample_size * count;
+        return;
+    }
+    if (stsz.size < 12 + (size_t)count * 4) return;
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        total += rd32(stsz.data + 12 + (size_t)i * 4);
+    }
+    track->sample_bytes = total;
+}
+
+// Media time the edit list starts presentation at, in track timescale
+// units; muxers shift B-frame streams this way so the first frame shows
+// at 0
+static int64_t edit_media_start(span trak) {
+    static const uint32_t elst_path[] = { FOURCC('e', 'd', 't', 's'), FOURCC('e', 'l', 's', 't') };
+    span elst;
+    if (!find_path(trak, elst_path, 2, &elst) || elst.size < 8) return 0;
+    int version = elst.data[0];
+    uint32_t entries = rd32(elst.data + 4);
+    size_t entry_size = version == 1 ? 20 : 12;
+    for (uint32_t i = 0; i < entries && 8 + (size_t)(i + 1) * entry_size <= elst.size; i++) {
+        const uint8_t* entry = elst.data + 8 + (size_t)i * entry_size;
+        int64_t media_time = version == 1 ? (int64_t)rd64(entry + 8) : (int32_t)rd32(entry + 4);
+        // -1 marks an empty edit, a gap before the media starts
+        if (media_time >= 0) return media_time;
+    }
+    return 0;
+}
+
+// File offsets of `count` samples in decode order, from the chunk offsets
+// in stco or co64 and the samples per chunk in stsc. Offsets stay 0 from
+// the first sample of unknown size, or all of them without the tables.
+static void parse_sample_offsets(span stbl, vp_mp4_sample* samples, int count) {
+    span stsc, stco;
+    int wide = find_box(stbl, FOURCC('c', 'o', '6', '4'), &stco);
+    if (!wide && !find_box(stbl, FOURCC('s', 't', 'c', 'o'), &stco)) return;
+    if (!find_box(stbl, FOURCC('s', 't', 's', 'c'), &stsc) || stsc.size < 8 || stco.size < 8) return;
+    uint32_t stsc_entries = rd32(stsc.data + 4);
+    uint32_t chunk_count = rd32(stco.data + 4);
+    size_t offset_size = wide ? 8 : 4;
+    if (stsc.size < 8 + (size_t)stsc_entries * 12 || stco.size < 8 + (size_t)chunk_count * offset_size) return;
+
+    int sample = 0;
+    for (uint32_t i = 0; i < stsc_entries && sample < count; i++) {
+        const uint8_t* entry = stsc.data + 8 + (size_t)i * 12;
+        uint32_t first_chunk = rd32(entry);
+        uint32_t per_chunk = rd32(entry + 4);
+        // An entry runs up to the next one's first chunk, the last one to
+        // the end of the table
+        uint32_t last_chunk = i + 1 < stsc_entries ? rd32(entry + 12) - 1 : chunk_count;
+        if (first_chunk == 0) return;
+        if (last_chunk > chunk_count) last_chunk = chunk_count;
+        for (uint32_t chunk = first_chunk; chunk <= last_chunk && sample < count; chunk++) {
+            const uint8_t* chunk_offset = stco.data + 8 + (size_t)(chunk - 1) * offset_size;
+            uint64_t offset = wide ? rd64(chunk_offset) : rd32(chunk_offset);
+            for (uint32_t j = 0; j < per_chunk && sample < count; j++, sample++) {
+                if (samples[sample].size == 0 || offset > INT64_MAX) return;
+                samples[sample].offset = (int64_t)offset;
+                offset += samples[sample].size;
+            }
+        }
+    }
+}
+
+// Presentation times of the samples, from the decode times in stts, the
+// composition offsets in ctts and the sample numbers in stss; with
+// INDEX_SAMPLES also their sizes from stsz, dependencies from sdtp and
+// offsets from the chunk tables
+static void parse_sample_index(mp4_parser* parser, const mp4_track* track, span trak, span stbl) {
+    span stts = { 0 }, stss = { 0 }, ctts = { 0 }, stsz = { 0 }, sdtp = { 0 };
+    if (track->timescale == 0 || !find_box(stbl, FOURCC('s', 't', 't', 's'), &stts) || stts.size < 8) return;
+    uint32_t stts_entries = rd32(stts.data + 4);
+    if (stts.size < 8 + (size_t)stts_entries * 8) return;
+
+    // Without stss every sample is a sync sample
+    int has_stss = find_box(stbl, FOURCC('s', 't', 's', 's'), &stss) && stss.size >= 8;
+    uint32_t sync_count = has_stss ? rd32(stss.data + 4) : 0;
+    if (has_stss && stss.size < 8 + (size_t)sync_count * 4) return;
+    uint32_t ctts_entries = 0;
+    if (find_box(stbl, FOURCC('c', 't', 't', 's'), &ctts) && ctts.size >= 8) {
+        ctts_entries = rd32(ctts.data + 4);
+        if (ctts.size < 8 + (size_t)ctts_entries * 8) ctts_entries = 0;
+    }
+
+    uint64_t sample_count = 0;
+    for (uint32_t i = 0; i < stts_entries; i++) {
+        sample_count += rd32(stts.data + 8 + (size_t)i * 8);
+    }
+    // A track with samples missing from stss is not all-intra; settle
+    // that before allocating the table
+    if (parser->want_index == INDEX_INTRA_SAMPLES && has_stss && sync_count < sample_count) {
+        parser->index_done = 1;
+        return;
+    }
+    int want_samples = parser->want_index != INDEX_KEYFRAMES;
+    uint64_t capacity = has_stss && !want_samples ? sync_count : sample_count;
+    if (capacity == 0 || capacity > INT32_MAX) return;
+    double* times = NULL;
+    vp_mp4_sample* samples = NULL;
+    if (want_samples) {
+        samples = (vp_mp4_sample*)vp_arena_alloc(parser->arena, sizeof(vp_mp4_sample) * (size_t)capacity);
+        if (samples == NULL) return;
+    } else {
+        times = (double*)vp_arena_alloc(parser->arena, sizeof(double) * (size_t)capacity);
+        if (times == NULL) return;
+    }
+
+    // Sizes and dependencies are optional; missing or short tables leave
+    // them unknown
+    uint32_t constant_size = 0;
+    uint32_t size_count = 0;
+    if (want_samples && find_box(stbl, FOURCC('s', 't', 's', 'z'), &stsz) && stsz.size >= 12) {
+        constant_size = rd32(stsz.data + 4);
+        size_count = rd32(stsz.data + 8);
+        if (constant_size == 0 && stsz.size < 12 + (size_t)size_count * 4) size_count = 0;
+    }
+    uint32_t dependency_count = 0;
+    if (want_samples && find_box(stbl, FOURCC('s', 'd', 't', 'p'), &sdtp) && sdtp.size >= 4) {
+        dependency_count = (uint32_t)(sdtp.size - 4);
+    }
+
+    int64_t media_start = edit_media_start(trak);
+    int64_t dts = 0;
+    uint32_t sample = 1;
+    uint32_t sync_index = 0;
+    uint32_t ctts_index = 0;
+    uint32_t ctts_left = 0;
+    int64_t ctts_offset = 0;
+    int count = 0;
+    for (uint32_t i = 0; i < stts_entries && (uint64_t)count < capacity; i++) {
+        uint32_t samples_in_run = rd32(stts.data + 8 + (size_t)i * 8);
+        uint32_t delta = rd32(stts.data + 12 + (size_t)i * 8);
+        for (uint32_t j = 0; j < samples_in_run && (uint64_t)count < capacity; j++, sample++) {
+            while (ctts_left == 0 && ctts_index < ctts_entries) {
+                ctts_left = rd32(ctts.data + 8 + (size_t)ctts_index * 8);
+                // Version 0 offsets are unsigned, but never large enough
+                // for the sign to matter
+                ctts_offset = (int32_t)rd32(ctts.data + 12 + (size_t)ctts_index * 8);
+                ctts_index++;
+            }
+            int64_t offset = 0;
+            if (ctts_left > 0) {
+                offset = ctts_offset;
+                ctts_left--;
+            }
+
+            int sync = !has_stss;
+            while (has_stss && sync_index < sync_count && rd32(stss.data + 8 + (size_t)sync_index * 4) < sample) {
+                sync_index++;
+            }
+            if (has_stss && sync_index < sync_count && rd32(stss.data + 8 + (size_t)sync_index * 4) == sample) {
+                sync = 1;
+                sync_index++;
+            }
+            int64_t pts = dts + offset - media_start;
+            double time = pts > 0 ? (double)pts / track->timescale : 0.0;
+            if (want_samples) {
+                vp_mp4_sample* out = &samples[count++];
+                out->time = time;
+                out->flags = sync ? VP_MP4_SAMPLE_SYNC : 0;
+                if (sample <= size_count) {
+                    out->size = constant_size != 0 ? constant_size : rd32(stsz.data + 12 + (size_t)(sample - 1) * 4);
+                }
+                // sample_is_depended_on: 2 means no other sample refers
+                // to this one
+                if (sample <= dependency_count && ((sdtp.data[4 + sample - 1] >> 2) & 3) == 2) {
+                    out->flags |= VP_MP4_SAMPLE_DISPOSABLE;
+                }
+            } else if (sync) {
+                times[count++] = time;
+            }
+            dts += delta;
+        }
+    }
+    if (want_samples) {
+        parse_sample_offsets(stbl, samples, count);
+    }
+    parser->keyframes = times;
+    parser->samples = samples;
+    if (want_samples) {
+        parser->sample_count = count;
+    } else {
+        parser->keyframe_count = count;
+    }
+    parser->index_done = 1;
+}
+
+static int rotation_from_matrix(const uint8_t* m) {
+    int32_t a = (int32_t)rd32(m);
+    int32_t b = (int32_t)rd32(m + 4);
+    int32_t c = (int32_t)rd32(m + 12);
+    int32_t d = (int32_t)rd32(m + 16);
+    if (a == 0 && d == 0 && b > 0 && c < 0) return 90;
+    if (a < 0 && d < 0 && b == 0 && c == 0) return 180;
+    if (a == 0 && d == 0 && b < 0 && c > 0) return 270;
+    return 0;
+}
+
+static void parse_tkhd(mp4_track* track, span tkhd) {
+    if (tkhd.size < 4) return;
+    int version = tkhd.data[0];
+    size_t id_offset = version == 1 ? 20 : 12;
+    size_t matrix_offset = version == 1 ? 52 : 40;
+    if (tkhd.size < matrix_offset + 36) return;
+    track->track_id = rd32(tkhd.data + id_offset);
+    track->stream.rotation = rotation_from_matrix(tkhd.data + matrix_offset);
+}
+
+static void parse_mdhd(mp4_parser* parser, mp4_track* track, span mdhd) {
+    if (mdhd.size < 4) return;
+    int version = mdhd.data[0];
+    const uint8_t* p = mdhd.data + (version == 1 ? 20 : 12);
+    size_t needed = version == 1 ? 34 : 22;
+    if (mdhd.size < needed) return;
+    track->timescale = rd32(p);
+    track->duration = version == 1 ? rd64(p + 4) : rd32(p + 4);
+    uint16_t lang = rd16(p + (version == 1 ? 12 : 8));
+
+    // Packed ISO-639-2/T; values below 0x400 are QuickTime language codes
+    if (lang >= 0x400 && lang != 0x7fff) {
+        char code[4] = {
+            (char)(((lang >> 10) & 0x1f) + 0x60),
+            (char)(((lang >> 5) & 0x1f) + 0x60),
+            (char)((lang & 0x1f) + 0x60),
+            '\0',
+        };
+        if (strcmp(code, "und") != 0) {
+            track->stream.language = vp_arena_strdup(parser->arena, code);
+        }
+    }
+}
+
+static void parse_trak(mp4_parser* parser, span trak) {
+    if (parser->track_count >= MP4_MAX_TRACKS) return;
+    mp4_track* track = &parser->tracks[parser->track_count];
+    memset(track, 0, sizeof(*track));
+
+    span mdia, box;
+    if (!find_box(trak, FOURCC('m', 'd', 'i', 'a'), &mdia)) return;
+    if (!find_box(mdia, FOURCC('h', 'd', 'l', 'r'), &box) || box.size < 12) return;
+    track->handler = rd32(box.data + 8);
+
+    switch (track->handler) {
+        case FOURCC('v', 'i', 'd', 'e'):
+            track->stream.type = VP_STREAM_VIDEO;
+            break;
+        case FOURCC('s', 'o', 'u', 'n'):
+            track->stream.type = VP_STREAM_AUDIO;
+            break;
+        case FOURCC('s', 'b', 't', 'l'):
+        case FOURCC('t', 'e', 'x', 't'):
+        case FOURCC('s', 'u', 'b', 't'):
+        case FOURCC('c', 'l', 'c', 'p'):
+            track->stream.type = VP_STREAM_SUBTITLE;
+            break;
+        default:
+            // Hint, timecode and metadata tracks are not media streams
+            return;
+    }
+
+    if (find_box(trak, FOURCC('t', 'k', 'h', 'd'), &box)) parse_tkhd(track, box);
+    if (find_box(mdia, FOURCC('m', 'd', 'h', 'd'), &box)) parse_mdhd(parser, track, box);
+
+    static const uint32_t stbl_path[] = { FOURCC('m', 'i', 'n', 'f'), FOURCC('s', 't', 'b', 'l') };
+    span stbl;
+    if (find_path(mdia, stbl_path, 2, &stbl)) {
+        if (find_box(stbl, FOURCC('s', 't', 's', 'd'), &box)) parse_stsd(parser, track, box);
+        if (find_box(stbl, FOURCC('s', 't', 't', 's'), &box)) parse_stts(track, box);
+        if (find_box(stbl, FOURCC('s', 't', 's', 'z'), &box)) parse_stsz(track, box);
+        if (parser->want_index && !parser->index_done && track->stream.type == VP_STREAM_VIDEO) {
+            parse_sample_index(parser, track, trak, stbl);
+            parser->index_track = parser->track_count;
+        }
+    }
+    if (track->stream.codec == NULL) {
+        track->stream.codec = "unknown";
+    }
+    parser->track_count++;
+}
+
+static mp4_track* track_by_id(mp4_parser* parser, uint32_t track_id) {
+    for (int i = 0; i < parser->track_count; i++) {
+        if (parser->tracks[i].track_id == track_id) {
+            return &parser->tracks[i];
+        }
+    }
+    return NULL;
+}
+
+static void parse_mvex(mp4_parser* parser, span mvex) {
+    parser->fragmented = 1;
+    box_iter it = iter_of(mvex);
+    uint32_t type;
+    span box;
+    while (next_box(&it, &type, &box)) {
+        if (type == FOURCC('m', 'e', 'h', 'd') && box.size >= 8) {
+            parser->fragment_duration = box.data[0] == 1 && box.size >= 12 ? rd64(box.data + 4) : rd32(box.data + 4);
+        } else if (type == FOURCC('t', 'r', 'e', 'x') && box.size >= 24) {
+            mp4_track* track = track_by_id(parser, rd32(box.data + 4));
+            if (track) track->trex_default_duration = rd32(box.data + 12);
+        }
+    }
+}
+
+int vp_image_format(const uint8_t* data, size_t size) {
+    static const uint8_t png[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    if (size >= 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF) return VP_IMAGE_JPEG;
+    if (size >= sizeof(png) && memcmp(data, png, sizeof(png)) == 0) return VP_IMAGE_PNG;
+    return 0;
+}
+
+// Keeps the first JPEG or PNG found
+static void set_cover(mp4_parser* parser, const uint8_t* data, size_t size) {
+    int format = vp_image_format(data, size);
+    if (parser->cover.data != NULL || format == 0) return;
+    uint8_t* copy = (uint8_t*)vp_arena_alloc(parser->arena, size);
+    if (copy == NULL) return;
+    memcpy(copy, data, size);
+    parser->cover.data = copy;
+    parser->cover.size = size;
+    parser->cover.format = format;
+}
+
+// covr holds one data box per image, each starting with a type indicator
+// and a locale; the signature decides the format
+static void parse_meta_cover(mp4_parser* parser, span meta) {
+    // ISO meta is a full box; QuickTime's starts with its first child
+    if (meta.size >= 4 && rd32(meta.data) == 0) {
+        meta.data += 4;
+        meta.size -= 4;
+    }
+    static const uint32_t covr_path[] = { FOURCC('i', 'l', 's', 't'), FOURCC('c', 'o', 'v', 'r') };
+    span covr;
+    if (!find_path(meta, covr_path, 2, &covr)) return;
+    box_iter it = iter_of(covr);
+    uint32_t type;
+    span data;
+    while (parser->cover.data == NULL && next_box(&it, &type, &data)) {
+        if (type == FOURCC('d', 'a', 't', 'a') && data.size > 8) {
+            set_cover(parser, data.data + 8, data.size - 8);
+        }
+    }
+}
+
+static void parse_udta_cover(mp4_parser* parser, span udta) {
+    span box;
+    if (find_box(udta, FOURCC('m', 'e', 't', 'a'), &box)) parse_meta_cover(parser, box);
+    // Canon cameras store a 160x120 JPEG in CNTH/CNDA
+    static const uint32_t cnda_path[] = { FOURCC('C', 'N', 'T', 'H'), FOURCC('C', 'N', 'D', 'A') };
+    if (parser->cover.data == NULL && find_path(udta, cnda_path, 2, &box)) set_cover(parser, box.data, box.size);
+}
+
+static void parse_moov(mp4_parser* parser, span moov) {
+    box_iter it = iter_of(moov);
+    uint32_t type;
+    span box;
+    while (next_box(&it, &type, &box)) {
+        if (type == FOURCC('m', 'v', 'h', 'd') && box.size >= 20) {
+            int version = box.data[0];
+            const uint8_t* p = box.data + (version == 1 ? 20 : 12);
+            if (box.size >= (size_t)(version == 1 ? 32 : 20)) {
+                parser->movie_timescale = rd32(p);
+                parser->movie_duration = version == 1 ? rd64(p + 4) : rd32(p + 4);
+            }
+        } else if (type == FOURCC('t', 'r', 'a', 'k')) {
+            parse_trak(parser, box);
+        } else if (type == FOURCC('u', 'd', 't', 'a') && parser->want_cover) {
+            parse_udta_cover(parser, box);
+        } else if (type == FOURCC('m', 'e', 't', 'a') && parser->want_cover) {
+            parse_meta_cover(parser, box);
+        }
+    }
+    // trex refers to track IDs, so handle mvex once every trak is known
+    if (find_box(moov, FOURCC('m', 'v', 'e', 'x'), &box)) {
+        parse_mvex(parser, box);
+    }
+}
+
+// Count samples and accumulate durations from one movie fragment
+static void parse_moof(mp4_parser* parser, span moof) {
+    box_iter it = iter_of(moof);
+    uint32_t type;
+    span traf;
+    while (next_box(&it, &type, &traf)) {
+        if (type != FOURCC('t', 'r', 'a', 'f')) continue;
+
+        span tfhd;
+        if (!find_box(traf, FOURCC('t', 'f', 'h', 'd'), &tfhd) || tfhd.size < 8) continue;
+        uint32_t tf_flags = rd32(tfhd.data) & 0xffffff;
+        mp4_track* track = track_by_id(parser, rd32(tfhd.data + 4));
+        if (track == NULL) continue;
+
+        uint32_t default_duration = track->trex_default_duration;
+        size_t offset = 8;
+        if (tf_flags & 0x01) offset += 8;
+        if (tf_flags & 0x02) offset += 4;
+        if ((tf_flags & 0x08) && tfhd.size >= offset + 4) default_duration = rd32(tfhd.data + offset);
+
+        box_iter runs = iter_of(traf);
+        span trun;
+        while (next_box(&runs, &type, &trun)) {
+            if (type != FOURCC('t', 'r', 'u', 'n') || trun.size < 8) continue;
+            uint32_t flags = rd32(trun.data) & 0xffffff;
+            uint32_t count = rd32(trun.data + 4);
+            track->sample_count += count;
+
+            size_t pos = 8;
+            if (flags & 0x001) pos += 4;
+            if (flags & 0x004) pos += 4;
+            size_t stride = ((flags & 0x100) ? 4 : 0) + ((flags & 0x200) ? 4 : 0) +
+                            ((flags & 0x400) ? 4 : 0) + ((flags & 0x800) ? 4 : 0);
+            if (!(flags & 0x100)) {
+                track->fragment_duration += (uint64_t)default_duration * count;
+            }
+            if (stride == 0 || trun.size < pos + stride * (size_t)count) continue;
+            for (uint32_t i = 0; i < count; i++) {
+                const uint8_t* sample = trun.data + pos + stride * i;
+                if (flags & 0x100) {
+                    track->fragment_duration += rd32(sample);
+                    sample += 4;
+                }
+                if (flags & 0x200) {
+                    track->sample_bytes += rd32(sample);
+                }
+            }
+        }
+    }
+}
+
+// Returns 0, VP_READ_UNAVAILABLE or -1, like vp_reader_read_full()
+static int read_box(vp_reader* reader, int64_t offset, uint64_t size, size_t max, uint8_t** out) {
+    if (size > max) return -1;
+    uint8_t* data = (uint8_t*)malloc(size > 0 ? (size_t)size : 1);
+    if (data == NULL) return -1;
+    int result = vp_reader_read_full(reader, offset, data, (int64_t)size);
+    if (result != 0) {
+        free(data);
+        return result;
+    }
+    *out = data;
+    return 0;
+}
+
+static void add_needed(mp4_parser* parser, int64_t offset, int64_t length) {
+    if (parser->need_count < VP_MP4_MAX_NEEDED && length > 0) {
+        parser->needed[parser->need_count].offset = offset;
+        parser->needed[parser->need_count].length = length;
+        parser->need_count++;
+    }
+}
+
+// A top-level box header is not downloaded yet. Ask for it with some
+// read-ahead and, until moov turns up, for both ends of the file, where
+// muxers put it.
+static int need_header(mp4_parser* parser, vp_reader* reader, int64_t offset) {
+    int64_t length = MP4_HEADER_READAHEAD;
+    if (reader->size > 0 && offset + length > reader->size) {
+        length = reader->size - offset;
+    }
+    add_needed(parser, offset, length);
+    if (reader->size > 0) {
+        add_needed(parser, 0, reader->size < MP4_PARTIAL_HEAD_SIZE ? reader->size : MP4_PARTIAL_HEAD_SIZE);
+        int64_t tail = reader->size < MP4_PARTIAL_TAIL_SIZE ? reader->size : MP4_PARTIAL_TAIL_SIZE;
+        add_needed(parser, reader->size - tail, tail);
+    }
+    return VP_ERROR_NEED_DATA;
+}
+
+static int is_top_level_type(uint32_t type) {
+    switch (type) {
+        case FOURCC('f', 't', 'y', 'p'):
+        case FOURCC('s', 't', 'y', 'p'):
+        case FOURCC('m', 'o', 'o', 'v'):
+        case FOURCC('m', 'd', 'a', 't'):
+        case FOURCC('f', 'r', 'e', 'e'):
+        case FOURCC('s', 'k', 'i', 'p'):
+        case FOURCC('w', 'i', 'd', 'e'):
+        case FOURCC('p', 'n', 'o', 't'):
+        case FOURCC('u', 'u', 'i', 'd'):
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+// Walk top-level boxes, parsing moov and, for fragmented files, every moof
+// that is available
+static int walk_top_level(mp4_parser* parser, vp_reader* reader) {
+    int64_t offset = 0;
+    int found_moov = 0;
+    int first = 1;
+
+    while (reader->size < 0 || offset + 8 <= reader->size) {
+        uint8_t header[16];
+        int result = vp_reader_read_full(reader, offset, header, 8);
+        if (result == VP_READ_UNAVAILABLE && !found_moov) {
+            return need_header(parser, reader, offset);
+        }
+        if (result != 0) break;
+        uint64_t size = rd32(header);
+        uint32_t type = rd32(header + 4);
+        uint64_t header_size = 8;
+
+        if (first && !is_top_level_type(type)) {
+            return VP_ERROR_UNSUPPORTED;
+        }
+        first = 0;
+
+        if (size == 1) {
+            result = vp_reader_read_full(reader, offset + 8, header + 8, 8);
+            if (result == VP_READ_UNAVAILABLE && !found_moov) {
+                return need_header(parser, reader, offset);
+            }
+            if (result != 0) break;
+            size = rd64(header + 8);
+            header_size = 16;
+        } else if (size == 0) {
+            if (reader->size < 0) break;
+            size = (uint64_t)(reader->size - offset);
+        }
+        if (size < header_size) {
+            return found_moov ? VP_OK : VP_ERROR_UNSUPPORTED;
+        }
+        int64_t payload_offset = offset + (int64_t)header_size;
+        uint64_t payload_size = size - header_size;
+
+        if (type == FOURCC('f', 't', 'y', 'p') && payload_size >= 4) {
+            uint8_t brand[4];
+            if (vp_reader_read_full(reader, payload_offset, brand, 4) == 0) {
+                parser->major_brand = rd32(brand);
+            }
+        } else if (type == FOURCC('m', 'o', 'o', 'v') && !found_moov) {
+            uint8_t* data = NULL;
+            result = read_box(reader, payload_offset, payload_size, MP4_MAX_MOOV_SIZE, &data);
+            if (result == VP_READ_UNAVAILABLE) {
+                add_needed(parser, offset, (int64_t)size);
+                return VP_ERROR_NEED_DATA;
+            }
+            if (result != 0) {
+                return VP_ERROR_FAILED;
+            }
+            span moov = { data, (size_t)payload_size };
+            parse_moov(parser, moov);
+            free(data);
+            found_moov = 1;
+            // Fragments add nothing to the stored images
+            if (!parser->fragmented || parser->want_cover) break;
+        } else if (type == FOURCC('m', 'o', 'o', 'f') && found_moov) {
+            uint8_t* data = NULL;
+            result = read_box(reader, payload_offset, payload_size, MP4_MAX_MOOF_SIZE, &data);
+            if (result == VP_READ_UNAVAILABLE) {
+                // Fragments still downloading; mehd or the fragments seen
+                // so far answer the duration.
+                break;
+            }
+            if (result == 0) {
+                span moof = { data, (size_t)payload_size };
+                parse_moof(parser, moof);
+                free(data);
+            }
+        }
+        offset += (int64_t)size;
+    }
+    return found_moov ? VP_OK : VP_ERROR_UNSUPPORTED;
+}
+
+static double track_seconds(const mp4_track* track) {
+    if (track->timescale == 0) return 0.0;
+    uint64_t duration = track->duration > 0 ? track->duration : track->fragment_duration;
+    return (double)duration / track->timescale;
+}
+
+int vp_mp4_probe(vp_reader* reader, vp_arena* arena, vp_media_info* out) {
+    vp_byte_range needed[VP_MP4_MAX_NEEDED];
+    int needed_count = 0;
+    int status = vp_mp4_probe_partial(reader, arena, out, needed, &needed_count);
+    // Complete readers never run out of data; treat it as truncation
+    return status == VP_ERROR_NEED_DATA ? VP_ERROR_UNSUPPORTED : status;
+}
+
+int vp_mp4_probe_partial(vp_reader* reader, vp_arena* arena, vp_media_info* out,
+                         vp_byte_range* needed, int* needed_count) {
+    if (reader == NULL || arena == NULL || out == NULL || needed == NULL || needed_count == NULL) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+    *needed_count = 0;
+
+    mp4_parser* parser = (mp4_parser*)calloc(1, sizeof(mp4_parser));
+    if (parser == NULL) {
+        return VP_ERROR_NO_MEMORY;
+    }
+    parser->arena = arena;
+
+    int status = walk_top_level(parser, reader);
+    if (status == VP_ERROR_NEED_DATA) {
+        memcpy(needed, parser->needed, sizeof(vp_byte_range) * (size_t)parser->need_count);
+        *needed_count = parser->need_count;
+    }
+    if (status != VP_OK) {
+        free(parser);
+        return status;
+    }
+    if (parser->track_count == 0) {
+        free(parser);
+        return VP_ERROR_UNSUPPORTED;
+    }
+
+    out->container = "video/quicktime";
+    if (parser->movie_timescale > 0) {
+        uint64_t duration = parser->movie_duration > 0 ? parser->movie_duration : parser->fragment_duration;
+        out->duration = (double)duration / parser->movie_timescale;
+    }
+
+    out->streams = (vp_stream_info*)vp_arena_alloc(arena, sizeof(vp_stream_info) * (size_t)parser->track_count);
+    if (out->streams == NULL) {
+        free(parser);
+        return VP_ERROR_NO_MEMORY;
+    }
+
+    const mp4_track* primary = NULL;
+    double longest = 0.0;
+    for (int i = 0; i < parser->track_count; i++) {
+        mp4_track* track = &parser->tracks[i];
+        vp_stream_info* stream = &track->stream;
+        double seconds = track_seconds(track);
+        if (seconds > longest) longest = seconds;
+
+        if (stream->bitrate == 0 && seconds > 0.0 && track->sample_bytes > 0) {
+            stream->bitrate = (int64_t)((double)track->sample_bytes * 8.0 / seconds);
+        }
+        if (stream->type == VP_STREAM_VIDEO && stream->fps_num == 0 && seconds > 0.0 && track->sample_count > 0) {
+            fps_from_average((double)track->sample_count / seconds, &stream->fps_num, &stream->fps_den);
+        }
+        if (stream->type == VP_STREAM_VIDEO && primary == NULL) {
+            primary = track;
+        }
+        out->streams[out->stream_count++] = *stream;
+    }
+    if (out->duration <= 0.0) {
+        out->duration = longest;
+    }
+
+    if (primary != NULL) {
+        const vp_stream_info* video = &primary->stream;
+        out->has_video = 1;
+        out->video_codec = video->codec;
+        out->width = video->width;
+        out->height = video->height;
+        out->par_num = video->par_num;
+        out->par_den = video->par_den;
+        out->fps_num = video->fps_num;
+        out->fps_den = video->fps_den;
+        out->rotation = video->rotation;
+        out->bit_depth = video->bit_depth;
+        out->color_primaries = video->color_primaries;
+        out->transfer = video->transfer;
+        out->is_hdr = video->is_hdr;
+        out->frame_count = (int64_t)primary->sample_count;
+    }
+    if (out->duration > 0.0 && reader->size > 0) {
+        out->bitrate = (int64_t)((double)reader->size * 8.0 / out->duration);
+    }
+
+    // A moov without sample tables (e.g. a truncated fragment header) cannot
+    // answer the basics; let the caller fall back.
+    int complete = out->duration > 0.0 && (!out->has_video || (out->width > 0 && out->height > 0));
+    free(parser);
+    if (!complete) {
+        memset(out, 0, sizeof(*out));
+        return VP_ERROR_UNSUPPORTED;
+    }
+    return VP_OK;
+}
+
+// Walks `reader` for the sample index of the first video track
+static int parse_index(vp_reader* reader, vp_arena* arena, int want, mp4_parser** out) {
+    mp4_parser* parser = (mp4_parser*)calloc(1, sizeof(mp4_parser));
+    if (parser == NULL) {
+        return VP_ERROR_NO_MEMORY;
+    }
+    parser->arena = arena;
+    parser->want_index = want;
+
+    int status = walk_top_level(parser, reader);
+    if (status == VP_ERROR_NEED_DATA) {
+        status = VP_ERROR_UNSUPPORTED;
+    }
+    // Fragmented files flag sync samples in every trun instead
+    if (status == VP_OK && (parser->fragmented || !parser->index_done)) {
+        status = VP_ERROR_UNSUPPORTED;
+    }
+    if (status != VP_OK) {
+        free(parser);
+        return status;
+    }
+    *out = parser;
+    return VP_OK;
+}
+
+int vp_mp4_keyframes(vp_reader* reader, vp_arena* arena, double** times, int* count) {
+    if (reader == NULL || arena == NULL || times == NULL || count == NULL) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+    *times = NULL;
+    *count = 0;
+
+    mp4_parser* parser = NULL;
+    int status = parse_index(reader, arena, INDEX_KEYFRAMES, &parser);
+    if (status == VP_OK) {
+        *times = parser->keyframes;
+        *count = parser->keyframe_count;
+        free(parser);
+    }
+    return status;
+}
+
+static int index_samples(vp_reader* reader, vp_arena* arena, int want, vp_mp4_sample** samples, int* count,
+                         vp_stream_info* stream) {
+    if (reader == NULL || arena == NULL || samples == NULL || count == NULL) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+    *samples = NULL;
+    *count = 0;
+
+    mp4_parser* parser = NULL;
+    int status = parse_index(reader, arena, want, &parser);
+    if (status == VP_OK) {
+        if (parser->samples == NULL) {
+            status = VP_ERROR_UNSUPPORTED;
+        } else {
+            *samples = parser->samples;
+            *count = parser->sample_count;
+            if (stream) {
+                *stream = parser->tracks[parser->index_track].stream;
+            }
+        }
+        free(parser);
+    }
+    return status;
+}
+
+int vp_mp4_samples(vp_reader* reader, vp_arena* arena, vp_mp4_sample** samples, int* count,
+                   vp_stream_info* stream) {
+    return index_samples(reader, arena, INDEX_SAMPLES, samples, count, stream);
+}
+
+int vp_mp4_intra_samples(vp_reader* reader, vp_arena* arena, vp_mp4_sample** samples, int* count,
+                         vp_stream_info* stream) {
+    return index_samples(reader, arena, INDEX_INTRA_SAMPLES, samples, count, stream);
+}
+
+int vp_mp4_cover(vp_reader* reader, vp_arena* arena, vp_embedded_image* out) {
+    if (reader == NULL || arena == NULL || out == NULL) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+    memset(out, 0, sizeof(*out));
+
+    mp4_parser* parser = (mp4_parser*)calloc(1, sizeof(mp4_parser));
+    if (parser == NULL) {
+        return VP_ERROR_NO_MEMORY;
+    }
+    parser->arena = arena;
+    parser->want_cover = 1;
+
+    int status = walk_top_level(parser, reader);
+    if (status == VP_ERROR_NEED_DATA) {
+        status = VP_ERROR_UNSUPPORTED;
+    }
+    if (status == VP_OK) {
+        if (parser->cover.data != NULL) {
+            *out = parser->cover;
+        } else {
+            status = VP_ERROR_NOT_FOUND;
+        }
+    }
+    free(parser);
+    return status;
+}
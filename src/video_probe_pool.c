@@ -0,0 +1,140 @@
+/**
+ * Size-classed pool for frame buffers handed to callers.
+ *
+ * Steady thumbnailing frees and allocates JPEGs of much the same size over
+ * and over, often large enough that malloc() maps and unmaps them each
+ * time. Freed frames are kept on a free list per power-of-two size class
+ * instead, up to a byte limit, and handed out again for any size in the
+ * class. Frames above the largest class are not pooled.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "video_probe_internal.h"
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+// Classes from 4 KiB to 16 MiB
+#define MIN_CLASS_SHIFT 12
+#define MAX_CLASS_SHIFT 24
+#define CLASS_COUNT (MAX_CLASS_SHIFT - MIN_CLASS_SHIFT + 1)
+#define UNPOOLED -1
+
+#define DEFAULT_POOL_LIMIT ((int64_t)32 << 20)
+
+// Precedes every frame; keeps the frame as aligned as malloc() would
+typedef union frame_header {
+    struct {
+        // Next free frame of the class while pooled
+        union frame_header* next;
+        int size_class;
+    } link;
+    max_align_t align;
+} frame_header;
+
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static frame_header* free_lists[CLASS_COUNT];
+static int64_t pooled_bytes;
+static int64_t pool_limit = DEFAULT_POOL_LIMIT;
+
+static size_t class_bytes(int size_class) {
+    return (size_t)1 << (size_class + MIN_CLASS_SHIFT);
+}
+
+static int size_class_of(size_t size) {
+    if (size > class_bytes(CLASS_COUNT - 1)) {
+        return UNPOOLED;
+    }
+    int size_class = 0;
+    while (class_bytes(size_class) < size) {
+        size_class++;
+    }
+    return size_class;
+}
+
+uint8_t* vp_frame_alloc(size_t size) {
+    int size_class = size_class_of(size);
+    frame_header* header = NULL;
+    if (size_class != UNPOOLED) {
+        pthread_mutex_lock(&pool_lock);
+        header = free_lists[size_class];
+        if (header != NULL) {
+            free_lists[size_class] = header->link.next;
+            pooled_bytes -= (int64_t)class_bytes(size_class);
+        }
+        pthread_mutex_unlock(&pool_lock);
+    }
+    if (header == NULL) {
+        header = (frame_header*)malloc(sizeof(frame_header) +
+                                       (size_class != UNPOOLED ? class_bytes(size_class) : size));
+        if (header == NULL) {
+            return NULL;
+        }
+        vp_metrics_count(VP_COUNTER_ALLOCATIONS, 1);
+    }
+    header->link.next = NULL;
+    header->link.size_class = size_class;
+    vp_metrics_count(VP_COUNTER_LIVE_FRAMES, 1);
+    return (uint8_t*)(header + 1);
+}
+
+void vp_frame_free(uint8_t* frame) {
+    if (frame == NULL) {
+        return;
+    }
+    // Shards are summed, so freeing on another thread than the one that
+    // allocated still balances
+    vp_metrics_count(VP_COUNTER_LIVE_FRAMES, -1);
+
+    frame_header* header = (frame_header*)frame - 1;
+    int size_class = header->link.size_class;
+    if (size_class != UNPOOLED) {
+        int64_t bytes = (int64_t)class_bytes(size_class);
+        pthread_mutex_lock(&pool_lock);
+        if (pooled_bytes + bytes <= pool_limit) {
+            header->link.next = free_lists[size_class];
+            free_lists[size_class] = header;
+            pooled_bytes += bytes;
+            header = NULL;
+        }
+        pthread_mutex_unlock(&pool_lock);
+    }
+    free(header);
+}
+
+int64_t vp_frame_pool_bytes(void) {
+    pthread_mutex_lock(&pool_lock);
+    int64_t bytes = pooled_bytes;
+    pthread_mutex_unlock(&pool_lock);
+    return bytes;
+}
+
+int set_frame_pool_limit(int64_t bytes) {
+    if (bytes < 0) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+
+    // Drop the largest frames first, freeing them outside the lock
+    frame_header* dropped = NULL;
+    pthread_mutex_lock(&pool_lock);
+    pool_limit = bytes;
+    for (int size_class = CLASS_COUNT - 1; size_class >= 0 && pooled_bytes > pool_limit; size_class--) {
+        while (free_lists[size_class] != NULL && pooled_bytes > pool_limit) {
+            frame_header* header = free_lists[size_class];
+            free_lists[size_class] = header->link.next;
+            pooled_bytes -= (int64_t)class_bytes(size_class);
+            header->link.next = dropped;
+            dropped = header;
+        }
+    }
+    pthread_mutex_unlock(&pool_lock);
+
+    while (dropped != NULL) {
+        frame_header* next = dropped->link.next;
+        free(dropped);
+        dropped = next;
+    }
+    return VP_OK;
+}
@@ -0,0 +1,362 @@
+/**
+ * Priority scheduler for probe and extraction requests.
+ *
+ * Requests wait in one FIFO per priority class and workers always take the
+ * head of the most urgent non-empty one, so a visible thumbnail never
+ * queues behind prefetch or background work. Requests tied to a view slot
+ * replace the previous request on that slot, which keeps the visible queue
+ * no longer than the number of slots on screen however fast it scrolls.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "video_probe_internal.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PRIORITY_COUNT (VP_PRIORITY_BACKGROUND + 1)
+
+typedef struct job {
+    int64_t id;
+    // request.path points at a private copy
+    vp_request request;
+    vp_cancel_token* cancel;
+    int64_t submitted_us;
+    struct job* prev;
+    struct job* next;
+} job;
+
+typedef struct {
+    job* head;
+    job* tail;
+} job_queue;
+
+typedef struct worker {
+    vp_scheduler* scheduler;
+    pthread_t thread;
+    // Job being run, NULL while idle. Guarded by the scheduler lock.
+    job* current;
+} worker;
+
+struct vp_scheduler {
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    job_queue queues[PRIORITY_COUNT];
+    worker* workers;
+    int worker_count;
+    int stopping;
+    int64_t next_id;
+    vp_scheduler_run run;
+    vp_request_callback callback;
+    void* user_data;
+};
+
+static void job_free(job* j) {
+    free((char*)j->request.path);
+    cancel_token_free(j->cancel);
+    free(j);
+}
+
+static void queue_push(job_queue* queue, job* j) {
+    j->next = NULL;
+    j->prev = queue->tail;
+    if (queue->tail) {
+        queue->tail->next = j;
+    } else {
+        queue->head = j;
+    }
+    queue->tail = j;
+}
+
+static void queue_unlink(job_queue* queue, job* j) {
+    if (j->prev) {
+        j->prev->next = j->next;
+    } else {
+        queue->head = j->next;
+    }
+    if (j->next) {
+        j->next->prev = j->prev;
+    } else {
+        queue->tail = j->prev;
+    }
+    j->prev = j->next = NULL;
+}
+
+// Queued job matching `id`, or on `slot` when id is 0. Sets *priority to
+// the queue it is in.
+static job* find_queued(vp_scheduler* scheduler, int64_t id, int64_t slot, int* priority) {
+    for (int p = 0; p < PRIORITY_COUNT; p++) {
+        for (job* j = scheduler->queues[p].head; j != NULL; j = j->next) {
+            if (id != 0 ? j->id == id : j->request.slot == slot) {
+                *priority = p;
+                return j;
+            }
+        }
+    }
+    return NULL;
+}
+
+// Running job matching `id`, or on `slot` when id is 0
+static job* find_running(vp_scheduler* scheduler, int64_t id, int64_t slot) {
+    for (int i = 0; i < scheduler->worker_count; i++) {
+        job* j = scheduler->workers[i].current;
+        if (j != NULL && (id != 0 ? j->id == id : j->request.slot == slot)) {
+            return j;
+        }
+    }
+    return NULL;
+}
+
+// Reports a job that never ran and frees it. Called without the lock.
+static void complete_dropped(vp_scheduler* scheduler, job* j, int status) {
+    vp_request_result* result = (vp_request_result*)calloc(1, sizeof(vp_request_result));
+    if (result) {
+        result->id = j->id;
+        result->status = status;
+        result->queued_us = vp_monotonic_us() - j->submitted_us;
+        scheduler->callback(result, scheduler->user_data);
+    }
+    job_free(j);
+}
+
+static void run_job(vp_scheduler* scheduler, job* j, vp_request_result* result) {
+    result->id = j->id;
+    result->queued_us = vp_monotonic_us() - j->submitted_us;
+
+    // The deadline counts from submission, so time spent queued is part
+    // of it
+    vp_call_options options = { .cancel = j->cancel };
+    options.peak_memory = &result->peak_memory;
+    if (j->request.timeout_ms > 0) {
+        int64_t left_ms = j->request.timeout_ms - result->queued_us / 1000;
+        if (left_ms <= 0) {
+            result->status = VP_ERROR_TIMEOUT;
+            return;
+        }
+        options.timeout_ms = left_ms;
+    }
+    if (cancel_token_is_cancelled(j->cancel)) {
+        result->status = VP_ERROR_CANCELLED;
+        return;
+    }
+    int64_t start = vp_monotonic_us();
+    scheduler->run(&j->request, &options, result);
+    vp_trace_span(0, j->request.kind == VP_REQUEST_FRAME ? "frame request" : "media info request", start,
+                  vp_monotonic_us());
+}
+
+static void* worker_main(void* data) {
+    worker* self = (worker*)data;
+    vp_scheduler* scheduler = self->scheduler;
+
+    for (;;) {
+        pthread_mutex_lock(&scheduler->lock);
+        job* j = NULL;
+        while (!scheduler->stopping) {
+            for (int p = 0; p < PRIORITY_COUNT && j == NULL; p++) {
+                j = scheduler->queues[p].head;
+                if (j) {
+                    queue_unlink(&scheduler->queues[p], j);
+                }
+            }
+            if (j) {
+                break;
+            }
+            pthread_cond_wait(&scheduler->wake, &scheduler->lock);
+        }
+        if (j == NULL) {
+            pthread_mutex_unlock(&scheduler->lock);
+            return NULL;
+        }
+        self->current = j;
+        pthread_mutex_unlock(&scheduler->lock);
+
+        vp_request_result* result = (vp_request_result*)calloc(1, sizeof(vp_request_result));
+        if (result) {
+            run_job(scheduler, j, result);
+        }
+
+        // Cancellation only touches the token while `current` is set, so it
+        // can be freed once that is cleared
+        pthread_mutex_lock(&scheduler->lock);
+        self->current = NULL;
+        pthread_mutex_unlock(&scheduler->lock);
+
+        if (result) {
+            scheduler->callback(result, scheduler->user_data);
+        }
+        job_free(j);
+    }
+}
+
+vp_scheduler* vp_scheduler_new(int workers, vp_scheduler_run run, vp_request_callback callback, void* user_data) {
+    if (workers <= 0 || run == NULL || callback == NULL) {
+        return NULL;
+    }
+    vp_scheduler* scheduler = (vp_scheduler*)calloc(1, sizeof(vp_scheduler));
+    if (scheduler == NULL) {
+        return NULL;
+    }
+    scheduler->workers = (worker*)calloc((size_t)workers, sizeof(worker));
+    if (scheduler->workers == NULL) {
+        free(scheduler);
+        return NULL;
+    }
+    scheduler->run = run;
+    scheduler->callback = callback;
+    scheduler->user_data = user_data;
+    pthread_mutex_init(&scheduler->lock, NULL);
+    pthread_cond_init(&scheduler->wake, NULL);
+
+    for (int i = 0; i < workers; i++) {
+        scheduler->workers[i].scheduler = scheduler;
+        if (pthread_create(&scheduler->workers[i].thread, NULL, worker_main, &scheduler->workers[i]) != 0) {
+            break;
+        }
+        scheduler->worker_count++;
+    }
+    if (scheduler->worker_count == 0) {
+        scheduler_free(scheduler);
+        return NULL;
+    }
+    return scheduler;
+}
+
+int64_t scheduler_submit(vp_scheduler* scheduler, const vp_request* request) {
+    if (scheduler == NULL || request == NULL || request->path == NULL ||
+        (request->kind != VP_REQUEST_MEDIA_INFO && request->kind != VP_REQUEST_FRAME) ||
+        request->priority < 0 || request->priority >= PRIORITY_COUNT ||
+        (request->kind == VP_REQUEST_FRAME && request->frame_num < 0)) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+
+    job* j = (job*)calloc(1, sizeof(job));
+    char* path = strdup(request->path);
+    vp_cancel_token* cancel = cancel_token_new();
+    if (j == NULL || path == NULL || cancel == NULL) {
+        free(j);
+        free(path);
+        cancel_token_free(cancel);
+        return VP_ERROR_NO_MEMORY;
+    }
+    j->request = *request;
+    j->request.path = path;
+    j->cancel = cancel;
+    j->submitted_us = vp_monotonic_us();
+
+    job* superseded = NULL;
+    pthread_mutex_lock(&scheduler->lock);
+    j->id = ++scheduler->next_id;
+    if (request->slot != 0) {
+        int priority;
+        superseded = find_queued(scheduler, 0, request->slot, &priority);
+        if (superseded) {
+            queue_unlink(&scheduler->queues[priority], superseded);
+        }
+        job* running = find_running(scheduler, 0, request->slot);
+        if (running) {
+            cancel_token_cancel(running->cancel);
+        }
+    }
+    queue_push(&scheduler->queues[request->priority], j);
+    pthread_cond_signal(&scheduler->wake);
+    int64_t id = j->id;
+    pthread_mutex_unlock(&scheduler->lock);
+
+    if (superseded) {
+        complete_dropped(scheduler, superseded, VP_ERROR_CANCELLED);
+    }
+    return id;
+}
+
+int scheduler_set_priority(vp_scheduler* scheduler, int64_t id, int priority) {
+    if (scheduler == NULL || id <= 0 || priority < 0 || priority >= PRIORITY_COUNT) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+
+    pthread_mutex_lock(&scheduler->lock);
+    int current;
+    job* j = find_queued(scheduler, id, 0, &current);
+    if (j && current != priority) {
+        queue_unlink(&scheduler->queues[current], j);
+        j->request.priority = priority;
+        queue_push(&scheduler->queues[priority], j);
+    }
+    pthread_mutex_unlock(&scheduler->lock);
+    return j ? VP_OK : VP_ERROR_NOT_FOUND;
+}
+
+int scheduler_cancel(vp_scheduler* scheduler, int64_t id) {
+    if (scheduler == NULL || id <= 0) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+
+    pthread_mutex_lock(&scheduler->lock);
+    int priority;
+    job* queued = find_queued(scheduler, id, 0, &priority);
+    job* running = NULL;
+    if (queued) {
+        queue_unlink(&scheduler->queues[priority], queued);
+    } else {
+        running = find_running(scheduler, id, 0);
+        if (running) {
+            cancel_token_cancel(running->cancel);
+        }
+    }
+    pthread_mutex_unlock(&scheduler->lock);
+
+    if (queued) {
+        complete_dropped(scheduler, queued, VP_ERROR_CANCELLED);
+    }
+    return queued || running ? VP_OK : VP_ERROR_NOT_FOUND;
+}
+
+void scheduler_free(vp_scheduler* scheduler) {
+    if (scheduler == NULL) {
+        return;
+    }
+
+    // Queued jobs are reported once the lock is released, since the
+    // callback may call back into the scheduler
+    job_queue dropped = { 0 };
+    pthread_mutex_lock(&scheduler->lock);
+    scheduler->stopping = 1;
+    for (int p = 0; p < PRIORITY_COUNT; p++) {
+        while (scheduler->queues[p].head) {
+            job* j = scheduler->queues[p].head;
+            queue_unlink(&scheduler->queues[p], j);
+            queue_push(&dropped, j);
+        }
+    }
+    for (int i = 0; i < scheduler->worker_count; i++) {
+        if (scheduler->workers[i].current) {
+            cancel_token_cancel(scheduler->workers[i].current->cancel);
+        }
+    }
+    pthread_cond_broadcast(&scheduler->wake);
+    pthread_mutex_unlock(&scheduler->lock);
+
+    while (dropped.head) {
+        job* j = dropped.head;
+        queue_unlink(&dropped, j);
+        complete_dropped(scheduler, j, VP_ERROR_CANCELLED);
+    }
+    for (int i = 0; i < scheduler->worker_count; i++) {
+        pthread_join(scheduler->workers[i].thread, NULL);
+    }
+    pthread_cond_destroy(&scheduler->wake);
+    pthread_mutex_destroy(&scheduler->lock);
+    free(scheduler->workers);
+    free(scheduler);
+}
+
+void free_request_result(vp_request_result* result) {
+    if (result == NULL) {
+        return;
+    }
+    vp_arena_free((vp_arena*)result->info.arena);
+    vp_frame_free(result->frame);
+    free(result);
+}
@@ -0,0 +1,296 @@
+/**
+ * Opt-in span recording, exported as Chrome trace event JSON.
+ *
+ * Spans are written whole when they end into a ring of fixed size, so a
+ * long session keeps its newest events and never allocates while
+ * recording. Each slot carries a sequence number that writers clear
+ * before filling it and set afterwards, letting the dump skip slots that
+ * are being overwritten instead of locking out the writers.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+// syscall() for the kernel thread id
+#define _DEFAULT_SOURCE
+
+#include "video_probe_internal.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+#define TRACE_DEFAULT_CAPACITY 65536
+#define TRACE_MAX_CAPACITY (1 << 24)
+
+typedef struct {
+    // Index of the event + 1 once written, 0 while a writer fills the slot
+    int64_t seq;
+    const char* name;
+    int64_t thread;
+    int64_t start_us;
+    int64_t end_us;
+} trace_event;
+
+typedef struct {
+    trace_event* events;
+    int64_t capacity;
+    int64_t next;
+} trace_ring;
+
+static int enabled;
+static trace_ring* ring;
+// Writers between loading `ring` and finishing their event
+static int writers;
+static pthread_mutex_t control_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_key_t thread_key;
+static pthread_once_t thread_key_once = PTHREAD_ONCE_INIT;
+#if !defined(__linux__)
+static int64_t last_thread_id;
+#endif
+
+static void create_thread_key(void) {
+    pthread_key_create(&thread_key, NULL);
+}
+
+int64_t vp_trace_thread_id(void) {
+    pthread_once(&thread_key_once, create_thread_key);
+    intptr_t cached = (intptr_t)pthread_getspecific(thread_key);
+    if (cached != 0) {
+        return (int64_t)cached;
+    }
+    // Kernel thread ids line up with perf and /proc; elsewhere threads are
+    // numbered in order of their first event
+#if defined(__linux__)
+    int64_t id = (int64_t)syscall(SYS_gettid);
+#else
+    int64_t id = __atomic_add_fetch(&last_thread_id, 1, __ATOMIC_RELAXED);
+#endif
+    pthread_setspecific(thread_key, (void*)(intptr_t)id);
+    return id;
+}
+
+int vp_trace_enabled(void) {
+    return __atomic_load_n(&enabled, __ATOMIC_RELAXED);
+}
+
+void vp_trace_span(int64_t thread, const char* name, int64_t start_us, int64_t end_us) {
+    if (!vp_trace_enabled() || name == NULL) {
+        return;
+    }
+    if (thread == 0) {
+        thread = vp_trace_thread_id();
+    }
+
+    __atomic_add_fetch(&writers, 1, __ATOMIC_SEQ_CST);
+    trace_ring* r = __atomic_load_n(&ring, __ATOMIC_SEQ_CST);
+    if (r != NULL) {
+        int64_t index = __atomic_fetch_add(&r->next, 1, __ATOMIC_RELAXED);
+        trace_event* event = &r->events[index % r->capacity];
+        __atomic_store_n(&event->seq, 0, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        __atomic_store_n(&event->name, name, __ATOMIC_RELAXED);
+        __atomic_store_n(&event->thread, thread, __ATOMIC_RELAXED);
+        __atomic_store_n(&event->start_us, start_us, __ATOMIC_RELAXED);
+        __atomic_store_n(&event->end_us, end_us, __ATOMIC_RELAXED);
+        __atomic_store_n(&event->seq, index + 1, __ATOMIC_RELEASE);
+    }
+    __atomic_sub_fetch(&writers, 1, __ATOMIC_SEQ_CST);
+}
+
+int trace_start(int capacity) {
+    if (capacity < 0 || capacity > TRACE_MAX_CAPACITY) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+    trace_ring* fresh = (trace_ring*)calloc(1, sizeof(trace_ring));
+    if (fresh == NULL) {
+        return VP_ERROR_NO_MEMORY;
+    }
+    fresh->capacity = capacity > 0 ? capacity : TRACE_DEFAULT_CAPACITY;
+    fresh->events = (trace_event*)calloc((size_t)fresh->capacity, sizeof(trace_event));
+    if (fresh->events == NULL) {
+        free(fresh);
+        return VP_ERROR_NO_MEMORY;
+    }
+
+    pthread_mutex_lock(&control_lock);
+    trace_ring* old = __atomic_exchange_n(&ring, fresh, __ATOMIC_SEQ_CST);
+    // Writers that picked up the old ring finish within a few stores
+    while (__atomic_load_n(&writers, __ATOMIC_SEQ_CST) > 0) {
+        sched_yield();
+    }
+    __atomic_store_n(&enabled, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&control_lock);
+
+    if (old != NULL) {
+        free(old->events);
+        free(old);
+    }
+    return VP_OK;
+}
+
+void trace_stop(void) {
+    __atomic_store_n(&enabled, 0, __ATOMIC_RELAXED);
+}
+
+typedef struct {
+    char* data;
+    size_t size;
+    size_t capacity;
+    int failed;
+} json_buffer;
+
+static void json_append(json_buffer* buf, const char* format, ...) {
+    if (buf->failed) {
+        return;
+    }
+    for (;;) {
+        va_list args;
+        va_start(args, format);
+        int n = vsnprintf(buf->data + buf->size, buf->capacity - buf->size, format, args);
+        va_end(args);
+        if (n < 0) {
+            buf->failed = 1;
+            return;
+        }
+        if ((size_t)n < buf->capacity - buf->size) {
+            buf->size += (size_t)n;
+            return;
+        }
+        size_t capacity = buf->capacity * 2 > buf->size + (size_t)n + 1 ? buf->capacity * 2 : buf->size + (size_t)n + 1;
+        char* grown = (char*)realloc(buf->data, capacity);
+        if (grown == NULL) {
+            buf->failed = 1;
+            return;
+        }
+        buf->data = grown;
+        buf->capacity = capacity;
+    }
+}
+
+// Appends `value` as a JSON string body, dropping control characters
+static void json_append_escaped(json_buffer* buf, const char* value) {
+    for (const char* c = value; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            json_append(buf, "\\%c", *c);
+        } else if ((unsigned char)*c >= 0x20) {
+            json_append(buf, "%c", *c);
+        }
+    }
+}
+
+static int compare_threads(const void* a, const void* b) {
+    int64_t x = *(const int64_t*)a;
+    int64_t y = *(const int64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+// Names the threads seen in the trace, where the system still knows them
+static void append_thread_names(json_buffer* buf, int64_t* threads, int64_t count, int pid) {
+    qsort(threads, (size_t)count, sizeof(int64_t), compare_threads);
+    for (int64_t i = 0; i < count; i++) {
+        if (i > 0 && threads[i] == threads[i - 1]) {
+            continue;
+        }
+#if defined(__linux__)
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/self/task/%lld/comm", (long long)threads[i]);
+        FILE* comm = fopen(path, "r");
+        if (comm == NULL) {
+            continue;
+        }
+        char name[64] = "";
+        if (fgets(name, sizeof(name), comm) != NULL) {
+            name[strcspn(name, "\n")] = '\0';
+            json_append(buf, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%lld,\"args\":{\"name\":\"",
+                        pid, (long long)threads[i]);
+            json_append_escaped(buf, name);
+            json_append(buf, "\"}}");
+        }
+        fclose(comm);
+#else
+        (void)buf;
+        (void)pid;
+#endif
+    }
+}
+
+int trace_dump(char** out, int64_t* out_size) {
+    if (out) *out = NULL;
+    if (out_size) *out_size = 0;
+    if (out == NULL || out_size == NULL) {
+        return VP_ERROR_INVALID_ARGUMENT;
+    }
+
+    json_buffer buf = { NULL, 0, 0, 0 };
+    buf.capacity = 4096;
+    buf.data = (char*)malloc(buf.capacity);
+    if (buf.data == NULL) {
+        return VP_ERROR_NO_MEMORY;
+    }
+    int pid = (int)getpid();
+    json_append(&buf, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+    // Holding the control lock keeps the ring alive; writers carry on
+    pthread_mutex_lock(&control_lock);
+    trace_ring* r = __atomic_load_n(&ring, __ATOMIC_SEQ_CST);
+    int64_t* threads = NULL;
+    int64_t thread_count = 0;
+    int64_t written = 0;
+    if (r != NULL) {
+        int64_t next = __atomic_load_n(&r->next, __ATOMIC_ACQUIRE);
+        int64_t first = next > r->capacity ? next - r->capacity : 0;
+        threads = (int64_t*)malloc(sizeof(int64_t) * (size_t)(next - first + 1));
+        for (int64_t index = first; index < next; index++) {
+            trace_event* slot = &r->events[index % r->capacity];
+            if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != index + 1) {
+                continue;
+            }
+            trace_event event;
+            event.name = __atomic_load_n(&slot->name, __ATOMIC_RELAXED);
+            event.thread = __atomic_load_n(&slot->thread, __ATOMIC_RELAXED);
+            event.start_us = __atomic_load_n(&slot->start_us, __ATOMIC_RELAXED);
+            event.end_us = __atomic_load_n(&slot->end_us, __ATOMIC_RELAXED);
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != index + 1) {
+                continue;
+            }
+            json_append(&buf,
+                        "%s\n{\"name\":\"%s\",\"cat\":\"video_probe\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,"
+                        "\"pid\":%d,\"tid\":%lld}",
+                        written++ > 0 ? "," : "", event.name, (long long)event.start_us,
+                        (long long)(event.end_us - event.start_us), pid, (long long)event.thread);
+            if (threads) {
+                threads[thread_count++] = event.thread;
+            }
+        }
+    }
+    pthread_mutex_unlock(&control_lock);
+
+    if (threads) {
+        if (thread_count > 0) {
+            append_thread_names(&buf, threads, thread_count, pid);
+        }
+        free(threads);
+    }
+    json_append(&buf, "\n]}\n");
+
+    if (buf.failed) {
+        free(buf.data);
+        return VP_ERROR_NO_MEMORY;
+    }
+    *out = buf.data;
+    *out_size = (int64_t)buf.size;
+    return VP_OK;
+}
+
+void free_trace(char* json) {
+    free(json);
+}
@@ -1,5 +1,9 @@
+import 'dart:async';
+import 'dart:typed_data';
+
 import 'package:flutter/services.dart';
 import 'package:flutter_test/flutter_test.dart';
+import 'package:video_probe/video_info.dart';
 import 'package:video_probe/video_probe_method_channel.dart';
 
 void main() {
@@ -7,12 +11,95 @@ void main() {
 
   MethodChannelVideoProbe platform = MethodChannelVideoProbe();
   const MethodChannel channel = MethodChannel('video_probe');
+  final calls = <MethodCall>[];
+  // Frame 9 decodes until a cancel arrives
+  late Completer<void> cancelled;
+  const mediaInfo = <String, Object?>{
+    'container': 'video/quicktime',
+    'duration': 12.5,
+    'bitrate': 800000,
+    'frameCount': 300,
+    'hasVideo': true,
+    'videoCodec': 'h264',
+    'width': 640,
+    'height': 360,
+    'pixelAspectNum': 1,
+    'pixelAspectDen': 1,
+    'frameRateNum': 24,
+    'frameRateDen': 1,
+    'rotation': 90,
+    'bitDepth': 8,
+    'colorPrimaries': 1,
+    'transfer': 1,
+    'isHdr': false,
+    'streams': [
+      {
+        'type': 1,
+        'codec': 'aac',
+        'language': 'eng',
+        'bitrate': 128000,
+        'width': 0,
+        'height': 0,
+        'pixelAspectNum': 1,
+        'pixelAspectDen': 1,
+        'frameRateNum': 0,
+        'frameRateDen': 1,
+        'rotation': 0,
+        'bitDepth': 0,
+        'colorPrimaries': 2,
+        'transfer': 2,
+        'isHdr': false,
+        'channels': 2,
+        'sampleRate': 48000,
+      },
+    ],
+  };
 
   setUp(() {
+    calls.clear();
+    cancelled = Completer();
     TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(
       channel,
       (MethodCall methodCall) async {
-        return '42';
+        calls.add(methodCall);
+        final args = methodCall.arguments as Map<Object?, Object?>?;
+        switch (methodCall.method) {
+          case 'getPlatformVersion':
+            return '42';
+          case 'getDuration':
+            return 12.5;
+          case 'getMediaInfo':
+            return args!['path'] == '/v.mp4' ? mediaInfo : throw PlatformException(code: 'probeError', details: -2);
+          case 'probeBatch':
+            return [
+              {'status': 0, 'info': mediaInfo, 'thumbnail': Uint8List.fromList([0x89])},
+              {'status': -2},
+            ];
+          case 'extractFrame':
+            final frameNum = args!['frameNum']! as int;
+            if (frameNum == 9) {
+              await cancelled.future;
+              throw PlatformException(code: 'probeError', details: -7);
+            }
+            if (frameNum == 7) {
+              throw PlatformException(code: 'probeError', details: -8);
+            }
+            if (frameNum < 0 || frameNum > 100) {
+              throw PlatformException(code: 'probeError', details: -1);
+            }
+            return Uint8List.fromList([0xFF, 0xD8]);
+          case 'extractFrames':
+            final frameNums = args!['frameNums']! as Int32List;
+            return [
+              for (final frameNum in frameNums)
+                frameNum < 100
+                    ? {'status': 0, 'data': Uint8List.fromList([0xFF])}
+                    : {'status': -1},
+            ];
+          case 'cancel':
+            cancelled.complete();
+        }
+        return null;
       },
     );
   });
@@ -24,4 +111,91 @@ void main() {
   test('getPlatformVersion', () async {
     expect(await platform.getPlatformVersion(), '42');
   });
+
+  test('getDuration', () async {
+    expect(await platform.getDuration('/v.mp4'), 12.5);
+    expect(calls.single.arguments, containsPair('path', '/v.mp4'));
+    // Nothing could cancel it, so it takes no native cancel token
+    expect(calls.single.arguments, isNot(contains('callId')));
+  });
+
+  test('getMediaInfo reads the info map', () async {
+    final info = await platform.getMediaInfo('/v.mp4');
+    expect(info!.videoCodec, 'h264');
+    expect(info.frameRate, 24.0);
+    expect(info.rotation, 90);
+    expect(info.audioStreams.single.sampleRate, 48000);
+    expect(info.audioStreams.single.language, 'eng');
+    expect(await platform.getMediaInfo('/missing.mp4'), isNull);
+  });
+
+  test('probeBatch pairs results with the paths', () async {
+    final results = await platform.probeBatch(
+      ['/v.mp4', '/missing.mp4'],
+      thumbnails: true,
+      preferEmbeddedThumbnails: true,
+    );
+    expect(calls.single.arguments, containsPair('preferEmbeddedThumbnails', true));
+    expect(results.map((r) => r.path), ['/v.mp4', '/missing.mp4']);
+    expect(results[0].info!.width, 640);
+    expect(results[0].thumbnail, [0x89]);
+    expect(results[1].status, ProbeStatus.notFound);
+    expect(results[1].info, isNull);
+  });
+
+  test('a cancelled probeBatch reports every path', () async {
+    final token = CancelToken()..cancel();
+    final results = await platform.probeBatch(['/a.mp4', '/b.mp4'], cancelToken: token);
+    expect(results.map((r) => r.status), everyElement(ProbeStatus.cancelled));
+    expect(calls, isEmpty);
+  });
+
+  test('extractFrame returns the JPEG or null', () async {
+    expect(await platform.extractFrame('/v.mp4', 1), [0xFF, 0xD8]);
+    expect(await platform.extractFrame('/v.mp4', 500), isNull);
+  });
+
+  test('extractFrame passes the timeout and maps it back', () async {
+    await expectLater(
+      platform.extractFrame(
+        '/v.mp4',
+        7,
+        timeout: const Duration(milliseconds: 300),
+      ),
+      throwsA(
+        isA<ProbeCancelledException>().having((e) => e.timedOut, 'timedOut', isTrue),
+      ),
+    );
+    expect(calls.single.arguments, containsPair('timeoutMs', 300));
+  });
+
+  test('extractFrames pairs statuses with the requested frames', () async {
+    final results = await platform.extractFrames('/v.mp4', [5, 500]);
+    expect(results.map((r) => r.frameNum), [5, 500]);
+    expect(results[0].isOk, isTrue);
+    expect(results[1].status, ProbeStatus.invalidArgument);
+    expect(results[1].data, isNull);
+  });
+
+  test('cancelling sends a cancel for the running call', () async {
+    final token = CancelToken();
+    final frame = platform.extractFrame('/v.mp4', 9, cancelToken: token);
+    await Future<void>.delayed(Duration.zero);
+    token.cancel();
+    await expectLater(frame, throwsA(isA<ProbeCancelledException>()));
+    expect(calls.map((c) => c.method), ['extractFrame', 'cancel']);
+    expect(
+      (calls[1].arguments as Map)['callId'],
+      (calls[0].arguments as Map)['callId'],
+    );
+  });
+
+  test('a cancelled token fails before calling the platform', () async {
+    final token = CancelToken()..cancel();
+    await expectLater(
+      platform.extractFrame('/v.mp4', 1, cancelToken: token),
+      throwsA(isA<ProbeCancelledException>()),
+    );
+    expect(calls, isEmpty);
+  });
 }
@@ -1,4 +1,6 @@
 import 'package:flutter_test/flutter_test.dart';
+import 'dart:async';
+import 'dart:math';
 import 'dart:typed_data';
 import 'package:video_probe/video_probe.dart';
 import 'package:video_probe/video_probe_platform_interface.dart';
@@ -13,6 +15,37 @@ class MockVideoProbePlatform
   double mockDuration = 120.5;
   int mockFrameCount = 3000;
   Uint8List? mockFrameData = Uint8List.fromList([0xFF, 0xD8, 0xFF, 0xE0]);
+  // Cover art of .m4a and .mkv files
+  Uint8List mockCoverData = Uint8List.fromList([0x89, 0x50, 0x4E, 0x47]);
+  VideoInfo mockMediaInfo = const VideoInfo(
+    container: 'video/quicktime',
+    duration: 120.5,
+    frameCount: 3000,
+    hasVideo: true,
+    videoCodec: 'h264',
+    width: 1920,
+    height: 1080,
+    frameRateNum: 25,
+    frameRateDen: 1,
+    bitDepth: 8,
+    streams: [
+      MediaStreamInfo(
+        type: MediaStreamType.video,
+        codec: 'h264',
+        width: 1920,
+        height: 1080,
+        frameRateNum: 25,
+        frameRateDen: 1,
+      ),
+      MediaStreamInfo(
+        type: MediaStreamType.audio,
+        codec: 'aac',
+        language: 'en',
+        channels: 2,
+        sampleRate: 48000,
+      ),
+    ],
+  );
   bool shouldFail = false;
 
   @override
@@ -30,11 +63,440 @@ class MockVideoProbePlatform
     return Future.value(mockFrameCount);
   }
 
+  /// Mirrors the native calls, which fail a cancelled call before doing
+  /// any work.
+  void _checkCancelled(CancelToken? cancelToken) {
+    if (cancelToken?.isCancelled ?? false) {
+      throw const ProbeCancelledException();
+    }
+  }
+
+  @override
+  Future<Uint8List?> extractFrame(
+    String path,
+    int frameNum, {
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) async {
+    _checkCancelled(cancelToken);
+    if (shouldFail || path.isEmpty || frameNum < 0) return null;
+    return mockFrameData;
+  }
+
+  @override
+  Future<VideoInfo?> getMediaInfo(
+    String path, {
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) async {
+    _checkCancelled(cancelToken);
+    if (timeout == Duration.zero) {
+      throw const ProbeCancelledException(timedOut: true);
+    }
+    if (shouldFail || path.isEmpty) return null;
+    return mockMediaInfo;
+  }
+
+  @override
+  Future<VideoInfo?> getMediaInfoFromBytes(
+    Uint8List bytes, {
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) async {
+    _checkCancelled(cancelToken);
+    if (shouldFail || bytes.isEmpty) return null;
+    return mockMediaInfo;
+  }
+
+  @override
+  Future<Uint8List?> extractFrameFromBytes(
+    Uint8List bytes,
+    int frameNum, {
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) async {
+    _checkCancelled(cancelToken);
+    if (shouldFail || bytes.isEmpty || frameNum < 0) return null;
+    return mockFrameData;
+  }
+
+  @override
+  Future<PartialProbeResult> probePartial(
+    String path, {
+    required int totalSize,
+    List<ByteRange>? available,
+  }) async {
+    final needed = await getNeededRanges(
+      path,
+      totalSize: totalSize,
+      available: available,
+    );
+    if (needed.isNotEmpty) {
+      return PartialProbeResult(
+        status: ProbeStatus.needData,
+        neededRanges: needed,
+      );
+    }
+    return PartialProbeResult(status: ProbeStatus.ok, info: mockMediaInfo);
+  }
+
+  @override
+  Future<List<ByteRange>> getNeededRanges(
+    String path, {
+    required int totalSize,
+    List<ByteRange>? available,
+  }) {
+    // Pretend the index sits in the last 100 bytes
+    final tail = ByteRange(totalSize - 100, 100);
+    final present = (available ?? const []).any(
+      (r) => r.offset <= tail.offset && r.end >= tail.end,
+    );
+    return Future.value(present ? const [] : [tail]);
+  }
+
+  @override
+  Future<List<BatchProbeResult>> probeBatch(
+    List<String> paths, {
+    bool thumbnails = false,
+    int thumbnailFrame = 0,
+    bool preferEmbeddedThumbnails = false,
+    int maxWorkers = 0,
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) {
+    Uint8List? thumbnail(String path) {
+      if (!thumbnails) return null;
+      final covered = path.endsWith('.m4a') || path.endsWith('.mkv');
+      return preferEmbeddedThumbnails && covered ? mockCoverData : mockFrameData;
+    }
+
+    return Future.value([
+      for (final path in paths)
+        cancelToken?.isCancelled ?? false
+            ? BatchProbeResult(path: path, status: ProbeStatus.cancelled)
+            : shouldFail || path.isEmpty
+            ? BatchProbeResult(path: path, status: ProbeStatus.notFound)
+            : BatchProbeResult(
+                path: path,
+                status: ProbeStatus.ok,
+                info: mockMediaInfo,
+                thumbnail: thumbnail(path),
+              ),
+    ]);
+  }
+
+  @override
+  Stream<BatchProbeResult> discoverMediaInfo(
+    List<String> paths, {
+    int maxInFlight = 0,
+    Duration? timeout,
+    CancelToken? cancelToken,
+  }) async* {
+    // Finishes last to first, as discoveries in flight may
+    for (final path in paths.reversed) {
+      yield cancelToken?.isCancelled ?? false
+          ? BatchProbeResult(path: path, status: ProbeStatus.cancelled)
+          : path.isEmpty
+          ? BatchProbeResult(path: path, status: ProbeStatus.invalidArgument)
+          : BatchProbeResult(
+              path: path,
+              status: ProbeStatus.ok,
+              info: mockMediaInfo,
+            );
+    }
+  }
+
+  @override
+  Future<GopInfo?> analyzeGop(
+    String path, {
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) {
+    if (!path.endsWith('.mp4')) return Future.value(null);
+    // I P P | I P P at 25 fps
+    return Future.value(
+      GopInfo(
+        frameCount: 6,
+        keyframeCount: 2,
+        gopFramesMin: 3,
+        gopFramesP50: 3,
+        gopFramesP90: 3,
+        gopFramesMax: 3,
+        seekFramesMean: 2,
+        seekFramesMax: 3,
+        costs: [
+          for (var i = 0; i < 6; i++)
+            SeekCost(
+              position: Duration(milliseconds: 40 * i),
+              keyframePosition: Duration(milliseconds: 120 * (i ~/ 3)),
+              frames: i % 3 + 1,
+            ),
+        ],
+      ),
+    );
+  }
+
+  @override
+  Future<Uint8List?> getEmbeddedThumbnail(
+    String path, {
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) {
+    final covered = path.endsWith('.m4a') || path.endsWith('.mkv');
+    return Future.value(covered ? mockCoverData : null);
+  }
+
+  IoBackend ioBackend = IoBackend.auto;
+  IoStats mockIoStats = const IoStats();
+
+  @override
+  Future<bool> setIoBackend(IoBackend backend) {
+    if (backend == IoBackend.ioUring) return Future.value(false);
+    ioBackend = backend;
+    return Future.value(true);
+  }
+
+  @override
+  Future<IoStats> getIoStats() => Future.value(mockIoStats);
+
+  ProbeMetrics mockMetrics = const ProbeMetrics();
+
+  @override
+  Future<ProbeMetrics> metrics({bool reset = false}) {
+    final snapshot = mockMetrics;
+    if (reset) mockMetrics = const ProbeMetrics();
+    return Future.value(snapshot);
+  }
+
+  bool tracing = false;
+
+  @override
+  Future<bool> startTracing({int capacity = 0}) {
+    if (capacity < 0) return Future.value(false);
+    tracing = true;
+    return Future.value(true);
+  }
+
+  @override
+  Future<String> stopTracing() {
+    tracing = false;
+    return Future.value('{"traceEvents":[]}');
+  }
+
+  int globalBudget = 0;
+  int requestBudget = 0;
+
+  @override
+  Future<bool> setMemoryBudget({int global = 0, int perRequest = 0}) {
+    if (global < 0 || perRequest < 0) return Future.value(false);
+    globalBudget = global;
+    requestBudget = perRequest;
+    return Future.value(true);
+  }
+
+  int framePoolLimit = 32 << 20;
+
+  @override
+  Future<bool> setFramePoolLimit(int bytes) {
+    if (bytes < 0) return Future.value(false);
+    framePoolLimit = bytes;
+    return Future.value(true);
+  }
+
+  var warmedUp = false;
+  List<String>? pluginAllowlist;
+
+  @override
+  Future<bool> warmup() {
+    warmedUp = true;
+    return Future.value(true);
+  }
+
+  @override
+  Future<bool> setPluginAllowlist(List<String> plugins) {
+    // Too late once warmup has initialized the framework
+    if (warmedUp) return Future.value(false);
+    pluginAllowlist = plugins.isEmpty ? null : plugins;
+    return Future.value(true);
+  }
+
+  @override
+  Future<List<FrameResult>> extractFrames(
+    String path,
+    List<int> frameNums, {
+    int maxWorkers = 0,
+    int decoderThreads = 0,
+    CancelToken? cancelToken,
+    Duration? timeout,
+  }) async {
+    _checkCancelled(cancelToken);
+    return [
+      for (final frameNum in frameNums)
+        frameNum < 0 || frameNum >= mockFrameCount
+            ? FrameResult(
+                frameNum: frameNum,
+                status: ProbeStatus.invalidArgument,
+              )
+            : FrameResult(
+                frameNum: frameNum,
+                status: ProbeStatus.ok,
+                data: mockFrameData,
+              ),
+    ];
+  }
+
   @override
-  Future<Uint8List?> extractFrame(String path, int frameNum) {
-    if (shouldFail || path.isEmpty || frameNum < 0) return Future.value(null);
-    return Future.value(mockFrameData);
+  Stream<VideoFrame> frameStream(
+    String path, {
+    int startFrame = 0,
+    int step = 1,
+    int? endFrame,
+    int queueSize = 0,
+    CancelToken? cancelToken,
+  }) async* {
+    _checkCancelled(cancelToken);
+    final end = min(endFrame ?? mockFrameCount, mockFrameCount);
+    for (var frame = startFrame; frame < end; frame += max(step, 1)) {
+      yield VideoFrame(
+        frameNum: frame,
+        timestamp: Duration(milliseconds: frame * 40),
+        data: mockFrameData!,
+      );
+    }
+  }
+
+  @override
+  Stream<List<VideoFrame>> sampleFrames(
+    String path, {
+    Duration interval = const Duration(seconds: 1),
+    int startFrame = 0,
+    int? endFrame,
+    FrameFormat format = FrameFormat.jpeg,
+    int batchSize = 1,
+    int queueSize = 0,
+    CancelToken? cancelToken,
+  }) async* {
+    _checkCancelled(cancelToken);
+    // 25 fps, so a frame every 40 ms
+    final step = max(interval.inMilliseconds ~/ 40, 1);
+    final end = min(endFrame ?? mockFrameCount, mockFrameCount);
+    var batch = <VideoFrame>[];
+    for (var frame = startFrame; frame < end; frame += step) {
+      batch.add(
+        VideoFrame(
+          frameNum: frame,
+          timestamp: Duration(milliseconds: frame * 40),
+          data: mockFrameData!,
+          width: 1920,
+          height: 1080,
+          format: format,
+        ),
+      );
+      if (batch.length == batchSize) {
+        yield batch;
+        batch = [];
+      }
+    }
+    if (batch.isNotEmpty) yield batch;
+  }
+
+  /// Scheduled requests waiting for [runScheduled], in submission order.
+  final scheduled = <_MockRequest>[];
+  final ranScheduled = <String>[];
+  var _nextRequestId = 0;
+
+  ScheduledRequest<T> _schedule<T>(
+    String path,
+    RequestPriority priority,
+    int? slot,
+    T value,
+  ) {
+    if (slot != null) {
+      for (final old in scheduled.where((r) => r.slot == slot).toList()) {
+        scheduled.remove(old);
+        old.complete(const ScheduledResult(status: ProbeStatus.cancelled));
+      }
+    }
+    final completer = Completer<ScheduledResult<T>>();
+    final request = _MockRequest(++_nextRequestId, path, priority, slot, (
+      result,
+    ) {
+      completer.complete(
+        ScheduledResult(
+          status: result.status,
+          value: result.isOk ? value : null,
+        ),
+      );
+    });
+    scheduled.add(request);
+    return ScheduledRequest(request.id, completer.future);
   }
+
+  /// Runs every queued request, most urgent class first.
+  void runScheduled() {
+    for (final priority in RequestPriority.values) {
+      for (final request in scheduled.where((r) => r.priority == priority)) {
+        ranScheduled.add(request.path);
+        request.complete(const ScheduledResult(status: ProbeStatus.ok));
+      }
+    }
+    scheduled.clear();
+  }
+
+  @override
+  ScheduledRequest<Uint8List> scheduleFrame(
+    String path,
+    int frameNum, {
+    RequestPriority priority = RequestPriority.visible,
+    int? slot,
+    Duration? timeout,
+    bool preferEmbeddedThumbnail = false,
+  }) => _schedule(
+    path,
+    priority,
+    slot,
+    preferEmbeddedThumbnail && path.endsWith('.m4a')
+        ? mockCoverData
+        : mockFrameData!,
+  );
+
+  @override
+  ScheduledRequest<VideoInfo> scheduleMediaInfo(
+    String path, {
+    RequestPriority priority = RequestPriority.visible,
+    int? slot,
+    Duration? timeout,
+  }) => _schedule(path, priority, slot, mockMediaInfo);
+
+  @override
+  Future<bool> setRequestPriority(int id, RequestPriority priority) async {
+    final index = scheduled.indexWhere((r) => r.id == id);
+    if (index < 0) return false;
+    // Moves behind the requests already in the new class
+    final request = scheduled.removeAt(index)..priority = priority;
+    scheduled.add(request);
+    return true;
+  }
+
+  @override
+  Future<bool> cancelRequest(int id) async {
+    final index = scheduled.indexWhere((r) => r.id == id);
+    if (index < 0) return false;
+    scheduled
+        .removeAt(index)
+        .complete(const ScheduledResult(status: ProbeStatus.cancelled));
+    return true;
+  }
+}
+
+class _MockRequest {
+  _MockRequest(this.id, this.path, this.priority, this.slot, this.complete);
+
+  final int id;
+  final String path;
+  RequestPriority priority;
+  final int? slot;
+  final void Function(ScheduledResult<Object?> result) complete;
 }
 
 void main() {
@@ -126,6 +588,526 @@ void main() {
         expect(frame, isNull);
       });
     });
+
+    group('getMediaInfo', () {
+      test('returns info for valid path', () async {
+        final info = await plugin.getMediaInfo('/path/to/video.mp4');
+        expect(info, isNotNull);
+        expect(info!.videoCodec, 'h264');
+        expect(info.width, 1920);
+        expect(info.frameRate, 25.0);
+        expect(info.videoStreams.length, 1);
+        expect(info.audioStreams.single.sampleRate, 48000);
+        expect(info.subtitleStreams, isEmpty);
+      });
+
+      test('returns null for empty path', () async {
+        final info = await plugin.getMediaInfo('');
+        expect(info, isNull);
+      });
+
+      test('returns null on failure', () async {
+        mockPlatform.shouldFail = true;
+        final info = await plugin.getMediaInfo('/path/to/video.mp4');
+        expect(info, isNull);
+      });
+    });
+
+    group('in-memory sources', () {
+      final bytes = Uint8List.fromList(List.generate(64, (i) => i));
+
+      test('getMediaInfoFromBytes returns info', () async {
+        final info = await plugin.getMediaInfoFromBytes(bytes);
+        expect(info!.videoCodec, 'h264');
+      });
+
+      test('getMediaInfoFromBytes returns null for empty buffer', () async {
+        final info = await plugin.getMediaInfoFromBytes(Uint8List(0));
+        expect(info, isNull);
+      });
+
+      test('extractFrameFromBytes returns frame data', () async {
+        final frame = await plugin.extractFrameFromBytes(bytes, 0);
+        expect(frame, mockFrameData);
+      });
+
+      test('stream overloads collect every chunk', () async {
+        final stream = Stream.fromIterable([
+          bytes.sublist(0, 10),
+          bytes.sublist(10),
+        ]);
+        final info = await plugin.getMediaInfoFromStream(stream);
+        expect(info, isNotNull);
+
+        final frame = await plugin.extractFrameFromStream(
+          Stream.fromIterable([bytes]),
+          0,
+          length: bytes.length,
+        );
+        expect(frame, mockFrameData);
+      });
+
+      test('empty stream returns null', () async {
+        final info = await plugin.getMediaInfoFromStream(const Stream.empty());
+        expect(info, isNull);
+      });
+    });
+
+    group('probePartial', () {
+      test('reports needed ranges until they are present', () async {
+        final first = await plugin.probePartial('/dl.mp4', totalSize: 1000);
+        expect(first.needsData, isTrue);
+        expect(first.info, isNull);
+        expect(first.neededRanges, [const ByteRange(900, 100)]);
+
+        final second = await plugin.probePartial(
+          '/dl.mp4',
+          totalSize: 1000,
+          available: [const ByteRange(0, 64), ...first.neededRanges],
+        );
+        expect(second.status, ProbeStatus.ok);
+        expect(second.info!.width, 1920);
+        expect(second.neededRanges, isEmpty);
+      });
+
+      test('getNeededRanges is empty once everything is present', () async {
+        final needed = await plugin.getNeededRanges(
+          '/dl.mp4',
+          totalSize: 1000,
+          available: [const ByteRange(0, 1000)],
+        );
+        expect(needed, isEmpty);
+      });
+
+      test('ByteRange has value semantics', () {
+        expect(const ByteRange(10, 5).end, 15);
+        expect(const ByteRange(10, 5), const ByteRange(10, 5));
+      });
+    });
+
+    group('probeBatch', () {
+      test('returns one result per path in order', () async {
+        final results = await plugin.probeBatch(['/a.mp4', '', '/b.mp4']);
+        expect(results.map((r) => r.path), ['/a.mp4', '', '/b.mp4']);
+        expect(results[0].isOk, isTrue);
+        expect(results[0].info!.width, 1920);
+        expect(results[1].status, ProbeStatus.notFound);
+        expect(results[1].info, isNull);
+        expect(results[2].thumbnail, isNull);
+      });
+
+      test('includes thumbnails when requested', () async {
+        final results = await plugin.probeBatch(['/a.mp4'], thumbnails: true);
+        expect(results.single.thumbnail, mockFrameData);
+      });
+
+      test('maps native status codes', () {
+        expect(ProbeStatus.fromCode(0), ProbeStatus.ok);
+        expect(ProbeStatus.fromCode(-3), ProbeStatus.unsupported);
+        expect(ProbeStatus.fromCode(-99), ProbeStatus.failed);
+      });
+    });
+
+    group('discoverMediaInfo', () {
+      test('streams results as they finish', () async {
+        final results = await plugin
+            .discoverMediaInfo(['/a.mkv', '', 'https://host/b.webm'])
+            .toList();
+        expect(results.map((r) => r.path), ['https://host/b.webm', '', '/a.mkv']);
+        expect(results[0].info!.width, 1920);
+        expect(results[1].status, ProbeStatus.invalidArgument);
+        expect(results[1].info, isNull);
+      });
+
+      test('reports cancelled files', () async {
+        final token = CancelToken()..cancel();
+        final results = await plugin
+            .discoverMediaInfo(['/a.mkv', '/b.mkv'], cancelToken: token)
+            .toList();
+        expect(results.map((r) => r.status), [
+          ProbeStatus.cancelled,
+          ProbeStatus.cancelled,
+        ]);
+      });
+    });
+
+    group('analyzeGop', () {
+      test('looks up the frame shown at a position', () async {
+        final gop = await plugin.analyzeGop('/video.mp4');
+        expect(gop!.allIntra, isFalse);
+        expect(gop.gopFramesMax, 3);
+
+        final cost = gop.seekCost(const Duration(milliseconds: 210))!;
+        expect(cost.position, const Duration(milliseconds: 200));
+        expect(cost.keyframePosition, const Duration(milliseconds: 120));
+        expect(cost.frames, 3);
+        expect(gop.seekCost(const Duration(seconds: -1))!.frames, 1);
+        expect(gop.seekCost(const Duration(hours: 1))!.frames, 3);
+      });
+
+      test('returns null without an index', () async {
+        expect(await plugin.analyzeGop('/video.mkv'), isNull);
+        expect(
+          const GopInfo(frameCount: 0, keyframeCount: 0).seekCost(Duration.zero),
+          isNull,
+        );
+      });
+    });
+
+    group('getEmbeddedThumbnail', () {
+      test('returns the stored image or null', () async {
+        expect(
+          await plugin.getEmbeddedThumbnail('/song.m4a'),
+          mockPlatform.mockCoverData,
+        );
+        expect(await plugin.getEmbeddedThumbnail('/video.mp4'), isNull);
+      });
+
+      test('batches prefer stored images when asked', () async {
+        final paths = ['/a.mkv', '/b.mp4'];
+        final plain = await plugin.probeBatch(paths, thumbnails: true);
+        expect(plain.map((r) => r.thumbnail), [
+          mockPlatform.mockFrameData,
+          mockPlatform.mockFrameData,
+        ]);
+
+        final preferred = await plugin.probeBatch(
+          paths,
+          thumbnails: true,
+          preferEmbeddedThumbnails: true,
+        );
+        expect(preferred.map((r) => r.thumbnail), [
+          mockPlatform.mockCoverData,
+          mockPlatform.mockFrameData,
+        ]);
+      });
+
+      test('scheduled frames prefer stored images when asked', () async {
+        final cover = plugin.scheduleFrame(
+          '/song.m4a',
+          0,
+          preferEmbeddedThumbnail: true,
+        );
+        final frame = plugin.scheduleFrame('/song.m4a', 0);
+        mockPlatform.runScheduled();
+        expect((await cover.result).value, mockPlatform.mockCoverData);
+        expect((await frame.result).value, mockPlatform.mockFrameData);
+      });
+    });
+
+    group('cancellation', () {
+      test('cancelled calls throw', () async {
+        final token = CancelToken();
+        expect(
+          await plugin.getMediaInfo('/video.mp4', cancelToken: token),
+          isNotNull,
+        );
+        token.cancel();
+        expect(token.isCancelled, isTrue);
+        await expectLater(
+          plugin.getMediaInfo('/video.mp4', cancelToken: token),
+          throwsA(
+            isA<ProbeCancelledException>().having(
+              (e) => e.status,
+              'status',
+              ProbeStatus.cancelled,
+            ),
+          ),
+        );
+        await expectLater(
+          plugin.extractFrame('/video.mp4', 0, cancelToken: token),
+          throwsA(isA<ProbeCancelledException>()),
+        );
+      });
+
+      test('expired timeouts are reported', () async {
+        await expectLater(
+          plugin.getMediaInfo('/video.mp4', timeout: Duration.zero),
+          throwsA(
+            isA<ProbeCancelledException>().having(
+              (e) => e.timedOut,
+              'timedOut',
+              isTrue,
+            ),
+          ),
+        );
+      });
+
+      test('cancelled batches report per-file status', () async {
+        final token = CancelToken()..cancel();
+        final results = await plugin.probeBatch([
+          '/a.mp4',
+          '/b.mp4',
+        ], cancelToken: token);
+        expect(results.map((r) => r.status), [
+          ProbeStatus.cancelled,
+          ProbeStatus.cancelled,
+        ]);
+      });
+
+      test('whenCancelled completes once', () async {
+        final token = CancelToken();
+        var calls = 0;
+        token.whenCancelled.then((_) => calls++);
+        token
+          ..cancel()
+          ..cancel();
+        await token.whenCancelled;
+        expect(calls, 1);
+        expect(ProbeStatus.fromCode(-7), ProbeStatus.cancelled);
+        expect(ProbeStatus.fromCode(-8), ProbeStatus.timedOut);
+      });
+    });
+
+    group('scheduled requests', () {
+      test('run most urgent class first', () async {
+        plugin.scheduleFrame(
+          '/background.mp4',
+          0,
+          priority: RequestPriority.background,
+        );
+        plugin.scheduleFrame(
+          '/prefetch.mp4',
+          0,
+          priority: RequestPriority.prefetch,
+        );
+        final visible = plugin.scheduleFrame('/visible.mp4', 0);
+        mockPlatform.runScheduled();
+        expect(mockPlatform.ranScheduled, [
+          '/visible.mp4',
+          '/prefetch.mp4',
+          '/background.mp4',
+        ]);
+        final result = await visible.result;
+        expect(result.isOk, isTrue);
+        expect(result.value, mockPlatform.mockFrameData);
+      });
+
+      test('latest request on a slot wins', () async {
+        final first = plugin.scheduleFrame('/a.mp4', 0, slot: 3);
+        final second = plugin.scheduleMediaInfo('/b.mp4', slot: 3);
+        expect((await first.result).status, ProbeStatus.cancelled);
+        expect((await first.result).value, isNull);
+        mockPlatform.runScheduled();
+        expect((await second.result).value!.width, 1920);
+        expect(mockPlatform.ranScheduled, ['/b.mp4']);
+      });
+
+      test('can be reprioritized and cancelled while queued', () async {
+        final a = plugin.scheduleFrame(
+          '/a.mp4',
+          0,
+          priority: RequestPriority.background,
+        );
+        final b = plugin.scheduleFrame(
+          '/b.mp4',
+          0,
+          priority: RequestPriority.background,
+        );
+        final c = plugin.scheduleFrame('/c.mp4', 0);
+        expect(
+          await plugin.setRequestPriority(b.id, RequestPriority.visible),
+          isTrue,
+        );
+        expect(await plugin.cancelRequest(a.id), isTrue);
+        mockPlatform.runScheduled();
+        expect(mockPlatform.ranScheduled, ['/c.mp4', '/b.mp4']);
+        expect((await a.result).status, ProbeStatus.cancelled);
+        expect(await plugin.cancelRequest(c.id), isFalse);
+      });
+    });
+
+    group('I/O backends', () {
+      test('reports unavailable backends', () async {
+        expect(await plugin.setIoBackend(IoBackend.mmap), isTrue);
+        expect(mockPlatform.ioBackend, IoBackend.mmap);
+        expect(await plugin.setIoBackend(IoBackend.ioUring), isFalse);
+        expect(mockPlatform.ioBackend, IoBackend.mmap);
+      });
+
+      test('I/O stats snapshots can be diffed', () async {
+        mockPlatform.mockIoStats = const IoStats(files: 3, readSyscalls: 7);
+        final before = await plugin.getIoStats();
+        mockPlatform.mockIoStats = const IoStats(files: 4, readSyscalls: 9);
+        final delta = (await plugin.getIoStats()) - before;
+        expect(delta.files, 1);
+        expect(delta.readSyscalls, 2);
+      });
+    });
+
+    group('metrics', () {
+      test('reports stage percentiles', () async {
+        mockPlatform.mockMetrics = const ProbeMetrics(
+          stages: {
+            ProbeStage.seek: StageMetrics(
+              count: 4,
+              total: Duration(milliseconds: 40),
+              p50: Duration(milliseconds: 8),
+              p99: Duration(milliseconds: 19),
+            ),
+          },
+          bytesRead: 1024,
+        );
+        final metrics = await plugin.metrics();
+        expect(metrics[ProbeStage.seek].p99, const Duration(milliseconds: 19));
+        expect(metrics[ProbeStage.seek].mean, const Duration(milliseconds: 10));
+        expect(metrics[ProbeStage.decode].count, 0);
+        expect(metrics.bytesRead, 1024);
+      });
+
+      test('reset starts a new window', () async {
+        mockPlatform.mockMetrics = const ProbeMetrics(allocations: 3);
+        expect((await plugin.metrics(reset: true)).allocations, 3);
+        expect((await plugin.metrics()).allocations, 0);
+      });
+    });
+
+    group('tracing', () {
+      test('records between start and stop', () async {
+        expect(await plugin.startTracing(capacity: 1024), isTrue);
+        expect(mockPlatform.tracing, isTrue);
+        final json = await plugin.stopTracing();
+        expect(json, contains('traceEvents'));
+        expect(mockPlatform.tracing, isFalse);
+      });
+
+      test('rejects a negative capacity', () async {
+        expect(await plugin.startTracing(capacity: -1), isFalse);
+        expect(mockPlatform.tracing, isFalse);
+      });
+    });
+
+    group('memory budget', () {
+      test('sets global and per-request budgets', () async {
+        expect(
+          await plugin.setMemoryBudget(global: 256 << 20, perRequest: 64 << 20),
+          isTrue,
+        );
+        expect(mockPlatform.globalBudget, 256 << 20);
+        expect(mockPlatform.requestBudget, 64 << 20);
+      });
+
+      test('rejects negative budgets', () async {
+        expect(await plugin.setMemoryBudget(perRequest: -1), isFalse);
+        expect(mockPlatform.requestBudget, 0);
+      });
+
+      test('maps the over-budget status', () {
+        expect(ProbeStatus.fromCode(-9), ProbeStatus.overBudget);
+      });
+    });
+
+    group('frame pool', () {
+      test('sets the limit', () async {
+        expect(await plugin.setFramePoolLimit(0), isTrue);
+        expect(mockPlatform.framePoolLimit, 0);
+      });
+
+      test('rejects a negative limit', () async {
+        expect(await plugin.setFramePoolLimit(-1), isFalse);
+        expect(mockPlatform.framePoolLimit, 32 << 20);
+      });
+    });
+
+    group('warmup', () {
+      test('sets the allowlist before warming up', () async {
+        expect(await plugin.setPluginAllowlist(['isomp4', 'libav']), isTrue);
+        expect(await plugin.warmup(), isTrue);
+        expect(mockPlatform.pluginAllowlist, ['isomp4', 'libav']);
+      });
+
+      test('rejects the allowlist after warmup', () async {
+        await plugin.warmup();
+        expect(await plugin.setPluginAllowlist(['isomp4']), isFalse);
+        expect(mockPlatform.pluginAllowlist, isNull);
+      });
+    });
+
+    group('frame sets', () {
+      test('returns one result per frame in request order', () async {
+        final results = await plugin.extractFrames('/v.mp4', [250, 0, 250]);
+        expect(results.map((r) => r.frameNum), [250, 0, 250]);
+        expect(results.every((r) => r.isOk), isTrue);
+        expect(results.first.data, mockPlatform.mockFrameData);
+      });
+
+      test('reports frames past the end individually', () async {
+        final results = await plugin.extractFrames('/v.mp4', [0, 5000]);
+        expect(results[0].isOk, isTrue);
+        expect(results[1].status, ProbeStatus.invalidArgument);
+        expect(results[1].data, isNull);
+      });
+
+      test('throws when cancelled before it starts', () async {
+        final token = CancelToken()..cancel();
+        expect(
+          plugin.extractFrames('/v.mp4', [0], cancelToken: token),
+          throwsA(isA<ProbeCancelledException>()),
+        );
+      });
+    });
+
+    group('frame stream', () {
+      test('emits every step-th frame of the range', () async {
+        final frames = await plugin
+            .frameStream('/v.mp4', startFrame: 10, step: 25, endFrame: 100)
+            .toList();
+        expect(frames.map((f) => f.frameNum), [10, 35, 60, 85]);
+        expect(frames[1].timestamp, const Duration(milliseconds: 1400));
+      });
+
+      test('stops when the listener cancels', () async {
+        final frames = await plugin.frameStream('/v.mp4').take(3).toList();
+        expect(frames.map((f) => f.frameNum), [0, 1, 2]);
+      });
+
+      test('ends with an error when cancelled', () async {
+        final token = CancelToken()..cancel();
+        expect(
+          plugin.frameStream('/v.mp4', cancelToken: token).toList(),
+          throwsA(isA<ProbeCancelledException>()),
+        );
+      });
+    });
+
+    group('sample frames', () {
+      test('emits a frame per interval in batches', () async {
+        final batches = await plugin
+            .sampleFrames(
+              '/v.mp4',
+              interval: const Duration(seconds: 2),
+              endFrame: 250,
+              batchSize: 2,
+            )
+            .toList();
+        expect(batches.map((b) => b.length), [2, 2, 1]);
+        expect(batches.expand((b) => b).map((f) => f.frameNum), [
+          0,
+          50,
+          100,
+          150,
+          200,
+        ]);
+      });
+
+      test('passes the frame format through', () async {
+        final batches = await plugin
+            .sampleFrames('/v.mp4', format: FrameFormat.rgba)
+            .take(1)
+            .toList();
+        final frame = batches.single.single;
+        expect(frame.format, FrameFormat.rgba);
+        expect(frame.width, 1920);
+      });
+
+      test('ends with an error when cancelled', () async {
+        final token = CancelToken()..cancel();
+        expect(
+          plugin.sampleFrames('/v.mp4', cancelToken: token).toList(),
+          throwsA(isA<ProbeCancelledException>()),
+        );
+      });
+    });
   });
 
   group('Edge cases', () {